@@ -1,6 +1,9 @@
-#include "imdui.h"
+#include "ImDui.h"
+#include "ImDuiPlatform.h"
 
+#ifdef _MSC_VER
 #pragma warning (disable: 4996)
+#endif
 
 // Macros
 
@@ -48,30 +51,601 @@ private:
 	T m_elements[maxElements];
 };
 
-enum GuiStyleColor_
+// FNV-1a
+ImUint ImDui::HashBytes(const void* data, size_t size, ImUint hash)
 {
-	Color_Text,
-	Color_Border,
-	Color_WindowBg,
-	Color_WidgetBg,
-	Color_WidgetActive,
-	Color_TitleBar,
-	Color_TitleBarCollapsed,
-	Color_Slider,
-	Color_SliderActive,
-	Color_Button,
-	Color_ButtonHovered,
-	Color_ButtonActive,
-	Color_Collapse,
-	Color_CollapseHovered,
-	Color_CollapseActive,
-	Color_ResizeGrip,
-	Color_ResizeGripHovered,
-	Color_ResizeGripActive,
-	Color_TooltipBg,
-	Color_COUNT,
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
+
+// Memory
+
+namespace ImDui
+{
+	// STL allocator charging a category, for the containers below
+	template<typename T, int Category>
+	struct StlAllocator
+	{
+		typedef T value_type;
+
+		template<typename U>
+		struct rebind { typedef StlAllocator<U, Category> other; };
+
+		StlAllocator() {}
+		template<typename U>
+		StlAllocator(const StlAllocator<U, Category>&) {}
+
+		T* allocate(size_t count)
+		{
+			void* ptr = MemAlloc(count * sizeof(T), (AllocCategory)Category);
+			if (ptr == NULL)
+				throw std::bad_alloc();
+			return (T*)ptr;
+		}
+
+		void deallocate(T* ptr, size_t) { MemFree(ptr); }
+
+		template<typename U>
+		bool operator==(const StlAllocator<U, Category>&) const { return true; }
+		template<typename U>
+		bool operator!=(const StlAllocator<U, Category>&) const { return false; }
+	};
+
+	// Objects created with new: struct Window : HeapObject<AllocCategory_Windows>
+	template<int Category>
+	struct HeapObject
+	{
+		static void* operator new(size_t size)
+		{
+			void* ptr = MemAlloc(size, (AllocCategory)Category);
+			if (ptr == NULL)
+				throw std::bad_alloc();
+			return ptr;
+		}
+
+		static void operator delete(void* ptr) { MemFree(ptr); }
+	};
+
+	template<int Category>
+	using ImString = std::basic_string<char, std::char_traits<char>, StlAllocator<char, Category> >;
+
+	template<int Category>
+	struct ImStringHash
+	{
+		size_t operator()(const ImString<Category>& str) const { return HashBytes(str.data(), str.size()); }
+	};
+
+	template<typename T, int Category>
+	using ImVector = std::vector<T, StlAllocator<T, Category> >;
+	template<typename T, int Category>
+	using ImList = std::list<T, StlAllocator<T, Category> >;
+	template<typename T, int Category>
+	using ImDeque = std::deque<T, StlAllocator<T, Category> >;
+	template<typename K, typename V, int Category>
+	using ImHashMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, StlAllocator<std::pair<const K, V>, Category> >;
+	template<typename V, int Category>
+	using ImStringMap = std::unordered_map<ImString<Category>, V, ImStringHash<Category>, std::equal_to<ImString<Category> >,
+		StlAllocator<std::pair<const ImString<Category>, V>, Category> >;
+}
+
+// Bump allocator for the temporaries of a frame (wide strings, point arrays), one per thread.
+// What is allocated after Mark() is given back by Release(); the blocks are kept, so once the
+// largest frame has been seen nothing is allocated from the heap anymore.
+
+class FrameArena
+{
+public:
+	struct Marker
+	{
+		size_t Block;
+		size_t Used;
+	};
+
+	FrameArena() : m_block(0), m_used(0) {}
+	~FrameArena()
+	{
+		for (size_t i = 0; i < m_blocks.size(); i++)
+			ImDui::MemFree(m_blocks[i].Data);
+	}
+
+	void* Alloc(size_t size)
+	{
+		size = (size + 15) & ~(size_t)15;
+		while (m_block < m_blocks.size() && m_used + size > m_blocks[m_block].Size)
+		{
+			m_block++;
+			m_used = 0;
+		}
+
+		if (m_block == m_blocks.size())
+		{
+			Block block;
+			block.Size = size > (size_t)BLOCK_SIZE ? size : (size_t)BLOCK_SIZE;
+			block.Data = (char*)ImDui::MemAlloc(block.Size, ImDui::AllocCategory_Scratch);
+			m_blocks.push_back(block);
+		}
+
+		void* ptr = m_blocks[m_block].Data + m_used;
+		m_used += size;
+		return ptr;
+	}
+
+	template<typename T>
+	T* Alloc(size_t count) { return (T*)Alloc(count * sizeof(T)); }
+
+	Marker Mark() const
+	{
+		Marker marker = { m_block, m_used };
+		return marker;
+	}
+
+	void Release(const Marker& marker)
+	{
+		m_block = marker.Block;
+		m_used = marker.Used;
+	}
+
+private:
+	enum { BLOCK_SIZE = 64 * 1024 };
+
+	struct Block
+	{
+		char*	Data;
+		size_t	Size;
+	};
+
+	ImDui::ImVector<Block, ImDui::AllocCategory_Scratch> m_blocks;
+	size_t				m_block;
+	size_t				m_used;
+};
+
+static thread_local FrameArena s_frameArena;
+
+// Gives back what the enclosing scope allocated from the arena of the thread
+struct FrameArenaScope
+{
+	FrameArena::Marker Marker;
+
+	FrameArenaScope() : Marker(s_frameArena.Mark()) {}
+	~FrameArenaScope() { s_frameArena.Release(Marker); }
+};
+
+// Lock-free single producer / single consumer queue
+template<typename T, UINT capacity>
+class SPSCQueue
+{
+public:
+	SPSCQueue() : m_head(0), m_tail(0) {}
+
+	bool Push(const T& element)
+	{
+		const UINT tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == capacity)
+			return false;
+
+		m_elements[tail % capacity] = element;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	T* Peek()
+	{
+		const UINT head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return NULL;
+		return &m_elements[head % capacity];
+	}
+
+	void Pop()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	std::atomic<UINT> m_head;
+	std::atomic<UINT> m_tail;
+	T m_elements[capacity];
+};
+
+// Small work-stealing pool. Each thread owns a contiguous range of jobs and,
+// once it is drained, steals the remaining jobs of the other ranges.
+// The calling thread takes part in the work as worker 0. Runs from several
+// threads at once take turns.
+class JobPool : public ImDui::HeapObject<ImDui::AllocCategory_Context>
+{
+public:
+	enum { MAX_THREADS = 64 };
+
+	// true while a job of any pool runs on this thread: a job that runs a pool
+	// may wait for its own worker, it does the work itself instead
+	static bool InJob() { return t_inJob; }
+
+	JobPool() : m_generation(0), m_active(0), m_running(0), m_count(0), m_quit(false) {}
+	~JobPool() { Stop(); }
+
+	// fn(index, worker) for index in [0, count), worker in [0, num_threads) the slot of the thread
+	// running it, 0 for the calling one
+	void Run(int num_threads, UINT count, const std::function<void(UINT, int)>& fn)
+	{
+		if (num_threads <= 0)
+			num_threads = (int)std::thread::hardware_concurrency();
+		num_threads = (num_threads < 1) ? 1 : (num_threads > MAX_THREADS) ? MAX_THREADS : num_threads;
+		if ((UINT)num_threads > count)
+			num_threads = count > 0 ? (int)count : 1;
+
+		std::lock_guard<std::mutex> run(m_runMutex);
+		while ((int)m_threads.size() < num_threads - 1)
+			m_threads.push_back(std::thread(&JobPool::WorkerMain, this, (int)m_threads.size() + 1));
+
+		for (int i = 0; i < num_threads; i++)
+		{
+			m_ranges[i].Next = count * i / num_threads;
+			m_ranges[i].End = count * (i + 1) / num_threads;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_fn = fn;
+			m_count = count;
+			m_active = num_threads;
+			m_running = num_threads - 1;
+			m_generation++;
+		}
+		m_wake.notify_all();
+
+		const bool in_job = t_inJob;
+		t_inJob = true;
+		Work(0);
+		t_inJob = in_job;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_running == 0; });
+		m_fn = nullptr;
+	}
+
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+		for (size_t i = 0; i < m_threads.size(); i++)
+			m_threads[i].join();
+		m_threads.clear();
+		m_quit = false;
+	}
+
+private:
+	struct Range
+	{
+		std::atomic<UINT>	Next;
+		UINT				End;
+	};
+
+	void Work(int index)
+	{
+		for (int k = 0; k < m_active; k++)
+		{
+			Range& range = m_ranges[(index + k) % m_active];
+			for (UINT i = range.Next++; i < range.End; i = range.Next++)
+				m_fn(i, index);
+		}
+	}
+
+	void WorkerMain(int index)
+	{
+		t_inJob = true;
+		UINT generation = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_quit || m_generation != generation; });
+				if (m_quit)
+					return;
+				generation = m_generation;
+				if (index >= m_active)
+					continue;
+			}
+
+			Work(index);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_running == 0)
+				m_done.notify_one();
+		}
+	}
+
+	static thread_local bool	t_inJob;
+
+	ImDui::ImVector<std::thread, ImDui::AllocCategory_Context> m_threads;
+	std::mutex					m_runMutex;
+	std::mutex					m_mutex;
+	std::condition_variable		m_wake;
+	std::condition_variable		m_done;
+	std::function<void(UINT, int)>	m_fn;	// takes no allocator, small lambdas are stored inline
+	Range						m_ranges[MAX_THREADS];
+	UINT						m_generation;
+	int							m_active;
+	int							m_running;
+	UINT						m_count;
+	bool						m_quit;
+};
+
+thread_local bool JobPool::t_inJob = false;
+
+//-----------------------------------------------------------------------------
+// Resampling
+//-----------------------------------------------------------------------------
+
+// Separable resampling of 8-bit BGR(A) into premultiplied BGRA. Every source row is premultiplied
+// into floats and filtered horizontally, then the rows are filtered vertically and packed back
+// to bytes, so the image is read and written once. The output rows are processed in bands of
+// RESAMPLE_BAND rows on a JobPool, each band filtering the source rows it needs by itself.
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define IMDUI_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define IMDUI_AVX
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__)
+#define IMDUI_AVX2
+#endif
+
+enum { RESAMPLE_BAND = 64 };
+
+static float FilterSupport(int filter)
+{
+	switch (filter)
+	{
+	case ImDui::ImageFilter_Box:		return 0.5f;
+	case ImDui::ImageFilter_Bilinear:	return 1.0f;
+	default:							return 3.0f;
+	}
+}
+
+static float FilterWeight(int filter, float x)
+{
+	x = fabsf(x);
+	switch (filter)
+	{
+	case ImDui::ImageFilter_Box:
+		return x <= 0.5f ? 1.0f : 0.0f;
+	case ImDui::ImageFilter_Bilinear:
+		return x < 1.0f ? 1.0f - x : 0.0f;
+	default:
+		if (x < 1e-5f)
+			return 1.0f;
+		if (x >= 3.0f)
+			return 0.0f;
+		const float px = 3.14159265f * x;
+		return 3.0f * sinf(px) * sinf(px / 3.0f) / (px * px);
+	}
+}
+
+// Source pixels and normalized weights of every destination pixel along one axis. The filter
+// widens when shrinking so that every source pixel contributes.
+struct ResampleAxis
+{
+	ImDui::ImVector<int, ImDui::AllocCategory_Images>	Start;
+	ImDui::ImVector<float, ImDui::AllocCategory_Images>	Weights;	// Taps per destination pixel
+	int					Taps;
+
+	void Init(int src_size, int dst_size, int filter)
+	{
+		const float scale = (float)dst_size / (float)src_size;
+		const float filter_scale = scale < 1.0f ? scale : 1.0f;
+		const float support = FilterSupport(filter) / filter_scale;
+
+		Taps = std::min((int)ceilf(support * 2.0f) + 1, src_size);
+		Start.resize(dst_size);
+		Weights.resize(dst_size * Taps);
+
+		for (int i = 0; i < dst_size; i++)
+		{
+			const float center = (i + 0.5f) / scale;
+			const int first = std::max(0, std::min((int)floorf(center - support), src_size - Taps));
+
+			float* weights = &Weights[i * Taps];
+			float sum = 0.0f;
+			for (int k = 0; k < Taps; k++)
+			{
+				weights[k] = FilterWeight(filter, (first + k + 0.5f - center) * filter_scale);
+				sum += weights[k];
+			}
+			if (sum != 0.0f)
+			{
+				for (int k = 0; k < Taps; k++)
+					weights[k] /= sum;
+			}
+			Start[i] = first;
+		}
+	}
 };
 
+// 8-bit BGR or BGRA to premultiplied float BGRA
+static void PremultiplyRow(const BYTE* src, int width, int bpp, float* dst)
+{
+#ifdef IMDUI_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+	for (int x = 0; x < width; x++)
+	{
+		ImUint bgra = 0xff000000;
+		memcpy(&bgra, src + x * bpp, bpp);
+		const __m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)bgra), zero), zero);
+		const __m128 c = _mm_cvtepi32_ps(p);
+		const __m128 a = _mm_mul_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3)), inv255);
+		_mm_storeu_ps(dst + x * 4, _mm_or_ps(_mm_and_ps(rgb_mask, _mm_mul_ps(c, a)), _mm_andnot_ps(rgb_mask, c)));
+	}
+#else
+	for (int x = 0; x < width; x++)
+	{
+		const BYTE* p = src + x * bpp;
+		const float a = (bpp == 4) ? p[3] : 255.0f;
+		dst[x * 4 + 0] = p[0] * a / 255.0f;
+		dst[x * 4 + 1] = p[1] * a / 255.0f;
+		dst[x * 4 + 2] = p[2] * a / 255.0f;
+		dst[x * 4 + 3] = a;
+	}
+#endif
+}
+
+static void ResampleRow(const float* src, const ResampleAxis& axis, int width, float* dst)
+{
+	const int taps = axis.Taps;
+	for (int x = 0; x < width; x++)
+	{
+		const float* s = src + axis.Start[x] * 4;
+		const float* w = &axis.Weights[x * taps];
+#ifdef IMDUI_SSE2
+		__m128 acc = _mm_setzero_ps();
+		for (int k = 0; k < taps; k++)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + k * 4), _mm_set1_ps(w[k])));
+		_mm_storeu_ps(dst + x * 4, acc);
+#else
+		float acc[4] = { 0 };
+		for (int k = 0; k < taps; k++)
+		{
+			for (int c = 0; c < 4; c++)
+				acc[c] += s[k * 4 + c] * w[k];
+		}
+		memcpy(dst + x * 4, acc, sizeof(acc));
+#endif
+	}
+}
+
+#ifdef IMDUI_SSE2
+// rounds to bytes, the Lanczos lobes may overshoot so colors are clamped to alpha
+static void StorePixel(__m128 c, BYTE* dst)
+{
+	c = _mm_max_ps(c, _mm_setzero_ps());
+	const __m128 a = _mm_min_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 3, 3)), _mm_set1_ps(255.0f));
+	__m128i p = _mm_cvtps_epi32(_mm_min_ps(c, a));
+	p = _mm_packs_epi32(p, p);
+	p = _mm_packus_epi16(p, p);
+	const int bgra = _mm_cvtsi128_si32(p);
+	memcpy(dst, &bgra, 4);
+}
+#endif
+
+// rows: the first source row of the destination row, stride floats apart
+static void ResampleColumn(const float* rows, int stride, const float* w, int taps, int width, BYTE* dst)
+{
+	int x = 0;
+#ifdef IMDUI_AVX
+	for (; x + 2 <= width; x += 2)
+	{
+		__m256 acc = _mm256_setzero_ps();
+		for (int k = 0; k < taps; k++)
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(rows + k * stride + x * 4), _mm256_set1_ps(w[k])));
+		StorePixel(_mm256_castps256_ps128(acc), dst + x * 4);
+		StorePixel(_mm256_extractf128_ps(acc, 1), dst + x * 4 + 4);
+	}
+#endif
+	for (; x < width; x++)
+	{
+#ifdef IMDUI_SSE2
+		__m128 acc = _mm_setzero_ps();
+		for (int k = 0; k < taps; k++)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows + k * stride + x * 4), _mm_set1_ps(w[k])));
+		StorePixel(acc, dst + x * 4);
+#else
+		float acc[4] = { 0 };
+		for (int k = 0; k < taps; k++)
+		{
+			for (int c = 0; c < 4; c++)
+				acc[c] += rows[k * stride + x * 4 + c] * w[k];
+		}
+		const float a = std::min(std::max(acc[3], 0.0f), 255.0f);
+		for (int c = 0; c < 4; c++)
+			dst[x * 4 + c] = (BYTE)(std::min(std::max(acc[c], 0.0f), a) + 0.5f);
+#endif
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Colormaps
+//-----------------------------------------------------------------------------
+
+// 256 entry BGRA lookup tables, interpolated between the stops of each colormap
+static const ImUint* GetColormap(int colormap)
+{
+	static const ImUint sc_viridis[] = { 0x440154, 0x472c7a, 0x3b518b, 0x2c718e, 0x21908d, 0x27ad81, 0x5cc863, 0xaadc32, 0xfde725 };
+	static const ImUint sc_inferno[] = { 0x000004, 0x1b0c41, 0x4a0c6b, 0x781c6d, 0xa52c60, 0xcf4446, 0xed6925, 0xfb9b06, 0xf7d13d, 0xfcffa4 };
+	static const ImUint sc_gray[] = { 0x000000, 0xffffff };
+	static const ImUint* sc_stops[ImDui::Colormap_COUNT] = { sc_viridis, sc_inferno, sc_gray };
+	static const int sc_stopCount[ImDui::Colormap_COUNT] = { ARRAYSIZE(sc_viridis), ARRAYSIZE(sc_inferno), ARRAYSIZE(sc_gray) };
+
+	static ImUint s_luts[ImDui::Colormap_COUNT][256];
+	static std::once_flag s_once;
+	std::call_once(s_once, []
+	{
+		for (int m = 0; m < ImDui::Colormap_COUNT; m++)
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const float t = i / 255.0f * (sc_stopCount[m] - 1);
+				const int k = std::min((int)t, sc_stopCount[m] - 2);
+				const float f = t - k;
+				ImUint bgra = 0xff000000;
+				for (int shift = 0; shift < 24; shift += 8)
+				{
+					const float a = (float)((sc_stops[m][k] >> shift) & 0xff);
+					const float b = (float)((sc_stops[m][k + 1] >> shift) & 0xff);
+					bgra |= (ImUint)(a + (b - a) * f + 0.5f) << shift;
+				}
+				s_luts[m][i] = bgra;
+			}
+		}
+	});
+	return s_luts[colormap];
+}
+
+// maps (value - v_min) * scale, clamped to [0, 255], through the lookup table. NaN maps to 0.
+static void ColormapRow(const float* values, int count, float v_min, float scale, const ImUint* lut, ImUint* dst)
+{
+	int i = 0;
+#ifdef IMDUI_AVX2
+	const __m256 min8 = _mm256_set1_ps(v_min), scale8 = _mm256_set1_ps(scale);
+	const __m256 zero8 = _mm256_setzero_ps(), top8 = _mm256_set1_ps(255.0f);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 t = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + i), min8), scale8);
+		t = _mm256_min_ps(_mm256_max_ps(t, zero8), top8);
+		const __m256i color = _mm256_i32gather_epi32((const int*)lut, _mm256_cvttps_epi32(t), 4);
+		_mm256_storeu_si256((__m256i*)(dst + i), color);
+	}
+#endif
+#ifdef IMDUI_SSE2
+	const __m128 min4 = _mm_set1_ps(v_min), scale4 = _mm_set1_ps(scale);
+	const __m128 zero4 = _mm_setzero_ps(), top4 = _mm_set1_ps(255.0f);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), min4), scale4);
+		t = _mm_min_ps(_mm_max_ps(t, zero4), top4);
+		int index[4];
+		_mm_storeu_si128((__m128i*)index, _mm_cvttps_epi32(t));
+		dst[i + 0] = lut[index[0]];
+		dst[i + 1] = lut[index[1]];
+		dst[i + 2] = lut[index[2]];
+		dst[i + 3] = lut[index[3]];
+	}
+#endif
+	for (; i < count; i++)
+	{
+		const float t = (values[i] - v_min) * scale;
+		dst[i] = lut[t > 0.0f ? (t < 255.0f ? (int)t : 255) : 0];
+	}
+}
+
 static ImFloat4 ImHexToRGBA(ImUint rgb)
 {
 	static const ImUint sc_redShift = 16;
@@ -106,8 +680,15 @@ static bool IsHideText(const char* text)
 namespace ImDui
 {
 	struct D2DRender;
+	struct NullRender;
 	struct Window;
 
+#ifdef IMDUI_D2D
+	typedef D2DRender		RenderBackend;
+#else
+	typedef NullRender		RenderBackend;
+#endif
+
 	int				Min(int lhs, int rhs) { return lhs < rhs ? lhs : rhs; }
 	int				Max(int lhs, int rhs) { return lhs >= rhs ? lhs : rhs; }
 	float			Min(float lhs, float rhs) { return lhs < rhs ? lhs : rhs; }
@@ -129,11 +710,21 @@ namespace ImDui
 	void			OutWarning(const char * pszFormat, ...);
 	void			OutError(const char * pszFormat, ...);
 
+	float			TicksToMs(LONGLONG ticks);
+	void			NoteReaction();
+	// ticks on the clock of the input event timestamps: GetTime(), or for a replayed frame its
+	// recorded time plus the real time since the frame began
+	double			InputClockTime(LONGLONG ticks, bool replayed, double frame_time, LONGLONG frame_begin);
+	void			DrainInputEvents(double* out_click_time);
+	void			UpdateStat(std::atomic<float>& stat, float value);
+	bool			IsRectCovered(const ImFloat4& rect, const ImVector<ImFloat4, AllocCategory_Context>& occluders);
+
 	size_t			FormatString(char* buf, size_t buf_size, const char* fmt, ...);
 	size_t			FormatStringV(char* buf, size_t buf_size, const char* fmt, va_list args);
 
 	std::wstring	ATOW(const std::string& str);
 	std::string		WTOA(const std::wstring& str);
+	const WCHAR*	FrameATOW(const char* str, UINT32* out_length);
 
 	bool			WidgetMouseEvent(ImFloat4 bb, const ImUint id, bool* out_hovered = NULL, bool* out_held = NULL, bool repeat = false);
 	bool			WindowCloseButton(bool* open = NULL);
@@ -146,33 +737,16 @@ namespace ImDui
 	void			ItemSize(ImFloat2 size, ImFloat2* adjust_start_offset = NULL);
 	void			ItemSize(const ImFloat4& aabb, ImFloat2* adjust_start_offset = NULL);
 
-	struct GuiStyle
-	{
-		wchar_t*		FontName;
-		float			FontSize;
-		float			StrokeWidth;
-		float			DefaultWindowAlpha;
-		ImFloat2		WindowPadding;
-		ImFloat2		WindowMinSize;
-		ImFloat2		FramePadding;
-		ImFloat2		ItemSpacing;
-		ImFloat2		ItemInnerSpacing;
-		float			WindowRounding;
-		float			TitleBarHeight;
-		ImFloat2		ResizeGripSize;
-		ImFloat4		Colors[Color_COUNT];
-
-		GuiStyle();
-	};
-
 	struct Storage
 	{
-		std::unordered_map<ImUint, int> Data;
+		ImHashMap<ImUint, int, AllocCategory_Storage> Data;
 
 		void	Clear();
 		int		GetValue(ImUint key, int default_val = 0);
 		void	SetValue(ImUint key, int val);
 		void	SetAllInt(int val);
+		float	GetFloat(ImUint key, float default_val = 0.0f);
+		void	SetFloat(ImUint key, float val);
 	};
 
 	struct LayoutData
@@ -182,7 +756,7 @@ namespace ImDui
 		ImFloat2			CursorStartPos;
 		float				CurrentLineHeight;
 		float				PrevLineHeight;
-		std::vector<float>	ItemWidth;
+		ImVector<float, AllocCategory_Windows> ItemWidth;
 
 		LayoutData()
 		{
@@ -191,7 +765,79 @@ namespace ImDui
 		}
 	};
 
-	struct Window
+	enum TEXT_ALIGNMENT_MODE
+	{
+		MODE_LEFT,
+		MODE_CENTER,
+		MODE_RIGHT,
+	};
+
+	// the values of the frame capture commands, which are written as they are
+	enum DrawCmdType
+	{
+		DrawCmd_Line			= FrameCaptureCmd_Line,
+		DrawCmd_Rect			= FrameCaptureCmd_Rect,
+		DrawCmd_RoundedRect		= FrameCaptureCmd_RoundedRect,
+		DrawCmd_Ellipse			= FrameCaptureCmd_Ellipse,
+		DrawCmd_Polygon			= FrameCaptureCmd_Polygon,
+		DrawCmd_PolygonalLine	= FrameCaptureCmd_PolygonalLine,
+		DrawCmd_Text			= FrameCaptureCmd_Text,
+		DrawCmd_Image			= FrameCaptureCmd_Image,
+		DrawCmd_ImageView		= FrameCaptureCmd_ImageView,
+		DrawCmd_Heatmap			= FrameCaptureCmd_Heatmap,
+		DrawCmd_PushClip		= FrameCaptureCmd_PushClip,
+		DrawCmd_PopClip			= FrameCaptureCmd_PopClip,
+	};
+
+	struct DrawCmd
+	{
+		DrawCmdType			Type;
+		ImFloat4			Color;
+		ImFloat4			Rect;			// rect, or center + radius for ellipses
+		ImFloat2			Radius;
+		bool				Filled;
+		bool				Aliased;
+		TEXT_ALIGNMENT_MODE	Align;
+		ImUint				Offset;			// into Points or TextBuffer (text, image path), heatmap version
+		ImUint				Count;			// points, text length, heatmap id, or for an image view the index of its center and zoom in Points
+	};
+
+	// Draw commands recorded by the widgets of one window. Recording does not touch
+	// Direct2D, so a window can be built on any thread and replayed later on the
+	// thread owning the render target.
+	struct DrawCmdList
+	{
+		ImVector<DrawCmd, AllocCategory_DrawLists>	Cmds;
+		ImVector<ImFloat2, AllocCategory_DrawLists>	Points;
+		ImVector<char, AllocCategory_DrawLists>		TextBuffer;
+
+		void Clear();
+		void Swap(DrawCmdList& other);
+		ImUint Hash() const;
+		void DrawLine(ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2);
+		void DrawRect(ImFloat4 color, ImFloat4 rt, bool isFilled = false, bool isAliased = false);
+		void DrawRoundedRect(ImFloat4 color, ImFloat4 rt, float radiusX, float radiusY, bool isFilled = false);
+		void DrawEllipse(ImFloat4 color, float x, float y, float radiusX, float radiusY, bool isFilled = false);
+		void DrawTriangle(ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2, const ImFloat2& pt3, bool isFilled = false);
+		void DrawPolygonalLine(ImFloat4 color, const ImFloat2* array, ImUint count);
+		void DrawText(ImFloat4 color, const char* txt, const ImFloat4& rt, TEXT_ALIGNMENT_MODE mode = MODE_CENTER);
+		void DrawImage(const char* path, const ImFloat4& rt);
+		void DrawImageView(const char* path, const ImFloat4& rt, const ImFloat2& center, float zoom);
+		void DrawHeatmap(ImUint id, ImUint version, const ImFloat4& rt);
+		void PushClipRect(const ImFloat4& rt);
+		void PopClipRect();
+
+	private:
+		DrawCmd& AddCmd(DrawCmdType type, const ImFloat4& color);
+	};
+
+	struct IDEntry
+	{
+		ImUint				Id;
+		ImUint				LastUsed;		// Window::BuiltFrames of the last GetID()
+	};
+
+	struct Window : HeapObject<AllocCategory_Windows>
 	{
 		char*				Name;
 		ImFloat4			Rect;
@@ -202,361 +848,846 @@ namespace ImDui
 		float				ItemWidthDefault;
 		LayoutData			Layout;
 		Storage				StateStorage;
-		ImStringUintMap		IDMap;
+		ImStringMap<IDEntry, AllocCategory_Storage> IDMap;
+		ImString<AllocCategory_Storage> IDKey;
+		ImUint				LastFrame;		// frame of the last BeginWindow()
+		ImUint				BuiltFrames;	// frames built not collapsed, the clock ids age with
+		DrawCmdList			DrawList;
+		ImVector<ImFloat4, AllocCategory_Windows> ClipStack;	// window coordinates, the window rect at the bottom
+#ifdef IMDUI_D2D
 		ID2D1BitmapRenderTarget* CRT;
+		bool				CRTStale;		// the surface skipped frames while hidden, render thread only
+		size_t				CRTBytes;
+		ImUint				CRTFrame;		// SurfaceClock of the last Render() with the window, render thread only
+		ImUint				CRTShown;		// SurfaceClock of the last Render() composing it
 
 		void Resize(ImFloat2 size);
+		void ReleaseSurface();
+#endif
 		ImUint GetID(const char* str);
 
 		Window(const char* name, ImFloat2 default_pos, ImFloat2 default_size);
 		~Window();
+	};
 
-	private:
-
-		static ImUint _idseed;
+	// Input latency of one input event, all times in seconds on the GetTime() clock
+	struct LatencyRecord
+	{
+		double				InputTime;		// timestamp of the event
+		double				ConsumeTime;	// NewFrame() that drained it
+		ImUint				Frame;			// index of that frame
 	};
 
-	struct GUIState
+	struct LatencyHistogram
 	{
-		float					FPS;
-		Event					Events;
-		GuiStyle				Styles;
-		ImUint					HoveredId;
-		ImUint					ActiveId;
-		Window*					CurrentWindow;
-		Window*					RenderWindow;
-		Window*					HoveredWindow;
-		std::vector<Window*>	Windows;
-		char					StrToolTip[1024];
-		std::string				BgImage;
+		enum { BIN_COUNT = 1000 };			// 0.5 ms bins, the last one collects everything above
 
-		D2DRender*				Render;
-	};
+		ImUint				Bins[BIN_COUNT];
+		ImUint				Count;
 
-	//////////////////////////////////////////////////////////////////////////
-	static GUIState s_state;
-	static RingBuffer<LONGLONG, 10>	s_times;
-	static LARGE_INTEGER s_frequency;
-	//////////////////////////////////////////////////////////////////////////
+		LatencyHistogram() { Clear(); }
+		void	Clear() { memset(Bins, 0, sizeof(Bins)); Count = 0; }
+		void	Add(float ms);
+		float	Percentile(float p) const;
+	};
 
-	template<class Interface>
-	inline void	SafeRelease(Interface **ppInterfaceToRelease)
+	// Pixels of a Heatmap(), converted by the thread building the UI and copied into the bitmap
+	// of the heatmap by the render thread. Dirty is the part changed since the last copy.
+	struct HeatmapData : HeapObject<AllocCategory_Heatmaps>
 	{
-		if (*ppInterfaceToRelease != NULL)
+		std::mutex			Mutex;
+		int					Width;			// pixels
+		int					Height;
+		int					Cols;
+		int					Rows;
+		float				Min;
+		float				Max;
+		int					Colormap;
+		ImVector<ImUint, AllocCategory_Heatmaps> Pixels;	// BGRA, opaque
+		ImUint				Version;		// changed pixels, recorded with the draw command
+		int					DirtyX0, DirtyY0, DirtyX1, DirtyY1;
+		ImUint				LastFrame;		// FrameCount of the last Heatmap() call, shown or not
+
+		HeatmapData() : Width(0), Height(0), Cols(0), Rows(0), Min(0.0f), Max(0.0f), Colormap(0), Version(0), LastFrame(0) { ClearDirty(); }
+		void	ClearDirty() { DirtyX0 = DirtyY0 = DirtyX1 = DirtyY1 = 0; }
+		bool	IsDirty() const { return DirtyX0 < DirtyX1 && DirtyY0 < DirtyY1; }
+		void	AddDirty(int x0, int y0, int x1, int y1)
 		{
-			(*ppInterfaceToRelease)->Release();
-			(*ppInterfaceToRelease) = NULL;
+			if (!IsDirty())
+			{
+				DirtyX0 = x0;
+				DirtyY0 = y0;
+				DirtyX1 = x1;
+				DirtyY1 = y1;
+				return;
+			}
+			DirtyX0 = std::min(DirtyX0, x0);
+			DirtyY0 = std::min(DirtyY0, y0);
+			DirtyX1 = std::max(DirtyX1, x1);
+			DirtyY1 = std::max(DirtyY1, y1);
 		}
-	}
+	};
 
-	struct D2DRender
+	// Snapshot of everything Render() needs to draw one frame. EndFrame() fills it on the
+	// UI thread, Render() consumes it, possibly on another thread while the next frame is built.
+	struct FrameWindow
 	{
-		enum TEXT_ALIGNMENT_MODE
-		{
-			MODE_LEFT,
-			MODE_CENTER,
-			MODE_RIGHT,
-		};
+		Window*				Win;
+		ImFloat4			Rect;
+		float				Alpha;
+		bool				Opaque;			// Alpha 1 over an opaque background, covers all of Rect
+		bool				Hidden;			// covered by opaque windows above, set by Render()
+		ImUint				Hash;			// of DrawList
+		DrawCmdList			DrawList;
+	};
 
-		D2DRender()
-		{
-			_penWidth		= s_state.Styles.StrokeWidth;
-			_pD2DFactory	= NULL;
-			_pDWriteFactory	= NULL;
-			_pWICFactory	= NULL;
-			_pMainRT		= NULL;
-			_pCommonBrush	= NULL;
-			_pTextFormat	= NULL;
-		}
+	// a window as composed by the last Render(), to find what changed since
+	struct ComposedWindow
+	{
+		Window*				Win;
+		ImFloat4			Rect;
+		float				Alpha;
+		ImUint				Hash;
+	};
 
-		~D2DRender()
-		{
-			for (auto itor = _mapBitmaps.begin(); itor != _mapBitmaps.end(); ++itor)
-				SafeRelease(&itor->second);
-			_mapBitmaps.clear();
+	struct FrameData
+	{
+		ImVector<FrameWindow, AllocCategory_Context> Windows;	// only the first Count entries are used, the rest keep their capacity
+		ImUint						Count;
+		ImUint						Index;
+		ImString<AllocCategory_Context> BgImage;
+		bool						BgImageResized;
+		bool						DirtyRendering;
+		ImFloat4					ClearColor;		// of the dirty rectangles
+		char						ToolTip[1024];
+		ImFloat4					ToolTipRect;
+		ImFloat4					ToolTipBgColor;
+		ImFloat4					ToolTipTextColor;
+		ImFloat4					PlaceholderColor;	// Color_WidgetBg, drawn where an image is not ready
+		float						FontSize;		// of the style, for the frame capture
+		float						StrokeWidth;
+		LONGLONG					BuildBegin;
+		LONGLONG					BuildEnd;
+		double						Time;			// Events.Time of the frame
+		bool						Replayed;		// Time is a replayed time
+		double						ReactTime;		// first widget reaction of the frame, 0 if nothing reacted
+		LatencyRecord				Latency[64];	// input events consumed by the frame
+		ImUint						LatencyCount;
+
+		FrameData() : Count(0), Index(0), BgImageResized(true), DirtyRendering(false), FontSize(0.0f), StrokeWidth(0.0f), BuildBegin(0), BuildEnd(0), Time(0.0), Replayed(false), ReactTime(0.0), LatencyCount(0) { ToolTip[0] = '\0'; }
+	};
 
-			SafeRelease(&_pCommonBrush);
-			SafeRelease(&_pTextFormat);
-		}
+	enum { FRAME_NEW = 0x80000000 };
 
-		bool Init(ID2D1Factory* pD2DFactory, IDWriteFactory* pDWriteFactory, IWICImagingFactory* pWICFactory, ID2D1HwndRenderTarget* pMainRT)
-		{
-			_pD2DFactory = pD2DFactory;
-			_pDWriteFactory = pDWriteFactory;
-			_pWICFactory = pWICFactory;
-			_pMainRT = pMainRT;
+	struct WindowJob
+	{
+		Window*				Win;
+		ImString<AllocCategory_Context> Name;
+		bool*				Open;
+		ImFloat2			Pos;
+		ImFloat2			Size;
+		float				FillAlpha;
+		ImDuiWindowFlags	Flags;
+		WindowJobFunc		Func;
+
+		// interaction results, merged in submission order
+		ImUint				HoveredId;
+		ImUint				ActiveId;
+		bool				MoveClaimed;	// ActiveId is the #MOVE of the window, taken in EndWindow()
+		double				ReactTime;
+		ImString<AllocCategory_Context> ToolTip;
+	};
 
-			_pMainRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+	// a window discarded by the garbage collection, deleted by the render thread once it picked
+	// up a frame that no longer has it
+	struct RetiredWindow
+	{
+		Window*				Win;
+		ImUint				Frame;
+	};
 
-			HRESULT hr = S_OK;
-			if (SUCCEEDED(hr))
-			{
-				hr = _pDWriteFactory->CreateTextFormat(
-					s_state.Styles.FontName,
-					NULL,
-					DWRITE_FONT_WEIGHT_REGULAR,
-					DWRITE_FONT_STYLE_NORMAL,
-					DWRITE_FONT_STRETCH_NORMAL,
-					s_state.Styles.FontSize,
-					L"en-us",
-					&_pTextFormat);
+	struct RetiredHeatmap
+	{
+		ImUint				Id;
+		HeatmapData*		Data;
+		ImUint				Frame;
+	};
 
-				_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-				_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
-				_pTextFormat->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
-			}
+	struct Context : HeapObject<AllocCategory_Context>
+	{
+		float					FPS;
+		Event					Events;
+		GuiStyle				Styles;
+		ImUint					HoveredId;
+		ImUint					ActiveId;
+		Window*					CurrentWindow;
+		Window*					RenderWindow;
+		Window*					HoveredWindow;
+		ImVector<Window*, AllocCategory_Context> Windows;
+		char					StrToolTip[1024];
+		ImString<AllocCategory_Context> BgImage;
+		bool					BgImageResized;
+		std::atomic<ImUint>		IDSeed;
+		std::mutex				IDMutex;
+		ImVector<ImUint, AllocCategory_Context> FreeIDs;		// released by the garbage collection
+		int						GCIdleFrames;
+		std::mutex				RetireMutex;
+		ImVector<RetiredWindow, AllocCategory_Context> RetiredWindows;
+		Context*				Parent;			// owning context of a parallel window job
+		bool					InWindowJobs;
+
+		ImVector<WindowJob, AllocCategory_Context> WindowJobs;
+		JobPool*				Jobs;
+		Context*				JobContexts[JobPool::MAX_THREADS];	// one per pool worker, reused every frame
+
+		// triple buffered frame data, handed from EndFrame() to Render() without locks
+		FrameData				Frames[3];
+		ImUint					FrameWrite;		// owned by the UI thread
+		ImUint					FrameRead;		// owned by the render thread
+		std::atomic<ImUint>		FrameReady;		// last published frame, | FRAME_NEW until Render() picks it up
+		ImUint					FrameCount;
+		ImUint					FrameRendered;
+		LONGLONG				FrameBegin;
+		bool					FrameEnded;
+		bool					Pipelined;
+		std::mutex				FrameMutex;		// only used to sleep in WaitForRenderer() and WaitForFrame()
+		std::condition_variable	FrameConsumed;
+		std::condition_variable	FramePublished;
+
+		std::atomic<float>		StatBuildTime;
+		std::atomic<float>		StatRenderTime;
+		std::atomic<float>		StatLatency;
+		std::atomic<int>		StatFramesDropped;
+		std::atomic<int>		StatWindowsCulled;
+		std::atomic<int>		StatDirtyRects;
+		std::atomic<int>		StatPixelsTouched;
+		ImVector<ImFloat4, AllocCategory_Context> Occluders;	// render thread scratch
+
+		// window surfaces, the list and the clock are owned by the render thread
+		ImVector<Window*, AllocCategory_Context> Surfaces;	// windows with a surface
+		ImUint					SurfaceClock;
+		std::atomic<size_t>		SurfaceBudget;
+		std::atomic<size_t>		SurfaceBytes;
+		std::atomic<int>		SurfaceCount;
+		std::atomic<int>		SurfacesCreated;
+		std::atomic<int>		SurfacesReleased;
+
+		// dirty rectangles: what the last Render() composed, owned by the render thread
+		bool					DirtyRendering;
+		ImFloat4				DirtyClearColor;
+		std::atomic<bool>		DirtyFull;		// the next Render() recomposes everything
+		ImVector<ImFloat4, AllocCategory_Context> DirtyRects;	// recomposed by the last Render()
+		ImVector<ComposedWindow, AllocCategory_Context> Composed;
+		ImString<AllocCategory_Context> ComposedBgImage;
+		bool					ComposedBgResized;
+		ImUint					ComposedToolTip;	// hash of the text and rect, 0 without tooltip
+		ImFloat4				ComposedToolTipRect;
+		ImFloat2				ComposedSize;
+
+		SPSCQueue<InputEvent, 256>	InputQueue;
+		std::atomic<int>		InputEventsDropped;
+		LONGLONG				TimeStart;
+
+		// input recording and replay, on the thread building the UI
+		FILE*					RecordFile;
+		FILE*					ReplayFile;
+		bool					ReplayPending;		// the next NewFrame() takes the replayed time
+		double					ReplayTime;
+		float					ReplayDeltaTime;
+		bool					FrameReplayed;		// Events.Time of this frame is a replayed time
+		ImUint					FrameHash;			// GetFrameHash()
+
+		// frame capture, requested from any thread and written by Render()
+		std::mutex				CaptureMutex;
+		ImString<AllocCategory_Context> CapturePath;		// or, when CaptureFunc is set, handed to it
+		FrameCaptureFunc		CaptureFunc;
+		void*					CaptureUserData;
+		std::atomic<bool>		CapturePending;
+		ImVector<char, AllocCategory_Context> CaptureData;
+		ImVector<float, AllocCategory_Context> CaptureCmdTimes;		// of all the windows, in frame order
+		ImVector<float, AllocCategory_Context> CaptureWindowTimes;
+
+		// input latency: records travel with the frame data and are finished by Render()
+		ImUint					HoveredIdPrev;
+		ImUint					ActiveIdPrev;
+		double					ReactTime;
+		std::mutex				LatencyMutex;
+		LatencyHistogram		LatencyConsume;
+		LatencyHistogram		LatencyReact;
+		LatencyHistogram		LatencyPresent;
+
+		// image loading options, applied by the render thread
+		std::atomic<bool>		ImageAsync;
+		std::atomic<int>		ImageUploadBudget;
+		std::atomic<bool>		ImageRelease;
+		std::atomic<size_t>		ImageCacheBudget;
+		std::atomic<int>		ImageFilterMode;
+
+		// heatmaps by id, shared by the UI and render threads
+		std::mutex				HeatmapMutex;
+		ImHashMap<ImUint, HeatmapData*, AllocCategory_Heatmaps> Heatmaps;
+		ImVector<RetiredHeatmap, AllocCategory_Heatmaps> RetiredHeatmaps;
+
+		RingBuffer<LONGLONG, 10> FrameTimes;
+		LONGLONG				Frequency;		// of GetTicks()
+		LONGLONG				LastTimeStatusShown;
+		char					TextBuf[1024];
+
+		RenderBackend*			Render;
+
+		Context();
+	};
 
-			if (SUCCEEDED(hr))
-				hr = _pMainRT->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Orange), &_pCommonBrush);
+	//////////////////////////////////////////////////////////////////////////
+	// current context, one per thread so that independent UIs can be built in parallel
+	static thread_local Context* s_ctx = NULL;
+	//////////////////////////////////////////////////////////////////////////
 
-			return false;
+#ifdef IMDUI_D2D
+
+	template<class Interface>
+	inline void	SafeRelease(Interface **ppInterfaceToRelease)
+	{
+		if (*ppInterfaceToRelease != NULL)
+		{
+			(*ppInterfaceToRelease)->Release();
+			(*ppInterfaceToRelease) = NULL;
 		}
+	}
 
-		void Resize(float w, float h) { _pMainRT->Resize(D2D1::SizeU(w, h)); }
+	enum IMAGE_STATE
+	{
+		IMAGE_QUEUED,		// waiting for, or being decoded by, a loader thread
+		IMAGE_DECODED,		// pixels in memory, waiting to be uploaded
+		IMAGE_READY,
+		IMAGE_FAILED,
+	};
 
-		ID2D1RenderTarget* GetMainRT() { return _pMainRT; }
+	struct ImageEntry
+	{
+		ImString<AllocCategory_Images> Key;		// path|widthxheight as requested, or path#level/x_y for a tile
+		ImString<AllocCategory_Images> Path;
+		UINT				Width;			// requested size (0 = keep aspect / natural size), decoded size once decoded
+		UINT				Height;
+		WICRect				Clip;			// part of the source to decode, Width 0 = all of it
+		int					Level;			// mip level of a tile, -1 for an image
+		std::atomic<float>	Priority;		// queued entries with the lowest priority are decoded first
+		ImVector<BYTE, AllocCategory_Images> Pixels;	// 32bpp PBGRA, freed by the upload
+		const BYTE*			Source;			// pixels in a memory mapped image pack, used instead of Pixels
+		ID2D1Bitmap*		Bitmap;
+		std::atomic<int>	State;
+		std::atomic<bool>	Cancelled;
+		ImUint				LastUsedFrame;
+		ImList<ImageEntry*, AllocCategory_Images>::iterator LruPos;
+
+		ImageEntry() : Width(0), Height(0), Level(-1), Priority(0.0f), Source(NULL), Bitmap(NULL), State(IMAGE_QUEUED), Cancelled(false), LastUsedFrame(0) { memset(&Clip, 0, sizeof(Clip)); }
+		~ImageEntry() { SafeRelease(&Bitmap); }
+	};
 
-		ID2D1RenderTarget* ChooseRT(ID2D1RenderTarget* pRT) { return pRT == NULL ? _pMainRT : pRT; }
+	typedef std::shared_ptr<ImageEntry> ImageEntryPtr;
 
-		void BeginDraw(ID2D1RenderTarget* pRT)
+	// A memory mapped image pack, see ImagePackHeader. The index holds every image under
+	// "name|widthxheight" and, for the first image of a name, under "name".
+	struct ImagePack : HeapObject<AllocCategory_Images>
+	{
+		HANDLE				File;
+		HANDLE				Mapping;
+		const BYTE*			Data;
+		ImStringMap<const ImagePackEntry*, AllocCategory_Images> Index;
+
+		ImagePack() : File(INVALID_HANDLE_VALUE), Mapping(NULL), Data(NULL) {}
+		~ImagePack();
+		bool Open(const char* path);
+	};
+
+	// Decodes and scales images on background threads so that Render() never waits for WIC.
+	// The render thread requests images or tiles of images, uploads finished decodes (a bounded
+	// number per call) and, once per built frame, cancels the requests that frame did not ask
+	// for anymore and releases the least recently used images over the memory budget.
+	struct ImageLoader
+	{
+		std::atomic<int>	StatPending;
+		std::atomic<int>	StatDecoded;
+		std::atomic<int>	StatReady;
+		std::atomic<int>	StatFailed;
+		std::atomic<int>	StatCancelled;
+		std::atomic<int>	StatEntries;
+		std::atomic<size_t>	StatBytes;
+		std::atomic<int>	StatHits;
+		std::atomic<int>	StatMisses;
+		std::atomic<int>	StatEvicted;
+		std::atomic<int>	Filter;			// ImageFilter of the next decodes
+
+		ImageLoader()
+			: StatPending(0), StatDecoded(0), StatReady(0), StatFailed(0), StatCancelled(0)
+			, StatEntries(0), StatBytes(0), StatHits(0), StatMisses(0), StatEvicted(0), Filter(ImageFilter_Lanczos3)
+			, _pWICFactory(NULL), _frame(1), _quit(false) {}
+
+		~ImageLoader()
 		{
-			pRT->BeginDraw();
-			pRT->Clear();
+			Stop();
+			Clear();
+			for (size_t i = 0; i < _packs.size(); i++)
+				delete _packs[i];
 		}
 
-		void EndDraw(ID2D1RenderTarget* pRT)
+		void AddPack(ImagePack* pack)
 		{
-			pRT->EndDraw();
+			std::lock_guard<std::mutex> lock(_mutex);
+			_packs.push_back(pack);
 		}
 
-		void PushClipRect(ID2D1RenderTarget* pRT, ImFloat4 rt)
+		void Init(IWICImagingFactory* pWICFactory) { _pWICFactory = pWICFactory; }
+
+		// The entry stays valid until the next EndFrame() or Clear(); check its state before drawing.
+		// The keys are built in strings kept by the loader, a request for a cached image does not allocate.
+		ImageEntry* Request(ID2D1RenderTarget* pRT, const char* path, UINT width, UINT height, bool async)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			pRenderTarget->PushAxisAlignedClip(rt.ToD2DRectF(), D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+			_path = path;
+			_key = path;
+			_key += '|';
+			AppendUint(_key, width);
+			_key += 'x';
+			AppendUint(_key, height);
+
+			WICRect clip;
+			memset(&clip, 0, sizeof(clip));
+			return Request(pRT, _path, width, height, clip, -1, 0.0f, (width == 0 && height == 0) ? _path : _key, async);
 		}
 
-		void PopClipRect(ID2D1RenderTarget* pRT)
+		// One tile of the mip pyramid of an image: clip is the part of the source it covers,
+		// width x height the size of the tile at its level.
+		ImageEntry* RequestTile(ID2D1RenderTarget* pRT, const char* path, int level, UINT tx, UINT ty,
+			const WICRect& clip, UINT width, UINT height, float priority, bool async)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			pRenderTarget->PopAxisAlignedClip();
+			_path = path;
+			_key = path;
+			_key += '#';
+			AppendUint(_key, level);
+			_key += '/';
+			AppendUint(_key, tx);
+			_key += '_';
+			AppendUint(_key, ty);
+
+			return Request(pRT, _path, width, height, clip, level, priority, _key, async);
 		}
 
-		void SetPenWidth(float width)
+		// Size of the source image, read by a loader thread the first time it is asked for.
+		// Returns false until it is known, or when the image cannot be read. Any thread.
+		bool GetImageSize(const char* path, UINT* width, UINT* height)
 		{
-			_penWidth = width;
+			std::lock_guard<std::mutex> lock(_mutex);
+			_sizeKey = path;
+			auto iter = _sizes.find(_sizeKey);
+			if (iter == _sizes.end())
+			{
+				_sizes[_sizeKey] = ImageSize();
+				_sizeQueue.push_back(_sizeKey);
+				StartThreads();
+				_wake.notify_one();
+				return false;
+			}
+
+			*width = iter->second.Width;
+			*height = iter->second.Height;
+			return iter->second.Width != 0;
 		}
 
-		void DrawPoint(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2& pt)
+		// Turns at most budget decoded images into bitmaps, returns true when any was uploaded.
+		bool Upload(ID2D1RenderTarget* pRT, int budget)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
-			pRenderTarget->DrawRectangle(D2D1::RectF(pt.x, pt.y, pt.x, pt.y), _pCommonBrush, _penWidth);
+			_uploads.clear();
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				while (!_decoded.empty() && (int)_uploads.size() < budget)
+				{
+					// skips cancelled images and the ones already uploaded by a synchronous request
+					if (!_decoded.front()->Cancelled && _decoded.front()->State == IMAGE_DECODED)
+						_uploads.push_back(_decoded.front());
+					_decoded.pop_front();
+				}
+			}
+
+			for (size_t i = 0; i < _uploads.size(); i++)
+				Upload(pRT, _uploads[i].get());
+
+			const bool uploaded = !_uploads.empty();
+			_uploads.clear();
+			return uploaded;
 		}
 
-		void DrawLine(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2)
+		// The most recently uploaded image of that path at any size, drawn scaled while the
+		// requested size is still loading (e.g. the background while the window is resized).
+		ImageEntry* FindStandIn(const char* path)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
-			pRenderTarget->DrawLine(D2D1::Point2F(pt1.x, pt1.y), D2D1::Point2F(pt2.x, pt2.y), _pCommonBrush, _penWidth);
+			_path = path;
+			auto iter = _standIns.find(_path);
+			if (iter == _standIns.end())
+				return NULL;
+			Touch(iter->second);
+			return iter->second;
 		}
 
-		void DrawRect(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat4 rt, bool isFilled = false)
+		// Cancels the pending images the frame did not request, trims the cache to the budget and
+		// starts the next frame. The images requested by this frame are never released.
+		void EndFrame(size_t budget)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
+			for (auto iter = _lru.begin(); iter != _lru.end();)
+			{
+				ImageEntry* entry = *iter++;
+				if (entry->LastUsedFrame != _frame && (entry->State == IMAGE_QUEUED || entry->State == IMAGE_DECODED))
+					Remove(entry);
+			}
 
-			if (isFilled)
-				pRenderTarget->FillRectangle(rt.ToD2DRectF(), _pCommonBrush);
-			else
-				pRenderTarget->DrawRectangle(rt.ToD2DRectF(), _pCommonBrush, _penWidth);
+			while (StatBytes > budget && !_lru.empty() && _lru.back()->LastUsedFrame != _frame)
+			{
+				Remove(_lru.back());
+				StatEvicted++;
+			}
+			_frame++;
 		}
 
-		void DrawRoundedRect(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat4 rt, float radiusX, float radiusY, bool isFilled = false)
+		void Clear()
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
+			while (!_lru.empty())
+				Remove(_lru.back());
 
-			D2D1_ROUNDED_RECT roundRect = D2D1::RoundedRect(rt.ToD2DRectF(), radiusX, radiusY);
-			if (isFilled)
-				pRenderTarget->FillRoundedRectangle(roundRect, _pCommonBrush);
-			else
-				pRenderTarget->DrawRoundedRectangle(roundRect, _pCommonBrush, _penWidth);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_queue.clear();
+				_decoded.clear();
+			}
+
+			std::lock_guard<std::mutex> lock(_levelMutex);
+			ClearLevels();
 		}
 
-		void DrawEllipse(ID2D1RenderTarget* pRT, ImFloat4 color, float x, float y, float radiusX, float radiusY, bool isFilled = false)
+	private:
+
+		struct ImageSize
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
+			UINT		Width;		// 0 while unknown or when the image could not be read
+			UINT		Height;
 
-			D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(x, y), radiusX, radiusY);
-			if (isFilled)
-				pRenderTarget->FillEllipse(ellipse, _pCommonBrush);
-			else
-				pRenderTarget->DrawEllipse(ellipse, _pCommonBrush, _penWidth);
+			ImageSize() : Width(0), Height(0) {}
+		};
+
+		// _key holds the key of the request, pack_name the name it is looked up with in the packs
+		ImageEntry* Request(ID2D1RenderTarget* pRT, const ImString<AllocCategory_Images>& path, UINT width, UINT height,
+			const WICRect& clip, int level, float priority, const ImString<AllocCategory_Images>& pack_name, bool async)
+		{
+			auto iter = _entries.find(_key);
+			if (iter != _entries.end())
+			{
+				Touch(iter->second.get());
+				iter->second->Priority = priority;
+				StatHits++;
+				return iter->second.get();
+			}
+
+			const BYTE* packed_pixels = NULL;
+			const ImagePackEntry* packed = FindPacked(pack_name, &packed_pixels);
+
+			ImageEntryPtr entry = std::allocate_shared<ImageEntry>(StlAllocator<ImageEntry, AllocCategory_Images>());
+			entry->Key = _key;
+			entry->Path = path;
+			entry->Width = width;
+			entry->Height = height;
+			entry->Clip = clip;
+			entry->Level = level;
+			entry->Priority = priority;
+			entry->LastUsedFrame = _frame;
+			_lru.push_front(entry.get());
+			entry->LruPos = _lru.begin();
+			_entries[_key] = entry;
+			StatEntries++;
+			StatMisses++;
+
+			if (packed)
+			{
+				// nothing to decode, the bitmap is created straight from the mapped pixels
+				entry->Source = packed_pixels;
+				entry->Width = packed->Width;
+				entry->Height = packed->Height;
+				entry->State = IMAGE_DECODED;
+				StatDecoded++;
+				Upload(pRT, entry.get());
+				return entry.get();
+			}
+
+			StatPending++;
+
+			if (!async)
+			{
+				// the old behavior, decode on the render thread
+				const bool decoded = Decode(entry.get());
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					Finish(entry, decoded);
+				}
+				Upload(pRT, entry.get());
+				return entry.get();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_queue.push_back(entry);
+				StartThreads();
+			}
+			_wake.notify_one();
+			return entry.get();
 		}
 
-		void DrawTriangle(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2 &pt1, const ImFloat2 &pt2, const ImFloat2 &pt3, bool isFilled = false)
+		// std::to_string() returns a new string
+		static void AppendUint(ImString<AllocCategory_Images>& str, UINT value)
 		{
-			ImFloat2 arrayPoint[3];
-			arrayPoint[0] = pt1;
-			arrayPoint[1] = pt2;
-			arrayPoint[2] = pt3;
-			DrawPolygon(pRT, color, arrayPoint, 3, isFilled);
+			char buf[16];
+			char* p = buf + sizeof(buf);
+			do
+			{
+				*--p = (char)('0' + value % 10);
+				value /= 10;
+			} while (value != 0);
+			str.append(p, buf + sizeof(buf) - p);
 		}
 
-		void DrawPolygon(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat2* array, ImUint count, bool isFilled = false)
+		// called with _mutex held
+		void StartThreads()
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
+			if (!_threads.empty())
+				return;
 
-			D2D1_POINT_2F* D2DPoints = new D2D1_POINT_2F[count];
-			if (D2DPoints != NULL)
-			{
-				for (ImUint i = 0; i < count; i++)
-					D2DPoints[i] = D2D1::Point2F(array[i].x, array[i].y);
+			int num_threads = (int)std::thread::hardware_concurrency() / 2;
+			num_threads = (num_threads < 1) ? 1 : (num_threads > 4) ? 4 : num_threads;
+			for (int i = 0; i < num_threads; i++)
+				_threads.push_back(std::thread(&ImageLoader::WorkerMain, this));
+		}
 
-				ID2D1PathGeometry* pGeometry = NULL;
-				HRESULT hr = _pD2DFactory->CreatePathGeometry(&pGeometry);
-				if (SUCCEEDED(hr))
+		const ImagePackEntry* FindPacked(const ImString<AllocCategory_Images>& name, const BYTE** out_pixels)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (size_t i = 0; i < _packs.size(); i++)
+			{
+				auto iter = _packs[i]->Index.find(name);
+				if (iter != _packs[i]->Index.end())
 				{
-					ID2D1GeometrySink *pSink = NULL;
-					hr = pGeometry->Open(&pSink);
-					if (SUCCEEDED(hr))
-					{
-						pSink->BeginFigure(D2DPoints[0], D2D1_FIGURE_BEGIN_FILLED);
-						pSink->AddLines(D2DPoints, count);
-						pSink->EndFigure(D2D1_FIGURE_END_CLOSED);
-					}
-					pSink->Close();
+					*out_pixels = _packs[i]->Data + iter->second->Offset;
+					return iter->second;
 				}
-
-				if (isFilled)
-					pRenderTarget->FillGeometry(pGeometry, _pCommonBrush);
-				else
-					pRenderTarget->DrawGeometry(pGeometry, _pCommonBrush, _penWidth);
-
-				SafeRelease(&pGeometry);
-				delete[] D2DPoints;
 			}
+			return NULL;
 		}
 
-		void DrawPolygonalLine(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat2* array, ImUint count)
+		void Touch(ImageEntry* entry)
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
+			entry->LastUsedFrame = _frame;
+			_lru.splice(_lru.begin(), _lru, entry->LruPos);
+		}
 
-			ID2D1PathGeometry* pGeometry = NULL;
-			D2D1_POINT_2F* D2DPoints = new D2D1_POINT_2F[count];
-			if (D2DPoints != NULL)
+		void Remove(ImageEntry* entry)
+		{
 			{
-				for (ImUint i = 0; i < count; i++)
-					D2DPoints[i] = D2D1::Point2F(array[i].x, array[i].y);
+				std::lock_guard<std::mutex> lock(_mutex);
+				Cancel(entry);
+			}
 
-				HRESULT hr = _pD2DFactory->CreatePathGeometry(&pGeometry);
-				if (SUCCEEDED(hr))
+			if (entry->State == IMAGE_READY)
+			{
+				StatReady--;
+				StatBytes -= (size_t)entry->Width * entry->Height * 4;
+				// only the entry that is the stand-in gives it up, to the most recent other size
+				// of the same image still loaded, if any
+				auto iter = _standIns.find(entry->Path);
+				if (iter != _standIns.end() && iter->second == entry)
 				{
-					ID2D1GeometrySink *pSink = NULL;
-					hr = pGeometry->Open(&pSink);
-					if (SUCCEEDED(hr))
+					ImageEntry* next = NULL;
+					for (auto lru = _lru.begin(); lru != _lru.end() && next == NULL; ++lru)
 					{
-						pSink->BeginFigure(D2DPoints[0], D2D1_FIGURE_BEGIN_HOLLOW);
-						pSink->AddLines(D2DPoints, count);
-						pSink->EndFigure(D2D1_FIGURE_END_OPEN);
+						if (*lru != entry && (*lru)->State == IMAGE_READY && (*lru)->Clip.Width == 0 && (*lru)->Path == entry->Path)
+							next = *lru;
 					}
-					pSink->Close();
+					if (next)
+						iter->second = next;
+					else
+						_standIns.erase(iter);
 				}
-
-				pRenderTarget->DrawGeometry(pGeometry, _pCommonBrush, _penWidth);
-
-				SafeRelease(&pGeometry);
-				delete[] D2DPoints;
 			}
+			else if (entry->State == IMAGE_FAILED)
+			{
+				StatFailed--;
+			}
+
+			_lru.erase(entry->LruPos);
+			StatEntries--;
+			_entries.erase(entry->Key);		// last, may destroy the entry
 		}
 
-		void DrawText(ID2D1RenderTarget* pRT, ImFloat4 color, std::string txt, const ImFloat4& rt, TEXT_ALIGNMENT_MODE mode = D2DRender::MODE_CENTER)
+		void Stop()
 		{
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-			_pCommonBrush->SetColor(color.ToD2DColorF());
-
-			switch (mode)
 			{
-			case D2DRender::MODE_LEFT:
-				_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
-				break;
-			case D2DRender::MODE_CENTER:
-				_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
-				break;
-			case D2DRender::MODE_RIGHT:
-				_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING);
-				break;
-			default:
-				break;
+				std::lock_guard<std::mutex> lock(_mutex);
+				_quit = true;
 			}
-
-			pRenderTarget->DrawText(ATOW(txt).c_str(), ATOW(txt).length(), _pTextFormat,rt. ToD2DRectF(), _pCommonBrush);
+			_wake.notify_all();
+			for (size_t i = 0; i < _threads.size(); i++)
+				_threads[i].join();
+			_threads.clear();
+			_quit = false;
 		}
 
-		ImFloat2 GetTextSize(std::string txt)
+		// called with _mutex held
+		void Cancel(ImageEntry* entry)
 		{
-			ImFloat2 size;
-			IDWriteTextLayout* textLayout = NULL;
+			if (entry->Cancelled)
+				return;
+			if (entry->State == IMAGE_QUEUED)
+				StatPending--;
+			else if (entry->State == IMAGE_DECODED)
+				StatDecoded--;
+			else
+				return;
+			entry->Cancelled = true;
+			StatCancelled++;
+		}
 
-			HRESULT hr = _pDWriteFactory->CreateTextLayout(ATOW(txt).c_str(), ATOW(txt).length(), _pTextFormat, 0,	0, &textLayout);
-			if (textLayout != NULL)
+		// called with _mutex held
+		void Finish(const ImageEntryPtr& entry, bool decoded)
+		{
+			if (entry->Cancelled)
+				return;
+			StatPending--;
+			if (decoded)
 			{
-				DWRITE_TEXT_METRICS textMetrics;
-				textLayout->GetMetrics(&textMetrics);
-				size.x = ceil(textMetrics.widthIncludingTrailingWhitespace);
-				size.y = ceil(textMetrics.height);
+				entry->State = IMAGE_DECODED;
+				StatDecoded++;
+				_decoded.push_back(entry);
+			}
+			else
+			{
+				entry->State = IMAGE_FAILED;
+				StatFailed++;
+				OutWarning("ImDui: failed to load image %s", entry->Path.c_str());
 			}
-			SafeRelease(&textLayout);
-			return size;
 		}
 
-		void DrawImage(ID2D1RenderTarget* pRT, std::string image, float x = 0, float y = 0, float w = 0, float h = 0)
+		void Upload(ID2D1RenderTarget* pRT, ImageEntry* entry)
 		{
-			// find image object
-			assert(!image.empty());
-			ID2D1Bitmap* pBitmap = NULL;
-
-			auto iter = _mapBitmaps.find(image);
-			if (iter == _mapBitmaps.end())
+			if (entry->State != IMAGE_DECODED)
+				return;
+
+			HRESULT hr = pRT->CreateBitmap(
+				D2D1::SizeU(entry->Width, entry->Height),
+				entry->Source ? entry->Source : entry->Pixels.data(),
+				entry->Width * 4,
+				D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED)),
+				&entry->Bitmap);
+
+			ImVector<BYTE, AllocCategory_Images>().swap(entry->Pixels);
+			entry->State = SUCCEEDED(hr) ? IMAGE_READY : IMAGE_FAILED;
+			StatDecoded--;
+			if (SUCCEEDED(hr))
 			{
-				_mapBitmaps[image] = LoadImage(image, w, h);
-				assert(_mapBitmaps[image] != NULL);
-			}				
-
-			pBitmap = _mapBitmaps[image];
-
-			// draw image object
-			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
-
-			if (w == 0 || h == 0)
+				StatReady++;
+				StatBytes += (size_t)entry->Width * entry->Height * 4;
+				if (entry->Clip.Width == 0)
+					_standIns[entry->Path] = entry;
+			}
+			else
 			{
-				w = pBitmap->GetSize().width;
-				h = pBitmap->GetSize().height;
+				StatFailed++;
 			}
-			pRenderTarget->DrawBitmap(pBitmap, D2D1::RectF(x, y, x + w, y + h));
 		}
 
-		ID2D1Bitmap* LoadImage(std::string image, UINT width, UINT height)
+		void WorkerMain()
 		{
-			ID2D1Bitmap* pBitmap = nullptr;
-			IWICBitmapDecoder *pDecoder = nullptr;
-			IWICBitmapFrameDecode *pSource = nullptr;
-			IWICStream *pStream = nullptr;
-			IWICFormatConverter *pConverter = nullptr;
-			IWICBitmapScaler *pScaler = nullptr;
+			CoInitializeEx(NULL, COINIT_MULTITHREADED);
+			for (;;)
+			{
+				ImageEntryPtr entry;
+				ImString<AllocCategory_Images> size_path;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_wake.wait(lock, [this] { return _quit || !_queue.empty() || !_sizeQueue.empty(); });
+					if (_quit)
+						break;
 
-			HRESULT hr = _pWICFactory->CreateDecoderFromFilename(
-				ATOW(image).c_str(),
+					if (!_sizeQueue.empty())
+					{
+						size_path = _sizeQueue.front();
+						_sizeQueue.pop_front();
+					}
+					else
+					{
+						auto next = _queue.begin();
+						for (auto iter = _queue.begin(); iter != _queue.end(); ++iter)
+							if ((*iter)->Priority < (*next)->Priority)
+								next = iter;
+						entry = *next;
+						_queue.erase(next);
+					}
+				}
+
+				if (!size_path.empty())
+				{
+					ImageSize size;
+					ReadSize(size_path, &size);
+					std::lock_guard<std::mutex> lock(_mutex);
+					_sizes[size_path] = size;
+					continue;
+				}
+
+				if (entry->Cancelled)
+					continue;
+
+				const bool decoded = Decode(entry.get());
+
+				std::lock_guard<std::mutex> lock(_mutex);
+				Finish(entry, decoded);
+			}
+			CoUninitialize();
+		}
+
+		// Decodes the image into entry->Pixels, scaled to the requested size. Unless the WIC
+		// scaler is selected, the decoded pixels are scaled and premultiplied by ResampleImage().
+		bool Decode(ImageEntry* entry)
+		{
+			if (entry->Level > 0 && DecodeTileFromLevel(entry))
+				return true;
+
+			UINT width = entry->Width;
+			UINT height = entry->Height;
+			UINT srcWidth = 0, srcHeight = 0, srcBpp = 4;
+			int filter = Filter;
+			bool resample = false;
+			IWICBitmapSource* pDecoded = nullptr;	// BGR or BGRA source of the resampler
+
+			IWICBitmapDecoder *pDecoder = nullptr;
+			IWICBitmapFrameDecode *pFrame = nullptr;
+			IWICBitmapClipper *pClipper = nullptr;
+			IWICFormatConverter *pConverter = nullptr;
+			IWICBitmapScaler *pScaler = nullptr;
+
+			FrameArenaScope scope;
+			UINT32 path_length;
+			HRESULT hr = _pWICFactory->CreateDecoderFromFilename(
+				FrameATOW(entry->Path.c_str(), &path_length),
 				nullptr,
 				GENERIC_READ,
 				WICDecodeMetadataCacheOnLoad,
 				&pDecoder);
 
 			if (SUCCEEDED(hr))
-				hr = pDecoder->GetFrame(0, &pSource);
+				hr = pDecoder->GetFrame(0, &pFrame);
+
+			// tiles only decode their part of the source
+			IWICBitmapSource* pSource = pFrame;
+			if (SUCCEEDED(hr) && entry->Clip.Width > 0)
+			{
+				hr = _pWICFactory->CreateBitmapClipper(&pClipper);
+				if (SUCCEEDED(hr))
+					hr = pClipper->Initialize(pFrame, &entry->Clip);
+				pSource = pClipper;
+			}
 
 			if (SUCCEEDED(hr))
 				hr = _pWICFactory->CreateFormatConverter(&pConverter);
@@ -580,11 +1711,42 @@ namespace ImDui
 							height = static_cast<UINT>(scalar * static_cast<FLOAT>(originalHeight));
 						}
 
-						hr = _pWICFactory->CreateBitmapScaler(&pScaler);
-						if (SUCCEEDED(hr))
-							hr = pScaler->Initialize(pSource, width, height, WICBitmapInterpolationModeCubic);
-						if (SUCCEEDED(hr))
-							hr = pConverter->Initialize(pScaler, GUID_WICPixelFormat32bppPBGRA, 
+						// Fant and box average all the source pixels, tiles of the coarse levels shrink a lot
+						IWICBitmapSource* pScaled = pSource;
+						if ((width != originalWidth || height != originalHeight) && filter == ImageFilter_WIC)
+						{
+							hr = _pWICFactory->CreateBitmapScaler(&pScaler);
+							if (SUCCEEDED(hr))
+								hr = pScaler->Initialize(pSource, width, height, entry->Clip.Width > 0 ? WICBitmapInterpolationModeFant : WICBitmapInterpolationModeCubic);
+							pScaled = pScaler;
+						}
+						else if (width != originalWidth || height != originalHeight)
+						{
+							resample = true;
+							srcWidth = originalWidth;
+							srcHeight = originalHeight;
+							if (entry->Clip.Width > 0)
+								filter = ImageFilter_Box;
+						}
+
+						// the resampler reads BGR and BGRA itself, other formats are converted to BGRA
+						WICPixelFormatGUID format;
+						if (SUCCEEDED(hr) && resample)
+							hr = pSource->GetPixelFormat(&format);
+						if (SUCCEEDED(hr) && resample)
+						{
+							pDecoded = pSource;
+							if (IsEqualGUID(format, GUID_WICPixelFormat24bppBGR))
+								srcBpp = 3;
+							else if (!IsEqualGUID(format, GUID_WICPixelFormat32bppBGRA))
+							{
+								hr = pConverter->Initialize(pSource, GUID_WICPixelFormat32bppBGRA,
+									WICBitmapDitherTypeNone, nullptr, 0.f, WICBitmapPaletteTypeMedianCut);
+								pDecoded = pConverter;
+							}
+						}
+						else if (SUCCEEDED(hr))
+							hr = pConverter->Initialize(pScaled, GUID_WICPixelFormat32bppPBGRA, 
 								WICBitmapDitherTypeNone, nullptr, 0.f, WICBitmapPaletteTypeMedianCut);
 					}
 				}
@@ -600,193 +1762,2523 @@ namespace ImDui
 				}
 			}
 
-			if (SUCCEEDED(hr))
-				hr = _pMainRT->CreateBitmapFromWicBitmap(pConverter, nullptr, &pBitmap);
+			if (SUCCEEDED(hr) && resample)
+			{
+				ImVector<BYTE, AllocCategory_Images> pixels(srcWidth * srcHeight * srcBpp);
+				hr = pDecoded->CopyPixels(NULL, srcWidth * srcBpp, (UINT)pixels.size(), pixels.data());
+				if (SUCCEEDED(hr))
+				{
+					// on this thread, the other image threads decode the other images
+					entry->Pixels.resize(width * height * 4);
+					ResampleImage(pixels.data(), srcWidth, srcHeight, srcWidth * srcBpp, srcBpp,
+						entry->Pixels.data(), width, height, width * 4, (ImageFilter)filter, 1);
+				}
+			}
+			else
+			{
+				if (SUCCEEDED(hr))
+					hr = pConverter->GetSize(&width, &height);
+
+				if (SUCCEEDED(hr))
+				{
+					entry->Pixels.resize(width * height * 4);
+					hr = pConverter->CopyPixels(NULL, width * 4, (UINT)entry->Pixels.size(), entry->Pixels.data());
+				}
+			}
+
+			if (SUCCEEDED(hr))
+			{
+				entry->Width = width;
+				entry->Height = height;
+			}
+			else
+			{
+				ImVector<BYTE, AllocCategory_Images>().swap(entry->Pixels);
+			}
+
+			SafeRelease(&pDecoder);
+			SafeRelease(&pFrame);
+			SafeRelease(&pClipper);
+			SafeRelease(&pConverter);
+			SafeRelease(&pScaler);
+
+			return SUCCEEDED(hr);
+		}
+
+		// A tile of a coarse level is cut from the whole level, decoded once for all its tiles:
+		// halved from the next finer level when that one is decoded already, else scaled from
+		// the source by the WIC Fant scaler. Decoding each tile from the source would read the
+		// whole image again for every tile of the coarse levels. Only the levels of the image
+		// last asked for are kept. False when the level is too large to keep, the tile is then
+		// decoded from its part of the source.
+		bool DecodeTileFromLevel(ImageEntry* entry)
+		{
+			UINT width, height;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				auto iter = _sizes.find(entry->Path);
+				if (iter == _sizes.end() || iter->second.Width == 0)
+					return false;
+				width = iter->second.Width;
+				height = iter->second.Height;
+			}
+
+			const int level = entry->Level;
+			const UINT round = (1 << level) - 1;
+			const UINT level_width = (width + round) >> level;
+			const UINT level_height = (height + round) >> level;
+			if (level >= IMAGE_MAX_LEVELS || (ULONGLONG)level_width * level_height > IMAGE_LEVEL_MAX_PIXELS)
+				return false;
+
+			std::lock_guard<std::mutex> lock(_levelMutex);
+			if (_levelPath != entry->Path)
+			{
+				ClearLevels();
+				_levelPath = entry->Path;
+			}
+
+			ImVector<BYTE, AllocCategory_Images>& pixels = _levels[level];
+			if (pixels.empty())
+			{
+				const ImVector<BYTE, AllocCategory_Images>& finer = _levels[level - 1];
+				if (!finer.empty())
+				{
+					pixels.resize(level_width * level_height * 4);
+					HalveLevel(finer.data(), (width + (round >> 1)) >> (level - 1), (height + (round >> 1)) >> (level - 1), pixels.data(), level_width, level_height);
+				}
+				else if (!DecodeLevel(entry->Path, level_width, level_height, pixels))
+				{
+					ImVector<BYTE, AllocCategory_Images>().swap(pixels);
+					return false;
+				}
+			}
+
+			// tiles start on multiples of IMAGE_TILE_SIZE of their level
+			const UINT x0 = entry->Clip.X >> level;
+			const UINT y0 = entry->Clip.Y >> level;
+			entry->Pixels.resize(entry->Width * entry->Height * 4);
+			for (UINT y = 0; y < entry->Height; y++)
+				memcpy(&entry->Pixels[y * entry->Width * 4], &pixels[((y0 + y) * level_width + x0) * 4], entry->Width * 4);
+			return true;
+		}
+
+		// the whole source scaled to width x height, 32bpp PBGRA
+		bool DecodeLevel(const ImString<AllocCategory_Images>& path, UINT width, UINT height, ImVector<BYTE, AllocCategory_Images>& pixels)
+		{
+			IWICBitmapDecoder *pDecoder = nullptr;
+			IWICBitmapFrameDecode *pFrame = nullptr;
+			IWICBitmapScaler *pScaler = nullptr;
+			IWICFormatConverter *pConverter = nullptr;
+
+			FrameArenaScope scope;
+			UINT32 path_length;
+			HRESULT hr = _pWICFactory->CreateDecoderFromFilename(FrameATOW(path.c_str(), &path_length), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &pDecoder);
+			if (SUCCEEDED(hr))
+				hr = pDecoder->GetFrame(0, &pFrame);
+			if (SUCCEEDED(hr))
+				hr = _pWICFactory->CreateBitmapScaler(&pScaler);
+			if (SUCCEEDED(hr))
+				hr = pScaler->Initialize(pFrame, width, height, WICBitmapInterpolationModeFant);
+			if (SUCCEEDED(hr))
+				hr = _pWICFactory->CreateFormatConverter(&pConverter);
+			if (SUCCEEDED(hr))
+				hr = pConverter->Initialize(pScaler, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0.f, WICBitmapPaletteTypeMedianCut);
+			if (SUCCEEDED(hr))
+			{
+				pixels.resize(width * height * 4);
+				hr = pConverter->CopyPixels(NULL, width * 4, (UINT)pixels.size(), pixels.data());
+			}
+
+			SafeRelease(&pDecoder);
+			SafeRelease(&pFrame);
+			SafeRelease(&pScaler);
+			SafeRelease(&pConverter);
+			return SUCCEEDED(hr);
+		}
+
+		// 2x2 box filter of premultiplied pixels, the last row and column of an odd size alone
+		static void HalveLevel(const BYTE* src, UINT src_width, UINT src_height, BYTE* dst, UINT width, UINT height)
+		{
+			for (UINT y = 0; y < height; y++)
+			{
+				const BYTE* row0 = src + (y * 2) * src_width * 4;
+				const BYTE* row1 = (y * 2 + 1 < src_height) ? row0 + src_width * 4 : row0;
+				for (UINT x = 0; x < width; x++)
+				{
+					const UINT x0 = x * 2 * 4;
+					const UINT x1 = (x * 2 + 1 < src_width) ? x0 + 4 : x0;
+					for (int c = 0; c < 4; c++)
+						dst[(y * width + x) * 4 + c] = (BYTE)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+				}
+			}
+		}
+
+		// with _levelMutex held
+		void ClearLevels()
+		{
+			for (int i = 0; i < IMAGE_MAX_LEVELS; i++)
+				ImVector<BYTE, AllocCategory_Images>().swap(_levels[i]);
+			_levelPath.clear();
+		}
+
+		void ReadSize(const ImString<AllocCategory_Images>& path, ImageSize* size)
+		{
+			IWICBitmapDecoder *pDecoder = nullptr;
+			IWICBitmapFrameDecode *pFrame = nullptr;
+
+			FrameArenaScope scope;
+			UINT32 path_length;
+			HRESULT hr = _pWICFactory->CreateDecoderFromFilename(FrameATOW(path.c_str(), &path_length), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &pDecoder);
+			if (SUCCEEDED(hr))
+				hr = pDecoder->GetFrame(0, &pFrame);
+			if (SUCCEEDED(hr))
+				hr = pFrame->GetSize(&size->Width, &size->Height);
+			if (FAILED(hr))
+			{
+				size->Width = size->Height = 0;
+				OutWarning("ImDui: failed to read image %s", path.c_str());
+			}
+
+			SafeRelease(&pDecoder);
+			SafeRelease(&pFrame);
+		}
+
+		IWICImagingFactory*			_pWICFactory;
+		ImStringMap<ImageEntryPtr, AllocCategory_Images> _entries;	// render thread only, like everything up to _frame
+		ImStringMap<ImageEntry*, AllocCategory_Images> _standIns;	// by path
+		ImList<ImageEntry*, AllocCategory_Images> _lru;				// most recently requested first
+		ImString<AllocCategory_Images> _key;
+		ImString<AllocCategory_Images> _path;
+		ImVector<ImageEntryPtr, AllocCategory_Images> _uploads;
+		ImUint						_frame;
+
+		ImVector<std::thread, AllocCategory_Images> _threads;
+		std::mutex					_mutex;
+		std::condition_variable		_wake;
+		ImDeque<ImageEntryPtr, AllocCategory_Images> _queue;
+		ImDeque<ImageEntryPtr, AllocCategory_Images> _decoded;
+		ImVector<ImagePack*, AllocCategory_Images> _packs;
+		ImStringMap<ImageSize, AllocCategory_Images> _sizes;
+		ImString<AllocCategory_Images> _sizeKey;	// with _mutex held
+		ImDeque<ImString<AllocCategory_Images>, AllocCategory_Images> _sizeQueue;
+		bool						_quit;
+
+		enum { IMAGE_MAX_LEVELS = 16, IMAGE_LEVEL_MAX_PIXELS = 4096 * 4096 };
+
+		std::mutex					_levelMutex;
+		ImString<AllocCategory_Images> _levelPath;		// of the levels kept, with _levelMutex held
+		ImVector<BYTE, AllocCategory_Images> _levels[IMAGE_MAX_LEVELS];	// 32bpp PBGRA, empty until decoded
+	};
+
+	struct D2DRender : HeapObject<AllocCategory_Context>
+	{
+		D2DRender()
+		{
+			_penWidth		= s_ctx->Styles.StrokeWidth;
+			_pD2DFactory	= NULL;
+			_pDWriteFactory	= NULL;
+			_pWICFactory	= NULL;
+			_pMainRT		= NULL;
+			_pCommonBrush	= NULL;
+			_lineHeight		= 0;
+			memset(_pTextFormat, 0, sizeof(_pTextFormat));
+		}
+
+		~D2DRender()
+		{
+			for (auto it = _heatmaps.begin(); it != _heatmaps.end(); ++it)
+				SafeRelease(&it->second);
+			SafeRelease(&_pCommonBrush);
+			for (int i = 0; i < ARRAYSIZE(_pTextFormat); i++)
+				SafeRelease(&_pTextFormat[i]);
+		}
+
+		bool Init(ID2D1Factory* pD2DFactory, IDWriteFactory* pDWriteFactory, IWICImagingFactory* pWICFactory, ID2D1HwndRenderTarget* pMainRT)
+		{
+			_pD2DFactory = pD2DFactory;
+			_pDWriteFactory = pDWriteFactory;
+			_pWICFactory = pWICFactory;
+			_pMainRT = pMainRT;
+			_images.Init(pWICFactory);
+
+			_pMainRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+
+			// one immutable text format per alignment, so that text can be measured on the UI
+			// thread while another thread is drawing
+			static const DWRITE_TEXT_ALIGNMENT sc_alignments[3] = { DWRITE_TEXT_ALIGNMENT_LEADING, DWRITE_TEXT_ALIGNMENT_CENTER, DWRITE_TEXT_ALIGNMENT_TRAILING };
+
+			HRESULT hr = S_OK;
+			for (int i = 0; i < ARRAYSIZE(_pTextFormat) && SUCCEEDED(hr); i++)
+			{
+				hr = _pDWriteFactory->CreateTextFormat(
+					s_ctx->Styles.FontName,
+					NULL,
+					DWRITE_FONT_WEIGHT_REGULAR,
+					DWRITE_FONT_STYLE_NORMAL,
+					DWRITE_FONT_STRETCH_NORMAL,
+					s_ctx->Styles.FontSize,
+					L"en-us",
+					&_pTextFormat[i]);
+
+				if (SUCCEEDED(hr))
+				{
+					_pTextFormat[i]->SetTextAlignment(sc_alignments[i]);
+					_pTextFormat[i]->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
+					_pTextFormat[i]->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
+				}
+			}
+
+			if (SUCCEEDED(hr))
+				hr = _pMainRT->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Orange), &_pCommonBrush);
+
+			if (SUCCEEDED(hr))
+				_lineHeight = GetTextSize("").y;
+
+			return false;
+		}
+
+		void Resize(float w, float h) { _pMainRT->Resize(D2D1::SizeU(w, h)); }
+
+		ID2D1RenderTarget* GetMainRT() { return _pMainRT; }
+
+		ID2D1RenderTarget* ChooseRT(ID2D1RenderTarget* pRT) { return pRT == NULL ? _pMainRT : pRT; }
+
+		void BeginDraw(ID2D1RenderTarget* pRT)
+		{
+			pRT->BeginDraw();
+			pRT->Clear();
+		}
+
+		void EndDraw(ID2D1RenderTarget* pRT)
+		{
+			pRT->EndDraw();
+		}
+
+		void PushClipRect(ID2D1RenderTarget* pRT, ImFloat4 rt)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			pRenderTarget->PushAxisAlignedClip(rt.ToD2DRectF(), D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+		}
+
+		void PopClipRect(ID2D1RenderTarget* pRT)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			pRenderTarget->PopAxisAlignedClip();
+		}
+
+		void SetPenWidth(float width)
+		{
+			_penWidth = width;
+		}
+
+		// of the frame being drawn, for images not ready yet
+		void SetPlaceholderColor(const ImFloat4& color)
+		{
+			_placeholderColor = color;
+		}
+
+		void DrawPoint(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2& pt)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+			pRenderTarget->DrawRectangle(D2D1::RectF(pt.x, pt.y, pt.x, pt.y), _pCommonBrush, _penWidth);
+		}
+
+		void DrawLine(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+			pRenderTarget->DrawLine(D2D1::Point2F(pt1.x, pt1.y), D2D1::Point2F(pt2.x, pt2.y), _pCommonBrush, _penWidth);
+		}
+
+		void DrawRect(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat4 rt, bool isFilled = false)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			if (isFilled)
+				pRenderTarget->FillRectangle(rt.ToD2DRectF(), _pCommonBrush);
+			else
+				pRenderTarget->DrawRectangle(rt.ToD2DRectF(), _pCommonBrush, _penWidth);
+		}
+
+		void DrawRoundedRect(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat4 rt, float radiusX, float radiusY, bool isFilled = false)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			D2D1_ROUNDED_RECT roundRect = D2D1::RoundedRect(rt.ToD2DRectF(), radiusX, radiusY);
+			if (isFilled)
+				pRenderTarget->FillRoundedRectangle(roundRect, _pCommonBrush);
+			else
+				pRenderTarget->DrawRoundedRectangle(roundRect, _pCommonBrush, _penWidth);
+		}
+
+		void DrawEllipse(ID2D1RenderTarget* pRT, ImFloat4 color, float x, float y, float radiusX, float radiusY, bool isFilled = false)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			D2D1_ELLIPSE ellipse = D2D1::Ellipse(D2D1::Point2F(x, y), radiusX, radiusY);
+			if (isFilled)
+				pRenderTarget->FillEllipse(ellipse, _pCommonBrush);
+			else
+				pRenderTarget->DrawEllipse(ellipse, _pCommonBrush, _penWidth);
+		}
+
+		void DrawTriangle(ID2D1RenderTarget* pRT, ImFloat4 color, const ImFloat2 &pt1, const ImFloat2 &pt2, const ImFloat2 &pt3, bool isFilled = false)
+		{
+			ImFloat2 arrayPoint[3];
+			arrayPoint[0] = pt1;
+			arrayPoint[1] = pt2;
+			arrayPoint[2] = pt3;
+			DrawPolygon(pRT, color, arrayPoint, 3, isFilled);
+		}
+
+		void DrawPolygon(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat2* array, ImUint count, bool isFilled = false)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			FrameArenaScope scope;
+			D2D1_POINT_2F* D2DPoints = s_frameArena.Alloc<D2D1_POINT_2F>(count);
+			if (D2DPoints != NULL)
+			{
+				for (ImUint i = 0; i < count; i++)
+					D2DPoints[i] = D2D1::Point2F(array[i].x, array[i].y);
+
+				ID2D1PathGeometry* pGeometry = NULL;
+				HRESULT hr = _pD2DFactory->CreatePathGeometry(&pGeometry);
+				if (SUCCEEDED(hr))
+				{
+					ID2D1GeometrySink *pSink = NULL;
+					hr = pGeometry->Open(&pSink);
+					if (SUCCEEDED(hr))
+					{
+						pSink->BeginFigure(D2DPoints[0], D2D1_FIGURE_BEGIN_FILLED);
+						pSink->AddLines(D2DPoints, count);
+						pSink->EndFigure(D2D1_FIGURE_END_CLOSED);
+					}
+					pSink->Close();
+				}
+
+				if (isFilled)
+					pRenderTarget->FillGeometry(pGeometry, _pCommonBrush);
+				else
+					pRenderTarget->DrawGeometry(pGeometry, _pCommonBrush, _penWidth);
+
+				SafeRelease(&pGeometry);
+			}
+		}
+
+		void DrawPolygonalLine(ID2D1RenderTarget* pRT, ImFloat4 color, ImFloat2* array, ImUint count)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			ID2D1PathGeometry* pGeometry = NULL;
+			FrameArenaScope scope;
+			D2D1_POINT_2F* D2DPoints = s_frameArena.Alloc<D2D1_POINT_2F>(count);
+			if (D2DPoints != NULL)
+			{
+				for (ImUint i = 0; i < count; i++)
+					D2DPoints[i] = D2D1::Point2F(array[i].x, array[i].y);
+
+				HRESULT hr = _pD2DFactory->CreatePathGeometry(&pGeometry);
+				if (SUCCEEDED(hr))
+				{
+					ID2D1GeometrySink *pSink = NULL;
+					hr = pGeometry->Open(&pSink);
+					if (SUCCEEDED(hr))
+					{
+						pSink->BeginFigure(D2DPoints[0], D2D1_FIGURE_BEGIN_HOLLOW);
+						pSink->AddLines(D2DPoints, count);
+						pSink->EndFigure(D2D1_FIGURE_END_OPEN);
+					}
+					pSink->Close();
+				}
+
+				pRenderTarget->DrawGeometry(pGeometry, _pCommonBrush, _penWidth);
+
+				SafeRelease(&pGeometry);
+			}
+		}
+
+		void DrawText(ID2D1RenderTarget* pRT, ImFloat4 color, const char* txt, const ImFloat4& rt, TEXT_ALIGNMENT_MODE mode = MODE_CENTER)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+			_pCommonBrush->SetColor(color.ToD2DColorF());
+
+			FrameArenaScope scope;
+			UINT32 length;
+			const WCHAR* wtxt = FrameATOW(txt, &length);
+			pRenderTarget->DrawText(wtxt, length, _pTextFormat[mode], rt.ToD2DRectF(), _pCommonBrush);
+		}
+
+		ImFloat2 GetTextSize(const char* txt)
+		{
+			ImFloat2 size;
+			IDWriteTextLayout* textLayout = NULL;
+
+			FrameArenaScope scope;
+			UINT32 length;
+			const WCHAR* wtxt = FrameATOW(txt, &length);
+			HRESULT hr = _pDWriteFactory->CreateTextLayout(wtxt, length, _pTextFormat[MODE_CENTER], 0,	0, &textLayout);
+			if (textLayout != NULL)
+			{
+				DWRITE_TEXT_METRICS textMetrics;
+				textLayout->GetMetrics(&textMetrics);
+				size.x = ceil(textMetrics.widthIncludingTrailingWhitespace);
+				size.y = ceil(textMetrics.height);
+			}
+			SafeRelease(&textLayout);
+			return size;
+		}
+
+		// height of one line of text, measured once so that culled widgets need no text layout
+		float GetLineHeight() const { return _lineHeight; }
+
+		// cmd_times, when not NULL, receives the ms each command took to issue
+		void Execute(ID2D1RenderTarget* pRT, const DrawCmdList& list, float* cmd_times = NULL)
+		{
+			LONGLONG last = (cmd_times != NULL) ? GetTicks() : 0;
+			for (size_t i = 0; i < list.Cmds.size(); i++)
+			{
+				const DrawCmd& cmd = list.Cmds[i];
+				switch (cmd.Type)
+				{
+				case DrawCmd_Line:
+					DrawLine(pRT, cmd.Color, list.Points[cmd.Offset], list.Points[cmd.Offset + 1]);
+					break;
+				case DrawCmd_Rect:
+					if (cmd.Aliased)
+					{
+						D2D1_ANTIALIAS_MODE old_mode = pRT->GetAntialiasMode();
+						pRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+						DrawRect(pRT, cmd.Color, cmd.Rect, cmd.Filled);
+						pRT->SetAntialiasMode(old_mode);
+					}
+					else
+					{
+						DrawRect(pRT, cmd.Color, cmd.Rect, cmd.Filled);
+					}
+					break;
+				case DrawCmd_RoundedRect:
+					DrawRoundedRect(pRT, cmd.Color, cmd.Rect, cmd.Radius.x, cmd.Radius.y, cmd.Filled);
+					break;
+				case DrawCmd_Ellipse:
+					DrawEllipse(pRT, cmd.Color, cmd.Rect.x, cmd.Rect.y, cmd.Radius.x, cmd.Radius.y, cmd.Filled);
+					break;
+				case DrawCmd_Polygon:
+					DrawPolygon(pRT, cmd.Color, const_cast<ImFloat2*>(&list.Points[cmd.Offset]), cmd.Count, cmd.Filled);
+					break;
+				case DrawCmd_PolygonalLine:
+					DrawPolygonalLine(pRT, cmd.Color, const_cast<ImFloat2*>(&list.Points[cmd.Offset]), cmd.Count);
+					break;
+				case DrawCmd_Text:
+					DrawText(pRT, cmd.Color, &list.TextBuffer[cmd.Offset], cmd.Rect, cmd.Align);
+					break;
+				case DrawCmd_Image:
+					DrawImage(pRT, &list.TextBuffer[cmd.Offset], cmd.Rect.x, cmd.Rect.y, cmd.Rect.z, cmd.Rect.w);
+					break;
+				case DrawCmd_ImageView:
+					DrawImageView(pRT, &list.TextBuffer[cmd.Offset], cmd.Rect, list.Points[cmd.Count], list.Points[cmd.Count + 1].x);
+					break;
+				case DrawCmd_Heatmap:
+					DrawHeatmap(pRT, cmd.Count, cmd.Rect);
+					break;
+				case DrawCmd_PushClip:
+					PushClipRect(pRT, cmd.Rect);
+					break;
+				case DrawCmd_PopClip:
+					PopClipRect(pRT);
+					break;
+				}
+
+				if (cmd_times != NULL)
+				{
+					const LONGLONG now = GetTicks();
+					cmd_times[i] = TicksToMs(now - last);
+					last = now;
+				}
+			}
+		}
+
+		// Replay the recorded commands of a window into its offscreen surface,
+		// (re)creating the surface when the window has been resized.
+		void DrawWindow(Window* window, const DrawCmdList& list, const ImFloat4& rect, float* cmd_times = NULL)
+		{
+			if (window->CRT == NULL || window->CRT->GetSize().width != rect.z || window->CRT->GetSize().height != rect.w)
+				window->Resize(ImFloat2(rect.z, rect.w));
+
+			BeginDraw(window->CRT);
+			Execute(window->CRT, list, cmd_times);
+			EndDraw(window->CRT);
+		}
+
+		// Draws the image once it has been loaded, a placeholder until then. A zero w or h keeps
+		// the aspect ratio of the image, both zero draw it at its natural size.
+		void DrawImage(ID2D1RenderTarget* pRT, const char* image, float x = 0, float y = 0, float w = 0, float h = 0)
+		{
+			assert(image[0] != '\0');
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+
+			ImageEntry* entry = _images.Request(_pMainRT, image, (UINT)w, (UINT)h, s_ctx->ImageAsync);
+			if (entry->State == IMAGE_READY)
+			{
+				if (w == 0 || h == 0)
+				{
+					w = entry->Bitmap->GetSize().width;
+					h = entry->Bitmap->GetSize().height;
+				}
+				pRenderTarget->DrawBitmap(entry->Bitmap, D2D1::RectF(x, y, x + w, y + h));
+			}
+			else if (w > 0 && h > 0)
+			{
+				ImageEntry* stand_in = _images.FindStandIn(image);
+				if (stand_in)
+					pRenderTarget->DrawBitmap(stand_in->Bitmap, D2D1::RectF(x, y, x + w, y + h));
+				else
+					DrawRect(pRenderTarget, _placeholderColor, ImFloat4(x, y, w, h), true);
+			}
+		}
+
+		// Draws the part of an image seen through rt, centered on center (source pixels) and scaled
+		// by zoom (screen pixels per source pixel), from the tiles of the matching mip level.
+		void DrawImageView(ID2D1RenderTarget* pRT, const char* image, const ImFloat4& rt, const ImFloat2& center, float zoom)
+		{
+			ID2D1RenderTarget* pRenderTarget = ChooseRT(pRT);
+
+			UINT width, height;
+			if (zoom <= 0.0f || !_images.GetImageSize(image, &width, &height))
+			{
+				DrawRect(pRenderTarget, _placeholderColor, rt, true);
+				return;
+			}
+
+			// the coarsest level fits in one tile, the level drawn has about one pixel per screen pixel
+			int max_level = 0;
+			while (((width > height ? width : height) >> max_level) > IMAGE_TILE_SIZE)
+				max_level++;
+			int level = 0;
+			while (level < max_level && zoom * (float)(2 << level) <= 1.0f)
+				level++;
+
+			const float tile_src = (float)(IMAGE_TILE_SIZE << level);		// source pixels per tile
+			const ImFloat2 view_min(center.x - rt.z * 0.5f / zoom, center.y - rt.w * 0.5f / zoom);
+			const ImFloat2 view_max(center.x + rt.z * 0.5f / zoom, center.y + rt.w * 0.5f / zoom);
+			const int tx0 = (int)std::max(0.0f, floorf(view_min.x / tile_src));
+			const int ty0 = (int)std::max(0.0f, floorf(view_min.y / tile_src));
+			const int tx1 = (int)std::min(ceilf(width / tile_src), ceilf(view_max.x / tile_src));
+			const int ty1 = (int)std::min(ceilf(height / tile_src), ceilf(view_max.y / tile_src));
+
+			PushClipRect(pRenderTarget, rt);
+			for (int ty = ty0; ty < ty1; ty++)
+			{
+				for (int tx = tx0; tx < tx1; tx++)
+				{
+					// the tiles closest to the center of the view are decoded first
+					const float dx = (tx + 0.5f) * tile_src - center.x;
+					const float dy = (ty + 0.5f) * tile_src - center.y;
+					const float priority = sqrtf(dx * dx + dy * dy) / tile_src;
+
+					DrawTile(pRenderTarget, image, width, height, level, max_level, tx, ty, priority, rt, center, zoom);
+				}
+			}
+			PopClipRect(pRenderTarget);
+		}
+
+		// Copies the pixels changed by Heatmap() into the bitmap of the heatmap and draws it.
+		void DrawHeatmap(ID2D1RenderTarget* pRT, ImUint id, const ImFloat4& rt)
+		{
+			HeatmapData* data = NULL;
+			{
+				std::lock_guard<std::mutex> lock(s_ctx->HeatmapMutex);
+				auto it = s_ctx->Heatmaps.find(id);
+				if (it != s_ctx->Heatmaps.end())
+					data = it->second;
+			}
+			if (data == NULL)
+				return;
+
+			ID2D1Bitmap*& bitmap = _heatmaps[id];
+			std::lock_guard<std::mutex> lock(data->Mutex);
+			if (bitmap != NULL && (bitmap->GetPixelSize().width != (UINT32)data->Width || bitmap->GetPixelSize().height != (UINT32)data->Height))
+				SafeRelease(&bitmap);
+
+			if (bitmap == NULL)
+			{
+				_pMainRT->CreateBitmap(
+					D2D1::SizeU(data->Width, data->Height),
+					data->Pixels.data(),
+					data->Width * 4,
+					D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED)),
+					&bitmap);
+			}
+			else if (data->IsDirty())
+			{
+				const D2D1_RECT_U dirty = D2D1::RectU(data->DirtyX0, data->DirtyY0, data->DirtyX1, data->DirtyY1);
+				bitmap->CopyFromMemory(&dirty, &data->Pixels[data->DirtyY0 * data->Width + data->DirtyX0], data->Width * 4);
+			}
+			data->ClearDirty();
+
+			if (bitmap != NULL)
+				ChooseRT(pRT)->DrawBitmap(bitmap, rt.ToD2DRectF());
+		}
+
+		// The heatmap was discarded, its id may be handed out again.
+		void ReleaseHeatmap(ImUint id)
+		{
+			auto it = _heatmaps.find(id);
+			if (it == _heatmaps.end())
+				return;
+			SafeRelease(&it->second);
+			_heatmaps.erase(it);
+		}
+
+		// Called once per Render(), before drawing. Returns true when new images became ready.
+		bool UploadImages()
+		{
+			if (s_ctx->ImageRelease.exchange(false))
+				_images.Clear();
+			_images.Filter = s_ctx->ImageFilterMode.load();
+			return _images.Upload(_pMainRT, s_ctx->ImageUploadBudget);
+		}
+
+		// Called after a newly built frame has been drawn.
+		void EndImageFrame() { _images.EndFrame(s_ctx->ImageCacheBudget); }
+
+		ImageLoader& GetImageLoader() { return _images; }
+		bool GetImageSize(const char* path, UINT* width, UINT* height) { return _images.GetImageSize(path, width, height); }
+
+	private:
+
+		ImageEntry* RequestTile(const char* image, UINT width, UINT height, int level, UINT tx, UINT ty, float priority)
+		{
+			const UINT tile_src = IMAGE_TILE_SIZE << level;
+
+			WICRect clip;
+			clip.X = tx * tile_src;
+			clip.Y = ty * tile_src;
+			clip.Width = std::min(tile_src, width - clip.X);
+			clip.Height = std::min(tile_src, height - clip.Y);
+
+			const UINT round = (1 << level) - 1;
+			return _images.RequestTile(_pMainRT, image, level, tx, ty, clip, (clip.Width + round) >> level, (clip.Height + round) >> level, priority, s_ctx->ImageAsync);
+		}
+
+		// Draws a tile, or while it is loading the part of the nearest loaded coarser tile covering it.
+		void DrawTile(ID2D1RenderTarget* pRT, const char* image, UINT width, UINT height, int level, int max_level,
+			UINT tx, UINT ty, float priority, const ImFloat4& rt, const ImFloat2& center, float zoom)
+		{
+			ImageEntry* tile = RequestTile(image, width, height, level, tx, ty, priority);
+
+			const WICRect& clip = tile->Clip;
+			const D2D1_RECT_F dst = D2D1::RectF(
+				rt.x + rt.z * 0.5f + (clip.X - center.x) * zoom,
+				rt.y + rt.w * 0.5f + (clip.Y - center.y) * zoom,
+				rt.x + rt.z * 0.5f + (clip.X + clip.Width - center.x) * zoom,
+				rt.y + rt.w * 0.5f + (clip.Y + clip.Height - center.y) * zoom);
+
+			if (tile->State == IMAGE_READY)
+			{
+				pRT->DrawBitmap(tile->Bitmap, dst);
+				return;
+			}
+
+			// the coarser tiles are requested too, after the visible tiles of the level drawn
+			for (int l = level + 1; l <= max_level; l++)
+			{
+				const int shift = l - level;
+				ImageEntry* parent = RequestTile(image, width, height, l, tx >> shift, ty >> shift, priority + 1000.0f * shift);
+				if (parent->State == IMAGE_READY)
+				{
+					const float parent_scale = (float)parent->Width / (float)parent->Clip.Width;
+					const D2D1_RECT_F src = D2D1::RectF(
+						(clip.X - parent->Clip.X) * parent_scale,
+						(clip.Y - parent->Clip.Y) * parent_scale,
+						(clip.X + clip.Width - parent->Clip.X) * parent_scale,
+						(clip.Y + clip.Height - parent->Clip.Y) * parent_scale);
+					pRT->DrawBitmap(parent->Bitmap, dst, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &src);
+					return;
+				}
+			}
+
+			DrawRect(pRT, _placeholderColor, ImFloat4(dst.left, dst.top, dst.right - dst.left, dst.bottom - dst.top), true);
+		}
+
+	private:
+
+		ImFloat4				_bgColor;
+		ImFloat4				_placeholderColor;
+		float					_penWidth;
+		float					_lineHeight;
+
+		ID2D1Factory*			_pD2DFactory;
+		IDWriteFactory*			_pDWriteFactory;
+		IWICImagingFactory*		_pWICFactory;
+		ID2D1HwndRenderTarget*	_pMainRT;
+
+		IDWriteTextFormat*		_pTextFormat[3];	// indexed by TEXT_ALIGNMENT_MODE
+		ID2D1SolidColorBrush*	_pCommonBrush;
+		ImageLoader				_images;
+		ImHashMap<ImUint, ID2D1Bitmap*, AllocCategory_Heatmaps> _heatmaps;
+	};
+
+#else
+
+	// Draws nothing. Text is measured with a fixed advance per character and a fixed line
+	// height derived from the font size, so that layouts are the same on every machine.
+	struct NullRender : HeapObject<AllocCategory_Context>
+	{
+		NullRender()
+		{
+			_advance	= ceilf(s_ctx->Styles.FontSize * 0.5f);
+			_lineHeight	= ceilf(s_ctx->Styles.FontSize * 1.25f);
+		}
+
+		ImFloat2 GetTextSize(const char* txt) const
+		{
+			// UTF-8 continuation bytes take no advance, every '\n' starts a line
+			float width = 0.0f;
+			float line = 0.0f;
+			int lines = 1;
+			for (const unsigned char* p = (const unsigned char*)txt; *p; p++)
+			{
+				if (*p == '\n')
+				{
+					width = std::max(width, line);
+					line = 0.0f;
+					lines++;
+				}
+				else if ((*p & 0xc0) != 0x80)
+				{
+					line += _advance;
+				}
+			}
+			return ImFloat2(std::max(width, line), lines * _lineHeight);
+		}
+
+		float GetLineHeight() const { return _lineHeight; }
+		bool UploadImages() { s_ctx->ImageRelease = false; return false; }
+		void EndImageFrame() {}
+		void ReleaseHeatmap(ImUint) {}
+
+		// PNG and JPEG sizes are read from the file headers, so that ImageViewer() lays out
+		// and zooms as it does with images; the pixels are never decoded. Any thread.
+		bool GetImageSize(const char* path, UINT* width, UINT* height)
+		{
+			std::lock_guard<std::mutex> lock(_sizeMutex);
+			_sizeKey = path;
+			auto iter = _sizes.find(_sizeKey);
+			if (iter == _sizes.end())
+			{
+				ImFloat2 size;
+				UINT w = 0, h = 0;
+				if (ReadImageHeader(path, &w, &h))
+					size = ImFloat2((float)w, (float)h);
+				iter = _sizes.insert(std::make_pair(_sizeKey, size)).first;
+			}
+			*width = (UINT)iter->second.x;
+			*height = (UINT)iter->second.y;
+			return iter->second.x > 0.0f;
+		}
+
+	private:
+		static bool ReadImageHeader(const char* path, UINT* width, UINT* height)
+		{
+			FILE* file = fopen(path, "rb");
+			if (file == NULL)
+				return false;
+
+			unsigned char buf[24];
+			bool found = false;
+			if (fread(buf, 1, 4, file) == 4 && memcmp(buf, "\x89PNG", 4) == 0)
+			{
+				// the IHDR chunk comes first, big endian
+				if (fread(buf + 4, 1, 20, file) == 20)
+				{
+					*width = (UINT)buf[16] << 24 | (UINT)buf[17] << 16 | (UINT)buf[18] << 8 | buf[19];
+					*height = (UINT)buf[20] << 24 | (UINT)buf[21] << 16 | (UINT)buf[22] << 8 | buf[23];
+					found = true;
+				}
+			}
+			else if (buf[0] == 0xFF && buf[1] == 0xD8)
+			{
+				// segments up to a start of frame, SOF0 to SOF15 but DHT, JPG and DAC
+				fseek(file, 2, SEEK_SET);
+				while (!found && fread(buf, 1, 4, file) == 4 && buf[0] == 0xFF)
+				{
+					const int marker = buf[1];
+					const long length = buf[2] << 8 | buf[3];
+					if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+					{
+						if (fread(buf, 1, 5, file) == 5)
+						{
+							*height = (UINT)buf[1] << 8 | buf[2];
+							*width = (UINT)buf[3] << 8 | buf[4];
+							found = true;
+						}
+						break;
+					}
+					if (length < 2 || fseek(file, length - 2, SEEK_CUR) != 0)
+						break;
+				}
+			}
+			fclose(file);
+			return found && *width > 0 && *height > 0;
+		}
+
+		float					_advance;
+		float					_lineHeight;
+		std::mutex				_sizeMutex;
+		ImString<AllocCategory_Images> _sizeKey;
+		ImStringMap<ImFloat2, AllocCategory_Images> _sizes;		// 0 x 0 when not readable
+	};
+
+#endif
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// Every block starts with a header naming its category and the allocator that made it
+	struct AllocHeader
+	{
+		size_t		Size;
+		ImUint		Category;
+		ImUint		Allocator;		// index in s_allocators
+	};
+
+	enum { ALLOC_HEADER_SIZE = 16, MAX_ALLOCATORS = 16 };
+
+	struct AllocatorFuncs
+	{
+		AllocFunc	Alloc;
+		FreeFunc	Free;
+		void*		UserData;
+	};
+
+	static void* DefaultAlloc(size_t size, void*) { return malloc(size); }
+	static void DefaultFree(void* ptr, void*) { free(ptr); }
+
+	static AllocatorFuncs		s_allocators[MAX_ALLOCATORS] = { { DefaultAlloc, DefaultFree, NULL } };
+	static std::atomic<int>		s_allocatorCount(1);
+	static std::atomic<int>		s_allocator(0);
+	static std::atomic<size_t>	s_allocBytes[AllocCategory_COUNT];
+	static std::atomic<size_t>	s_allocPeakBytes[AllocCategory_COUNT];
+	static std::atomic<size_t>	s_allocBlocks[AllocCategory_COUNT];
+	static std::atomic<size_t>	s_allocCount[AllocCategory_COUNT];
+	static std::atomic<size_t>	s_gcIds;
+	static std::atomic<size_t>	s_gcStates;
+	static std::atomic<size_t>	s_gcWindows;
+
+	void SetAllocatorFunctions(AllocFunc alloc_func, FreeFunc free_func, void* user_data)
+	{
+		assert((alloc_func != NULL) == (free_func != NULL));
+		if (alloc_func == NULL)
+		{
+			s_allocator = 0;
+			return;
+		}
+
+		// a pair set before is reused, the blocks it made may still be around
+		const int count = s_allocatorCount.load();
+		for (int i = 0; i < count; i++)
+		{
+			const AllocatorFuncs& funcs = s_allocators[i];
+			if (funcs.Alloc == alloc_func && funcs.Free == free_func && funcs.UserData == user_data)
+			{
+				s_allocator = i;
+				return;
+			}
+		}
+
+		assert(count < MAX_ALLOCATORS && "Too many allocators");
+		if (count == MAX_ALLOCATORS)
+			return;
+		s_allocators[count].Alloc = alloc_func;
+		s_allocators[count].Free = free_func;
+		s_allocators[count].UserData = user_data;
+		s_allocatorCount = count + 1;
+		s_allocator = count;
+	}
+
+	AllocStats GetAllocStats()
+	{
+		AllocStats stats;
+		for (int i = 0; i < AllocCategory_COUNT; i++)
+		{
+			stats.Bytes[i] = s_allocBytes[i].load();
+			stats.PeakBytes[i] = s_allocPeakBytes[i].load();
+			stats.Blocks[i] = s_allocBlocks[i].load();
+			stats.Allocations[i] = s_allocCount[i].load();
+		}
+		stats.IdsCollected = s_gcIds.load();
+		stats.StatesCollected = s_gcStates.load();
+		stats.WindowsCollected = s_gcWindows.load();
+		return stats;
+	}
+
+	void* MemAlloc(size_t size, AllocCategory category)
+	{
+		static_assert(sizeof(AllocHeader) <= ALLOC_HEADER_SIZE, "AllocHeader must keep blocks 16 byte aligned");
+
+		const int index = s_allocator.load();
+		const AllocatorFuncs& funcs = s_allocators[index];
+		char* block = (char*)funcs.Alloc(size + ALLOC_HEADER_SIZE, funcs.UserData);
+		if (block == NULL)
+			return NULL;
+
+		AllocHeader* header = (AllocHeader*)block;
+		header->Size = size;
+		header->Category = category;
+		header->Allocator = index;
+
+		const size_t bytes = s_allocBytes[category].fetch_add(size) + size;
+		size_t peak = s_allocPeakBytes[category].load();
+		while (bytes > peak && !s_allocPeakBytes[category].compare_exchange_weak(peak, bytes))
+			;
+		s_allocBlocks[category]++;
+		s_allocCount[category]++;
+		return block + ALLOC_HEADER_SIZE;
+	}
+
+	void MemFree(void* ptr)
+	{
+		if (ptr == NULL)
+			return;
+
+		char* block = (char*)ptr - ALLOC_HEADER_SIZE;
+		const AllocHeader* header = (const AllocHeader*)block;
+		s_allocBytes[header->Category] -= header->Size;
+		s_allocBlocks[header->Category]--;
+
+		const AllocatorFuncs& funcs = s_allocators[header->Allocator];
+		funcs.Free(block, funcs.UserData);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	Window* GetWindow(const char* name)
+	{
+		// a window job looks the windows up in its owning context, which waits for the jobs
+		const Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
+		for (size_t i = 0; i != ctx->Windows.size(); i++)
+			if (strcmp(ctx->Windows[i]->Name, name) == 0)
+				return ctx->Windows[i];
+		return NULL;
+	}
+
+	Context* CreateContext()
+	{
+		Context* ctx = new Context;
+		if (s_ctx == NULL)
+			s_ctx = ctx;
+		return ctx;
+	}
+
+	void DestroyContext(Context* ctx)
+	{
+		if (ctx == NULL)
+			ctx = s_ctx;
+		if (ctx == NULL)
+			return;
+
+		Context* prev_ctx = s_ctx;
+		s_ctx = ctx;
+		StopInputRecording();
+		StopInputReplay();
+		ClearResources();
+		s_ctx = (prev_ctx == ctx) ? NULL : prev_ctx;
+
+		delete ctx;
+	}
+
+	Context* GetCurrentContext()
+	{
+		return s_ctx;
+	}
+
+	void SetCurrentContext(Context* ctx)
+	{
+		s_ctx = ctx;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// garbage collection
+	//////////////////////////////////////////////////////////////////////////
+
+	enum { GC_INTERVAL = 32 };		// frames between two collections
+
+	void SetGarbageCollection(int idle_frames)
+	{
+		s_ctx->GCIdleFrames = std::max(0, idle_frames);
+	}
+
+	// The state and heatmap of the id are discarded and the id is handed out again. Heatmaps are
+	// deleted by the render thread, it may still draw them from an older frame.
+	static void ReleaseID(ImUint id, Window* window)
+	{
+		s_gcStates += window->StateStorage.Data.erase(id);
+
+		{
+			std::lock_guard<std::mutex> lock(s_ctx->HeatmapMutex);
+			ImHashMap<ImUint, HeatmapData*, AllocCategory_Heatmaps>::iterator it = s_ctx->Heatmaps.find(id);
+			if (it != s_ctx->Heatmaps.end())
+			{
+				RetiredHeatmap retired = { id, it->second, s_ctx->FrameCount + 1 };
+				s_ctx->RetiredHeatmaps.push_back(retired);
+				s_ctx->Heatmaps.erase(it);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(s_ctx->IDMutex);
+		s_ctx->FreeIDs.push_back(id);
+		s_gcIds++;
+	}
+
+	// A heatmap no frame asked for in GC_INTERVAL frames, its widget gone, is retired like the
+	// heatmap of a released id, with or without the garbage collection: its pixels are large.
+	static void RetireIdleHeatmaps()
+	{
+		std::lock_guard<std::mutex> lock(s_ctx->HeatmapMutex);
+		for (auto it = s_ctx->Heatmaps.begin(); it != s_ctx->Heatmaps.end();)
+		{
+			if (s_ctx->FrameCount - it->second->LastFrame > GC_INTERVAL)
+			{
+				RetiredHeatmap retired = { it->first, it->second, s_ctx->FrameCount + 1 };
+				s_ctx->RetiredHeatmaps.push_back(retired);
+				it = s_ctx->Heatmaps.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	static bool IsIDInUse(ImUint id)
+	{
+		return id == s_ctx->ActiveId || id == s_ctx->HoveredId || id == s_ctx->ActiveIdPrev || id == s_ctx->HoveredIdPrev;
+	}
+
+	// The widget of the id is gone with its window and will not release it: a window that stopped
+	// being submitted mid-drag would leave its id active, for the next widget handed the id.
+	static void ClearIDInUse(ImUint id)
+	{
+		if (s_ctx->ActiveId == id)
+			s_ctx->ActiveId = 0;
+		if (s_ctx->ActiveIdPrev == id)
+			s_ctx->ActiveIdPrev = 0;
+		if (s_ctx->HoveredId == id)
+			s_ctx->HoveredId = 0;
+		if (s_ctx->HoveredIdPrev == id)
+			s_ctx->HoveredIdPrev = 0;
+	}
+
+	// Called by EndFrame() before the frame is published, the frame gets the index FrameCount + 1.
+	static void CollectGarbage()
+	{
+		const ImUint idle = (ImUint)s_ctx->GCIdleFrames;
+		for (size_t i = 0; i < s_ctx->Windows.size();)
+		{
+			Window* window = s_ctx->Windows[i];
+
+			// whole windows
+			if (s_ctx->FrameCount - window->LastFrame > idle && window != s_ctx->HoveredWindow)
+			{
+				for (auto it = window->IDMap.begin(); it != window->IDMap.end(); ++it)
+				{
+					if (IsIDInUse(it->second.Id))
+						ClearIDInUse(it->second.Id);
+					ReleaseID(it->second.Id, window);
+				}
+
+				s_ctx->Windows.erase(s_ctx->Windows.begin() + i);
+				{
+					std::lock_guard<std::mutex> lock(s_ctx->RetireMutex);
+					RetiredWindow retired = { window, s_ctx->FrameCount + 1 };
+					s_ctx->RetiredWindows.push_back(retired);
+				}
+				s_gcWindows++;
+				continue;
+			}
+
+			// ids of the window
+			for (auto it = window->IDMap.begin(); it != window->IDMap.end();)
+			{
+				if (window->BuiltFrames - it->second.LastUsed > idle && !IsIDInUse(it->second.Id))
+				{
+					ReleaseID(it->second.Id, window);
+					it = window->IDMap.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			i++;
+		}
+	}
+
+	// Deletes what the garbage collection discarded before the frame with the index frame_index,
+	// on the render thread: the windows own surfaces of the render target.
+	static void ReleaseRetired(ImUint frame_index)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_ctx->RetireMutex);
+			ImVector<RetiredWindow, AllocCategory_Context>& windows = s_ctx->RetiredWindows;
+			for (size_t i = 0; i < windows.size();)
+			{
+				if (windows[i].Frame <= frame_index)
+				{
+					delete windows[i].Win;
+					windows[i] = windows.back();
+					windows.pop_back();
+					s_ctx->DirtyFull = true;
+				}
+				else
+				{
+					i++;
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(s_ctx->HeatmapMutex);
+		ImVector<RetiredHeatmap, AllocCategory_Heatmaps>& heatmaps = s_ctx->RetiredHeatmaps;
+		for (size_t i = 0; i < heatmaps.size();)
+		{
+			if (heatmaps[i].Frame <= frame_index)
+			{
+				if (s_ctx->Render)
+					s_ctx->Render->ReleaseHeatmap(heatmaps[i].Id);
+				delete heatmaps[i].Data;
+				heatmaps[i] = heatmaps.back();
+				heatmaps.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+#ifdef IMDUI_D2D
+	void InitResources(ID2D1Factory* pD2DFactory, IDWriteFactory* pDWriteFactory, IWICImagingFactory* pWICFactory, ID2D1HwndRenderTarget* pMainRT)
+#else
+	void InitResources()
+#endif
+	{
+		assert(s_ctx != NULL && "Call ImDui::CreateContext() first");
+
+		s_ctx->CurrentWindow = NULL;
+		s_ctx->RenderWindow = NULL;
+		s_ctx->HoveredWindow = NULL;
+		memset(s_ctx->StrToolTip, 0, sizeof(s_ctx->StrToolTip));
+
+#ifdef IMDUI_D2D
+		s_ctx->Render = new D2DRender;
+		s_ctx->Render->Init(pD2DFactory, pDWriteFactory, pWICFactory, pMainRT);
+#else
+		s_ctx->Render = new NullRender;
+#endif
+	}
+
+	void ClearResources()
+	{
+		for (size_t i = 0; i < s_ctx->Windows.size(); i++)
+			delete s_ctx->Windows[i];
+		s_ctx->Windows.clear();
+		ReleaseRetired(~0u);
+
+		delete s_ctx->Render;
+		s_ctx->Render = NULL;
+
+		for (auto it = s_ctx->Heatmaps.begin(); it != s_ctx->Heatmaps.end(); ++it)
+			delete it->second;
+		s_ctx->Heatmaps.clear();
+
+		delete s_ctx->Jobs;
+		s_ctx->Jobs = NULL;
+		for (int i = 0; i < JobPool::MAX_THREADS; i++)
+		{
+			delete s_ctx->JobContexts[i];
+			s_ctx->JobContexts[i] = NULL;
+		}
+	}
+
+	Event& GetEvents()
+	{
+		return s_ctx->Events;
+	}
+
+	float GetFPS()
+	{
+		return s_ctx->FPS;
+	}
+
+	void CalculateFramesPerSecond()
+	{
+		RingBuffer<LONGLONG, 10>& times = s_ctx->FrameTimes;
+		times.Add(GetTicks());
+
+		if (times.GetCount() > 0 && times.GetLast() > s_ctx->LastTimeStatusShown + s_ctx->Frequency / 10)
+		{
+			s_ctx->LastTimeStatusShown = times.GetLast();
+			if (times.GetCount() > 0)
+				s_ctx->FPS = (times.GetCount() - 1) * s_ctx->Frequency / static_cast<float>((times.GetLast() - times.GetFirst()));
+		}
+	}
+
+	double GetTime()
+	{
+		return (double)(GetTicks() - s_ctx->TimeStart) / (double)s_ctx->Frequency;
+	}
+
+	static void QueueInputEvent(const InputEvent& e)
+	{
+		if (!s_ctx->InputQueue.Push(e))
+			s_ctx->InputEventsDropped++;
+	}
+
+	void AddMouseMoveEvent(float x, float y, double time)
+	{
+		InputEvent e = {};
+		e.Type = InputEvent_MouseMove;
+		e.Time = time < 0.0 ? GetTime() : time;
+		e.MousePos = ImFloat2(x, y);
+		QueueInputEvent(e);
+	}
+
+	void AddMouseButtonEvent(float x, float y, bool down, double time)
+	{
+		InputEvent e = {};
+		e.Type = InputEvent_MouseButton;
+		e.Time = time < 0.0 ? GetTime() : time;
+		e.MousePos = ImFloat2(x, y);
+		e.Down = down;
+		QueueInputEvent(e);
+	}
+
+	void AddMouseWheelEvent(int delta, double time)
+	{
+		InputEvent e = {};
+		e.Type = InputEvent_MouseWheel;
+		e.Time = time < 0.0 ? GetTime() : time;
+		e.Wheel = delta;
+		QueueInputEvent(e);
+	}
+
+	void AddKeyEvent(int key, bool down, double time)
+	{
+		assert(key >= 0 && key < (int)ARRAYSIZE(s_ctx->Events.KeysDown));
+		if (key < 0 || key >= (int)ARRAYSIZE(s_ctx->Events.KeysDown))
+			return;		// dropped in release builds too, DrainInputEvents() indexes by it
+		InputEvent e = {};
+		e.Type = InputEvent_Key;
+		e.Time = time < 0.0 ? GetTime() : time;
+		e.Key = key;
+		e.Down = down;
+		QueueInputEvent(e);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// input recording
+	//
+	// little endian: "IMDR", version, then one record per frame and per consumed input event.
+	// A record starts with a tag byte, the input event type in the low bits:
+	//   frame		RECORD_FRAME, f64 time, f32 delta time
+	//   move		f32 x, f32 y
+	//   button		| RECORD_DOWN, f32 x, f32 y
+	//   wheel		i32 delta
+	//   key		| RECORD_DOWN, u8 key
+	// each event followed by f32 seconds from the frame time to the event timestamp.
+
+	static const ImUint RECORD_MAGIC = 0x52444d49;	// "IMDR"
+	static const ImUint RECORD_VERSION = 1;
+	static const unsigned char RECORD_TYPE_MASK = 0x03;
+	static const unsigned char RECORD_DOWN = 0x04;
+	static const unsigned char RECORD_FRAME = 0x80;
+
+	// the fields are written byte by byte, the recordings replay on hosts of either byte order
+	static void WriteRecordU32(FILE* f, ImUint value)
+	{
+		const unsigned char bytes[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+		fwrite(bytes, sizeof(bytes), 1, f);
+	}
+
+	static void WriteRecordF32(FILE* f, float value)
+	{
+		ImUint bits;
+		memcpy(&bits, &value, sizeof(bits));
+		WriteRecordU32(f, bits);
+	}
+
+	static void WriteRecordF64(FILE* f, double value)
+	{
+		ULONGLONG bits;
+		memcpy(&bits, &value, sizeof(bits));
+		WriteRecordU32(f, (ImUint)bits);
+		WriteRecordU32(f, (ImUint)(bits >> 32));
+	}
+
+	static bool ReadRecordU32(FILE* f, ImUint* value)
+	{
+		unsigned char bytes[4];
+		if (fread(bytes, sizeof(bytes), 1, f) != 1)
+			return false;
+		*value = (ImUint)bytes[0] | ((ImUint)bytes[1] << 8) | ((ImUint)bytes[2] << 16) | ((ImUint)bytes[3] << 24);
+		return true;
+	}
+
+	static bool ReadRecordF32(FILE* f, float* value)
+	{
+		ImUint bits;
+		if (!ReadRecordU32(f, &bits))
+			return false;
+		memcpy(value, &bits, sizeof(bits));
+		return true;
+	}
+
+	static bool ReadRecordF64(FILE* f, double* value)
+	{
+		ImUint low, high;
+		if (!ReadRecordU32(f, &low) || !ReadRecordU32(f, &high))
+			return false;
+		const ULONGLONG bits = (ULONGLONG)low | ((ULONGLONG)high << 32);
+		memcpy(value, &bits, sizeof(bits));
+		return true;
+	}
+
+	bool StartInputRecording(const char* path)
+	{
+		StopInputRecording();
+		s_ctx->RecordFile = fopen(path, "wb");
+		if (s_ctx->RecordFile == NULL)
+			return false;
+
+		WriteRecordU32(s_ctx->RecordFile, RECORD_MAGIC);
+		WriteRecordU32(s_ctx->RecordFile, RECORD_VERSION);
+		return true;
+	}
+
+	void StopInputRecording()
+	{
+		if (s_ctx->RecordFile == NULL)
+			return;
+		fclose(s_ctx->RecordFile);
+		s_ctx->RecordFile = NULL;
+	}
+
+	static void RecordFrame(double time, float delta_time)
+	{
+		FILE* f = s_ctx->RecordFile;
+		fputc(RECORD_FRAME, f);
+		WriteRecordF64(f, time);
+		WriteRecordF32(f, delta_time);
+	}
+
+	static void RecordInputEvent(const InputEvent& e, double frame_time)
+	{
+		FILE* f = s_ctx->RecordFile;
+		const bool has_down = (e.Type == InputEvent_MouseButton || e.Type == InputEvent_Key);
+		fputc((unsigned char)e.Type | ((has_down && e.Down) ? RECORD_DOWN : 0), f);
+		if (e.Type == InputEvent_MouseMove || e.Type == InputEvent_MouseButton)
+		{
+			WriteRecordF32(f, e.MousePos.x);
+			WriteRecordF32(f, e.MousePos.y);
+		}
+		else if (e.Type == InputEvent_MouseWheel)
+		{
+			WriteRecordU32(f, (ImUint)e.Wheel);
+		}
+		else
+		{
+			fputc((unsigned char)e.Key, f);
+		}
+		WriteRecordF32(f, (float)(e.Time - frame_time));
+	}
+
+	bool StartInputReplay(const char* path)
+	{
+		StopInputReplay();
+		s_ctx->ReplayFile = fopen(path, "rb");
+		if (s_ctx->ReplayFile == NULL)
+			return false;
+
+		ImUint magic, version;
+		if (!ReadRecordU32(s_ctx->ReplayFile, &magic) || !ReadRecordU32(s_ctx->ReplayFile, &version) || magic != RECORD_MAGIC || version != RECORD_VERSION)
+		{
+			OutWarning("ImDui: %s is not an input recording", path);
+			StopInputReplay();
+			return false;
+		}
+		return true;
+	}
+
+	void StopInputReplay()
+	{
+		if (s_ctx->ReplayFile == NULL)
+			return;
+		fclose(s_ctx->ReplayFile);
+		s_ctx->ReplayFile = NULL;
+		s_ctx->ReplayPending = false;
+	}
+
+	bool ReplayInputFrame()
+	{
+		FILE* f = s_ctx->ReplayFile;
+		if (f == NULL)
+			return false;
+
+		double time;
+		float delta_time;
+		if (fgetc(f) != RECORD_FRAME || !ReadRecordF64(f, &time) || !ReadRecordF32(f, &delta_time))
+		{
+			StopInputReplay();
+			return false;
+		}
+
+		for (int tag = fgetc(f); tag != EOF; tag = fgetc(f))
+		{
+			if (tag == RECORD_FRAME)
+			{
+				ungetc(tag, f);
+				break;
+			}
+
+			InputEvent e = {};
+			e.Type = (InputEventType)(tag & RECORD_TYPE_MASK);
+			e.Down = (tag & RECORD_DOWN) != 0;
+			bool read = true;
+			if (e.Type == InputEvent_MouseMove || e.Type == InputEvent_MouseButton)
+			{
+				read = ReadRecordF32(f, &e.MousePos.x) && ReadRecordF32(f, &e.MousePos.y);
+			}
+			else if (e.Type == InputEvent_MouseWheel)
+			{
+				ImUint wheel = 0;
+				read = ReadRecordU32(f, &wheel);
+				e.Wheel = (int)wheel;
+			}
+			else
+			{
+				const int key = fgetc(f);
+				read = (key != EOF && key < (int)ARRAYSIZE(s_ctx->Events.KeysDown));
+				e.Key = key;
+			}
+			float offset = 0.0f;
+			read = read && ReadRecordF32(f, &offset);
+			if (!read)
+			{
+				OutWarning("ImDui: truncated input recording");
+				StopInputReplay();
+				return false;
+			}
+			e.Time = time + offset;
+			QueueInputEvent(e);
+		}
+
+		s_ctx->ReplayPending = true;
+		s_ctx->ReplayTime = time;
+		s_ctx->ReplayDeltaTime = delta_time;
+		return true;
+	}
+
+	// Apply the queued input events to the event state of this frame. Moves are coalesced,
+	// and at most one change per button or key is applied: when a button goes down and up
+	// between two frames, the release is left in the queue for the next frame so the click
+	// is not lost.
+	void DrainInputEvents(double* out_click_time)
+	{
+		Event& events = s_ctx->Events;
+		FrameData& frame = s_ctx->Frames[s_ctx->FrameWrite];
+		frame.LatencyCount = 0;
+		bool mouse_button_changed = false;
+		bool key_changed[ARRAYSIZE(events.KeysDown)] = { false };
+		int wheel = 0;
+
+		while (InputEvent* e = s_ctx->InputQueue.Peek())
+		{
+			if (e->Type == InputEvent_MouseMove)
+			{
+				if (mouse_button_changed)
+					break;
+				events.MousePos = e->MousePos;
+			}
+			else if (e->Type == InputEvent_MouseButton)
+			{
+				if (mouse_button_changed)
+					break;
+				events.MousePos = e->MousePos;
+				if (e->Down != events.MouseDown)
+				{
+					events.MouseDown = e->Down;
+					mouse_button_changed = true;
+					if (e->Down)
+						*out_click_time = e->Time;
+				}
+			}
+			else if (e->Type == InputEvent_MouseWheel)
+			{
+				wheel += e->Wheel;
+			}
+			else if (e->Type == InputEvent_Key)
+			{
+				if (key_changed[e->Key])
+					break;
+				key_changed[e->Key] = (events.KeysDown[e->Key] != e->Down);
+				events.KeysDown[e->Key] = e->Down;
+			}
+
+			if (s_ctx->RecordFile != NULL)
+				RecordInputEvent(*e, events.Time);
+
+			if (frame.LatencyCount < ARRAYSIZE(frame.Latency))
+			{
+				LatencyRecord& record = frame.Latency[frame.LatencyCount++];
+				record.InputTime = e->Time;
+				record.ConsumeTime = events.Time;
+				record.Frame = s_ctx->FrameCount + 1;
+			}
+			s_ctx->InputQueue.Pop();
+		}
+
+		// a delta of this frame, like MouseDelta: 0 when no wheel event came
+		events.MouseWheel = wheel;
+	}
+
+	void NewFrame()
+	{
+		s_ctx->FrameBegin = GetTicks();
+		s_ctx->FrameEnded = false;
+		s_ctx->HoveredIdPrev = s_ctx->HoveredId;
+		s_ctx->ActiveIdPrev = s_ctx->ActiveId;
+		s_ctx->ReactTime = 0.0;
+		s_ctx->HoveredId = 0;
+		s_ctx->StrToolTip[0] = '\0';
+
+		CalculateFramesPerSecond();
+
+		const double time = s_ctx->ReplayPending ? s_ctx->ReplayTime : GetTime();
+		s_ctx->Events.DeltaTime = s_ctx->ReplayPending ? s_ctx->ReplayDeltaTime : (s_ctx->Events.Time > 0.0) ? (float)(time - s_ctx->Events.Time) : 1 / 60.f;
+		s_ctx->Events.Time = time;
+		s_ctx->FrameReplayed = s_ctx->ReplayPending;
+		s_ctx->ReplayPending = false;
+		if (s_ctx->RecordFile != NULL)
+			RecordFrame(time, s_ctx->Events.DeltaTime);
+
+		// update event states
+		double click_time = time;
+		DrainInputEvents(&click_time);
+
+		s_ctx->Events.MouseDelta = s_ctx->Events.MousePos - s_ctx->Events.MousePosPrev;
+		s_ctx->Events.MousePosPrev = s_ctx->Events.MousePos;
+		s_ctx->Events.MouseDownTime = s_ctx->Events.MouseDown ? (s_ctx->Events.MouseDownTime < 0.0f ? 0.0f : s_ctx->Events.MouseDownTime + s_ctx->Events.DeltaTime) : -1.0f;
+		s_ctx->Events.MouseClicked = (s_ctx->Events.MouseDownTime == 0.0f);
+		s_ctx->Events.MouseDoubleClicked = false;
+		if (s_ctx->Events.MouseClicked)
+		{
+			// compare the timestamps of the button presses, so the result does not depend on the frame rate
+			if (click_time - s_ctx->Events.MouseClickedTime < s_ctx->Events.MouseDoubleClickTime &&
+				Distance(s_ctx->Events.MousePos - s_ctx->Events.MouseClickedPos) < s_ctx->Events.MouseDoubleClickMaxDist)
+			{
+				s_ctx->Events.MouseDoubleClicked = true;
+				s_ctx->Events.MouseClickedTime = -FLT_MAX;
+			}
+			else
+			{
+				s_ctx->Events.MouseClickedTime = click_time;
+				s_ctx->Events.MouseClickedPos = s_ctx->Events.MousePos;
+			}
+		}
+
+		for (int i = (int)s_ctx->Windows.size() - 1; i >= 0; i--)
+		{
+			if (PtInRect(s_ctx->Events.MousePos, s_ctx->Windows[i]->Rect))
+			{
+				s_ctx->HoveredWindow = s_ctx->Windows[i];
+				break;
+			}
+		}
+
+		if (s_ctx->Events.MouseClicked)
+		{
+			for (int i = (int)s_ctx->Windows.size() - 1; i >=0; i--)
+			{
+				if (PtInRect(s_ctx->Events.MousePos, s_ctx->Windows[i]->Rect))
+				{
+					s_ctx->Windows.push_back(s_ctx->Windows[i]);
+					s_ctx->Windows.erase(s_ctx->Windows.begin() + i);
+
+					break;
+				}
+			}
+		}
+	}
+
+	void SetBgImage(std::string image, bool is_resized)
+	{
+		s_ctx->BgImage = image.c_str();
+		s_ctx->BgImageResized = is_resized;
+	}
+
+	void EndFrame()
+	{
+		assert(!s_ctx->FrameEnded);
+		s_ctx->FrameEnded = true;
+
+		// the hovered or active widget changed: compared once all the windows are built, the ids
+		// are only final then
+		if (s_ctx->HoveredId != s_ctx->HoveredIdPrev || s_ctx->ActiveId != s_ctx->ActiveIdPrev)
+			NoteReaction();
+
+		if (s_ctx->GCIdleFrames > 0 && s_ctx->FrameCount % GC_INTERVAL == 0)
+			CollectGarbage();
+		if (s_ctx->FrameCount % GC_INTERVAL == 0)
+			RetireIdleHeatmaps();
+
+		FrameData& frame = s_ctx->Frames[s_ctx->FrameWrite];
+		frame.Count = 0;
+		for (size_t i = 0; i < s_ctx->Windows.size(); i++)
+		{
+			Window* window = s_ctx->Windows[i];
+			if (window->Visible)
+			{
+				if (frame.Count == frame.Windows.size())
+					frame.Windows.push_back(FrameWindow());
+
+				// the slot this window had in this frame buffer, so that its draw list gets its
+				// own buffers back when the window order changed, not those of a smaller window
+				for (size_t j = frame.Count + 1; j < frame.Windows.size(); j++)
+				{
+					if (frame.Windows[j].Win == window)
+					{
+						std::swap(frame.Windows[frame.Count], frame.Windows[j]);
+						break;
+					}
+				}
+
+				FrameWindow& frame_window = frame.Windows[frame.Count++];
+				frame_window.Win = window;
+				frame_window.Rect = window->Rect;
+				if (window->Collapse)
+					frame_window.Rect.w = std::min(window->Rect.w, s_ctx->Styles.TitleBarHeight);
+				frame_window.Alpha = window->Alpha;
+				frame_window.Opaque = window->Alpha >= 1.0f && !window->Collapse && s_ctx->Styles.Colors[Color_WindowBg].w >= 1.0f;
+				frame_window.DrawList.Swap(window->DrawList);
+				frame_window.Hash = frame_window.DrawList.Hash();
+			}
+			window->Visible = false;
+		}
+
+		frame.BgImage = s_ctx->BgImage;
+		frame.BgImageResized = s_ctx->BgImageResized;
+		frame.DirtyRendering = s_ctx->DirtyRendering;
+		frame.ClearColor = s_ctx->DirtyClearColor;
+
+		// the style as the render thread needs it, GetStyle() may change it while it draws
+		frame.PlaceholderColor = s_ctx->Styles.Colors[Color_WidgetBg];
+		frame.FontSize = s_ctx->Styles.FontSize;
+		frame.StrokeWidth = s_ctx->Styles.StrokeWidth;
+
+		// tooltip
+		frame.ToolTip[0] = '\0';
+		if (s_ctx->StrToolTip[0])
+		{
+			const ImFloat2 text_size = s_ctx->Render->GetTextSize(s_ctx->StrToolTip);
+			ImFloat2 pos = s_ctx->Events.MousePos + ImFloat2(32, 16);
+
+			memcpy(frame.ToolTip, s_ctx->StrToolTip, sizeof(frame.ToolTip));
+			frame.ToolTipRect = ImFloat4(pos - s_ctx->Styles.FramePadding * 2, text_size + s_ctx->Styles.FramePadding * 2);
+			frame.ToolTipBgColor = s_ctx->Styles.Colors[Color_TooltipBg];
+			frame.ToolTipTextColor = s_ctx->Styles.Colors[Color_Text];
+		}
+
+		// what the frame shows, in back to front order
+		ImUint frame_hash = frame.ToolTip[0] ? HashBytes(&frame.ToolTipRect, sizeof(ImFloat4), HashBytes(frame.ToolTip, strlen(frame.ToolTip))) : 0;
+		for (ImUint i = 0; i < frame.Count; i++)
+		{
+			const FrameWindow& frame_window = frame.Windows[i];
+			frame_hash = HashBytes(&frame_window.Rect, sizeof(frame_window.Rect), frame_hash);
+			frame_hash = HashBytes(&frame_window.Alpha, sizeof(frame_window.Alpha), frame_hash);
+			frame_hash = HashBytes(&frame_window.Hash, sizeof(frame_window.Hash), frame_hash);
+		}
+		s_ctx->FrameHash = frame_hash;
+
+		frame.ReactTime = s_ctx->ReactTime;
+		frame.Index = ++s_ctx->FrameCount;
+		frame.BuildBegin = s_ctx->FrameBegin;
+		frame.BuildEnd = GetTicks();
+		frame.Time = s_ctx->Events.Time;
+		frame.Replayed = s_ctx->FrameReplayed;
+		UpdateStat(s_ctx->StatBuildTime, TicksToMs(frame.BuildEnd - frame.BuildBegin));
+
+		// publish, a frame still flagged as new was never rendered and is dropped
+		const ImUint prev = s_ctx->FrameReady.exchange(s_ctx->FrameWrite | FRAME_NEW);
+		if (prev & FRAME_NEW)
+			s_ctx->StatFramesDropped++;
+		s_ctx->FrameWrite = prev & ~FRAME_NEW;
+		if (s_ctx->Pipelined)
+		{
+			std::lock_guard<std::mutex> lock(s_ctx->FrameMutex);
+			s_ctx->FramePublished.notify_one();
+		}
+	}
+
+	ImUint GetFrameHash()
+	{
+		return s_ctx->FrameHash;
+	}
+
+	void WaitForRenderer()
+	{
+		if (!(s_ctx->FrameReady.load() & FRAME_NEW))
+			return;
+
+		Context* ctx = s_ctx;
+		std::unique_lock<std::mutex> lock(ctx->FrameMutex);
+		ctx->FrameConsumed.wait(lock, [ctx] { return !(ctx->FrameReady.load() & FRAME_NEW); });
+	}
+
+	bool WaitForFrame(int timeout_ms)
+	{
+		Context* ctx = s_ctx;
+		const auto published = [ctx] { return (ctx->FrameReady.load() & FRAME_NEW) != 0; };
+		if (published())
+			return true;
+
+		std::unique_lock<std::mutex> lock(ctx->FrameMutex);
+		if (timeout_ms < 0)
+		{
+			ctx->FramePublished.wait(lock, published);
+			return true;
+		}
+		return ctx->FramePublished.wait_for(lock, std::chrono::milliseconds(timeout_ms), published);
+	}
+
+	void SetPipelinedRendering(bool enabled)
+	{
+		s_ctx->Pipelined = enabled;
+	}
+
+	void SetDirtyRectRendering(bool enabled, const ImFloat4& clear_color)
+	{
+		s_ctx->DirtyRendering = enabled;
+		s_ctx->DirtyClearColor = clear_color;
+		s_ctx->DirtyFull = true;
+	}
+
+	int GetDirtyRects(ImFloat4* rects, int max_count)
+	{
+		const int count = std::min(max_count, (int)s_ctx->DirtyRects.size());
+		for (int i = 0; i < count; i++)
+			rects[i] = s_ctx->DirtyRects[i];
+		return (int)s_ctx->DirtyRects.size();
+	}
+
+	FrameStats GetFrameStats()
+	{
+		FrameStats stats;
+		stats.BuildTime = s_ctx->StatBuildTime;
+		stats.RenderTime = s_ctx->StatRenderTime;
+		stats.Latency = s_ctx->StatLatency;
+		stats.FramesDropped = s_ctx->StatFramesDropped;
+		stats.WindowsCulled = s_ctx->StatWindowsCulled;
+		stats.DirtyRects = s_ctx->StatDirtyRects;
+		stats.PixelsTouched = s_ctx->StatPixelsTouched;
+		return stats;
+	}
+
+#ifdef IMDUI_D2D
+
+	static bool RectsOverlap(const ImFloat4& a, const ImFloat4& b)
+	{
+		return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+	}
+
+	static ImFloat4 RectsUnion(const ImFloat4& a, const ImFloat4& b)
+	{
+		const float x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+		return ImFloat4(x0, y0, std::max(a.x + a.z, b.x + b.z) - x0, std::max(a.y + a.w, b.y + b.w) - y0);
+	}
+
+	// Adds rt, grown to whole pixels plus the antialiased edge and clipped to the screen, and
+	// merges it with the dirty rectangles it overlaps.
+	static void AddDirtyRect(ImFloat4 rt, const ImFloat4& screen)
+	{
+		const float x0 = std::max(screen.x, floorf(rt.x) - 1.0f);
+		const float y0 = std::max(screen.y, floorf(rt.y) - 1.0f);
+		const float x1 = std::min(screen.x + screen.z, ceilf(rt.x + rt.z) + 1.0f);
+		const float y1 = std::min(screen.y + screen.w, ceilf(rt.y + rt.w) + 1.0f);
+		if (x1 <= x0 || y1 <= y0)
+			return;
+
+		ImVector<ImFloat4, AllocCategory_Context>& rects = s_ctx->DirtyRects;
+		rt = ImFloat4(x0, y0, x1 - x0, y1 - y0);
+		for (size_t i = 0; i < rects.size();)
+		{
+			if (RectsOverlap(rects[i], rt))
+			{
+				rt = RectsUnion(rects[i], rt);
+				rects.erase(rects.begin() + i);
+				i = 0;
+			}
+			else
+			{
+				i++;
+			}
+		}
+		rects.push_back(rt);
+	}
+
+	// Compares the frame with the last composed one: windows that appeared, disappeared, moved,
+	// were resized, restacked, faded or redrawn, and the tooltip. Image uploads, a new background
+	// or a resized render target recompose everything.
+	static void FindDirtyRects(const FrameData& frame, bool images_uploaded, const ImFloat4& screen)
+	{
+		enum { MAX_DIRTY_RECTS = 8 };
+		ImVector<ImFloat4, AllocCategory_Context>& rects = s_ctx->DirtyRects;
+		ImVector<ComposedWindow, AllocCategory_Context>& composed = s_ctx->Composed;
+		rects.clear();
+
+		const ImUint tooltip = frame.ToolTip[0] ? HashBytes(&frame.ToolTipRect, sizeof(ImFloat4), HashBytes(frame.ToolTip, strlen(frame.ToolTip))) : 0;
+		const bool full = s_ctx->DirtyFull.exchange(false) || images_uploaded ||
+			s_ctx->ComposedSize.x != screen.z || s_ctx->ComposedSize.y != screen.w ||
+			s_ctx->ComposedBgImage != frame.BgImage || s_ctx->ComposedBgResized != frame.BgImageResized;
+
+		if (full)
+		{
+			rects.push_back(screen);
+		}
+		else
+		{
+			size_t last = 0;
+			for (ImUint i = 0; i < frame.Count; i++)
+			{
+				const FrameWindow& frame_window = frame.Windows[i];
+				size_t j = 0;
+				while (j < composed.size() && composed[j].Win != frame_window.Win)
+					j++;
+
+				if (j == composed.size())
+				{
+					AddDirtyRect(frame_window.Rect, screen);
+					continue;
+				}
+
+				// restacked: came before a window it was above of
+				const ComposedWindow& prev = composed[j];
+				const bool moved = memcmp(&prev.Rect, &frame_window.Rect, sizeof(ImFloat4)) != 0;
+				if (moved || j < last || prev.Alpha != frame_window.Alpha)
+					AddDirtyRect(prev.Rect, screen);
+				if (moved || j < last || prev.Alpha != frame_window.Alpha || prev.Hash != frame_window.Hash)
+					AddDirtyRect(frame_window.Rect, screen);
+				last = std::max(last, j);
+				composed[j].Win = NULL;
+			}
+
+			for (size_t j = 0; j < composed.size(); j++)
+			{
+				if (composed[j].Win != NULL)
+					AddDirtyRect(composed[j].Rect, screen);
+			}
+
+			if (tooltip != s_ctx->ComposedToolTip)
+			{
+				if (s_ctx->ComposedToolTip)
+					AddDirtyRect(s_ctx->ComposedToolTipRect, screen);
+				if (tooltip)
+					AddDirtyRect(frame.ToolTipRect, screen);
+			}
+
+			if (rects.size() > MAX_DIRTY_RECTS)
+			{
+				ImFloat4 bounds = rects[0];
+				for (size_t i = 1; i < rects.size(); i++)
+					bounds = RectsUnion(bounds, rects[i]);
+				rects.assign(1, bounds);
+			}
+		}
+
+		composed.resize(frame.Count);
+		for (ImUint i = 0; i < frame.Count; i++)
+		{
+			composed[i].Win = frame.Windows[i].Win;
+			composed[i].Rect = frame.Windows[i].Rect;
+			composed[i].Alpha = frame.Windows[i].Alpha;
+			composed[i].Hash = frame.Windows[i].Hash;
+		}
+		s_ctx->ComposedBgImage = frame.BgImage;
+		s_ctx->ComposedBgResized = frame.BgImageResized;
+		s_ctx->ComposedToolTip = tooltip;
+		s_ctx->ComposedToolTipRect = frame.ToolTipRect;
+		s_ctx->ComposedSize = ImFloat2(screen.z, screen.w);
+
+		float pixels = 0.0f;
+		for (size_t i = 0; i < rects.size(); i++)
+			pixels += rects[i].z * rects[i].w;
+		s_ctx->StatDirtyRects = (int)rects.size();
+		s_ctx->StatPixelsTouched = frame.DirtyRendering ? (int)pixels : (int)(screen.z * screen.w);
+	}
+
+	// Draws the background, the visible windows and the tooltip overlapping clip.
+	static void ComposeFrame(const FrameData& frame, const ImFloat4& clip)
+	{
+		ID2D1RenderTarget* pMainRT = s_ctx->Render->GetMainRT();
+
+		// image bg
+		if (!frame.BgImage.empty())
+		{
+			if (frame.BgImageResized)
+				s_ctx->Render->DrawImage(NULL, frame.BgImage.c_str(), 0, 0, pMainRT->GetSize().width, pMainRT->GetSize().height);
+			else
+				s_ctx->Render->DrawImage(NULL, frame.BgImage.c_str());
+		}
+
+		for (ImUint i = 0; i < frame.Count; i++)
+		{
+			const FrameWindow& frame_window = frame.Windows[i];
+			if (frame_window.Hidden || !RectsOverlap(frame_window.Rect, clip))
+				continue;
+
+			ID2D1Bitmap* pBitmap = NULL;
+			frame_window.Win->CRT->GetBitmap(&pBitmap);
+			pMainRT->DrawBitmap(pBitmap, frame_window.Rect.ToD2DRectF(), frame_window.Alpha);
+			SafeRelease(&pBitmap);
+		}
+
+		// tooltip
+		if (frame.ToolTip[0] && RectsOverlap(frame.ToolTipRect, clip))
+		{
+			s_ctx->Render->DrawRoundedRect(NULL, frame.ToolTipBgColor, frame.ToolTipRect, 5, 5, true);
+			s_ctx->Render->DrawText(NULL, frame.ToolTipTextColor, frame.ToolTip, frame.ToolTipRect);
+		}
+	}
+
+	// Gives back the surfaces of the windows missing from the frame rendered at clock, then those
+	// of the windows it did not compose, least recently shown first, until they fit the budget.
+	static void TrimSurfaces(ImUint clock)
+	{
+		ImVector<Window*, AllocCategory_Context>& surfaces = s_ctx->Surfaces;
+		for (size_t i = 0; i < surfaces.size();)
+		{
+			Window* window = surfaces[i];
+			if (window->CRTFrame != clock)
+			{
+				window->ReleaseSurface();		// swaps the last one in
+				s_ctx->SurfacesReleased++;
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		const size_t budget = s_ctx->SurfaceBudget;
+		while (s_ctx->SurfaceBytes > budget)
+		{
+			Window* oldest = NULL;
+			for (size_t i = 0; i < surfaces.size(); i++)
+			{
+				Window* window = surfaces[i];
+				if (window->CRTShown != clock && (oldest == NULL || window->CRTShown < oldest->CRTShown))
+					oldest = window;
+			}
+			if (oldest == NULL)
+				break;		// the composed windows alone take more than the budget
+			oldest->ReleaseSurface();
+			s_ctx->SurfacesReleased++;
+		}
+	}
+
+	// Occlusion, window surfaces and composition of the frame on the main render target. A
+	// capture draws every window shown again, timing it into CaptureCmdTimes and CaptureWindowTimes.
+	static void DrawFrame(FrameData& frame, bool new_frame, bool images_uploaded, bool capture)
+	{
+		ID2D1RenderTarget* pMainRT = s_ctx->Render->GetMainRT();
+		const ImFloat4 screen(0, 0, pMainRT->GetSize().width, pMainRT->GetSize().height);
+		s_ctx->Render->SetPlaceholderColor(frame.PlaceholderColor);
+
+		// occlusion, from the top window down: a window inside the union of the opaque windows
+		// above it is not composed. Occluders are shrunk to whole pixels, their antialiased
+		// edges let the window below show through.
+		int culled = 0;
+		s_ctx->Occluders.clear();
+		for (ImUint i = frame.Count; i-- > 0;)
+		{
+			FrameWindow& frame_window = frame.Windows[i];
+			frame_window.Hidden = IsRectCovered(frame_window.Rect, s_ctx->Occluders);
+			culled += frame_window.Hidden ? 1 : 0;
+			if (frame_window.Opaque && !frame_window.Hidden)
+			{
+				const ImFloat4& rt = frame_window.Rect;
+				s_ctx->Occluders.push_back(ImFloat4(ceilf(rt.x), ceilf(rt.y), floorf(rt.x + rt.z), floorf(rt.y + rt.w)));
+			}
+		}
+		s_ctx->StatWindowsCulled = culled;
+
+		// windows, the offscreen surfaces only need to be redrawn once per built frame, or when
+		// images they may be waiting for became ready. Hidden windows keep their stale surface
+		// until they show up again, or until TrimSurfaces() takes it.
+		if (capture)
+		{
+			size_t cmds = 0;
+			for (ImUint i = 0; i < frame.Count; i++)
+				cmds += frame.Windows[i].DrawList.Cmds.size();
+			s_ctx->CaptureCmdTimes.assign(cmds, 0.0f);
+			s_ctx->CaptureWindowTimes.assign(frame.Count, 0.0f);
+		}
+
+		const ImUint clock = ++s_ctx->SurfaceClock;
+		size_t first_cmd = 0;
+		for (ImUint i = 0; i < frame.Count; i++)
+		{
+			FrameWindow& frame_window = frame.Windows[i];
+			Window* window = frame_window.Win;
+			float* cmd_times = capture ? s_ctx->CaptureCmdTimes.data() + first_cmd : NULL;
+			first_cmd += frame_window.DrawList.Cmds.size();
+			window->CRTFrame = clock;
+			if (frame_window.Hidden)
+			{
+				window->CRTStale |= new_frame || images_uploaded;
+				continue;
+			}
+			window->CRTShown = clock;
+			if (new_frame || images_uploaded || window->CRTStale || window->CRT == NULL || capture)
+			{
+				const LONGLONG begin = GetTicks();
+				s_ctx->Render->DrawWindow(window, frame_window.DrawList, frame_window.Rect, cmd_times);
+				window->CRTStale = false;
+				if (capture)
+					s_ctx->CaptureWindowTimes[i] = TicksToMs(GetTicks() - begin);
+			}
+		}
+		TrimSurfaces(clock);
+
+		// with dirty rectangles the main render target keeps its content and only the changed
+		// regions are cleared and composed again, otherwise all of it is composed
+		FindDirtyRects(frame, images_uploaded, screen);
+		if (frame.DirtyRendering)
+		{
+			for (size_t i = 0; i < s_ctx->DirtyRects.size(); i++)
+			{
+				const ImFloat4& clip = s_ctx->DirtyRects[i];
+				pMainRT->PushAxisAlignedClip(clip.ToD2DRectF(), D2D1_ANTIALIAS_MODE_ALIASED);
+				pMainRT->Clear(frame.ClearColor.ToD2DColorF());
+				ComposeFrame(frame, clip);
+				pMainRT->PopAxisAlignedClip();
+			}
+		}
+		else
+		{
+			ComposeFrame(frame, screen);
+		}
+	}
+
+#endif
+
+	void CaptureFrame(const char* path)
+	{
+		std::lock_guard<std::mutex> lock(s_ctx->CaptureMutex);
+		s_ctx->CapturePath = path;
+		s_ctx->CaptureFunc = NULL;
+		s_ctx->CapturePending = true;
+	}
+
+	void CaptureFrame(FrameCaptureFunc func, void* user_data)
+	{
+		std::lock_guard<std::mutex> lock(s_ctx->CaptureMutex);
+		s_ctx->CapturePath.clear();
+		s_ctx->CaptureFunc = func;
+		s_ctx->CaptureUserData = user_data;
+		s_ctx->CapturePending = true;
+	}
+
+	static void AppendCapture(ImVector<char, AllocCategory_Context>& data, const void* bytes, size_t size)
+	{
+		data.insert(data.end(), (const char*)bytes, (const char*)bytes + size);
+	}
+
+	// Serializes the frame just drawn, with the times left by DrawFrame(), see FrameCaptureHeader,
+	// and writes it to the file or hands it to the function of CaptureFrame().
+	static void WriteFrameCapture(const FrameData& frame)
+	{
+		ImString<AllocCategory_Context> path;
+		FrameCaptureFunc func;
+		void* user_data;
+		{
+			std::lock_guard<std::mutex> lock(s_ctx->CaptureMutex);
+			path.swap(s_ctx->CapturePath);
+			func = s_ctx->CaptureFunc;
+			user_data = s_ctx->CaptureUserData;
+			s_ctx->CaptureFunc = NULL;
+			s_ctx->CapturePending = false;
+		}
+
+		ImVector<char, AllocCategory_Context>& data = s_ctx->CaptureData;
+		data.clear();
+
+		const bool timed = s_ctx->CaptureWindowTimes.size() == frame.Count;
+		FrameCaptureHeader header = {};
+		header.Magic = FRAME_CAPTURE_MAGIC;
+		header.Version = FRAME_CAPTURE_VERSION;
+		header.Frame = frame.Index;
+		header.WindowCount = frame.Count;
+#ifdef IMDUI_D2D
+		header.Width = s_ctx->Render->GetMainRT()->GetSize().width;
+		header.Height = s_ctx->Render->GetMainRT()->GetSize().height;
+#endif
+		header.FontSize = frame.FontSize;
+		header.StrokeWidth = frame.StrokeWidth;
+		header.BuildTime = TicksToMs(frame.BuildEnd - frame.BuildBegin);
+		for (ImUint i = 0; timed && i < frame.Count; i++)
+			header.DrawTime += s_ctx->CaptureWindowTimes[i];
+		header.ToolTipRect = frame.ToolTipRect;
+		header.ToolTipBgColor = frame.ToolTipBgColor;
+		header.ToolTipTextColor = frame.ToolTipTextColor;
+		AppendCapture(data, &header, sizeof(header));
+
+		size_t first_cmd = 0;
+		for (ImUint i = 0; i < frame.Count; i++)
+		{
+			const FrameWindow& frame_window = frame.Windows[i];
+			const DrawCmdList& list = frame_window.DrawList;
+
+			FrameCaptureWindow win = {};
+			strncpy(win.Name, frame_window.Win->Name, sizeof(win.Name) - 1);
+			win.Rect = frame_window.Rect;
+			win.Alpha = frame_window.Alpha;
+			win.Flags = (frame_window.Hidden ? FrameCaptureWindow_Hidden : 0) | (frame_window.Opaque ? FrameCaptureWindow_Opaque : 0);
+			win.DrawTime = timed ? s_ctx->CaptureWindowTimes[i] : 0.0f;
+			win.CmdCount = (ImUint)list.Cmds.size();
+			win.PointCount = (ImUint)list.Points.size();
+			win.TextBytes = (ImUint)((list.TextBuffer.size() + 3) & ~(size_t)3);
+			AppendCapture(data, &win, sizeof(win));
+
+			for (size_t j = 0; j < list.Cmds.size(); j++)
+			{
+				const DrawCmd& cmd = list.Cmds[j];
+				FrameCaptureCmd out;
+				out.Type = (ImUint)cmd.Type;
+				out.Flags = (cmd.Filled ? FrameCaptureCmd_Filled : 0) | (cmd.Aliased ? FrameCaptureCmd_Aliased : 0) | ((ImUint)cmd.Align << FrameCaptureCmd_AlignShift);
+				out.Color = cmd.Color;
+				out.Rect = cmd.Rect;
+				out.Radius = cmd.Radius;
+				out.Offset = cmd.Offset;
+				out.Count = cmd.Count;
+				out.Time = timed ? s_ctx->CaptureCmdTimes[first_cmd + j] : 0.0f;
+				AppendCapture(data, &out, sizeof(out));
+			}
+			first_cmd += list.Cmds.size();
+
+			AppendCapture(data, list.Points.data(), list.Points.size() * sizeof(ImFloat2));
+			AppendCapture(data, list.TextBuffer.data(), list.TextBuffer.size());
+			data.resize(data.size() + (win.TextBytes - list.TextBuffer.size()), '\0');
+		}
 
-			SafeRelease(&pDecoder);
-			SafeRelease(&pSource);
-			SafeRelease(&pStream);
-			SafeRelease(&pConverter);
-			SafeRelease(&pScaler);
+		AppendCapture(data, frame.BgImage.c_str(), frame.BgImage.size() + 1);
+		AppendCapture(data, frame.ToolTip, strlen(frame.ToolTip) + 1);
 
-			return pBitmap;
+		if (func != NULL)
+		{
+			func(data.data(), data.size(), user_data);
+			return;
 		}
 
-	private:
+		FILE* f = fopen(path.c_str(), "wb");
+		if (f == NULL || fwrite(data.data(), 1, data.size(), f) != data.size())
+			OutWarning("ImDui: failed to write frame capture %s", path.c_str());
+		if (f != NULL)
+			fclose(f);
+	}
 
-		ImFloat4				_bgColor;
-		float					_penWidth;
 
-		ID2D1Factory*			_pD2DFactory;
-		IDWriteFactory*			_pDWriteFactory;
-		IWICImagingFactory*		_pWICFactory;
-		ID2D1HwndRenderTarget*	_pMainRT;
+	void Render()
+	{
+		if (!s_ctx->Pipelined && !s_ctx->FrameEnded)
+			EndFrame();
 
-		IDWriteTextFormat*		_pTextFormat;
-		ID2D1SolidColorBrush*	_pCommonBrush;
-		std::unordered_map<std::string, ID2D1Bitmap*> _mapBitmaps;
-	};
+		const LONGLONG render_begin = GetTicks();
 
-	//////////////////////////////////////////////////////////////////////////
+		// pick up the latest published frame
+		if (s_ctx->FrameReady.load() & FRAME_NEW)
+		{
+			s_ctx->FrameRead = s_ctx->FrameReady.exchange(s_ctx->FrameRead) & ~FRAME_NEW;
+			if (s_ctx->Pipelined)
+			{
+				std::lock_guard<std::mutex> lock(s_ctx->FrameMutex);
+				s_ctx->FrameConsumed.notify_one();
+			}
+		}
 
-	Window* GetWindow(const char* name)
+		FrameData& frame = s_ctx->Frames[s_ctx->FrameRead];
+		const bool new_frame = (frame.Index != s_ctx->FrameRendered);
+		if (new_frame)
+			ReleaseRetired(frame.Index);
+		const bool images_uploaded = s_ctx->Render->UploadImages();
+		const bool capture = s_ctx->CapturePending.load();
+#ifdef IMDUI_D2D
+		DrawFrame(frame, new_frame, images_uploaded, capture);
+#else
+		(void)images_uploaded;
+		if (capture)
+		{
+			s_ctx->CaptureCmdTimes.clear();
+			s_ctx->CaptureWindowTimes.clear();
+		}
+#endif
+		if (capture)
+			WriteFrameCapture(frame);
+
+		const LONGLONG render_end = GetTicks();
+		UpdateStat(s_ctx->StatRenderTime, TicksToMs(render_end - render_begin));
+		if (new_frame)
+		{
+			s_ctx->Render->EndImageFrame();
+			UpdateStat(s_ctx->StatLatency, TicksToMs(render_end - frame.BuildEnd));
+			s_ctx->FrameRendered = frame.Index;
+
+			const double present_time = InputClockTime(render_end, frame.Replayed, frame.Time, frame.BuildBegin);
+			std::lock_guard<std::mutex> lock(s_ctx->LatencyMutex);
+			for (ImUint i = 0; i < frame.LatencyCount; i++)
+			{
+				const LatencyRecord& record = frame.Latency[i];
+				s_ctx->LatencyConsume.Add((float)(record.ConsumeTime - record.InputTime) * 1000.0f);
+				if (frame.ReactTime > 0.0)
+					s_ctx->LatencyReact.Add((float)(frame.ReactTime - record.InputTime) * 1000.0f);
+				s_ctx->LatencyPresent.Add((float)(present_time - record.InputTime) * 1000.0f);
+			}
+		}
+	}
+	LatencyStats GetLatencyStats()
 	{
-		for (size_t i = 0; i != s_state.Windows.size(); i++)
-			if (strcmp(s_state.Windows[i]->Name, name) == 0)
-				return s_state.Windows[i];
-		return NULL;
+		std::lock_guard<std::mutex> lock(s_ctx->LatencyMutex);
+
+		LatencyStats stats;
+		stats.Count = s_ctx->LatencyPresent.Count;
+		stats.ReactCount = s_ctx->LatencyReact.Count;
+		stats.ConsumeP50 = s_ctx->LatencyConsume.Percentile(0.50f);
+		stats.ConsumeP99 = s_ctx->LatencyConsume.Percentile(0.99f);
+		stats.ReactP50 = s_ctx->LatencyReact.Percentile(0.50f);
+		stats.ReactP99 = s_ctx->LatencyReact.Percentile(0.99f);
+		stats.PresentP50 = s_ctx->LatencyPresent.Percentile(0.50f);
+		stats.PresentP99 = s_ctx->LatencyPresent.Percentile(0.99f);
+		return stats;
 	}
 
-	void InitResources(ID2D1Factory* pD2DFactory, IDWriteFactory* pDWriteFactory, IWICImagingFactory* pWICFactory, ID2D1HwndRenderTarget* pMainRT)
+	void ResetLatencyStats()
 	{
-		QueryPerformanceFrequency(&s_frequency);
-
-		s_state.CurrentWindow = NULL;
-		s_state.RenderWindow = NULL;
-		s_state.HoveredWindow = NULL;
-		memset(s_state.StrToolTip, 0, sizeof(s_state.StrToolTip));
+		std::lock_guard<std::mutex> lock(s_ctx->LatencyMutex);
+		s_ctx->LatencyConsume.Clear();
+		s_ctx->LatencyReact.Clear();
+		s_ctx->LatencyPresent.Clear();
+	}
 
-		s_state.Render = new D2DRender;
-		s_state.Render->Init(pD2DFactory, pDWriteFactory, pWICFactory, pMainRT);
+	void ShowLatencyStats()
+	{
+		const LatencyStats stats = GetLatencyStats();
+
+		ImDui::Text("events: %d (%d with reaction)", stats.Count, stats.ReactCount);
+		ImDui::Text("input -> frame    p50 %6.2f  p99 %6.2f ms", stats.ConsumeP50, stats.ConsumeP99);
+		ImDui::Text("input -> reaction p50 %6.2f  p99 %6.2f ms", stats.ReactP50, stats.ReactP99);
+		ImDui::Text("input -> render   p50 %6.2f  p99 %6.2f ms", stats.PresentP50, stats.PresentP99);
+		if (ImDui::Button("Reset"))
+			ResetLatencyStats();
 	}
 
-	void ClearResources()
+	void SetImageLoading(bool async, int upload_budget)
 	{
-		for (size_t i = 0; i < s_state.Windows.size(); i++)
-			delete s_state.Windows[i];
-		s_state.Windows.clear();
+		s_ctx->ImageAsync = async;
+		s_ctx->ImageUploadBudget = (upload_budget < 1) ? 1 : upload_budget;
+	}
 
-		delete s_state.Render;
-		s_state.Render = NULL;
+	void ReleaseImages()
+	{
+		s_ctx->ImageRelease = true;
 	}
 
-	Event& GetEvents()
+	void SetImageCacheBudget(size_t bytes)
 	{
-		return s_state.Events;
+		s_ctx->ImageCacheBudget = bytes;
 	}
 
-	float GetFPS()
+	void SetSurfaceBudget(size_t bytes)
 	{
-		return s_state.FPS;
+		s_ctx->SurfaceBudget = bytes;
 	}
 
-	void CalculateFramesPerSecond()
+	SurfaceStats GetSurfaceStats()
 	{
-		LARGE_INTEGER time;
-		QueryPerformanceCounter(&time);
-		s_times.Add(time.QuadPart);
+		SurfaceStats stats;
+		stats.Surfaces = s_ctx->SurfaceCount;
+		stats.Bytes = s_ctx->SurfaceBytes;
+		stats.Budget = s_ctx->SurfaceBudget;
+		stats.Created = s_ctx->SurfacesCreated;
+		stats.Released = s_ctx->SurfacesReleased;
+		return stats;
+	}
 
-		static LONGLONG sc_lastTimeStatusShown = 0;
-		if (s_times.GetCount() > 0 && s_times.GetLast() > sc_lastTimeStatusShown + 1000000)
+	ImageCacheStats GetImageCacheStats()
+	{
+		ImageCacheStats stats;
+		memset(&stats, 0, sizeof(stats));
+		stats.Budget = s_ctx->ImageCacheBudget;
+#ifdef IMDUI_D2D
+		if (s_ctx->Render)
 		{
-			sc_lastTimeStatusShown = s_times.GetLast();
-			if (s_times.GetCount() > 0)
-				s_state.FPS = (s_times.GetCount() - 1) * s_frequency.QuadPart / static_cast<float>((s_times.GetLast() - s_times.GetFirst()));
+			ImageLoader& loader = s_ctx->Render->GetImageLoader();
+			stats.Entries = loader.StatEntries;
+			stats.Bytes = loader.StatBytes;
+			stats.Hits = loader.StatHits;
+			stats.Misses = loader.StatMisses;
+			stats.Evicted = loader.StatEvicted;
 		}
+#endif
+		return stats;
 	}
 
-	void NewFrame()
+	void SetImageFilter(ImageFilter filter)
 	{
-		s_state.HoveredId = 0;
-		s_state.StrToolTip[0] = '\0';
+		s_ctx->ImageFilterMode = filter;
+	}
 
-		CalculateFramesPerSecond();
+	void ResampleImage(const unsigned char* src, int src_w, int src_h, int src_pitch, int src_bpp,
+		unsigned char* dst, int dst_w, int dst_h, int dst_pitch, ImageFilter filter, int num_threads)
+	{
+		assert((src_bpp == 3 || src_bpp == 4) && filter != ImageFilter_WIC);
+		if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0)
+			return;
 
-		// update event states
-		s_state.Events.MouseDelta = s_state.Events.MousePos - s_state.Events.MousePosPrev;
-		s_state.Events.MousePosPrev = s_state.Events.MousePos;
-		s_state.Events.MouseDownTime = s_state.Events.MouseDown ? (s_state.Events.MouseDownTime < 0.0f ? 0.0f : s_state.Events.MouseDownTime + 1 / 60.f) : -1.0f;
-		s_state.Events.MouseClicked = (s_state.Events.MouseDownTime == 0.0f);
-		s_state.Events.MouseDoubleClicked = false;
-		if (s_state.Events.MouseClicked)
-		{
-			if (0 - s_state.Events.MouseClickedTime < s_state.Events.MouseDoubleClickTime)
-			{
-				if (Distance(s_state.Events.MousePos - s_state.Events.MouseClickedPos) < s_state.Events.MouseDoubleClickMaxDist)
-					s_state.Events.MouseDoubleClicked = true;
-				s_state.Events.MouseClickedTime = -FLT_MAX;
-			}
-			else
-			{
-				s_state.Events.MouseClickedTime = 0;
-				s_state.Events.MouseClickedPos = s_state.Events.MousePos;
-			}
-		}
+		ResampleAxis x_axis, y_axis;
+		x_axis.Init(src_w, dst_w, filter);
+		y_axis.Init(src_h, dst_h, filter);
 
-		for (int i = (int)s_state.Windows.size() - 1; i >= 0; i--)
+		const int stride = dst_w * 4;
+		const UINT bands = (dst_h + RESAMPLE_BAND - 1) / RESAMPLE_BAND;
+		auto resample_band = [&](UINT band, int)
 		{
-			if (PtInRect(s_state.Events.MousePos, s_state.Windows[i]->Rect))
+			const int y0 = band * RESAMPLE_BAND;
+			const int y1 = std::min(y0 + RESAMPLE_BAND, dst_h);
+			const int first = y_axis.Start[y0];
+			const int last = y_axis.Start[y1 - 1] + y_axis.Taps;
+
+			ImVector<float, AllocCategory_Images> line(src_w * 4);
+			ImVector<float, AllocCategory_Images> rows((last - first) * stride);
+			for (int y = first; y < last; y++)
 			{
-				s_state.HoveredWindow = s_state.Windows[i];
-				break;
+				PremultiplyRow(src + y * src_pitch, src_w, src_bpp, line.data());
+				ResampleRow(line.data(), x_axis, dst_w, &rows[(y - first) * stride]);
 			}
-		}
+			for (int y = y0; y < y1; y++)
+				ResampleColumn(&rows[(y_axis.Start[y] - first) * stride], stride, &y_axis.Weights[y * y_axis.Taps], y_axis.Taps, dst_w, dst + y * dst_pitch);
+		};
 
-		if (s_state.Events.MouseClicked)
+		// the image threads have no context, and a job waiting for a pool could wait for itself
+		if (num_threads == 1 || bands == 1 || s_ctx == NULL || JobPool::InJob())
 		{
-			for (int i = (int)s_state.Windows.size() - 1; i >=0; i--)
-			{
-				if (PtInRect(s_state.Events.MousePos, s_state.Windows[i]->Rect))
-				{
-					s_state.Windows.push_back(s_state.Windows[i]);
-					s_state.Windows.erase(s_state.Windows.begin() + i);
-
-					break;
-				}
-			}
+			for (UINT band = 0; band < bands; band++)
+				resample_band(band, 0);
+			return;
 		}
-	}
 
-	void SetBgImage(std::string image, bool is_resized)
-	{
-		s_state.BgImage = image;
+		if (s_ctx->Jobs == NULL)
+			s_ctx->Jobs = new JobPool;
+		s_ctx->Jobs->Run(num_threads, bands, resample_band);
 	}
 
-	void Render()
+	bool LoadImagePack(const char* path)
 	{
-		// image bg
-		if (!s_state.BgImage.empty())
-		{
-			s_state.Render->DrawImage(NULL, s_state.BgImage, 0, 0, s_state.Render->GetMainRT()->GetSize().width, s_state.Render->GetMainRT()->GetSize().height);
-		}
+		assert(s_ctx->Render != NULL && "Call ImDui::InitResources() first");
 
-		// windows
-		for (size_t i = 0; i < s_state.Windows.size(); i++)
+#ifdef IMDUI_D2D
+		ImagePack* pack = new ImagePack;
+		if (!pack->Open(path))
 		{
-			if (s_state.Windows[i]->Visible)
-			{
-				ID2D1Bitmap* pBitmap = NULL;
-				s_state.Windows[i]->CRT->GetBitmap(&pBitmap);
-				s_state.Render->GetMainRT()->DrawBitmap(pBitmap, s_state.Windows[i]->Rect.ToD2DRectF(), s_state.Windows[i]->Alpha);
-				SafeRelease(&pBitmap);
-			}
-			s_state.Windows[i]->Visible = false;
+			OutWarning("ImDui: failed to open image pack %s", path);
+			delete pack;
+			return false;
 		}
 
-		// tooltip
-		if (s_state.StrToolTip[0])
-		{
-			const ImFloat2 text_size = s_state.Render->GetTextSize(s_state.StrToolTip);
-			ImFloat2 pos = s_state.Events.MousePos + ImFloat2(32, 16);
-			ImFloat4 bb(pos - s_state.Styles.FramePadding * 2, text_size + s_state.Styles.FramePadding * 2);
+		s_ctx->Render->GetImageLoader().AddPack(pack);
+		return true;
+#else
+		OutWarning("ImDui: image pack %s not loaded, the null renderer has no images", path);
+		return false;
+#endif
+	}
 
-			s_state.Render->DrawRoundedRect(NULL, s_state.Styles.Colors[Color_TooltipBg], bb, 5, 5, true);
-			s_state.Render->DrawText(NULL, s_state.Styles.Colors[Color_Text], s_state.StrToolTip, bb);
+	ImageLoadStats GetImageLoadStats()
+	{
+		ImageLoadStats stats;
+		memset(&stats, 0, sizeof(stats));
+#ifdef IMDUI_D2D
+		if (s_ctx->Render)
+		{
+			ImageLoader& loader = s_ctx->Render->GetImageLoader();
+			stats.Pending = loader.StatPending;
+			stats.Decoded = loader.StatDecoded;
+			stats.Ready = loader.StatReady;
+			stats.Failed = loader.StatFailed;
+			stats.Cancelled = loader.StatCancelled;
 		}
+#endif
+		return stats;
 	}
 
 	void PushItemWidth(float width)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		window->Layout.ItemWidth.push_back(width > 0.0f ? width : window->ItemWidthDefault);
 	}
 
 	void PopItemWidth()
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		window->Layout.ItemWidth.pop_back();
 	}
 
+	void PushClipRect(const ImFloat4& rect, bool intersect_with_current)
+	{
+		Window* window = s_ctx->RenderWindow;
+
+		ImFloat4 clip = rect;
+		if (intersect_with_current)
+		{
+			const ImFloat4& cur = window->ClipStack.back();
+			const float x0 = Max(clip.x, cur.x);
+			const float y0 = Max(clip.y, cur.y);
+			const float x1 = Min(clip.x + clip.z, cur.x + cur.z);
+			const float y1 = Min(clip.y + clip.w, cur.y + cur.w);
+			clip = ImFloat4(x0, y0, Max(0.0f, x1 - x0), Max(0.0f, y1 - y0));
+		}
+
+		window->ClipStack.push_back(clip);
+		window->DrawList.PushClipRect(clip);
+	}
+
+	void PopClipRect()
+	{
+		Window* window = s_ctx->RenderWindow;
+		assert(window->ClipStack.size() > 1 && "PopClipRect() without PushClipRect()");
+		window->ClipStack.pop_back();
+		window->DrawList.PopClipRect();
+	}
+
+	bool IsRectVisible(const ImFloat4& rect)
+	{
+		Window* window = s_ctx->RenderWindow;
+		if (window->Collapse)
+			return false;
+
+		const ImFloat4& clip = window->ClipStack.back();
+		return rect.x < clip.x + clip.z && rect.x + rect.z > clip.x && rect.y < clip.y + clip.w && rect.y + rect.w > clip.y;
+	}
+
+	bool IsRectVisible(ImFloat2 size)
+	{
+		return IsRectVisible(ImFloat4(s_ctx->RenderWindow->Layout.CursorPos, size));
+	}
+
 	void Shutdown()
 	{
 		ClearResources();
@@ -794,23 +4286,23 @@ namespace ImDui
 
 	bool WindowCloseButton(bool* open)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 
 		const ImUint id = window->GetID("##CLOSE");
 
-		const float title_bar_height = s_state.Styles.TitleBarHeight;
+		const float title_bar_height = s_ctx->Styles.TitleBarHeight;
 		const ImFloat4 bb(window->Rect.z - 20 + 2, 2, title_bar_height - 4, title_bar_height - 4);
 
 		bool hovered, held;
 		bool pressed = WidgetMouseEvent(bb, id, &hovered, &held, false);
 
 		// Render
-		const GuiStyle& style = s_state.Styles;
+		const GuiStyle& style = s_ctx->Styles;
 		const ImFloat4 col = style.Colors[(held && hovered) ? Color_ButtonActive : hovered ? Color_ButtonHovered : Color_Button];
-		s_state.Render->DrawRect(window->CRT, col, bb, true);
+		window->DrawList.DrawRect(col, bb, true);
 
-		s_state.Render->DrawLine(window->CRT, style.Colors[Color_Text], ImFloat2(bb.x + 4, bb.y + 4), ImFloat2(bb.x + bb.z - 4, bb.y + bb.w - 4));
-		s_state.Render->DrawLine(window->CRT, style.Colors[Color_Text], ImFloat2(bb.x + bb.z - 4, bb.y + 4), ImFloat2(bb.x + 4, bb.y + bb.w - 4));
+		window->DrawList.DrawLine(style.Colors[Color_Text], ImFloat2(bb.x + 4, bb.y + 4), ImFloat2(bb.x + bb.z - 4, bb.y + bb.w - 4));
+		window->DrawList.DrawLine(style.Colors[Color_Text], ImFloat2(bb.x + bb.z - 4, bb.y + 4), ImFloat2(bb.x + 4, bb.y + bb.w - 4));
 
 		if (open != NULL && pressed)
 			*open = !*open;
@@ -821,35 +4313,36 @@ namespace ImDui
 	void DrawWindowState(bool collapse)
 	{
 		float collapse_radius = 6;
-		ImFloat2 collapse_state_center(s_state.Styles.TitleBarHeight / 2, s_state.Styles.TitleBarHeight / 2);
-		ImFloat4 collapse_state_rect(s_state.Styles.TitleBarHeight / 2 - collapse_radius, s_state.Styles.TitleBarHeight / 2 - collapse_radius, collapse_radius * 2, collapse_radius * 2);
+		ImFloat2 collapse_state_center(s_ctx->Styles.TitleBarHeight / 2, s_ctx->Styles.TitleBarHeight / 2);
+		ImFloat4 collapse_state_rect(s_ctx->Styles.TitleBarHeight / 2 - collapse_radius, s_ctx->Styles.TitleBarHeight / 2 - collapse_radius, collapse_radius * 2, collapse_radius * 2);
 
-		s_state.Render->DrawRect(s_state.RenderWindow->CRT, s_state.Styles.Colors[Color_Text], collapse_state_rect, true);
-		s_state.Render->DrawLine(s_state.RenderWindow->CRT, s_state.Styles.Colors[Color_WindowBg], collapse_state_center - ImFloat2(4, 0), collapse_state_center + ImFloat2(4, 0));
+		s_ctx->RenderWindow->DrawList.DrawRect(s_ctx->Styles.Colors[Color_Text], collapse_state_rect, true);
+		s_ctx->RenderWindow->DrawList.DrawLine(s_ctx->Styles.Colors[Color_WindowBg], collapse_state_center - ImFloat2(4, 0), collapse_state_center + ImFloat2(4, 0));
 
 		if (collapse)
-			s_state.Render->DrawLine(s_state.RenderWindow->CRT, s_state.Styles.Colors[Color_WindowBg], collapse_state_center - ImFloat2(0, 4), collapse_state_center + ImFloat2(0, 4));
+			s_ctx->RenderWindow->DrawList.DrawLine(s_ctx->Styles.Colors[Color_WindowBg], collapse_state_center - ImFloat2(0, 4), collapse_state_center + ImFloat2(0, 4));
 	}
 
 	void DrawCollapseState(ImFloat2 pos, float offset, float height, bool open, float scale)
 	{
 		float length = height * 0.8f;
+		const float depth = 8 * scale;		// of the arrow
 
 		ImFloat2 a, b, c;
 		if (open)
 		{
 			a = ImFloat2(offset, length / 2);
-			b = ImFloat2(offset + length / 2, length / 2 + 8);
+			b = ImFloat2(offset + length / 2, length / 2 + depth);
 			c = ImFloat2(offset + length, length / 2);
 
-			a = a + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - 8 * 0.5f, 8 * 0.5f);
-			b = b + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - 8 * 0.5f, 8 * 0.5f);
-			c = c + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - 8 * 0.5f, 8 * 0.5f);
+			a = a + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - depth * 0.5f, depth * 0.5f);
+			b = b + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - depth * 0.5f, depth * 0.5f);
+			c = c + pos + ImFloat2(0, height * 0.1f) - ImFloat2(length * 0.5f - depth * 0.5f, depth * 0.5f);
 		}
 		else
 		{
 			a = ImFloat2(offset, 0);
-			b = ImFloat2(offset + 8, length / 2);
+			b = ImFloat2(offset + depth, length / 2);
 			c = ImFloat2(offset, length);
 
 			a = a + pos + ImFloat2(0, height * 0.1f);
@@ -858,20 +4351,15 @@ namespace ImDui
 		}
 
 		ImFloat2 pt_arr[3] = { a, b, c };
-		s_state.Render->DrawPolygonalLine(s_state.RenderWindow->CRT, s_state.Styles.Colors[Color_Text], pt_arr, 3);
+		s_ctx->RenderWindow->DrawList.DrawPolygonalLine(s_ctx->Styles.Colors[Color_Text], pt_arr, 3);
 	}
 
 	void DrawWidgetFrame(ImFloat4 rect, ImUint fill_col, bool border)
 	{
-		Window* window = s_state.RenderWindow;
-		s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[fill_col], rect, true);
-		if (window->Flags & ImDuiWindowFlags_ShowBorders)
-		{
-			D2D1_ANTIALIAS_MODE old_mode = window->CRT->GetAntialiasMode();
-			window->CRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
-			s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_Border], rect, false);
-			window->CRT->SetAntialiasMode(old_mode);
-		}
+		Window* window = s_ctx->RenderWindow;
+		window->DrawList.DrawRect(s_ctx->Styles.Colors[fill_col], rect, true);
+		if (border && (window->Flags & ImDuiWindowFlags_ShowBorders))
+			window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_Border], rect, false, true);
 	}
 
 	bool BeginWindow(const char* name, bool* p_open, ImFloat2 pos, ImFloat2 size, float fill_alpha, ImDuiWindowFlags flags)
@@ -891,26 +4379,28 @@ namespace ImDui
 			else
 				sizeReal = size;
 
+			assert(s_ctx->Parent == NULL && "Parallel window jobs must be submitted with ParallelWindow()");
 			window = new Window(name, posReal, sizeReal);
-			s_state.Windows.push_back(window);
+			s_ctx->Windows.push_back(window);
 		}
 
 		window->Flags = (ImDuiWindowFlags)flags;
 
 		if (fill_alpha < 0.0f)
-			fill_alpha = s_state.Styles.DefaultWindowAlpha;
+			fill_alpha = s_ctx->Styles.DefaultWindowAlpha;
 
 		window->Alpha = fill_alpha;
 		window->Visible = true;
 		window->ItemWidthDefault = (float)(int)(window->Rect.z > 0.0f ? window->Rect.z * 0.65f : 250.0f);
-		s_state.RenderWindow = window;
+		s_ctx->RenderWindow = window;
 
 		// window collapse
 		if (!(window->Flags & ImDuiWindowFlags_NoTitleBar))
 		{
-			if (s_state.Events.MouseDoubleClicked && PtInRect(s_state.Events.MousePos, ImFloat4(window->Rect.x, window->Rect.y, window->Rect.z, s_state.Styles.TitleBarHeight)))
+			if (s_ctx->Events.MouseDoubleClicked && PtInRect(s_ctx->Events.MousePos, ImFloat4(window->Rect.x, window->Rect.y, window->Rect.z, s_ctx->Styles.TitleBarHeight)))
 			{
 				window->Collapse = !window->Collapse;
+				NoteReaction();
 			}
 		}
 		else
@@ -918,21 +4408,27 @@ namespace ImDui
 			window->Collapse = false;
 		}
 
+		window->LastFrame = (s_ctx->Parent ? s_ctx->Parent : s_ctx)->FrameCount;
+		if (!window->Collapse)
+			window->BuiltFrames++;
+
 		// move window
 		const ImUint move_id = window->GetID("#MOVE");
-		if (s_state.ActiveId == move_id)
+		if (s_ctx->ActiveId == move_id)
 		{
-			if (s_state.Events.MouseDown)
+			if (s_ctx->Events.MouseDown)
 			{
 				if (!(window->Flags & ImDuiWindowFlags_NoMove))
 				{
-					window->Rect.x += s_state.Events.MouseDelta.x;
-					window->Rect.y += s_state.Events.MouseDelta.y;
+					window->Rect.x += s_ctx->Events.MouseDelta.x;
+					window->Rect.y += s_ctx->Events.MouseDelta.y;
+					if (s_ctx->Events.MouseDelta.x != 0 || s_ctx->Events.MouseDelta.y != 0)
+						NoteReaction();
 				}
 			}
 			else
 			{
-				s_state.ActiveId = 0;
+				s_ctx->ActiveId = 0;
 			}
 		}
 
@@ -940,25 +4436,26 @@ namespace ImDui
 		ImFloat4 resize_col;
 		if (!window->Collapse && !(window->Flags & ImDuiWindowFlags_NoResize))
 		{
-			const ImFloat4 resize_rect(ImFloat2(window->Rect.z, window->Rect.w) - s_state.Styles.ResizeGripSize, s_state.Styles.ResizeGripSize);
+			const ImFloat4 resize_rect(ImFloat2(window->Rect.z, window->Rect.w) - s_ctx->Styles.ResizeGripSize, s_ctx->Styles.ResizeGripSize);
 			const ImUint resize_id = window->GetID("##RESIZE");
 
 			bool hovered, held;
 			WidgetMouseEvent(resize_rect, resize_id, &hovered, &held, false);
-			resize_col = s_state.Styles.Colors[held ? Color_ResizeGripActive : hovered ? Color_ResizeGripHovered : Color_ResizeGrip];
+			resize_col = s_ctx->Styles.Colors[held ? Color_ResizeGripActive : hovered ? Color_ResizeGripHovered : Color_ResizeGrip];
 			if (held)
 			{
 				ImFloat2 tmpSize(window->Rect.z, window->Rect.w);
-				ImFloat2 realSize = Max(tmpSize + s_state.Events.MouseDelta, s_state.Styles.WindowMinSize);
+				ImFloat2 realSize = Max(tmpSize + s_ctx->Events.MouseDelta, s_ctx->Styles.WindowMinSize);
+				if (window->Rect.z != realSize.x || window->Rect.w != realSize.y)
+					NoteReaction();
 				window->Rect.z = realSize.x;
 				window->Rect.w = realSize.y;
-				window->Resize(realSize);
 			}
 		}
 
 		// Setup drawing context
-		window->Layout.CursorStartPos = ImFloat2(s_state.Styles.WindowPadding.x, 
-			((window->Flags & ImDuiWindowFlags_NoTitleBar) ? 0 : s_state.Styles.TitleBarHeight) + s_state.Styles.WindowPadding.y);
+		window->Layout.CursorStartPos = ImFloat2(s_ctx->Styles.WindowPadding.x, 
+			((window->Flags & ImDuiWindowFlags_NoTitleBar) ? 0 : s_ctx->Styles.TitleBarHeight) + s_ctx->Styles.WindowPadding.y);
 		window->Layout.CursorPos = window->Layout.CursorStartPos;
 		window->Layout.CursorPosPrevLine = window->Layout.CursorPos;
 		window->Layout.CurrentLineHeight = window->Layout.PrevLineHeight = 0.0f;
@@ -972,34 +4469,36 @@ namespace ImDui
 		float w = window->Rect.z;
 		float h = window->Rect.w;
 
-		ImFloat4 rect_title_bar(x + 0, y + 0, w, s_state.Styles.TitleBarHeight);
-		ImFloat4 rect_title_text(x + 20, y + 0, w, s_state.Styles.TitleBarHeight);
+		ImFloat4 rect_title_bar(x + 0, y + 0, w, s_ctx->Styles.TitleBarHeight);
+		ImFloat4 rect_title_text(x + 20, y + 0, w, s_ctx->Styles.TitleBarHeight);
 		ImFloat4 rect_window_bg(x, y, w, h);
 
-		s_state.Render->BeginDraw(window->CRT);
+		window->DrawList.Clear();
+		window->ClipStack.resize(0);
+		window->ClipStack.push_back(rect_window_bg);
 
 		if (window->Collapse)
 		{
-			s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_TitleBarCollapsed], rect_title_bar, true);
+			window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_TitleBarCollapsed], rect_title_bar, true);
 			if (window->Flags & ImDuiWindowFlags_ShowBorders)
-				s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_Border], rect_title_bar, false);
+				window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_Border], rect_title_bar, false);
 		}
 		else
 		{
-			s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_WindowBg], rect_window_bg, true);
-			s_state.Render->DrawTriangle(window->CRT, resize_col, ImFloat2(w - s_state.Styles.ResizeGripSize.x, h), ImFloat2(w, h), ImFloat2(w, h - s_state.Styles.ResizeGripSize.y), true);
+			window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_WindowBg], rect_window_bg, true);
+			window->DrawList.DrawTriangle(resize_col, ImFloat2(w - s_ctx->Styles.ResizeGripSize.x, h), ImFloat2(w, h), ImFloat2(w, h - s_ctx->Styles.ResizeGripSize.y), true);
 			if (!(window->Flags & ImDuiWindowFlags_NoTitleBar))
-				s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_TitleBar], rect_title_bar, true);
+				window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_TitleBar], rect_title_bar, true);
 
 			if (window->Flags & ImDuiWindowFlags_ShowBorders)
-				s_state.Render->DrawRect(window->CRT, s_state.Styles.Colors[Color_Border], rect_window_bg, false);
+				window->DrawList.DrawRect(s_ctx->Styles.Colors[Color_Border], rect_window_bg, false);
 		}
 
 		// title bar
 		if (!(window->Flags & ImDuiWindowFlags_NoTitleBar))
 		{
 			DrawWindowState(window->Collapse);
-			s_state.Render->DrawText(window->CRT, s_state.Styles.Colors[Color_Text], name, rect_title_text, D2DRender::MODE_LEFT);
+			window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], name, rect_title_text, MODE_LEFT);
 			if (p_open)
 				WindowCloseButton(p_open);
 		}
@@ -1009,20 +4508,132 @@ namespace ImDui
 
 	void EndWindow()
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
+		assert(window->ClipStack.size() == 1 && "PushClipRect() without PopClipRect()");
+
+		if (s_ctx->ActiveId == 0 && s_ctx->HoveredId == 0 && PtInRect(s_ctx->Events.MousePos, window->Rect) && s_ctx->Events.MouseClicked)
+			s_ctx->ActiveId = window->GetID("#MOVE");
+
+		s_ctx->RenderWindow = NULL;
+	}
+
+	void BeginParallelWindows()
+	{
+		assert(!s_ctx->InWindowJobs && s_ctx->RenderWindow == NULL);
+		s_ctx->InWindowJobs = true;
+		s_ctx->WindowJobs.resize(0);
+	}
+
+	void ParallelWindow(const char* name, bool* p_open, WindowJobFunc func, ImFloat2 pos, ImFloat2 size, float fill_alpha, ImDuiWindowFlags flags)
+	{
+		assert(s_ctx->InWindowJobs);
+
+		// windows are created here, on the calling thread, so that z-order does not depend on scheduling
+		Window* window = GetWindow(name);
+		if (!window)
+		{
+			window = new Window(name, (pos.x == 0 && pos.y == 0) ? ImFloat2(60, 60) : pos, (size.x == 0 && size.y == 0) ? ImFloat2(250, 250) : size);
+			s_ctx->Windows.push_back(window);
+		}
+
+		WindowJob job;
+		job.Win = window;
+		job.Name = name;
+		job.Open = p_open;
+		job.Pos = pos;
+		job.Size = size;
+		job.FillAlpha = fill_alpha;
+		job.Flags = flags;
+		job.Func = func;
+		job.HoveredId = job.ActiveId = 0;
+		job.MoveClaimed = false;
+		job.ReactTime = 0.0;
+		s_ctx->WindowJobs.push_back(job);
+	}
+
+	void EndParallelWindows(int num_threads)
+	{
+		assert(s_ctx->InWindowJobs);
+		s_ctx->InWindowJobs = false;
 
-		s_state.Render->EndDraw(window->CRT);
+		Context* ctx = s_ctx;
+		const ImUint hovered_id = ctx->HoveredId;
+		const ImUint active_id = ctx->ActiveId;
 
-		if (s_state.ActiveId == 0 && s_state.HoveredId == 0 && PtInRect(s_state.Events.MousePos, window->Rect) && s_state.Events.MouseClicked)
-			s_state.ActiveId = window->GetID("#MOVE");
-		s_state.RenderWindow = NULL;
+		if (ctx->Jobs == NULL)
+			ctx->Jobs = new JobPool;
+
+		// every job runs against its own copy of the interaction state, in the context of its worker
+		ctx->Jobs->Run(num_threads, (UINT)ctx->WindowJobs.size(), [ctx, hovered_id, active_id](UINT index, int worker)
+		{
+			WindowJob& job = ctx->WindowJobs[index];
+
+			Context*& job_ctx = ctx->JobContexts[worker];
+			if (job_ctx == NULL)
+			{
+				job_ctx = new Context;
+				job_ctx->Parent = ctx;
+			}
+			job_ctx->FPS = ctx->FPS;
+			job_ctx->Events = ctx->Events;
+			job_ctx->Styles = ctx->Styles;
+			job_ctx->HoveredWindow = ctx->HoveredWindow;
+			job_ctx->Render = ctx->Render;
+			job_ctx->HoveredId = hovered_id;
+			job_ctx->ActiveId = active_id;
+			job_ctx->HoveredIdPrev = ctx->HoveredIdPrev;
+			job_ctx->ActiveIdPrev = ctx->ActiveIdPrev;
+			job_ctx->ReactTime = 0.0;
+			job_ctx->StrToolTip[0] = '\0';
+
+			Context* prev_ctx = s_ctx;
+			s_ctx = job_ctx;
+			BeginWindow(job.Name.c_str(), job.Open, job.Pos, job.Size, job.FillAlpha, job.Flags);
+			if (job.Func)
+				job.Func();
+			EndWindow();
+			s_ctx = prev_ctx;
+
+			job.HoveredId = job_ctx->HoveredId;
+			job.ActiveId = job_ctx->ActiveId;
+			job.MoveClaimed = job.ActiveId != active_id && job.ActiveId == job.Win->GetID("#MOVE");
+			job.ReactTime = job_ctx->ReactTime;
+			job.ToolTip = job_ctx->StrToolTip;
+		});
+
+		// Merge in submission order, as if the windows had been built one after the other. The
+		// widgets of a window set the ids whatever the ids were, and only the hovered window has
+		// hovered widgets; the #MOVE of a window is only taken when the windows built before it
+		// left no hovered nor active id. A later tooltip replaces an earlier one. The recorded
+		// draw lists are replayed by Render() in z-order.
+		for (size_t i = 0; i < ctx->WindowJobs.size(); i++)
+		{
+			const WindowJob& job = ctx->WindowJobs[i];
+			if (job.MoveClaimed)
+			{
+				if (ctx->HoveredId == 0 && ctx->ActiveId == 0)
+					ctx->ActiveId = job.ActiveId;
+			}
+			else
+			{
+				if (job.HoveredId != hovered_id)
+					ctx->HoveredId = job.HoveredId;
+				if (job.ActiveId != active_id)
+					ctx->ActiveId = job.ActiveId;
+			}
+			if (job.ReactTime > 0.0 && (ctx->ReactTime == 0.0 || job.ReactTime < ctx->ReactTime))
+				ctx->ReactTime = job.ReactTime;
+			if (!job.ToolTip.empty())
+				FormatString(ctx->StrToolTip, ARRAYSIZE(ctx->StrToolTip), "%s", job.ToolTip.c_str());
+		}
+		ctx->WindowJobs.resize(0);
 	}
 
 	//////////////////////////////////////////////////////////////////////////
 
 	void ItemSize(ImFloat2 size, ImFloat2* adjust_start_offset)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return;
 
@@ -1032,7 +4643,7 @@ namespace ImDui
 
 		// Always align ourselves on pixel boundaries
 		window->Layout.CursorPosPrevLine = ImFloat2(window->Layout.CursorPos.x + size.x, window->Layout.CursorPos.y);
-		window->Layout.CursorPos = ImFloat2(s_state.Styles.WindowPadding.x, window->Layout.CursorPos.y + line_height + s_state.Styles.ItemSpacing.y);
+		window->Layout.CursorPos = ImFloat2(s_ctx->Styles.WindowPadding.x, window->Layout.CursorPos.y + line_height + s_ctx->Styles.ItemSpacing.y);
 
 		window->Layout.PrevLineHeight = line_height;
 		window->Layout.CurrentLineHeight = 0.0f;
@@ -1045,7 +4656,7 @@ namespace ImDui
 
 	void SameLine(int column_x, int spacing_w)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return;
 
@@ -1058,7 +4669,7 @@ namespace ImDui
 		}
 		else
 		{
-			if (spacing_w < 0) spacing_w = (int)s_state.Styles.ItemSpacing.x;
+			if (spacing_w < 0) spacing_w = (int)s_ctx->Styles.ItemSpacing.x;
 			x = window->Layout.CursorPosPrevLine.x + (float)spacing_w;
 			y = window->Layout.CursorPosPrevLine.y;
 		}
@@ -1068,29 +4679,58 @@ namespace ImDui
 
 	void Spacing()
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return;
 
 		ItemSize(ImFloat2(0, 0));
 	}
 
+	// An item of the given height at the cursor that lies outside the current clip rect only
+	// takes its place in the layout. Widgets call this before measuring any text, the active
+	// widget is never culled so that it keeps tracking the mouse.
+	static bool CullItem(float height, ImUint id = 0)
+	{
+		Window* window = s_ctx->RenderWindow;
+		if (id != 0 && id == s_ctx->ActiveId)
+			return false;
+
+		const ImFloat4& clip = window->ClipStack.back();
+		const float y = window->Layout.CursorPos.y;
+		if (clip.z > 0.0f && y < clip.y + clip.w && y + height > clip.y)
+			return false;
+
+		ItemSize(ImFloat2(0, height));
+		return true;
+	}
+
+	static float LineHeight()
+	{
+		return s_ctx->Render->GetLineHeight();
+	}
+
 	//////////////////////////////////////////////////////////////////////////
 
 	void TextV(const char* fmt, va_list args)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return;
 
-		static char buf[1024];
-		FormatStringV(buf, ARRAYSIZE(buf), fmt, args);
+		char* buf = s_ctx->TextBuf;
+		FormatStringV(buf, ARRAYSIZE(s_ctx->TextBuf), fmt, args);
+
+		int lines = 1;
+		for (const char* p = buf; *p; p++)
+			lines += (*p == '\n');
+		if (CullItem(LineHeight() * lines))
+			return;
 
-		const ImFloat2 fontsize = s_state.Render->GetTextSize(buf);
+		const ImFloat2 fontsize = s_ctx->Render->GetTextSize(buf);
 		const ImFloat4 fontrt(window->Layout.CursorPos, fontsize);
 		ItemSize(fontrt);
 	
-		s_state.Render->DrawText(window->CRT, s_state.Styles.Colors[Color_Text], buf, fontrt, D2DRender::MODE_LEFT);
+		window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], buf, fontrt, MODE_LEFT);
 	}
 
 	void Text(const char* label, ...)
@@ -1103,26 +4743,26 @@ namespace ImDui
 
 	bool WidgetMouseEvent(ImFloat4 bb, const ImUint id, bool* out_hovered, bool* out_held, bool repeat)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 
 		bb.x += window->Rect.x;
 		bb.y += window->Rect.y;
 
-		const bool hovered = (s_state.HoveredWindow == window) && PtInRect(s_state.Events.MousePos, bb);
+		const bool hovered = (s_ctx->HoveredWindow == window) && PtInRect(s_ctx->Events.MousePos, bb);
 		bool pressed = false;
 		if (hovered)
 		{
-			s_state.HoveredId = id;
-			if (s_state.Events.MouseClicked)
-				s_state.ActiveId = id;
-			else if (repeat && s_state.ActiveId)
+			s_ctx->HoveredId = id;
+			if (s_ctx->Events.MouseClicked)
+				s_ctx->ActiveId = id;
+			else if (repeat && s_ctx->ActiveId)
 				pressed = true;
 		}
 
 		bool held = false;
-		if (s_state.ActiveId == id)
+		if (s_ctx->ActiveId == id)
 		{
-			if (s_state.Events.MouseDown)
+			if (s_ctx->Events.MouseDown)
 			{
 				held = true;
 			}
@@ -1130,7 +4770,7 @@ namespace ImDui
 			{
 				if (hovered)
 					pressed = true;
-				s_state.ActiveId = 0;
+				s_ctx->ActiveId = 0;
 			}
 		}
 
@@ -1142,40 +4782,46 @@ namespace ImDui
 
 	bool Button(const char* label, ImFloat2 size)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return false;
 
 		const ImUint id = window->GetID(label);
-		ImFloat2 text_size = s_state.Render->GetTextSize(label);
+		if (CullItem((size.y != 0.0f ? size.y : LineHeight()) + s_ctx->Styles.FramePadding.y * 2, id))
+			return false;
+
+		ImFloat2 text_size = s_ctx->Render->GetTextSize(label);
 
 		if (size.x == 0.0f)
 			size.x = text_size.x;
 		if (size.y == 0.0f)
 			size.y = text_size.y;
 
-		ImFloat4 boundRect(window->Layout.CursorPos, size + s_state.Styles.FramePadding * 2);
+		ImFloat4 boundRect(window->Layout.CursorPos, size + s_ctx->Styles.FramePadding * 2);
 		ItemSize(boundRect);
 
 		bool hovered, held;
 		bool pressed = WidgetMouseEvent(boundRect, id, &hovered, &held, false);
 
 		DrawWidgetFrame(boundRect,(hovered && held) ? Color_ButtonActive : hovered ? Color_ButtonHovered : Color_Button);
-		s_state.Render->DrawText(window->CRT, s_state.Styles.Colors[Color_Text], label, boundRect);
+		window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], label, boundRect);
 
 		return pressed;
 	}
 
 	void CheckBox(const char* label, bool* v)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return;
 
-		const GuiStyle& style = s_state.Styles;
+		const GuiStyle& style = s_ctx->Styles;
 		const unsigned int id = window->GetID(label);
 
-		const ImFloat2 text_size = s_state.Render->GetTextSize(label);
+		if (CullItem(LineHeight() + style.FramePadding.y * 2, id))
+			return;
+
+		const ImFloat2 text_size = s_ctx->Render->GetTextSize(label);
 		ImFloat4 check_bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, text_size.y + style.FramePadding.y * 2, text_size.y + style.FramePadding.y * 2);
 		ItemSize(check_bb);
 		SameLine(0, style.ItemInnerSpacing.x);
@@ -1186,14 +4832,15 @@ namespace ImDui
 		DrawWidgetFrame(check_bb, Color_WidgetBg);
 
 		ImFloat4 hovered_rect(check_bb.x + window->Rect.x, check_bb.y + window->Rect.y, check_bb.z, check_bb.w);
-		const bool hovered = (s_state.HoveredWindow == window) && PtInRect(s_state.Events.MousePos, hovered_rect);
-		const bool pressed = hovered && s_state.Events.MouseClicked;
+		const bool hovered = (s_ctx->HoveredWindow == window) && PtInRect(s_ctx->Events.MousePos, hovered_rect);
+		const bool pressed = hovered && s_ctx->Events.MouseClicked;
 		if (hovered)
-			s_state.HoveredId = id;
+			s_ctx->HoveredId = id;
 		if (pressed)
 		{
 			*v = !(*v);
-			s_state.ActiveId = 0;
+			s_ctx->ActiveId = 0;
+			NoteReaction();
 		}
 
 		if (*v)
@@ -1203,25 +4850,28 @@ namespace ImDui
 			fillRect.y = check_bb.y + 4;
 			fillRect.z = check_bb.z - 4 * 2;
 			fillRect.w = check_bb.w - 4 * 2;
-			s_state.Render->DrawRect(window->CRT, style.Colors[Color_WidgetActive], fillRect, true);
+			window->DrawList.DrawRect(style.Colors[Color_WidgetActive], fillRect, true);
 		}
 
 		if (!IsHideText(label))
 		{
-			s_state.Render->DrawText(window->CRT, s_state.Styles.Colors[Color_Text], label, text_bb);
+			window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], label, text_bb);
 		}
 	}
 
 	bool RadioButton(const char* label, bool active)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return false;
 
-		const GuiStyle& style = s_state.Styles;
+		const GuiStyle& style = s_ctx->Styles;
 		const unsigned int id = window->GetID(label);
 
-		ImFloat2 text_size = s_state.Render->GetTextSize(label);
+		if (CullItem(Max(LineHeight() + style.FramePadding.y * 2 - 1, LineHeight() + style.FramePadding.y), id))
+			return false;
+
+		ImFloat2 text_size = s_ctx->Render->GetTextSize(label);
 		ImFloat4 check_bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, text_size.y + style.FramePadding.y * 2 - 1, text_size.y + style.FramePadding.y * 2 - 1);
 		ItemSize(check_bb);
 		SameLine(0, style.ItemInnerSpacing.x);
@@ -1235,20 +4885,20 @@ namespace ImDui
 		const float radius = check_bb.w * 0.5f;
 
 		ImFloat4 hovered_rect(check_bb.x + window->Rect.x, check_bb.y + window->Rect.y, check_bb.z, check_bb.w);
-		const bool hovered = (s_state.HoveredWindow == window) && PtInRect(s_state.Events.MousePos, hovered_rect);
-		const bool pressed = hovered && s_state.Events.MouseClicked;
+		const bool hovered = (s_ctx->HoveredWindow == window) && PtInRect(s_ctx->Events.MousePos, hovered_rect);
+		const bool pressed = hovered && s_ctx->Events.MouseClicked;
 		if (hovered)
-			s_state.HoveredId = id;
+			s_ctx->HoveredId = id;
 
-		s_state.Render->DrawEllipse(window->CRT, style.Colors[Color_WidgetBg], center.x, center.y, radius, radius, true);
+		window->DrawList.DrawEllipse(style.Colors[Color_WidgetBg], center.x, center.y, radius, radius, true);
 		if (active)
-			s_state.Render->DrawEllipse(window->CRT, style.Colors[Color_WidgetActive], center.x, center.y, radius - 4, radius - 4, true);
+			window->DrawList.DrawEllipse(style.Colors[Color_WidgetActive], center.x, center.y, radius - 4, radius - 4, true);
 
 		if (window->Flags & ImDuiWindowFlags_ShowBorders)
-			s_state.Render->DrawEllipse(window->CRT, style.Colors[Color_Border], center.x, center.y, radius, radius, false);
+			window->DrawList.DrawEllipse(style.Colors[Color_Border], center.x, center.y, radius, radius, false);
 
 		if (!IsHideText(label))
-			s_state.Render->DrawText(window->CRT, s_state.Styles.Colors[Color_Text], label, text_bb);
+			window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], label, text_bb);
 		
 		return pressed;
 	}
@@ -1257,18 +4907,21 @@ namespace ImDui
 	{
 		const bool pressed = ImDui::RadioButton(label, *v == v_button);
 		if (pressed)
+		{
 			*v = v_button;
+			NoteReaction();
+		}
 
 		return pressed;
 	}
 
 	bool Collapse(const char* label, const char* str_id, const bool display_frame, const bool default_open)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return false;
 
-		const GuiStyle& style = s_state.Styles;
+		const GuiStyle& style = s_ctx->Styles;
 
 		assert(str_id != NULL || label != NULL);
 		if (str_id == NULL)	str_id = label;
@@ -1277,8 +4930,10 @@ namespace ImDui
 
 		bool opened;
 		opened = window->StateStorage.GetValue(id, default_open) != 0;
+		if (CullItem(LineHeight() + (display_frame ? style.FramePadding.y * 2 : 0.0f), id))
+			return opened;
 
-		const ImFloat2 text_size = s_state.Render->GetTextSize(label);
+		const ImFloat2 text_size = s_ctx->Render->GetTextSize(label);
 		const ImFloat2 pos_min = window->Layout.CursorPos;
 		const ImFloat2 pos_max(window->Rect.z - style.WindowPadding.x * 2, window->Rect.w);
 		ImFloat4 bb = ImFloat4(pos_min.x, pos_min.y, pos_max.x, text_size.y);
@@ -1312,14 +4967,14 @@ namespace ImDui
 		{
 			DrawWidgetFrame(bb, (held && hovered) ? Color_CollapseActive : hovered ? Color_CollapseHovered : Color_Collapse);
 			DrawCollapseState(pos_min, bb.z - 50, bb.w, opened);
-			s_state.Render->DrawText(window->CRT, style.Colors[Color_Text], label, label_box, ImDui::D2DRender::MODE_LEFT);
+			window->DrawList.DrawText(style.Colors[Color_Text], label, label_box, MODE_LEFT);
 		}
 		else
 		{
 			if ((held && hovered) || hovered)
-				s_state.Render->DrawRect(window->CRT, col, bb, true);
+				window->DrawList.DrawRect(col, bb, true);
 			DrawCollapseState(pos_min, bb.z - 50, bb.w, opened);
-			s_state.Render->DrawText(window->CRT, style.Colors[Color_Text], label, label_box, ImDui::D2DRender::MODE_LEFT);
+			window->DrawList.DrawText(style.Colors[Color_Text], label, label_box, MODE_LEFT);
 		}
 
 		return opened;
@@ -1327,13 +4982,15 @@ namespace ImDui
 
 	bool SliderFloat(const char* label, float* v, float v_min, float v_max, const char* display_format, float power)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return false;
 
-		const GuiStyle& style = s_state.Styles;
+		const GuiStyle& style = s_ctx->Styles;
 		const unsigned int id = window->GetID(label);
 		const float w = window->Layout.ItemWidth.back();
+		if (CullItem(LineHeight() + style.FramePadding.y * 2, id))
+			return false;
 
 		if (!display_format)
 			display_format = "%.3f";
@@ -1355,12 +5012,12 @@ namespace ImDui
 
 		ImFloat2 text_size;
 		if (!IsHideText(label))
-			text_size = s_state.Render->GetTextSize(label);
+			text_size = s_ctx->Render->GetTextSize(label);
 		else
-			text_size = s_state.Render->GetTextSize("");
+			text_size = s_ctx->Render->GetTextSize("");
 
 		const ImFloat4 frame_bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, w + style.FramePadding.x*2.0f, text_size.y + style.FramePadding.y*2.0f);
-		const ImFloat4 slider_bb(frame_bb.x + s_state.Styles.FramePadding.x, frame_bb.y + s_state.Styles.FramePadding.y, frame_bb.z - s_state.Styles.FramePadding.x * 2, frame_bb.w - s_state.Styles.FramePadding.y * 2);
+		const ImFloat4 slider_bb(frame_bb.x + s_ctx->Styles.FramePadding.x, frame_bb.y + s_ctx->Styles.FramePadding.y, frame_bb.z - s_ctx->Styles.FramePadding.x * 2, frame_bb.w - s_ctx->Styles.FramePadding.y * 2);
 		const ImFloat4 bb(frame_bb.x, frame_bb.y, frame_bb.z + style.ItemInnerSpacing.x + text_size.x, frame_bb.w);
 
 		const bool is_unbound = v_min == -FLT_MAX || v_min == FLT_MAX || v_max == -FLT_MAX || v_max == FLT_MAX;
@@ -1393,25 +5050,25 @@ namespace ImDui
 			}
 		}
 
-		const bool hovered = (s_state.HoveredWindow == window) && 
-			PtInRect(s_state.Events.MousePos, ImFloat4(slider_bb.x + window->Rect.x, slider_bb.y + window->Rect.y, slider_bb.z, slider_bb.w));
+		const bool hovered = (s_ctx->HoveredWindow == window) && 
+			PtInRect(s_ctx->Events.MousePos, ImFloat4(slider_bb.x + window->Rect.x, slider_bb.y + window->Rect.y, slider_bb.z, slider_bb.w));
 		if (hovered)
-			s_state.HoveredId = id;
-		if (hovered && s_state.Events.MouseClicked)
-			s_state.ActiveId = id;
+			s_ctx->HoveredId = id;
+		if (hovered && s_ctx->Events.MouseClicked)
+			s_ctx->ActiveId = id;
 
 		bool value_changed = false;
 
 		ItemSize(bb);
 		DrawWidgetFrame(frame_bb, Color_WidgetBg);
 
-		if (s_state.ActiveId == id)
+		if (s_ctx->ActiveId == id)
 		{
-			if (s_state.Events.MouseDown)
+			if (s_ctx->Events.MouseDown)
 			{
 				if (!is_unbound)
 				{
-					const float normalized_pos = Clamp((s_state.Events.MousePos.x - window->Rect.x - slider_effective_x1) / slider_effective_w, 0.0f, 1.0f);
+					const float normalized_pos = Clamp((s_ctx->Events.MousePos.x - window->Rect.x - slider_effective_x1) / slider_effective_w, 0.0f, 1.0f);
 
 					// Linear slider
 					//float new_value = ImLerp(v_min, v_max, normalized_pos);
@@ -1452,103 +5109,353 @@ namespace ImDui
 					{
 						*v = new_value;
 						value_changed = true;
+						NoteReaction();
 					}
 				}
 			}
 			else
 			{
-				s_state.ActiveId = 0;
+				s_ctx->ActiveId = 0;
+			}
+		}
+
+		if (!is_unbound)
+		{
+			// Calculate slider grab positioning
+			float grab_t;
+			float v_clamped = Clamp(*v, v_min, v_max);
+			if (v_clamped < 0.0f)
+			{
+				float f = 1.0f - (v_clamped - v_min) / (Min(0.0f, v_max) - v_min);
+				grab_t = (1.0f - powf(f, 1.0f / power)) * linear_zero_pos;
+			}
+			else
+			{
+				float f = (v_clamped - Max(0.0f, v_min)) / (v_max - Max(0.0f, v_min));
+				grab_t = linear_zero_pos + powf(f, 1.0f / power) * (1.0f - linear_zero_pos);
 			}
+
+			// Draw
+			const float grab_x = Lerp(slider_effective_x1, slider_effective_x2, grab_t);
+			const ImFloat4 grab_bb(grab_x - grab_size_in_pixels*0.5f, frame_bb.y + 2.0f, grab_size_in_pixels, frame_bb.w - 2.0f - 1.0f);
+			window->DrawList.DrawRect(style.Colors[s_ctx->ActiveId == id ? Color_SliderActive : Color_Slider], grab_bb, true);
+		}
+
+		char value_buf[64];
+		FormatString(value_buf, ARRAYSIZE(value_buf), display_format, *v);
+
+		if (!IsHideText(value_buf))
+		{
+			const ImFloat2 value_buf_size = s_ctx->Render->GetTextSize(value_buf);
+			ImFloat4 value_buf_box(slider_bb.x + slider_bb.z / 2 - value_buf_size.x*0.5f, frame_bb.y + style.FramePadding.y, value_buf_size.x, value_buf_size.y);
+			window->DrawList.DrawText(style.Colors[Color_Text], value_buf, value_buf_box);
+		}
+
+		if (!IsHideText(label))
+		{
+			const ImFloat2 label_size = s_ctx->Render->GetTextSize(label);
+			ImFloat4 label_box(frame_bb.x + frame_bb.z + style.ItemInnerSpacing.x + style.FramePadding.x, slider_bb.y, label_size.x, label_size.y);
+			window->DrawList.DrawText(style.Colors[Color_Text], label, label_box);
+		}
+
+		return value_changed;
+	}
+
+	bool SliderInt(const char* label, int* v, int v_min, int v_max, const char* display_format)
+	{
+		if (!display_format)
+			display_format = "%.0f";
+		float v_f = (float)*v;
+		bool changed = ImDui::SliderFloat(label, &v_f, (float)v_min, (float)v_max, display_format, 1.0f);
+		*v = (int)v_f;
+		return changed;
+	}
+
+	bool ColorButton(const ImFloat4& col, bool small_height, bool outline_border)
+	{
+		Window* window = s_ctx->RenderWindow;
+		if (window->Collapse)
+			return false;
+
+		const GuiStyle& style = s_ctx->Styles;
+
+		const float square_size = LineHeight();
+		if (CullItem(square_size + (small_height ? 0 : style.FramePadding.y * 2)))
+			return false;
+
+		const ImFloat4 bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, square_size + style.FramePadding.x * 2, square_size + (small_height ? 0 : style.FramePadding.y * 2));
+		ItemSize(bb);
+
+		const bool hovered = (s_ctx->HoveredWindow == window) && 
+			PtInRect(s_ctx->Events.MousePos, ImFloat4(bb.x + window->Rect.x, bb.y + window->Rect.y, bb.z, bb.w));
+		const bool pressed = hovered && s_ctx->Events.MouseClicked;
+
+		if (outline_border)
+		{
+			window->DrawList.DrawRect(style.Colors[Color_WidgetBg], bb, true);
+			window->DrawList.DrawRect(col, ImFloat4(bb.x + 1, bb.y + 1, bb.z - 2, bb.w - 2), true);
+		}
+		else
+		{
+			window->DrawList.DrawRect(col, bb, true);
+		}
+
+		if (hovered)
+		{
+			int ix = (int)(col.x * 255.0f + 0.5f);
+			int iy = (int)(col.y * 255.0f + 0.5f);
+			int iz = (int)(col.z * 255.0f + 0.5f);
+			int iw = (int)(col.w * 255.0f + 0.5f);
+			ImDui::ToolTip("Color:\n(%.2f,%.2f,%.2f,%.2f)\n#%02X%02X%02X%02X", col.x, col.y, col.z, col.w, ix, iy, iz, iw);
 		}
 
-		if (!is_unbound)
+		return pressed;
+	}
+
+	void Image(const char* path, ImFloat2 size)
+	{
+		Window* window = s_ctx->RenderWindow;
+		if (window->Collapse)
+			return;
+
+		if (CullItem(size.y))
+			return;
+
+		const ImFloat4 bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, size.x, size.y);
+		ItemSize(bb);
+
+		window->DrawList.DrawImage(path, bb);
+	}
+
+	void ImageViewer(const char* path, ImFloat2 size)
+	{
+		Window* window = s_ctx->RenderWindow;
+		if (window->Collapse)
+			return;
+
+		// view state: center in source pixels and zoom, 0 until fitted to the image
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%s##view", path);
+		const ImUint id = window->GetID(s_ctx->TextBuf);
+		if (CullItem(size.y, id))
+			return;
+
+		const ImFloat4 bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, size.x, size.y);
+		ItemSize(bb);
+
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%s##zoom", path);
+		const ImUint id_zoom = window->GetID(s_ctx->TextBuf);
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%s##cx", path);
+		const ImUint id_cx = window->GetID(s_ctx->TextBuf);
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%s##cy", path);
+		const ImUint id_cy = window->GetID(s_ctx->TextBuf);
+
+		float zoom = window->StateStorage.GetFloat(id_zoom);
+		ImFloat2 center(window->StateStorage.GetFloat(id_cx), window->StateStorage.GetFloat(id_cy));
+
+		bool hovered, held;
+		WidgetMouseEvent(bb, id, &hovered, &held);
+
+		Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
+		UINT width, height;
+		if (ctx->Render->GetImageSize(path, &width, &height))
 		{
-			// Calculate slider grab positioning
-			float grab_t;
-			float v_clamped = Clamp(*v, v_min, v_max);
-			if (v_clamped < 0.0f)
+			const float fit = std::min(bb.z / width, bb.w / height);
+			if (zoom <= 0.0f || (hovered && s_ctx->Events.MouseDoubleClicked))
 			{
-				float f = 1.0f - (v_clamped - v_min) / (Min(0.0f, v_max) - v_min);
-				grab_t = (1.0f - powf(f, 1.0f / power)) * linear_zero_pos;
+				zoom = fit;
+				center = ImFloat2(width * 0.5f, height * 0.5f);
 			}
-			else
+
+			const ImFloat2 old_center = center;
+			const float old_zoom = zoom;
+			if (held)
+				center -= s_ctx->Events.MouseDelta / zoom;
+
+			if (hovered && s_ctx->Events.MouseWheel != 0)
 			{
-				float f = (v_clamped - Max(0.0f, v_min)) / (v_max - Max(0.0f, v_min));
-				grab_t = linear_zero_pos + powf(f, 1.0f / power) * (1.0f - linear_zero_pos);
+				// keeps the source pixel under the mouse in place, 1.25x a notch; the wheel of
+				// the frame is used up, no other view zooms with it
+				ImFloat2 mouse = s_ctx->Events.MousePos - ImFloat2(window->Rect.x + bb.x + bb.z * 0.5f, window->Rect.y + bb.y + bb.w * 0.5f);
+				const ImFloat2 anchor = center + mouse / zoom;
+				zoom *= powf(1.25f, (float)s_ctx->Events.MouseWheel);
+				zoom = std::max(fit * 0.5f, std::min(zoom, 16.0f));
+				center = anchor - mouse / zoom;
+				s_ctx->Events.MouseWheel = 0;
 			}
 
-			// Draw
-			const float grab_x = Lerp(slider_effective_x1, slider_effective_x2, grab_t);
-			const ImFloat4 grab_bb(grab_x - grab_size_in_pixels*0.5f, frame_bb.y + 2.0f, grab_size_in_pixels, frame_bb.w - 2.0f - 1.0f);
-			s_state.Render->DrawRect(window->CRT, style.Colors[s_state.ActiveId == id ? Color_SliderActive : Color_Slider], grab_bb, true);
+			center.x = std::max(0.0f, std::min(center.x, (float)width));
+			center.y = std::max(0.0f, std::min(center.y, (float)height));
+			if (center.x != old_center.x || center.y != old_center.y || zoom != old_zoom)
+				NoteReaction();
+
+			window->StateStorage.SetFloat(id_zoom, zoom);
+			window->StateStorage.SetFloat(id_cx, center.x);
+			window->StateStorage.SetFloat(id_cy, center.y);
 		}
 
-		char value_buf[64];
-		FormatString(value_buf, ARRAYSIZE(value_buf), display_format, *v);
+		window->DrawList.DrawImageView(path, bb, center, zoom);
+	}
 
-		if (!IsHideText(value_buf))
-		{
-			const ImFloat2 value_buf_size = s_state.Render->GetTextSize(value_buf);
-			ImFloat4 value_buf_box(slider_bb.x + slider_bb.z / 2 - value_buf_size.x*0.5f, frame_bb.y + style.FramePadding.y, value_buf_size.x, value_buf_size.y);
-			s_state.Render->DrawText(window->CRT, style.Colors[Color_Text], value_buf, value_buf_box);
-		}
+	// cells [first, last) covered by pixel p when cells are shown on pixels
+	static void HeatmapCells(int p, int pixels, int cells, int* first, int* last)
+	{
+		*first = (int)((LONGLONG)p * cells / pixels);
+		*last = std::max(*first + 1, (int)((LONGLONG)(p + 1) * cells / pixels));
+	}
 
-		if (!IsHideText(label))
+	// Recomputes the pixels [x0, x1) x [y0, y1) of a heatmap: every pixel averages the cells
+	// it covers, then a row of averages goes through the colormap.
+	static void UpdateHeatmap(HeatmapData* data, const float* values, int stride, int x0, int y0, int x1, int y1)
+	{
+		int c0, c1, unused;
+		HeatmapCells(x0, data->Width, data->Cols, &c0, &unused);
+		HeatmapCells(x1 - 1, data->Width, data->Cols, &unused, &c1);
+
+		const ImUint* lut = GetColormap(data->Colormap);
+		const float scale = (data->Max != data->Min) ? 255.0f / (data->Max - data->Min) : 0.0f;
+		FrameArenaScope scope;
+		float* sums = s_frameArena.Alloc<float>(c1 - c0);
+		float* averages = s_frameArena.Alloc<float>(x1 - x0);
+
+		for (int y = y0; y < y1; y++)
 		{
-			const ImFloat2 label_size = s_state.Render->GetTextSize(label);
-			ImFloat4 label_box(frame_bb.x + frame_bb.z + style.ItemInnerSpacing.x + style.FramePadding.x, slider_bb.y, label_size.x, label_size.y);
-			s_state.Render->DrawText(window->CRT, style.Colors[Color_Text], label, label_box);
+			int r0, r1;
+			HeatmapCells(y, data->Height, data->Rows, &r0, &r1);
+			std::fill(sums, sums + (c1 - c0), 0.0f);
+			for (int r = r0; r < r1; r++)
+			{
+				const float* row = values + (size_t)r * stride + c0;
+				for (int c = 0; c < c1 - c0; c++)
+					sums[c] += row[c];
+			}
+
+			for (int x = x0; x < x1; x++)
+			{
+				int first, last;
+				HeatmapCells(x, data->Width, data->Cols, &first, &last);
+				float sum = 0.0f;
+				for (int c = first; c < last; c++)
+					sum += sums[c - c0];
+				averages[x - x0] = sum / (float)((last - first) * (r1 - r0));
+			}
+
+			ColormapRow(averages, x1 - x0, data->Min, scale, lut, &data->Pixels[y * data->Width + x0]);
 		}
 
-		return value_changed;
+		data->AddDirty(x0, y0, x1, y1);
+		data->Version++;
 	}
 
-	bool SliderInt(const char* label, int* v, int v_min, int v_max, const char* display_format)
+	void Heatmap(const char* label, const float* values, int cols, int rows, int stride, float v_min, float v_max,
+		ImFloat2 size, HeatmapColormap colormap, const HeatmapRegion* dirty, int dirty_count)
 	{
-		if (!display_format)
-			display_format = "%.0f";
-		float v_f = (float)*v;
-		bool changed = ImDui::SliderFloat(label, &v_f, (float)v_min, (float)v_max, display_format, 1.0f);
-		*v = (int)v_f;
-		return changed;
-	}
+		Window* window = s_ctx->RenderWindow;
+		if (cols <= 0 || rows <= 0)
+			return;
 
-	bool ColorButton(const ImFloat4& col, bool small_height, bool outline_border)
-	{
-		Window* window = s_state.RenderWindow;
-		if (window->Collapse)
-			return false;
+		const ImUint id = window->GetID(label);
+		Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
 
-		const GuiStyle& style = s_state.Styles;
+		// the map, its legend bar and the legend labels
+		const float spacing = s_ctx->Styles.ItemSpacing.y;
+		if (window->Collapse || CullItem(size.y + spacing + 8.0f + spacing + LineHeight(), id))
+		{
+			// dirty regions are not tracked while collapsed or culled, the next visible frame
+			// redraws everything
+			std::lock_guard<std::mutex> lock(ctx->HeatmapMutex);
+			ImHashMap<ImUint, HeatmapData*, AllocCategory_Heatmaps>::iterator it = ctx->Heatmaps.find(id);
+			if (it != ctx->Heatmaps.end())
+			{
+				std::lock_guard<std::mutex> data_lock(it->second->Mutex);
+				it->second->Width = 0;
+				it->second->LastFrame = ctx->FrameCount;
+			}
+			return;
+		}
 
-		const float square_size = s_state.Render->GetTextSize("").y;
-		const ImFloat4 bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, square_size + style.FramePadding.x * 2, square_size + (small_height ? 0 : style.FramePadding.y * 2));
+		const ImFloat4 bb(window->Layout.CursorPos.x, window->Layout.CursorPos.y, size.x, size.y);
 		ItemSize(bb);
 
-		const bool hovered = (s_state.HoveredWindow == window) && 
-			PtInRect(s_state.Events.MousePos, ImFloat4(bb.x + window->Rect.x, bb.y + window->Rect.y, bb.z, bb.w));
-		const bool pressed = hovered && s_state.Events.MouseClicked;
+		bool hovered, held;
+		WidgetMouseEvent(bb, id, &hovered, &held);
 
-		if (outline_border)
+		HeatmapData* data;
+		ImUint version;
 		{
-			s_state.Render->DrawRect(window->CRT, style.Colors[Color_WidgetBg], bb, true);
-			s_state.Render->DrawRect(window->CRT, col, ImFloat4(bb.x + 1, bb.y + 1, bb.z - 2, bb.w - 2), true);
+			std::lock_guard<std::mutex> lock(ctx->HeatmapMutex);
+			HeatmapData*& slot = ctx->Heatmaps[id];
+			if (slot == NULL)
+				slot = new HeatmapData;
+			data = slot;
 		}
-		else
+
 		{
-			s_state.Render->DrawRect(window->CRT, col, bb, true);
+			const int width = std::max(1, (int)size.x);
+			const int height = std::max(1, (int)size.y);
+
+			std::lock_guard<std::mutex> lock(data->Mutex);
+			data->LastFrame = ctx->FrameCount;
+			if (dirty_count < 0 || data->Width != width || data->Height != height || data->Cols != cols || data->Rows != rows ||
+				data->Min != v_min || data->Max != v_max || data->Colormap != colormap)
+			{
+				data->Width = width;
+				data->Height = height;
+				data->Cols = cols;
+				data->Rows = rows;
+				data->Min = v_min;
+				data->Max = v_max;
+				data->Colormap = colormap;
+				data->Pixels.resize(width * height);
+				UpdateHeatmap(data, values, stride, 0, 0, width, height);
+			}
+			else
+			{
+				// pixels touching a dirty cell, one more on each side for the rounding of HeatmapCells()
+				for (int i = 0; i < dirty_count; i++)
+				{
+					const HeatmapRegion& region = dirty[i];
+					const int x0 = std::max(0, (int)((LONGLONG)region.X * width / cols) - 1);
+					const int y0 = std::max(0, (int)((LONGLONG)region.Y * height / rows) - 1);
+					const int x1 = std::min(width, (int)(((LONGLONG)(region.X + region.Width) * width + cols - 1) / cols) + 1);
+					const int y1 = std::min(height, (int)(((LONGLONG)(region.Y + region.Height) * height + rows - 1) / rows) + 1);
+					if (x0 < x1 && y0 < y1)
+						UpdateHeatmap(data, values, stride, x0, y0, x1, y1);
+				}
+			}
+			version = data->Version;
 		}
 
+		window->DrawList.DrawHeatmap(id, version, bb);
+
 		if (hovered)
 		{
-			int ix = (int)(col.x * 255.0f + 0.5f);
-			int iy = (int)(col.y * 255.0f + 0.5f);
-			int iz = (int)(col.z * 255.0f + 0.5f);
-			int iw = (int)(col.w * 255.0f + 0.5f);
-			ImDui::ToolTip("Color:\n(%.2f,%.2f,%.2f,%.2f)\n#%02X%02X%02X%02X", col.x, col.y, col.z, col.w, ix, iy, iz, iw);
+			const float mx = s_ctx->Events.MousePos.x - window->Rect.x - bb.x;
+			const float my = s_ctx->Events.MousePos.y - window->Rect.y - bb.y;
+			const int col = std::min(cols - 1, (int)(mx * cols / bb.z));
+			const int row = std::min(rows - 1, (int)(my * rows / bb.w));
+			ToolTip("[%d, %d] %g", col, row, values[(size_t)row * stride + col]);
 		}
 
-		return pressed;
+		// legend: the colormap from v_min to v_max
+		const ImUint* lut = GetColormap(colormap);
+		const ImFloat4 bar(window->Layout.CursorPos.x, window->Layout.CursorPos.y, size.x, 8.0f);
+		ItemSize(bar);
+		const int steps = 32;
+		for (int i = 0; i < steps; i++)
+		{
+			const float x = bar.x + bar.z * i / steps;
+			const ImFloat4 step(x, bar.y, bar.x + bar.z * (i + 1) / steps - x, bar.w);
+			window->DrawList.DrawRect(ImHexToRGBA(lut[i * 255 / (steps - 1)] & 0xffffff), step, true, true);
+		}
+
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%g", v_max);
+		const ImFloat4 labels(window->Layout.CursorPos, ImFloat2(size.x, s_ctx->Render->GetTextSize(s_ctx->TextBuf).y));
+		ItemSize(labels);
+		window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], s_ctx->TextBuf, labels, MODE_RIGHT);
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%g", (v_min + v_max) * 0.5f);
+		window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], s_ctx->TextBuf, labels, MODE_CENTER);
+		FormatString(s_ctx->TextBuf, sizeof(s_ctx->TextBuf), "%g", v_min);
+		window->DrawList.DrawText(s_ctx->Styles.Colors[Color_Text], s_ctx->TextBuf, labels, MODE_LEFT);
 	}
 
 	bool ColorEdit3(const char* label, float col[3])
@@ -1567,17 +5474,14 @@ namespace ImDui
 
 	bool ColorEdit4(const char* label, float col[4], bool alpha)
 	{
-		Window* window = s_state.RenderWindow;
+		Window* window = s_ctx->RenderWindow;
 		if (window->Collapse)
 			return false;
 
-		const GuiStyle& style = s_state.Styles;
-		const unsigned int id = window->GetID(label);
+		const GuiStyle& style = s_ctx->Styles;
 		const float w_full = window->Layout.ItemWidth.back();
 		const float square_sz = (style.FontSize + style.FramePadding.x * 2.0f);
 
-		const ImFloat2 text_size = s_state.Render->GetTextSize(label);
-
 		float fx = col[0];
 		float fy = col[1];
 		float fz = col[2];
@@ -1634,8 +5538,12 @@ namespace ImDui
 		if (!IsHideText(label))
 		{
 			ImDui::SameLine();
-			s_state.Render->DrawText(window->CRT, style.Colors[Color_Text], label, ImFloat4(window->Layout.CursorPos.x, style.FramePadding.y + window->Layout.CursorPos.y, text_size.x, text_size.y));
-			ItemSize(text_size);
+			if (!CullItem(LineHeight()))
+			{
+				const ImFloat2 text_size = s_ctx->Render->GetTextSize(label);
+				window->DrawList.DrawText(style.Colors[Color_Text], label, ImFloat4(window->Layout.CursorPos.x, style.FramePadding.y + window->Layout.CursorPos.y, text_size.x, text_size.y));
+				ItemSize(text_size);
+			}
 		}
 
 		// Convert back
@@ -1687,11 +5595,11 @@ namespace ImDui
 
 	void ShowStyleEditor()
 	{
-		GuiStyle& style = s_state.Styles;
+		GuiStyle& style = s_ctx->Styles;
 		const GuiStyle def;
 
 		if (ImDui::Button("Revert Style"))
-			s_state.Styles = def;
+			s_ctx->Styles = def;
 
 		for (size_t i = 0; i < Color_COUNT; i++)
 		{
@@ -1703,11 +5611,16 @@ namespace ImDui
 		}
 	}
 
+	GuiStyle& GetStyle()
+	{
+		return s_ctx->Styles;
+	}
+
 	void ToolTip(const char* fmt, ...)
 	{
 		va_list args;
 		va_start(args, fmt);
-		FormatStringV(s_state.StrToolTip, ARRAYSIZE(s_state.StrToolTip), fmt, args);
+		FormatStringV(s_ctx->StrToolTip, ARRAYSIZE(s_ctx->StrToolTip), fmt, args);
 		va_end(args);
 	}
 
@@ -1756,13 +5669,21 @@ namespace ImDui
 	// Event
 
 	Event::Event()
+		: MouseDoubleClickTime(0.30f)
+		, MouseDoubleClickMaxDist(6.0f)
+		, MousePos(-1, -1)
+		, MouseDown(false)
+		, MouseWheel(0)
+		, WantCaptureMouse(false)
+		, Time(0.0)
+		, DeltaTime(0.0f)
+		, MousePosPrev(-1, -1)
+		, MouseClicked(false)
+		, MouseClickedTime(0.0)
+		, MouseDoubleClicked(false)
+		, MouseDownTime(0.0f)
 	{
-		memset(this, 0, sizeof(*this));
-
-		MousePos = ImFloat2(-1, -1);
-		MousePosPrev = ImFloat2(-1, -1);
-		MouseDoubleClickTime = 0.30f;
-		MouseDoubleClickMaxDist = 6.0f;
+		memset(KeysDown, 0, sizeof(KeysDown));
 	}
 
 	// Storage
@@ -1774,7 +5695,7 @@ namespace ImDui
 
 	int Storage::GetValue(ImUint key, int default_val)
 	{
-		std::unordered_map<ImUint, int>::iterator iter = Data.find(key);
+		ImHashMap<ImUint, int, AllocCategory_Storage>::iterator iter = Data.find(key);
 		if (iter != Data.end())
 			return iter->second;
 		else
@@ -1783,61 +5704,440 @@ namespace ImDui
 
 	void Storage::SetValue(ImUint key, int val)
 	{
-		std::unordered_map<ImUint, int>::iterator iter = Data.find(key);
+		ImHashMap<ImUint, int, AllocCategory_Storage>::iterator iter = Data.find(key);
 		if (iter != Data.end())
 			iter->second = val;
 		else
 			Data[key] = val;
 	}
 
+	float Storage::GetFloat(ImUint key, float default_val)
+	{
+		int bits;
+		memcpy(&bits, &default_val, sizeof(bits));
+		bits = GetValue(key, bits);
+
+		float val;
+		memcpy(&val, &bits, sizeof(val));
+		return val;
+	}
+
+	void Storage::SetFloat(ImUint key, float val)
+	{
+		int bits;
+		memcpy(&bits, &val, sizeof(bits));
+		SetValue(key, bits);
+	}
+
 	void Storage::SetAllInt(int v)
 	{
 		for (auto iter = Data.begin(); iter != Data.end(); iter++)
 			iter->second = v;
 	}
 
-	// Window
+	// DrawCmdList
+
+	void DrawCmdList::Clear()
+	{
+		Cmds.resize(0);
+		Points.resize(0);
+		TextBuffer.resize(0);
+	}
+
+	void DrawCmdList::Swap(DrawCmdList& other)
+	{
+		Cmds.swap(other.Cmds);
+		Points.swap(other.Points);
+		TextBuffer.swap(other.TextBuffer);
+	}
+
+	// commands are zeroed by AddCmd(), padding included, so the bytes can be hashed as they are
+	ImUint DrawCmdList::Hash() const
+	{
+		ImUint hash = HashBytes(Cmds.data(), Cmds.size() * sizeof(DrawCmd));
+		hash = HashBytes(Points.data(), Points.size() * sizeof(ImFloat2), hash);
+		return HashBytes(TextBuffer.data(), TextBuffer.size(), hash);
+	}
+
+	DrawCmd& DrawCmdList::AddCmd(DrawCmdType type, const ImFloat4& color)
+	{
+		Cmds.push_back(DrawCmd());
+		DrawCmd& cmd = Cmds.back();
+		memset((void*)&cmd, 0, sizeof(cmd));		// the padding too, the copy left it undefined
+		cmd.Type = type;
+		cmd.Color = color;
+		cmd.Align = MODE_CENTER;
+		return cmd;
+	}
+
+	void DrawCmdList::DrawLine(ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Line, color);
+		cmd.Offset = (ImUint)Points.size();
+		cmd.Count = 2;
+		Points.push_back(pt1);
+		Points.push_back(pt2);
+	}
+
+	void DrawCmdList::DrawRect(ImFloat4 color, ImFloat4 rt, bool isFilled, bool isAliased)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Rect, color);
+		cmd.Rect = rt;
+		cmd.Filled = isFilled;
+		cmd.Aliased = isAliased;
+	}
+
+	void DrawCmdList::DrawRoundedRect(ImFloat4 color, ImFloat4 rt, float radiusX, float radiusY, bool isFilled)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_RoundedRect, color);
+		cmd.Rect = rt;
+		cmd.Radius = ImFloat2(radiusX, radiusY);
+		cmd.Filled = isFilled;
+	}
+
+	void DrawCmdList::DrawEllipse(ImFloat4 color, float x, float y, float radiusX, float radiusY, bool isFilled)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Ellipse, color);
+		cmd.Rect = ImFloat4(x, y, 0, 0);
+		cmd.Radius = ImFloat2(radiusX, radiusY);
+		cmd.Filled = isFilled;
+	}
+
+	void DrawCmdList::DrawTriangle(ImFloat4 color, const ImFloat2& pt1, const ImFloat2& pt2, const ImFloat2& pt3, bool isFilled)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Polygon, color);
+		cmd.Offset = (ImUint)Points.size();
+		cmd.Count = 3;
+		cmd.Filled = isFilled;
+		Points.push_back(pt1);
+		Points.push_back(pt2);
+		Points.push_back(pt3);
+	}
+
+	void DrawCmdList::DrawPolygonalLine(ImFloat4 color, const ImFloat2* array, ImUint count)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_PolygonalLine, color);
+		cmd.Offset = (ImUint)Points.size();
+		cmd.Count = count;
+		Points.insert(Points.end(), array, array + count);
+	}
+
+	void DrawCmdList::DrawText(ImFloat4 color, const char* txt, const ImFloat4& rt, TEXT_ALIGNMENT_MODE mode)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Text, color);
+		cmd.Rect = rt;
+		cmd.Align = mode;
+		cmd.Offset = (ImUint)TextBuffer.size();
+		cmd.Count = (ImUint)strlen(txt);
+		TextBuffer.insert(TextBuffer.end(), txt, txt + cmd.Count + 1);
+	}
+
+	void DrawCmdList::DrawImage(const char* path, const ImFloat4& rt)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Image, ImFloat4());
+		cmd.Rect = rt;
+		cmd.Offset = (ImUint)TextBuffer.size();
+		cmd.Count = (ImUint)strlen(path);
+		TextBuffer.insert(TextBuffer.end(), path, path + cmd.Count + 1);
+	}
+
+	void DrawCmdList::DrawImageView(const char* path, const ImFloat4& rt, const ImFloat2& center, float zoom)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_ImageView, ImFloat4());
+		cmd.Rect = rt;
+		cmd.Offset = (ImUint)TextBuffer.size();
+		cmd.Count = (ImUint)Points.size();
+		TextBuffer.insert(TextBuffer.end(), path, path + strlen(path) + 1);
+		Points.push_back(center);
+		Points.push_back(ImFloat2(zoom, 0.0f));
+	}
+
+	void DrawCmdList::DrawHeatmap(ImUint id, ImUint version, const ImFloat4& rt)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_Heatmap, ImFloat4());
+		cmd.Rect = rt;
+		cmd.Offset = version;
+		cmd.Count = id;
+	}
+
+	void DrawCmdList::PushClipRect(const ImFloat4& rt)
+	{
+		DrawCmd& cmd = AddCmd(DrawCmd_PushClip, ImFloat4());
+		cmd.Rect = rt;
+	}
+
+	void DrawCmdList::PopClipRect()
+	{
+		AddCmd(DrawCmd_PopClip, ImFloat4());
+	}
+
+#ifdef IMDUI_D2D
+
+	// ImagePack
+
+	ImagePack::~ImagePack()
+	{
+		if (Data)
+			UnmapViewOfFile(Data);
+		if (Mapping)
+			CloseHandle(Mapping);
+		if (File != INVALID_HANDLE_VALUE)
+			CloseHandle(File);
+	}
+
+	bool ImagePack::Open(const char* path)
+	{
+		FrameArenaScope scope;
+		UINT32 path_length;
+		File = CreateFileW(FrameATOW(path, &path_length), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (File == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(File, &size) || size.QuadPart < (LONGLONG)sizeof(ImagePackHeader))
+			return false;
+
+		Mapping = CreateFileMappingW(File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (Mapping == NULL)
+			return false;
+
+		Data = (const BYTE*)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (Data == NULL)
+			return false;
+
+		const ImagePackHeader* header = (const ImagePackHeader*)Data;
+		if (header->Magic != IMAGE_PACK_MAGIC || header->Version != IMAGE_PACK_VERSION ||
+			sizeof(ImagePackHeader) + (LONGLONG)header->Count * sizeof(ImagePackEntry) > size.QuadPart)
+			return false;
+
+		const ImagePackEntry* entries = (const ImagePackEntry*)(header + 1);
+		for (ImUint i = 0; i < header->Count; i++)
+		{
+			const ImagePackEntry& entry = entries[i];
+			if (memchr(entry.Name, 0, sizeof(entry.Name)) == NULL || (ULONGLONG)entry.Width * entry.Height * 4 != entry.Size ||
+				(ULONGLONG)entry.Offset + entry.Size > (ULONGLONG)size.QuadPart)
+				return false;
+
+			// a scaled entry is only found at its size, the bare name is the source size
+			char key[sizeof(entry.Name) + 32];
+			const char* colon = strrchr(entry.Name, ':');
+			UINT width, height;
+			char end;
+			const bool scaled = colon && sscanf(colon + 1, "%ux%u%c", &width, &height, &end) == 2;
+			if (scaled && (width != entry.Width || height != entry.Height))
+				return false;
+
+			const int length = scaled ? (int)(colon - entry.Name) : (int)strlen(entry.Name);
+			sprintf(key, "%.*s|%ux%u", length, entry.Name, entry.Width, entry.Height);
+			Index[key] = &entry;
+			if (!scaled)
+				Index[entry.Name] = &entry;
+		}
+		return true;
+	}
+
+#endif
 
-	ImUint Window::_idseed = 1;
+	// LatencyHistogram
+
+	void LatencyHistogram::Add(float ms)
+	{
+		int bin = (int)(ms * 2.0f);
+		bin = (bin < 0) ? 0 : (bin >= BIN_COUNT) ? BIN_COUNT - 1 : bin;
+		Bins[bin]++;
+		Count++;
+	}
+
+	float LatencyHistogram::Percentile(float p) const
+	{
+		if (Count == 0)
+			return 0.0f;
+
+		const ImUint target = (ImUint)ceil(p * Count);
+		ImUint sum = 0;
+		for (int i = 0; i < BIN_COUNT; i++)
+		{
+			sum += Bins[i];
+			if (sum >= target)
+				return (i + 1) * 0.5f;
+		}
+		return BIN_COUNT * 0.5f;
+	}
+
+	// Context
+
+	Context::Context()
+		: FPS(0.f)
+		, HoveredId(0)
+		, ActiveId(0)
+		, CurrentWindow(NULL)
+		, RenderWindow(NULL)
+		, HoveredWindow(NULL)
+		, BgImageResized(true)
+		, IDSeed(1)
+		, GCIdleFrames(0)
+		, Parent(NULL)
+		, InWindowJobs(false)
+		, Jobs(NULL)
+		, FrameWrite(0)
+		, FrameRead(2)
+		, FrameReady(1)
+		, FrameCount(0)
+		, FrameRendered(0)
+		, FrameBegin(0)
+		, FrameEnded(false)
+		, Pipelined(false)
+		, StatBuildTime(0.f)
+		, StatRenderTime(0.f)
+		, StatLatency(0.f)
+		, StatFramesDropped(0)
+		, StatWindowsCulled(0)
+		, StatDirtyRects(0)
+		, StatPixelsTouched(0)
+		, SurfaceClock(0)
+		, SurfaceBudget(128 * 1024 * 1024)
+		, SurfaceBytes(0)
+		, SurfaceCount(0)
+		, SurfacesCreated(0)
+		, SurfacesReleased(0)
+		, DirtyRendering(false)
+		, DirtyFull(true)
+		, ComposedBgResized(false)
+		, ComposedToolTip(0)
+		, InputEventsDropped(0)
+		, RecordFile(NULL)
+		, ReplayFile(NULL)
+		, ReplayPending(false)
+		, ReplayTime(0.0)
+		, ReplayDeltaTime(0.f)
+		, FrameReplayed(false)
+		, FrameHash(0)
+		, CaptureFunc(NULL)
+		, CaptureUserData(NULL)
+		, CapturePending(false)
+		, HoveredIdPrev(0)
+		, ActiveIdPrev(0)
+		, ReactTime(0.0)
+		, ImageAsync(true)
+		, ImageUploadBudget(4)
+		, ImageRelease(false)
+		, ImageCacheBudget(64 * 1024 * 1024)
+		, ImageFilterMode(ImageFilter_Lanczos3)
+		, LastTimeStatusShown(0)
+		, Render(NULL)
+	{
+		Frequency = GetTickFrequency();
+		memset(JobContexts, 0, sizeof(JobContexts));
+		TimeStart = GetTicks();
+		memset(StrToolTip, 0, sizeof(StrToolTip));
+		memset(TextBuf, 0, sizeof(TextBuf));
+	}
+
+	// Window
 
 	Window::Window(const char* name, ImFloat2 default_pos, ImFloat2 default_size)
-		: CRT(NULL)
-		, Rect(default_pos.x, default_pos.y, default_size.x, default_size.y)
+		: Rect(default_pos.x, default_pos.y, default_size.x, default_size.y)
 		, Alpha(1.f)
 		, Visible(true)
 		, Collapse(false)
 		, ItemWidthDefault(0.f)
+		, LastFrame(0)
+		, BuiltFrames(0)
+#ifdef IMDUI_D2D
+		, CRT(NULL)
+		, CRTStale(false)
+		, CRTBytes(0)
+		, CRTFrame(0)
+		, CRTShown(0)
+#endif
 	{
-		Name = strdup(name);
-		Resize(default_size);
+		const size_t size = strlen(name) + 1;
+		Name = (char*)MemAlloc(size, AllocCategory_Windows);
+		memcpy(Name, name, size);
 	}
 
 	Window::~Window()
 	{
-		SafeRelease(&CRT);
+#ifdef IMDUI_D2D
+		ReleaseSurface();
+#endif
 
-		free(Name);
+		MemFree(Name);
 		Name = NULL;
 	}
 
+#ifdef IMDUI_D2D
 	void Window::Resize(ImFloat2 size)
 	{
-		SafeRelease(&CRT);
+		ReleaseSurface();
 
-		HRESULT hr = s_state.Render->GetMainRT()->CreateCompatibleRenderTarget(D2D1::SizeF(size.x, size.y), &CRT);
+		HRESULT hr = s_ctx->Render->GetMainRT()->CreateCompatibleRenderTarget(D2D1::SizeF(size.x, size.y), &CRT);
 		assert(hr == S_OK);
+		if (CRT == NULL)
+			return;
+
+		const D2D1_SIZE_U pixels = CRT->GetPixelSize();
+		CRTBytes = (size_t)pixels.width * pixels.height * 4;
+		s_ctx->SurfaceBytes += CRTBytes;
+		s_ctx->SurfaceCount++;
+		s_ctx->SurfacesCreated++;
+		s_ctx->Surfaces.push_back(this);
 
 		//CRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
 	}
 
+	void Window::ReleaseSurface()
+	{
+		if (CRT == NULL)
+			return;
+
+		SafeRelease(&CRT);
+		s_ctx->SurfaceBytes -= CRTBytes;
+		s_ctx->SurfaceCount--;
+		CRTBytes = 0;
+
+		ImVector<Window*, AllocCategory_Context>& surfaces = s_ctx->Surfaces;
+		for (size_t i = 0; i < surfaces.size(); i++)
+		{
+			if (surfaces[i] == this)
+			{
+				surfaces[i] = surfaces.back();
+				surfaces.pop_back();
+				break;
+			}
+		}
+	}
+#endif
+
 	ImUint Window::GetID(const char* str)
 	{
-		ImStringUintMap::iterator iter = IDMap.find(str);
+		// the key is copied into a string the window keeps, a known label does not allocate
+		IDKey = str;
+		ImStringMap<IDEntry, AllocCategory_Storage>::iterator iter = IDMap.find(IDKey);
 		if (iter != IDMap.end())
-			return IDMap[str];
+		{
+			iter->second.LastUsed = BuiltFrames;
+			return iter->second.Id;
+		}
 
-		ImUint id = _idseed++;
-		IDMap[str] = id;
+		// parallel window jobs share the id seed of the owning context, ids released by the
+		// garbage collection are used first
+		Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
+		ImUint id = 0;
+		{
+			std::lock_guard<std::mutex> lock(ctx->IDMutex);
+			if (!ctx->FreeIDs.empty())
+			{
+				id = ctx->FreeIDs.back();
+				ctx->FreeIDs.pop_back();
+			}
+		}
+		if (id == 0)
+			id = ctx->IDSeed++;
+
+		IDEntry& entry = IDMap[IDKey];
+		entry.Id = id;
+		entry.LastUsed = BuiltFrames;
 		return id;
 	}
 
@@ -1846,6 +6146,34 @@ namespace ImDui
 	// util
 	//////////////////////////////////////////////////////////////////////////
 
+	float TicksToMs(LONGLONG ticks)
+	{
+		return ticks * 1000.0f / s_ctx->Frequency;
+	}
+
+	double InputClockTime(LONGLONG ticks, bool replayed, double frame_time, LONGLONG frame_begin)
+	{
+		const Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
+		if (replayed)
+			return frame_time + (double)(ticks - frame_begin) / (double)ctx->Frequency;
+		return (double)(ticks - ctx->TimeStart) / (double)ctx->Frequency;
+	}
+
+	void NoteReaction()
+	{
+		if (s_ctx->ReactTime == 0.0)
+		{
+			const Context* ctx = s_ctx->Parent ? s_ctx->Parent : s_ctx;
+			s_ctx->ReactTime = InputClockTime(GetTicks(), ctx->FrameReplayed, ctx->Events.Time, ctx->FrameBegin);
+		}
+	}
+
+	void UpdateStat(std::atomic<float>& stat, float value)
+	{
+		// exponential moving average, smooths out single slow frames
+		stat = stat * 0.9f + value * 0.1f;
+	}
+
 	size_t FormatString(char* buf, size_t buf_size, const char* fmt, ...)
 	{
 		va_list args;
@@ -1872,12 +6200,55 @@ namespace ImDui
 		return true;
 	}
 
+	// True when the union of the occluders covers rect. Occluders are left, top, right, bottom.
+	// The uncovered pieces of rect are split around every occluder until none is left.
+	bool IsRectCovered(const ImFloat4& rect, const ImVector<ImFloat4, AllocCategory_Context>& occluders)
+	{
+		enum { MAX_PIECES = 64 };
+		ImFloat4 pieces[2][MAX_PIECES];
+		int count = 1;
+		int cur = 0;
+		pieces[0][0] = ImFloat4(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w);
+
+		for (size_t i = 0; i < occluders.size() && count > 0; i++)
+		{
+			const ImFloat4& o = occluders[i];
+			ImFloat4* next = pieces[cur ^ 1];
+			int next_count = 0;
+			for (int k = 0; k < count; k++)
+			{
+				const ImFloat4& p = pieces[cur][k];
+				if (next_count + 4 > MAX_PIECES)
+					return false;
+				if (o.x >= p.z || o.z <= p.x || o.y >= p.w || o.w <= p.y)
+				{
+					next[next_count++] = p;
+					continue;
+				}
+
+				const float top = std::max(p.y, o.y);
+				const float bottom = std::min(p.w, o.w);
+				if (p.y < o.y)
+					next[next_count++] = ImFloat4(p.x, p.y, p.z, o.y);
+				if (p.w > o.w)
+					next[next_count++] = ImFloat4(p.x, o.w, p.z, p.w);
+				if (p.x < o.x)
+					next[next_count++] = ImFloat4(p.x, top, o.x, bottom);
+				if (p.z > o.z)
+					next[next_count++] = ImFloat4(o.z, top, p.z, bottom);
+			}
+			cur ^= 1;
+			count = next_count;
+		}
+		return count == 0;
+	}
+
 	void OutLog(const char * pszFormat, ...)
 	{
 		char szBuf[MAX_LEN];
 		va_list ap;
 		va_start(ap, pszFormat);
-		vsnprintf_s(szBuf, MAX_LEN, MAX_LEN, pszFormat, ap);
+		FormatStringV(szBuf, MAX_LEN, pszFormat, ap);
 		va_end(ap);
 		printf("[LOG] %s\n",szBuf);
 	}
@@ -1887,7 +6258,7 @@ namespace ImDui
 		char szBuf[MAX_LEN];
 		va_list ap;
 		va_start(ap, pszFormat);
-		vsnprintf_s(szBuf, MAX_LEN, MAX_LEN, pszFormat, ap);
+		FormatStringV(szBuf, MAX_LEN, pszFormat, ap);
 		va_end(ap);
 		printf("[WARNING] %s\n", szBuf);
 	}
@@ -1897,53 +6268,36 @@ namespace ImDui
 		char szBuf[MAX_LEN];
 		va_list ap;
 		va_start(ap, pszFormat);
-		vsnprintf_s(szBuf, MAX_LEN, MAX_LEN, pszFormat, ap);
+		FormatStringV(szBuf, MAX_LEN, pszFormat, ap);
 		va_end(ap);
 		printf("[ERROR] %s\n", szBuf);
 	}
 
+	// Converts into the arena of the thread, valid until the enclosing FrameArenaScope ends
+	const WCHAR* FrameATOW(const char* src, UINT32* out_length)
+	{
+		const int src_length = (int)strlen(src);
+		const int length = MultiByteToWide(src, src_length, NULL, 0);
+		WCHAR* dst = s_frameArena.Alloc<WCHAR>(length + 1);
+		MultiByteToWide(src, src_length, dst, length);
+		dst[length] = L'\0';
+		*out_length = (UINT32)length;
+		return dst;
+	}
+
 	std::wstring ATOW(const std::string& src)
 	{
-		std::wstring ret;
-		if (!src.empty())
-		{
-			int nNum = MultiByteToWideChar(CP_ACP, 0, src.c_str(), -1, NULL, 0);
-			if (nNum)
-			{
-				WCHAR* wideChaUtilStr = new WCHAR[nNum + 1];
-				wideChaUtilStr[0] = 0;
-				nNum = MultiByteToWideChar(CP_ACP, 0, src.c_str(), -1, wideChaUtilStr, nNum + 1);
-				ret = wideChaUtilStr;
-				delete[] wideChaUtilStr;
-			}
-			else
-			{
-				OutLog("Wrong convert to WideChar code:0x%x", GetLastError());
-			}
-		}
+		std::wstring ret(MultiByteToWide(src.c_str(), (int)src.size(), NULL, 0), L'\0');
+		if (!ret.empty())
+			MultiByteToWide(src.c_str(), (int)src.size(), &ret[0], (int)ret.size());
 		return ret;
 	}
 
 	std::string WTOA(const std::wstring& src)
 	{
-		std::string ret;
-		if (!src.empty())
-		{
-			int nNum = WideCharToMultiByte(CP_ACP, 0, src.c_str(), -1, NULL, 0, NULL, FALSE);
-			if (nNum)
-			{
-				char* utf8String = new char[nNum + 1];
-				utf8String[0] = 0;
-				nNum = WideCharToMultiByte(CP_ACP, 0, src.c_str(), -1, utf8String, nNum + 1, NULL, FALSE);
-				ret = utf8String;
-				delete[] utf8String;
-			}
-			else
-			{
-				OutLog("Wrong convert to Utf8 code:0x%x", GetLastError());
-			}
-		}
-
+		std::string ret(WideToMultiByte(src.c_str(), (int)src.size(), NULL, 0), '\0');
+		if (!ret.empty())
+			WideToMultiByte(src.c_str(), (int)src.size(), &ret[0], (int)ret.size());
 		return ret;
 	}
 }
\ No newline at end of file
@@ -7,23 +7,44 @@
 #ifndef __IMDUI_H__
 #define __IMDUI_H__
 
+// Rendering backend: Direct2D on Windows. Elsewhere, or when IMDUI_NULL_RENDER is defined, a null
+// renderer that draws nothing and measures text with fixed advances, for headless builds.
+#if defined(_WIN32) && !defined(IMDUI_NULL_RENDER)
+#define IMDUI_D2D
+#endif
+
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <assert.h>
 #include <ctime>
+#include <cmath>
 #include <algorithm>
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <vector>
+#include <deque>
+#include <list>
+#include <memory>
 #include <unordered_map>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
 
+#ifdef IMDUI_D2D
 #include <d2d1.h>
 #include <dwrite.h>
 #include <wincodec.h>
 
+#ifdef _MSC_VER
 #pragma comment(lib, "D2D1.lib")
 #pragma comment(lib, "DWrite.lib")
+#endif
+#endif
 
 typedef unsigned int ImDuiWindowFlags;
 typedef unsigned int ImUint;
@@ -46,8 +67,10 @@ struct ImFloat2
 	ImFloat2& operator*=(const float rhs) { x *= rhs; y *= rhs; return *this; }
 	ImFloat2& operator/=(const float rhs) { x /= rhs; y /= rhs; return *this; }
 
+#ifdef IMDUI_D2D
 	D2D1_POINT_2F ToD2DPointF() const { return D2D1::Point2F(x, y); }
 	D2D1_SIZE_F ToD2DSizeF() const { return D2D1::SizeF(x, y); }
+#endif
 };
 
 struct ImFloat4
@@ -57,8 +80,10 @@ struct ImFloat4
 	ImFloat4(float _x, float _y, float _z, float _w) { x = _x; y = _y; z = _z; w = _w; }
 	ImFloat4(const ImFloat2& _pos, const ImFloat2& _size) { x = _pos.x; y = _pos.y; z = _size.x; w = _size.y; }
 
+#ifdef IMDUI_D2D
 	D2D1_RECT_F ToD2DRectF() const { return D2D1::RectF(x, y, x + z, y + w); }
 	D2D_COLOR_F ToD2DColorF() const { return D2D1::ColorF(x, y, z, w); }
+#endif
 };
 
 // Flags for ImDui::BeginWindow()
@@ -72,6 +97,31 @@ enum ImDuiWindowFlags_
 	ImDuiWindowFlags_NoScrollbar			= 1 << 4,
 };
 
+// Colors of ImDui::GuiStyle
+enum GuiStyleColor_
+{
+	Color_Text,
+	Color_Border,
+	Color_WindowBg,
+	Color_WidgetBg,
+	Color_WidgetActive,
+	Color_TitleBar,
+	Color_TitleBarCollapsed,
+	Color_Slider,
+	Color_SliderActive,
+	Color_Button,
+	Color_ButtonHovered,
+	Color_ButtonActive,
+	Color_Collapse,
+	Color_CollapseHovered,
+	Color_CollapseActive,
+	Color_ResizeGrip,
+	Color_ResizeGripHovered,
+	Color_ResizeGripActive,
+	Color_TooltipBg,
+	Color_COUNT,
+};
+
 namespace ImDui
 {
 	struct Event
@@ -81,41 +131,427 @@ namespace ImDui
 
 		ImFloat2	MousePos;
 		bool		MouseDown;
-		int			MouseWheel;
+		int			MouseWheel;				// notches of this frame, used up by the widget zooming with them
 
 		bool		WantCaptureMouse;
+		bool		KeysDown[256];			// indexed by virtual key code
+
+		double		Time;					// seconds since the context was created, updated by NewFrame()
+		float		DeltaTime;				// seconds since the previous NewFrame()
 
 		ImFloat2	MousePosPrev;
 		ImFloat2	MouseDelta;
 		bool		MouseClicked;
 		ImFloat2	MouseClickedPos;
-		float		MouseClickedTime;
+		double		MouseClickedTime;
 		bool		MouseDoubleClicked;
 		float		MouseDownTime;
 
 		Event();
 	};
 
+	// the style the widgets are built and drawn with, see GetStyle()
+	struct GuiStyle
+	{
+		const wchar_t*	FontName;
+		float			FontSize;
+		float			StrokeWidth;
+		float			DefaultWindowAlpha;
+		ImFloat2		WindowPadding;
+		ImFloat2		WindowMinSize;
+		ImFloat2		FramePadding;
+		ImFloat2		ItemSpacing;
+		ImFloat2		ItemInnerSpacing;
+		float			WindowRounding;
+		float			TitleBarHeight;
+		ImFloat2		ResizeGripSize;
+		ImFloat4		Colors[Color_COUNT];
+
+		GuiStyle();
+	};
+
+	struct Context;
+
+	enum InputEventType
+	{
+		InputEvent_MouseMove,
+		InputEvent_MouseButton,
+		InputEvent_MouseWheel,
+		InputEvent_Key,
+	};
+
+	struct InputEvent
+	{
+		InputEventType	Type;
+		double			Time;			// seconds, same clock as GetTime()
+		ImFloat2		MousePos;
+		bool			Down;
+		int				Wheel;
+		int				Key;
+	};
+
+	struct LatencyStats
+	{
+		int			Count;			// input events measured
+		int			ReactCount;		// of which consumed by a frame where a widget reacted
+		float		ConsumeP50, ConsumeP99;		// ms from the input event to the NewFrame() consuming it
+		float		ReactP50, ReactP99;			// ms from the input event to the first widget reaction (hovered/active id or value change)
+		float		PresentP50, PresentP99;		// ms from the input event to the end of Render() of that frame
+	};
+
+	struct FrameStats
+	{
+		float		BuildTime;		// ms from NewFrame() to EndFrame()
+		float		RenderTime;		// ms spent in Render()
+		float		Latency;		// ms from EndFrame() until Render() finished drawing that frame
+		int			FramesDropped;	// frames replaced by a newer one before they were rendered
+		int			WindowsCulled;	// windows of the last rendered frame hidden by opaque windows above them
+		int			DirtyRects;		// changed screen regions found by the last Render()
+		int			PixelsTouched;	// pixels composed by the last Render()
+	};
+
+	struct ImageLoadStats
+	{
+		int			Pending;		// queued or being decoded
+		int			Decoded;		// decoded, waiting to be uploaded
+		int			Ready;
+		int			Failed;
+		int			Cancelled;		// total, dropped because no frame requested them anymore
+	};
+
+	// Image pack: pre-decoded 32bpp premultiplied BGRA images in one file, written by the
+	// ImDuiPack tool and memory mapped by LoadImagePack(). The file holds an ImagePackHeader, Count
+	// ImagePackEntry records, then the pixel rows of the images, each starting on an
+	// IMAGE_PACK_ALIGN boundary.
+	// The tiles of the mip pyramid used by ImageViewer() are named "<path>#<level>/<x>_<y>".
+	// Level 0 is the source, every level halves the previous one, tiles are IMAGE_TILE_SIZE
+	// pixels square except on the right and bottom edges.
+	enum
+	{
+		IMAGE_PACK_MAGIC	= 0x4B504449,	// "IDPK"
+		IMAGE_PACK_VERSION	= 2,
+		IMAGE_PACK_ALIGN	= 64,
+		IMAGE_TILE_SIZE		= 256,
+	};
+
+	struct ImagePackHeader
+	{
+		ImUint		Magic;
+		ImUint		Version;
+		ImUint		Count;
+		ImUint		Reserved;
+	};
+
+	struct ImagePackEntry
+	{
+		char		Name[112];		// path as passed to Image() or SetBgImage(), then
+									// ":<Width>x<Height>" unless stored at source size; '\0' terminated
+		ImUint		Width;
+		ImUint		Height;
+		ImUint		Offset;			// from the start of the file
+		ImUint		Size;			// Width * Height * 4
+	};
+
+	// Frame capture: what one Render() drew, written by CaptureFrame() and read by the
+	// ImDuiCapture viewer. The file holds a FrameCaptureHeader, then for every window, back to
+	// front, a FrameCaptureWindow, its CmdCount FrameCaptureCmd records, its PointCount ImFloat2
+	// and its TextBytes bytes of '\0' terminated strings (text, image paths), zero padded to a
+	// multiple of 4 so that the records of every window are aligned, then the '\0' terminated
+	// background image path and tooltip. In the byte order of the host that wrote it,
+	// so that FrameCaptureReader reads it in place; it rejects a capture of the other byte order.
+	enum
+	{
+		FRAME_CAPTURE_MAGIC		= 0x43444D49,	// "IMDC"
+		FRAME_CAPTURE_VERSION	= 2,
+		FRAME_CAPTURE_MAX_SIZE	= 16384,		// of the frame and of the windows, FrameCaptureReader rejects more
+	};
+
+	enum FrameCaptureCmdType
+	{
+		FrameCaptureCmd_Line,
+		FrameCaptureCmd_Rect,
+		FrameCaptureCmd_RoundedRect,
+		FrameCaptureCmd_Ellipse,
+		FrameCaptureCmd_Polygon,
+		FrameCaptureCmd_PolygonalLine,
+		FrameCaptureCmd_Text,
+		FrameCaptureCmd_Image,
+		FrameCaptureCmd_ImageView,
+		FrameCaptureCmd_Heatmap,
+		FrameCaptureCmd_PushClip,		// intersected with the clip rects pushed before, in window coordinates
+		FrameCaptureCmd_PopClip,
+		FrameCaptureCmd_COUNT,
+	};
+
+	enum
+	{
+		FrameCaptureCmd_Filled		= 1 << 0,
+		FrameCaptureCmd_Aliased		= 1 << 1,
+		FrameCaptureCmd_AlignShift	= 2,		// text alignment in bits 2..3: 0 left, 1 center, 2 right
+
+		FrameCaptureWindow_Hidden	= 1 << 0,	// covered by opaque windows, not drawn
+		FrameCaptureWindow_Opaque	= 1 << 1,
+	};
+
+	struct FrameCaptureHeader
+	{
+		ImUint		Magic;
+		ImUint		Version;
+		ImUint		Frame;			// index of the frame
+		ImUint		WindowCount;
+		float		Width;			// of the render target, 0 with the null renderer
+		float		Height;
+		float		FontSize;		// of the style the frame was built with
+		float		StrokeWidth;
+		float		BuildTime;		// ms from NewFrame() to EndFrame()
+		float		DrawTime;		// ms spent drawing the windows into their surfaces
+		ImFloat4	ToolTipRect;
+		ImFloat4	ToolTipBgColor;
+		ImFloat4	ToolTipTextColor;
+	};
+
+	struct FrameCaptureWindow
+	{
+		char		Name[64];		// truncated, '\0' terminated
+		ImFloat4	Rect;
+		float		Alpha;
+		ImUint		Flags;			// FrameCaptureWindow_
+		float		DrawTime;		// ms to draw the commands into the surface and flush it
+		ImUint		CmdCount;
+		ImUint		PointCount;
+		ImUint		TextBytes;
+	};
+
+	struct FrameCaptureCmd
+	{
+		ImUint		Type;			// FrameCaptureCmdType
+		ImUint		Flags;			// FrameCaptureCmd_
+		ImFloat4	Color;
+		ImFloat4	Rect;			// rect, or center + radius for ellipses
+		ImFloat2	Radius;
+		ImUint		Offset;			// into the points or the text of the window, heatmap version
+		ImUint		Count;			// points, text length, heatmap id, or for an image view the index of its center and zoom in the points
+		float		Time;			// ms to issue the command, CPU side
+	};
+
+	struct ImageCacheStats
+	{
+		int			Entries;		// cached images, in any state
+		size_t		Bytes;			// pixel memory of the ready images
+		size_t		Budget;
+		int			Hits;			// requests served by an existing entry, total
+		int			Misses;
+		int			Evicted;		// total
+	};
+
+	struct SurfaceStats
+	{
+		int			Surfaces;		// offscreen surfaces of windows
+		size_t		Bytes;
+		size_t		Budget;
+		int			Created;		// total
+		int			Released;		// total, given back while the window was not shown
+	};
+
+	enum ImageFilter
+	{
+		ImageFilter_WIC,			// IWICBitmapScaler (cubic, Fant for tiles) and a conversion pass
+		ImageFilter_Box,
+		ImageFilter_Bilinear,
+		ImageFilter_Lanczos3,
+	};
+
+	enum HeatmapColormap
+	{
+		Colormap_Viridis,
+		Colormap_Inferno,
+		Colormap_Gray,
+		Colormap_COUNT,
+	};
+
+	// changed cells of a Heatmap() matrix
+	struct HeatmapRegion
+	{
+		int			X;				// first column
+		int			Y;				// first row
+		int			Width;
+		int			Height;
+	};
+
+	// memory: what ImDui allocates, by owner
+	enum AllocCategory
+	{
+		AllocCategory_Context,		// contexts, renderer, job pool, frame and composition state
+		AllocCategory_Windows,		// windows, their names, layout and clip stacks
+		AllocCategory_Storage,		// widget state storage and id maps
+		AllocCategory_DrawLists,	// recorded draw commands
+		AllocCategory_Images,		// image loader, cache entries, decoded pixels, packs, resampling, CPU rasterizer
+		AllocCategory_Heatmaps,
+		AllocCategory_Scratch,		// per-thread frame arenas
+		AllocCategory_COUNT,
+	};
+
+	struct AllocStats
+	{
+		size_t		Bytes[AllocCategory_COUNT];			// in use
+		size_t		PeakBytes[AllocCategory_COUNT];
+		size_t		Blocks[AllocCategory_COUNT];		// in use
+		size_t		Allocations[AllocCategory_COUNT];	// total
+
+		// discarded by the garbage collection, totals
+		size_t		IdsCollected;
+		size_t		StatesCollected;
+		size_t		WindowsCollected;
+	};
+
+	typedef void*	(*AllocFunc)(size_t size, void* user_data);
+	typedef void	(*FreeFunc)(void* ptr, void* user_data);
+	typedef void	(*FrameCaptureFunc)(const void* data, size_t size, void* user_data);
+
+	// Context
+	Context*	CreateContext();
+	void		DestroyContext(Context* ctx = NULL);	// NULL = destroy current context
+	Context*	GetCurrentContext();
+	void		SetCurrentContext(Context* ctx);
+
+	// Every allocation made by ImDui goes through these functions (default malloc/free), returned
+	// blocks must be 16 byte aligned. A block is always freed by the functions that allocated it,
+	// so they may be changed at any time; at most 16 different pairs can be set over a run.
+	void		SetAllocatorFunctions(AllocFunc alloc_func, FreeFunc free_func, void* user_data = NULL);
+	AllocStats	GetAllocStats();
+
+	// Ids, widget state and whole windows not used for idle_frames frames are discarded at the end
+	// of a frame, their ids are handed out again. Ids age only while their window is built and
+	// not collapsed, windows age with every frame. 0 (default) keeps everything.
+	void		SetGarbageCollection(int idle_frames);
+
 	// Main
+#ifdef IMDUI_D2D
 	void	InitResources(ID2D1Factory* pD2DFactory, IDWriteFactory* pDWriteFactory, IWICImagingFactory* pWICFactory, ID2D1HwndRenderTarget* pMainRT);
+#else
+	void	InitResources();	// null renderer: Render() only hands the frames over, images have no size
+#endif
 	void	ClearResources();
 	Event&	GetEvents();
+	double	GetTime();
+
+	// input event queue, drained by NewFrame(). May be fed from another thread than the one
+	// building the UI (one producer). time < 0 timestamps the event with GetTime().
+	void	AddMouseMoveEvent(float x, float y, double time = -1.0);
+	void	AddMouseButtonEvent(float x, float y, bool down, double time = -1.0);
+	void	AddMouseWheelEvent(int delta, double time = -1.0);
+	void	AddKeyEvent(int key, bool down, double time = -1.0);
+
+	// input recording: every NewFrame() writes its time, delta time and the input events it
+	// consumed to a compact binary file. A replay feeds it back: ReplayInputFrame() queues the
+	// events of the next recorded frame and makes the next NewFrame() take the recorded times,
+	// so a new context building the same UI with the same renderer goes through the same frames.
+	// Record from the first frame of a context, and do not queue other input while replaying.
+	bool	StartInputRecording(const char* path);
+	void	StopInputRecording();
+	bool	StartInputReplay(const char* path);
+	bool	ReplayInputFrame();		// call before NewFrame(), false at the end of the recording
+	void	StopInputReplay();
 	void	NewFrame();
-	void	SetBgImage(std::string image, bool is_resized = true);
+	void	SetBgImage(std::string image, bool is_resized = true);	// is_resized: stretched to the window, decoded at window size
+	void	EndFrame();				// optional, Render() ends the frame when it was not ended yet
 	void	Render();
+	ImUint	GetFrameHash();			// of the last ended frame: the window rects and all they draw, the tooltip
+
+	// pipelined rendering: EndFrame() publishes the frame built on the UI thread and Render(),
+	// called on a render thread with the same current context, draws the latest published
+	// frame while the next one is being built.
+	void		SetPipelinedRendering(bool enabled);
+	void		WaitForRenderer();		// blocks until Render() picked up the last published frame
+	bool		WaitForFrame(int timeout_ms);	// on the render thread: until a frame is published, false on timeout (-1 waits)
+	FrameStats	GetFrameStats();
+
+	// dirty rectangles: Render() compares every frame with the last one it composed and only
+	// clears (to clear_color) and composes the screen regions that changed: windows that moved,
+	// were resized, shown, hidden or redrawn, and the tooltip. The render target must keep its
+	// content between frames (D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS) and must not be cleared.
+	void		SetDirtyRectRendering(bool enabled, const ImFloat4& clear_color);
+	int			GetDirtyRects(ImFloat4* rects, int max_count);	// found by the last Render(), on its thread
+
+	// the next Render() writes the frame it draws to path, see FrameCaptureHeader. Every window
+	// of that frame is drawn again, timing each command. May be called from any thread.
+	void		CaptureFrame(const char* path);
+	void		CaptureFrame(FrameCaptureFunc func, void* user_data);	// hands the capture to func, on the thread of Render()
+
+	// input latency histograms, fed by the timestamps of the queued input events. Frames of an
+	// input replay measure on its recorded clock: the frame time plus the real time since.
+	LatencyStats	GetLatencyStats();
+	void			ResetLatencyStats();
+	void			ShowLatencyStats();		// debug view, to be placed inside a window
+
+	// images are decoded on background threads and drawn as a placeholder until ready. Render()
+	// turns at most upload_budget decoded images into bitmaps per call.
+	void			SetImageLoading(bool async, int upload_budget = 4);
+	void			ReleaseImages();		// drops every loaded or pending image at the next Render()
+	ImageLoadStats	GetImageLoadStats();
+
+	// images are cached per (path, size), the least recently used ones are released once per
+	// frame while the ready images take more than the budget (default 64 MB)
+	void			SetImageCacheBudget(size_t bytes);
+	ImageCacheStats	GetImageCacheStats();
+
+	// every window is drawn into an offscreen surface of its size, a collapsed window into one
+	// of its title bar. Windows not shown in a frame give their surface back, while the surfaces
+	// take more than the budget (default 128 MB) those of the windows covered by others are given
+	// back too, least recently shown first. Surfaces are recreated when the window shows up again.
+	void			SetSurfaceBudget(size_t bytes);
+	SurfaceStats	GetSurfaceStats();
+
+	// requests for a packed image at its packed size, or at natural size, are served from the
+	// memory mapped pack instead of decoding the file. Call after InitResources().
+	bool			LoadImagePack(const char* path);
+
+	// filter used to scale decoded images (default ImageFilter_Lanczos3). The coarse levels of
+	// ImageViewer() are scaled from the source once by the WIC Fant scaler, or halved with a box
+	// filter; the tiles of levels too large to keep are scaled from their part of the source, with
+	// a box filter unless ImageFilter_WIC is selected.
+	void			SetImageFilter(ImageFilter filter);
+
+	// converts 24bpp BGR or 32bpp BGRA (src_bpp 3 or 4, straight alpha) to 32bpp premultiplied
+	// BGRA and resizes it in one pass, splitting the rows over num_threads (0 = one per core) of
+	// the job pool of the current context. Without a current context, or inside a job of a pool
+	// (a parallel window), it runs on the calling thread alone.
+	// Uses SSE2 on x86, AVX when the compiler targets it, and plain C++ elsewhere.
+	void			ResampleImage(const unsigned char* src, int src_w, int src_h, int src_pitch, int src_bpp,
+						unsigned char* dst, int dst_w, int dst_h, int dst_pitch, ImageFilter filter, int num_threads = 0);
 	void	Shutdown();
 	float	GetFPS();
 	void	ShowStyleEditor();
 
+	// of the current context, changes apply to the widgets built after them. The renderer reads
+	// FontName, FontSize and StrokeWidth once, in InitResources().
+	GuiStyle&	GetStyle();
+
 	bool	BeginWindow(const char* name, bool* p_open, ImFloat2 pos = ImFloat2(), ImFloat2 size = ImFloat2(), float fill_alpha = -1.0f, ImDuiWindowFlags flags = 0);
 	void	EndWindow();
 	void	PushItemWidth(float width);
 	void	PopItemWidth();
 
+	// parallel window building: every ParallelWindow() job builds the contents of one window on a
+	// worker thread, results are merged in submission order by EndParallelWindows().
+	// Jobs must only use ImDui widgets and data owned by their own window.
+	typedef std::function<void()> WindowJobFunc;
+	void	BeginParallelWindows();
+	void	ParallelWindow(const char* name, bool* p_open, WindowJobFunc func, ImFloat2 pos = ImFloat2(), ImFloat2 size = ImFloat2(), float fill_alpha = -1.0f, ImDuiWindowFlags flags = 0);
+	void	EndParallelWindows(int num_threads = 0);	// 0 = one thread per core
+
 	// layout
 	void	SameLine(int column_x = 0, int spacing_w = -1);
 	void	Spacing();
 
+	// clipping: a window keeps a stack of clip rects, in window coordinates like the cursor, the
+	// window itself being the outermost one. Widgets fully outside the current clip rect only
+	// advance the layout, without measuring text or drawing.
+	void	PushClipRect(const ImFloat4& rect, bool intersect_with_current = true);
+	void	PopClipRect();
+	bool	IsRectVisible(const ImFloat4& rect);
+	bool	IsRectVisible(ImFloat2 size);		// an item of that size at the cursor
+
 	// widgets
 	void	Text(const char* label, ...);
 	bool	Button(const char* label, ImFloat2 size = ImFloat2(0, 0));
@@ -129,6 +565,19 @@ namespace ImDui
 	bool	ColorEdit3(const char* label, float col[3]);
 	bool	ColorEdit4(const char* label, float col[4], bool show_alpha = true);
 	void	ToolTip(const char* fmt, ...);
+	void	Image(const char* path, ImFloat2 size);
+
+	// pan (drag) and zoom (wheel, 1.25x a notch, double click to fit) over an image of any size.
+	// Only the tiles of the mip level matching the zoom that are visible are decoded, on the image
+	// threads, or read from the image packs; missing tiles are covered by a coarser level.
+	void	ImageViewer(const char* path, ImFloat2 size);
+
+	// shows a rows x cols float matrix, stride floats from one row to the next, mapped from
+	// [v_min, v_max] through colormap, with a value under the mouse tooltip and a legend. The
+	// matrix is averaged down to size pixels, which are kept between frames: only the pixels
+	// covering the dirty regions are recomputed, dirty_count < 0 recomputes all of them.
+	void	Heatmap(const char* label, const float* values, int cols, int rows, int stride, float v_min, float v_max,
+				ImFloat2 size, HeatmapColormap colormap = Colormap_Viridis, const HeatmapRegion* dirty = NULL, int dirty_count = -1);
 }
 
 #endif //__IMDUI_H__
\ No newline at end of file
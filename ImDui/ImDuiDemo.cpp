@@ -0,0 +1,211 @@
+#include "ImDuiDemo.h"
+
+namespace ImDui
+{
+	DemoState::DemoState()
+		: ShowDemo(true)
+		, ShowWindowOptions(true)
+		, ShowStyleEditor(true)
+		, Slider(0.5f)
+		, Check1(false)
+		, Check2(false)
+		, Radio(0)
+		, NoTitleBar(false)
+		, NoBorder(true)
+		, NoResize(false)
+		, NoMove(false)
+		, Chinese(true)
+		, FillAlpha(1.f)
+	{
+		Color[0] = 1.0f;
+		Color[1] = 0.0f;
+		Color[2] = 0.2f;
+	}
+
+	static void ShowDemo(DemoState* state)
+	{
+		BeginWindow("ImDui Demo", &state->ShowDemo, ImFloat2(20, 20), ImFloat2(400, 200));
+		Text("Hello ImDui!");
+		Button("I am a button.");
+
+		SliderFloat("slider", &state->Slider, 0.0f, 1.0f);
+
+		CheckBox("checkbox1", &state->Check1); SameLine(100);
+		CheckBox("checkbox2", &state->Check2);
+
+		RadioButton("radio a", &state->Radio, 0); SameLine(100);
+		RadioButton("radio b", &state->Radio, 1); SameLine(200);
+		RadioButton("radio c", &state->Radio, 2);
+
+		ColorEdit3("color editor 1", state->Color);
+		EndWindow();
+	}
+
+	static void ShowWindowOptions(DemoState* state)
+	{
+		static const char* options_en[11] = 
+		{
+			"Window Options",
+			"I can eat glass and it doesn't hurt me.",
+			"Help",
+			"1.Double-click on title bar to collapse window.\n2.Click and drag on lower right corner to resize window.\n3.Click and drag on any empty space to move window.",
+			"Window options",
+			"no titlebar",
+			"no border",
+			"no resize",
+			"no move",
+			"English",
+			"fill alpha"
+		};
+
+		static const char* options_cn[11] = 
+		{
+			"ѡ",
+			"²塣",
+			"",
+			"1.˫۵ڡ\n2.½϶ɵڴС\n3.϶ƶڡ",
+			"ѡ",
+			"ޱ",
+			"ޱ߿",
+			"ɵС",
+			"ƶ",
+			"",
+			"͸"
+		};
+
+		const char** options = state->Chinese ? options_cn : options_en;
+		const unsigned int layout_flags = 
+			(state->NoTitleBar ? ImDuiWindowFlags_NoTitleBar : 0) | 
+			(state->NoBorder ? 0 : ImDuiWindowFlags_ShowBorders) |
+			(state->NoResize ? ImDuiWindowFlags_NoResize : 0) | 
+			(state->NoMove ? ImDuiWindowFlags_NoMove : 0);
+		BeginWindow(options[0], &state->ShowWindowOptions, ImFloat2(20, 20 + 200 + 20), ImFloat2(400, 300), state->FillAlpha, layout_flags);
+		Text(options[1]);
+		Spacing();
+
+		if (Collapse(options[2]))
+		{
+			Text(options[3]);
+		}
+
+		if (Collapse(options[4]))
+		{
+			CheckBox(options[5], &state->NoTitleBar); SameLine(100);
+			CheckBox(options[6], &state->NoBorder); 
+			CheckBox(options[7], &state->NoResize); SameLine(100);
+			CheckBox(options[8], &state->NoMove); SameLine(200);
+			CheckBox(options[9], &state->Chinese);
+			SliderFloat(options[10], &state->FillAlpha, 0.0f, 1.0f);
+		}
+
+		EndWindow();
+	}
+
+	void ShowDemoWindows(DemoState* state)
+	{
+		if (state->ShowDemo)
+			ShowDemo(state);
+
+		if (state->ShowWindowOptions)
+			ShowWindowOptions(state);
+
+		if (state->ShowStyleEditor)
+		{
+			BeginWindow("Style Editor", &state->ShowStyleEditor, ImFloat2(1080 - 400 - 20 - 18, 20), ImFloat2(400, 570));
+			ShowStyleEditor();
+			EndWindow();
+		}
+	}
+
+	// the mouse moves to every point in turn, in Frames frames, and the button is set to Down
+	// once there
+	struct SessionPoint
+	{
+		float	X, Y;
+		bool	Down;
+		int		Frames;
+	};
+
+	static const SessionPoint sc_session[] =
+	{
+		{ 200,  28, false, 20 },	// title bar of "ImDui Demo"
+		{ 200,  28, true,   2 },
+		{ 260,  80, true,  30 },	// drag the window
+		{ 260,  80, false,  2 },
+		{ 300, 112, false, 10 },	// press over the window, away from the widgets
+		{ 300, 112, true,   2 },
+		{ 240,  60, true,  20 },	// and drag it back
+		{ 240,  60, false,  2 },
+		{ 100, 105, false, 10 },	// the slider
+		{ 100, 105, true,   2 },
+		{ 300, 105, true,  40 },	// scrub it
+		{ 180, 105, true,  20 },
+		{ 180, 105, false,  2 },
+		{  34, 128, false, 10 },	// checkbox1
+		{  34, 128, true,   2 },
+		{  34, 128, false,  2 },
+		{ 130, 160, false, 10 },	// radio b
+		{ 130, 160, true,   2 },
+		{ 130, 160, false,  2 },
+		{ 100, 332, false, 20 },	// open the collapses of the window options, the lower one first
+		{ 100, 332, true,   2 },
+		{ 100, 332, false,  2 },
+		{ 100, 304, false, 10 },
+		{ 100, 304, true,   2 },
+		{ 100, 304, false,  2 },
+		{ 200, 248, false, 10 },	// double click the title bar: collapse the window
+		{ 200, 248, true,   2 },
+		{ 200, 248, false,  2 },
+		{ 200, 248, true,   2 },
+		{ 200, 248, false,  2 },
+		{ 200, 248, true,  30 },	// and again to open it
+		{ 200, 248, false,  2 },
+		{ 200, 248, true,   2 },
+		{ 200, 248, false,  2 },
+		{ 700,  80, false, 30 },	// over the style editor
+		{ 700,  80, true,   2 },
+		{ 700,  80, false,  2 },
+	};
+
+	DemoSession::DemoSession()
+	{
+		Restart();
+	}
+
+	int DemoSession::GetFrameCount()
+	{
+		int frames = 0;
+		for (size_t i = 0; i < sizeof(sc_session) / sizeof(sc_session[0]); i++)
+			frames += sc_session[i].Frames;
+		return frames;
+	}
+
+	void DemoSession::Feed(int frame)
+	{
+		int begin = 0;
+		for (size_t i = 0; i < sizeof(sc_session) / sizeof(sc_session[0]); i++)
+		{
+			const SessionPoint& point = sc_session[i];
+			if (frame < begin + point.Frames)
+			{
+				const float t = (float)(frame - begin + 1) / point.Frames;
+				_x += (point.X - _x) * t;
+				_y += (point.Y - _y) * t;
+				AddMouseMoveEvent(_x, _y);
+				if (t >= 1.0f && point.Down != _down)
+				{
+					_down = point.Down;
+					AddMouseButtonEvent(_x, _y, _down);
+				}
+				return;
+			}
+			begin += point.Frames;
+		}
+	}
+
+	void DemoSession::Restart()
+	{
+		_x = _y = 0.0f;
+		_down = false;
+	}
+}
@@ -0,0 +1,59 @@
+// Name		: ImDui
+// File		: ImDuiDemo.h
+//
+// The demo windows of main.cpp that only use the ImDui API: the widget demo, the window
+// options and the style editor. Their state lives in a DemoState, so that the headless tools
+// can build the very same windows and compare what they hold.
+
+#ifndef __IMDUI_DEMO_H__
+#define __IMDUI_DEMO_H__
+
+#include "ImDui.h"
+
+namespace ImDui
+{
+	struct DemoState
+	{
+		bool	ShowDemo;
+		bool	ShowWindowOptions;
+		bool	ShowStyleEditor;
+
+		// "ImDui Demo"
+		float	Slider;
+		bool	Check1;
+		bool	Check2;
+		int		Radio;
+		float	Color[3];
+
+		// window options
+		bool	NoTitleBar;
+		bool	NoBorder;
+		bool	NoResize;
+		bool	NoMove;
+		bool	Chinese;
+		float	FillAlpha;
+
+		DemoState();
+	};
+
+	void	ShowDemoWindows(DemoState* state);		// between NewFrame() and Render()
+
+	// A scripted session of mouse input over the demo windows, for the headless tools and tests:
+	// it drags the demo window, scrubs the slider, clicks a checkbox and a radio button, opens the
+	// collapses of the window options, collapses and opens that window and clicks the style editor.
+	class DemoSession
+	{
+	public:
+		DemoSession();
+
+		static int	GetFrameCount();
+		void		Feed(int frame);		// queues the input of frame, before its NewFrame(), frames in order
+		void		Restart();				// the mouse back at the origin, released
+
+	private:
+		float	_x, _y;
+		bool	_down;
+	};
+}
+
+#endif //__IMDUI_DEMO_H__
@@ -0,0 +1,526 @@
+#ifdef _WIN32
+#include <winsock2.h>		// before Windows.h, which would bring the old winsock.h
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#include "ImDuiPlatform.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace ImDui
+{
+#ifdef _WIN32
+
+	LONGLONG GetTicks()
+	{
+		LARGE_INTEGER time;
+		QueryPerformanceCounter(&time);
+		return time.QuadPart;
+	}
+
+	LONGLONG GetTickFrequency()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}
+
+	int MultiByteToWide(const char* src, int src_length, WCHAR* dst, int dst_size)
+	{
+		if (src_length < 0)
+			src_length = (int)strlen(src);
+		if (src_length == 0)
+			return 0;
+		return MultiByteToWideChar(CP_ACP, 0, src, src_length, dst, dst ? dst_size : 0);
+	}
+
+	int WideToMultiByte(const WCHAR* src, int src_length, char* dst, int dst_size)
+	{
+		if (src_length < 0)
+			src_length = (int)wcslen(src);
+		if (src_length == 0)
+			return 0;
+		return WideCharToMultiByte(CP_ACP, 0, src, src_length, dst, dst ? dst_size : 0, NULL, NULL);
+	}
+
+	bool SharedMemory::Create(const char* name, size_t size)
+	{
+		Close();
+		HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, name);
+		if (mapping == NULL)
+			return false;
+		if (GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		_data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		if (_data == NULL)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		_handle = mapping;
+		_size = size;
+		return true;
+	}
+
+	bool SharedMemory::Open(const char* name)
+	{
+		Close();
+		HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+		if (mapping == NULL)
+			return false;
+		_data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		MEMORY_BASIC_INFORMATION info;
+		if (_data == NULL || VirtualQuery(_data, &info, sizeof(info)) == 0)
+		{
+			if (_data != NULL)
+				UnmapViewOfFile(_data);
+			_data = NULL;
+			CloseHandle(mapping);
+			return false;
+		}
+		_handle = mapping;
+		_size = info.RegionSize;
+		return true;
+	}
+
+	void SharedMemory::Close()
+	{
+		if (_data != NULL)
+			UnmapViewOfFile(_data);
+		if (_handle != NULL)
+			CloseHandle((HANDLE)_handle);
+		_data = NULL;
+		_handle = NULL;
+		_size = 0;
+	}
+
+#else
+
+	LONGLONG GetTicks()
+	{
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (LONGLONG)time.tv_sec * 1000000000 + time.tv_nsec;
+	}
+
+	LONGLONG GetTickFrequency()
+	{
+		return 1000000000;
+	}
+
+	// UTF-8 to UTF-32, malformed sequences become U+FFFD
+	int MultiByteToWide(const char* src, int src_length, WCHAR* dst, int dst_size)
+	{
+		if (src_length < 0)
+			src_length = (int)strlen(src);
+
+		const unsigned char* s = (const unsigned char*)src;
+		const unsigned char* end = s + src_length;
+		int count = 0;
+		while (s < end)
+		{
+			unsigned int c = *s++;
+			int extra = (c >= 0xf0 && c < 0xf8) ? 3 : (c >= 0xe0) ? 2 : (c >= 0xc0) ? 1 : 0;
+			if ((c >= 0x80 && c < 0xc0) || c >= 0xf8)
+			{
+				c = 0xfffd;
+				extra = 0;
+			}
+			else if (extra > 0)
+			{
+				c &= 0x3f >> extra;
+				for (; extra > 0 && s < end && (*s & 0xc0) == 0x80; extra--)
+					c = (c << 6) | (*s++ & 0x3f);
+				if (extra > 0)
+					c = 0xfffd;
+			}
+
+			if (dst != NULL)
+			{
+				if (count == dst_size)
+					break;
+				dst[count] = (WCHAR)c;
+			}
+			count++;
+		}
+		return count;
+	}
+
+	int WideToMultiByte(const WCHAR* src, int src_length, char* dst, int dst_size)
+	{
+		if (src_length < 0)
+			src_length = (int)wcslen(src);
+
+		int count = 0;
+		for (int i = 0; i < src_length; i++)
+		{
+			unsigned int c = (unsigned int)src[i];
+			if (c > 0x10ffff)
+				c = 0xfffd;
+
+			char buf[4];
+			int n;
+			if (c < 0x80)
+			{
+				buf[0] = (char)c;
+				n = 1;
+			}
+			else if (c < 0x800)
+			{
+				buf[0] = (char)(0xc0 | (c >> 6));
+				buf[1] = (char)(0x80 | (c & 0x3f));
+				n = 2;
+			}
+			else if (c < 0x10000)
+			{
+				buf[0] = (char)(0xe0 | (c >> 12));
+				buf[1] = (char)(0x80 | ((c >> 6) & 0x3f));
+				buf[2] = (char)(0x80 | (c & 0x3f));
+				n = 3;
+			}
+			else
+			{
+				buf[0] = (char)(0xf0 | (c >> 18));
+				buf[1] = (char)(0x80 | ((c >> 12) & 0x3f));
+				buf[2] = (char)(0x80 | ((c >> 6) & 0x3f));
+				buf[3] = (char)(0x80 | (c & 0x3f));
+				n = 4;
+			}
+
+			if (dst != NULL)
+			{
+				if (count + n > dst_size)
+					break;
+				memcpy(dst + count, buf, n);
+			}
+			count += n;
+		}
+		return count;
+	}
+
+	static void SharedMemoryName(const char* name, char* out, size_t size)
+	{
+		snprintf(out, size, "%s%s", name[0] == '/' ? "" : "/", name);
+	}
+
+	bool SharedMemory::Create(const char* name, size_t size)
+	{
+		Close();
+		char path[64];
+		SharedMemoryName(name, path, sizeof(path));
+		const int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd < 0)
+			return false;
+		if (ftruncate(fd, (off_t)size) != 0)
+		{
+			close(fd);
+			shm_unlink(path);
+			return false;
+		}
+		void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED)
+		{
+			shm_unlink(path);
+			return false;
+		}
+		_data = data;
+		_size = size;
+		strcpy(_name, path);
+		return true;
+	}
+
+	bool SharedMemory::Open(const char* name)
+	{
+		Close();
+		char path[64];
+		SharedMemoryName(name, path, sizeof(path));
+		const int fd = shm_open(path, O_RDWR, 0);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		void* data = (fstat(fd, &st) == 0 && st.st_size > 0) ? mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+		close(fd);
+		if (data == MAP_FAILED)
+			return false;
+		_data = data;
+		_size = (size_t)st.st_size;
+		return true;
+	}
+
+	void SharedMemory::Close()
+	{
+		if (_data != NULL)
+			munmap(_data, _size);
+		if (_name[0])
+			shm_unlink(_name);
+		_data = NULL;
+		_size = 0;
+		_name[0] = '\0';
+	}
+
+#endif
+
+	SharedMemory::SharedMemory()
+		: _data(NULL)
+		, _size(0)
+		, _handle(NULL)
+	{
+		_name[0] = '\0';
+	}
+
+	SharedMemory::~SharedMemory()
+	{
+		Close();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Socket
+
+#ifdef _WIN32
+	typedef SOCKET		NativeSocket;
+	typedef int			SocketLength;
+	static const int	SEND_FLAGS = 0;
+
+	static void CloseSocket(NativeSocket s)
+	{
+		closesocket(s);
+	}
+
+	static bool StartSockets()
+	{
+		struct Winsock
+		{
+			bool	Ok;
+			Winsock() { WSADATA data; Ok = WSAStartup(MAKEWORD(2, 2), &data) == 0; }
+		};
+		static const Winsock winsock;		// started once, by the first thread to get here
+		return winsock.Ok;
+	}
+#else
+	typedef int			NativeSocket;
+	typedef socklen_t	SocketLength;
+	static const int	INVALID_SOCKET = -1;
+#ifdef MSG_NOSIGNAL
+	static const int	SEND_FLAGS = MSG_NOSIGNAL;		// no SIGPIPE when the peer is gone
+#else
+	static const int	SEND_FLAGS = 0;
+#endif
+
+	static void CloseSocket(NativeSocket s)
+	{
+		close(s);
+	}
+
+	static bool StartSockets()
+	{
+		return true;
+	}
+#endif
+
+	// the socket and the address of "host:port" or "unix:<path>"
+	static NativeSocket OpenSocket(const char* address, sockaddr_storage* addr, SocketLength* addr_length)
+	{
+		memset(addr, 0, sizeof(*addr));
+		if (!StartSockets())
+			return INVALID_SOCKET;
+
+#ifndef _WIN32
+		if (strncmp(address, "unix:", 5) == 0)
+		{
+			sockaddr_un* un = (sockaddr_un*)addr;
+			if (strlen(address + 5) >= sizeof(un->sun_path))
+				return INVALID_SOCKET;
+			un->sun_family = AF_UNIX;
+			strcpy(un->sun_path, address + 5);
+			*addr_length = (SocketLength)sizeof(sockaddr_un);
+			return socket(AF_UNIX, SOCK_STREAM, 0);
+		}
+#endif
+
+		const char* colon = strrchr(address, ':');
+		if (colon == NULL)
+			return INVALID_SOCKET;
+		char host[256];
+		const size_t host_length = (size_t)(colon - address);
+		if (host_length >= sizeof(host))
+			return INVALID_SOCKET;
+		memcpy(host, address, host_length);
+		host[host_length] = '\0';
+
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* info = NULL;
+		if (getaddrinfo(host_length ? host : "127.0.0.1", colon + 1, &hints, &info) != 0 || info == NULL)
+			return INVALID_SOCKET;
+		memcpy(addr, info->ai_addr, info->ai_addrlen);
+		*addr_length = (SocketLength)info->ai_addrlen;
+		freeaddrinfo(info);
+
+		const NativeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (s != INVALID_SOCKET)
+		{
+			int on = 1;
+			setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+		}
+		return s;
+	}
+
+	// readable, or writable, within timeout_ms (-1 waits)
+	static bool WaitSocket(NativeSocket s, bool write, int timeout_ms)
+	{
+#ifdef _WIN32
+		fd_set set;
+		FD_ZERO(&set);
+		FD_SET(s, &set);
+		timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+		return select(0, write ? NULL : &set, write ? &set : NULL, NULL, timeout_ms < 0 ? NULL : &timeout) > 0;
+#else
+		pollfd fd = { s, (short)(write ? POLLOUT : POLLIN), 0 };
+		return poll(&fd, 1, timeout_ms) > 0;
+#endif
+	}
+
+	Socket::Socket()
+		: _fd(INVALID)
+	{
+		_path[0] = '\0';
+	}
+
+	Socket::~Socket()
+	{
+		Close();
+	}
+
+	bool Socket::Listen(const char* address)
+	{
+		Close();
+		sockaddr_storage addr;
+		SocketLength addr_length = 0;
+		const NativeSocket s = OpenSocket(address, &addr, &addr_length);
+		if (s == INVALID_SOCKET)
+			return false;
+
+#ifndef _WIN32
+		// on Windows SO_REUSEADDR would let another process take the port
+		int on = 1;
+		if (addr.ss_family == AF_INET)
+			setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));		// over connections in TIME_WAIT
+		else
+			unlink(((sockaddr_un*)&addr)->sun_path);		// left by a server that did not close
+#endif
+		if (bind(s, (const sockaddr*)&addr, addr_length) != 0 || listen(s, 1) != 0)
+		{
+			CloseSocket(s);
+			return false;
+		}
+#ifndef _WIN32
+		if (addr.ss_family == AF_UNIX)
+			strcpy(_path, ((sockaddr_un*)&addr)->sun_path);
+#endif
+		_fd = (Fd)s;
+		return true;
+	}
+
+	bool Socket::Accept(Socket* client, int timeout_ms)
+	{
+		if (_fd == INVALID || !WaitSocket((NativeSocket)_fd, false, timeout_ms))
+			return false;
+		const NativeSocket s = accept((NativeSocket)_fd, NULL, NULL);
+		if (s == INVALID_SOCKET)
+			return false;
+
+		int on = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));		// fails harmlessly on Unix sockets
+		client->Close();
+		client->_fd = (Fd)s;
+		return true;
+	}
+
+	bool Socket::Connect(const char* address)
+	{
+		Close();
+		sockaddr_storage addr;
+		SocketLength addr_length = 0;
+		const NativeSocket s = OpenSocket(address, &addr, &addr_length);
+		if (s == INVALID_SOCKET)
+			return false;
+		if (connect(s, (const sockaddr*)&addr, addr_length) != 0)
+		{
+			CloseSocket(s);
+			return false;
+		}
+		_fd = (Fd)s;
+		return true;
+	}
+
+	void Socket::Close()
+	{
+		if (_fd != INVALID)
+			CloseSocket((NativeSocket)_fd);
+#ifndef _WIN32
+		if (_path[0])
+			unlink(_path);
+#endif
+		_fd = INVALID;
+		_path[0] = '\0';
+	}
+
+	bool Socket::Send(const void* data, size_t size)
+	{
+		const char* bytes = (const char*)data;
+		while (size > 0 && _fd != INVALID)
+		{
+			const int chunk = (int)(size < (1 << 30) ? size : (1 << 30));
+			const int sent = (int)send((NativeSocket)_fd, bytes, chunk, SEND_FLAGS);
+			if (sent <= 0)
+				return false;
+			bytes += sent;
+			size -= (size_t)sent;
+		}
+		return _fd != INVALID;
+	}
+
+	bool Socket::Receive(void* data, size_t size)
+	{
+		char* bytes = (char*)data;
+		while (size > 0 && _fd != INVALID)
+		{
+			const int chunk = (int)(size < (1 << 30) ? size : (1 << 30));
+			const int received = (int)recv((NativeSocket)_fd, bytes, chunk, 0);
+			if (received <= 0)
+				return false;
+			bytes += received;
+			size -= (size_t)received;
+		}
+		return _fd != INVALID;
+	}
+
+	bool Socket::WaitReadable(int timeout_ms)
+	{
+		return _fd != INVALID && WaitSocket((NativeSocket)_fd, false, timeout_ms);
+	}
+
+	bool Socket::IsWritable()
+	{
+		return _fd != INVALID && WaitSocket((NativeSocket)_fd, true, 0);
+	}
+}
@@ -0,0 +1,110 @@
+// Name		: ImDui
+// File		: ImDuiPlatform.h
+//
+// Platform layer of the core: the clock, the string conversions, named shared memory and
+// sockets, plus the Windows types the core is written with, so that ImDui.cpp builds the same on
+// every platform. Rendering is selected by IMDUI_D2D in ImDui.h.
+
+#ifndef __IMDUI_PLATFORM_H__
+#define __IMDUI_PLATFORM_H__
+
+#include "ImDui.h"
+#include <float.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+typedef unsigned char		BYTE;
+typedef unsigned int		UINT;
+typedef unsigned int		UINT32;
+typedef long long			LONGLONG;
+typedef unsigned long long	ULONGLONG;
+typedef wchar_t				WCHAR;
+
+#define ARRAYSIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#endif
+
+namespace ImDui
+{
+	// monotonic clock: QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere
+	LONGLONG	GetTicks();
+	LONGLONG	GetTickFrequency();		// ticks per second
+
+	// the active code page on Windows, UTF-8 elsewhere. Convert src_length chars (-1 = up to the
+	// terminator, which is not converted) into at most dst_size chars of dst, without a terminator,
+	// and return how many were written; a NULL dst returns how many are needed.
+	int			MultiByteToWide(const char* src, int src_length, WCHAR* dst, int dst_size);
+	int			WideToMultiByte(const WCHAR* src, int src_length, char* dst, int dst_size);
+
+	// every allocation of the core, charged to category: 16 byte aligned, through the functions
+	// of SetAllocatorFunctions()
+	void*		MemAlloc(size_t size, AllocCategory category);
+	void		MemFree(void* ptr);
+
+	// FNV-1a of size bytes, continuing from hash: the hashes of draw lists, frames and states
+	ImUint		HashBytes(const void* data, size_t size, ImUint hash = 2166136261u);
+
+	// memory shared between processes by name: a file mapping backed by the paging file on
+	// Windows, POSIX shared memory (shm_open, "/" is prepended to the name) elsewhere. The
+	// creator removes the name when it closes, mappings opened before stay valid.
+	class SharedMemory
+	{
+	public:
+		SharedMemory();
+		~SharedMemory();
+
+		bool	Create(const char* name, size_t size);		// zero filled, fails when the name exists
+		bool	Open(const char* name);
+		void	Close();
+		void*	GetData() const { return _data; }
+		size_t	GetSize() const { return _size; }
+
+	private:
+		SharedMemory(const SharedMemory&);
+		SharedMemory& operator=(const SharedMemory&);
+
+		void*	_data;
+		size_t	_size;
+		void*	_handle;		// the file mapping on Windows
+		char	_name[64];		// to unlink, when created here
+	};
+
+	// blocking stream sockets: TCP to "host:port" (":port" is 127.0.0.1), with Nagle disabled,
+	// or a Unix domain socket to "unix:<path>" on other platforms than Windows
+	class Socket
+	{
+	public:
+		Socket();
+		~Socket();
+
+		bool	Listen(const char* address);
+		bool	Accept(Socket* client, int timeout_ms);		// false when no connection came in time
+		bool	Connect(const char* address);
+		void	Close();
+		bool	IsOpen() const { return _fd != INVALID; }
+
+		bool	Send(const void* data, size_t size);		// all of it, false when the peer is gone
+		bool	Receive(void* data, size_t size);			// all of it, false when the peer is gone
+		bool	WaitReadable(int timeout_ms);				// data or a closed connection to receive
+		bool	IsWritable();								// room to send without blocking
+
+	private:
+		Socket(const Socket&);
+		Socket& operator=(const Socket&);
+
+#ifdef _WIN32
+		typedef unsigned long long	Fd;		// SOCKET
+		static const Fd				INVALID = ~0ull;
+#else
+		typedef int					Fd;
+		static const Fd				INVALID = -1;
+#endif
+
+		Fd		_fd;
+		char	_path[108];		// of the Unix socket listened to, removed by Close()
+	};
+}
+
+#endif //__IMDUI_PLATFORM_H__
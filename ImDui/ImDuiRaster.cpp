@@ -0,0 +1,1514 @@
+#include "ImDuiRaster.h"
+#include "ImDuiPlatform.h"
+#include <math.h>
+
+namespace ImDui
+{
+	static const int	SUBSAMPLES = 4;		// scanlines per pixel row
+	static const float	PI = 3.14159265f;
+
+	// 5x7 glyphs of ' ' to '~', a byte per column, bit 0 at the top
+	static const unsigned char sc_font[95][5] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+		{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+		{ 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+		{ 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+		{ 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+		{ 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+		{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+		{ 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+		{ 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+		{ 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+		{ 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+		{ 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+		{ 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+		{ 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+		{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+		{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+		{ 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+		{ 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+		{ 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+		{ 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+		{ 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+		{ 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+		{ 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+		{ 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+	};
+
+	// drawn for the characters the font does not have
+	static const unsigned char sc_missingGlyph[5] = { 0x7F, 0x41, 0x41, 0x41, 0x7F };
+
+	static int		Min(int lhs, int rhs) { return lhs < rhs ? lhs : rhs; }
+	static int		Max(int lhs, int rhs) { return lhs >= rhs ? lhs : rhs; }
+	static float	Min(float lhs, float rhs) { return lhs < rhs ? lhs : rhs; }
+	static float	Max(float lhs, float rhs) { return lhs >= rhs ? lhs : rhs; }
+	static float	Saturate(float f) { return (f < 0.0f) ? 0.0f : (f > 1.0f) ? 1.0f : f; }
+
+	static float Overlap(float a0, float a1, float b0, float b1)
+	{
+		const float lo = a0 > b0 ? a0 : b0;
+		const float hi = a1 < b1 ? a1 : b1;
+		return hi > lo ? hi - lo : 0.0f;
+	}
+
+	static int AppendEllipse(ImFloat2* out, const ImFloat2& center, float rx, float ry)
+	{
+		const float r = rx > ry ? rx : ry;
+		int segments = (int)ceilf(2.0f * PI * r / 3.0f);
+		segments = segments < 12 ? 12 : segments > 128 ? 128 : segments;
+		for (int i = 0; i < segments; i++)
+		{
+			const float a = 2.0f * PI * i / segments;
+			out[i] = ImFloat2(center.x + cosf(a) * rx, center.y + sinf(a) * ry);
+		}
+		return segments;
+	}
+
+	// the corner radii are clamped to half the rect, like Direct2D does
+	static int AppendRoundedRect(ImFloat2* out, const ImFloat4& rect, float rx, float ry)
+	{
+		rx = rx < rect.z * 0.5f ? rx : rect.z * 0.5f;
+		ry = ry < rect.w * 0.5f ? ry : rect.w * 0.5f;
+		if (rx <= 0.0f || ry <= 0.0f)
+		{
+			out[0] = ImFloat2(rect.x, rect.y);
+			out[1] = ImFloat2(rect.x + rect.z, rect.y);
+			out[2] = ImFloat2(rect.x + rect.z, rect.y + rect.w);
+			out[3] = ImFloat2(rect.x, rect.y + rect.w);
+			return 4;
+		}
+
+		const int segments = 8;
+		const ImFloat2 centers[4] =
+		{
+			ImFloat2(rect.x + rect.z - rx, rect.y + ry),
+			ImFloat2(rect.x + rect.z - rx, rect.y + rect.w - ry),
+			ImFloat2(rect.x + rx, rect.y + rect.w - ry),
+			ImFloat2(rect.x + rx, rect.y + ry),
+		};
+		int count = 0;
+		for (int corner = 0; corner < 4; corner++)
+		{
+			for (int i = 0; i <= segments; i++)
+			{
+				const float a = (corner - 1 + (float)i / segments) * PI * 0.5f;
+				out[count++] = ImFloat2(centers[corner].x + cosf(a) * rx, centers[corner].y + sinf(a) * ry);
+			}
+		}
+		return count;
+	}
+
+	Raster::Raster()
+		: _width(0)
+		, _height(0)
+		, _scale(1.0f)
+		, _pixels(NULL)
+		, _attached(false)
+		, _clipStack(NULL)
+		, _clipDepth(0)
+		, _clipCapacity(0)
+		, _edges(NULL)
+		, _edgeCapacity(0)
+		, _crossings(NULL)
+		, _crossingCapacity(0)
+		, _coverage(NULL)
+	{
+	}
+
+	Raster::~Raster()
+	{
+		if (!_attached)
+			MemFree(_pixels);
+		MemFree(_clipStack);
+		MemFree(_edges);
+		MemFree(_crossings);
+		MemFree(_coverage);
+	}
+
+	void Raster::Reserve(void** buffer, int* capacity, int count, size_t item_size)
+	{
+		if (count <= *capacity)
+			return;
+
+		int new_capacity = *capacity > 16 ? *capacity : 16;
+		while (new_capacity < count)
+			new_capacity *= 2;
+		void* new_buffer = MemAlloc(new_capacity * item_size, AllocCategory_Images);
+		if (*buffer != NULL)
+			memcpy(new_buffer, *buffer, *capacity * item_size);
+		MemFree(*buffer);
+		*buffer = new_buffer;
+		*capacity = new_capacity;
+	}
+
+	void Raster::Resize(int width, int height)
+	{
+		width = width > 0 ? width : 0;
+		height = height > 0 ? height : 0;
+		const size_t pixels = (size_t)width * height;
+		if (pixels != (size_t)_width * _height || _pixels == NULL || _attached)
+		{
+			if (!_attached)
+				MemFree(_pixels);
+			_pixels = (unsigned char*)MemAlloc((pixels > 0 ? pixels : 1) * 4, AllocCategory_Images);
+			_attached = false;
+			if (_pixels == NULL)
+			{
+				// out of memory: an empty raster
+				_pixels = (unsigned char*)MemAlloc(4, AllocCategory_Images);
+				width = height = 0;
+			}
+		}
+		if (width != _width || _coverage == NULL)
+		{
+			MemFree(_coverage);
+			_coverage = (float*)MemAlloc((size_t)(width + 2) * sizeof(float), AllocCategory_Images);
+		}
+		_width = width;
+		_height = height;
+		_clip = ImFloat4(0.0f, 0.0f, (float)width, (float)height);
+		_clipDepth = 0;
+		memset(_pixels, 0, (size_t)width * height * 4);
+	}
+
+	void Raster::Attach(unsigned char* pixels, int width, int height)
+	{
+		if (!_attached)
+			MemFree(_pixels);
+		_pixels = pixels;
+		_attached = true;
+		if (width != _width || _coverage == NULL)
+		{
+			MemFree(_coverage);
+			_coverage = (float*)MemAlloc((size_t)(width + 2) * sizeof(float), AllocCategory_Images);
+		}
+		_width = width;
+		_height = height;
+		_clip = ImFloat4(0.0f, 0.0f, (float)width, (float)height);
+		_clipDepth = 0;
+	}
+
+	void Raster::Clear(const ImFloat4& color)
+	{
+		const unsigned char pixel[4] =
+		{
+			(unsigned char)(Saturate(color.x * color.w) * 255.0f + 0.5f),
+			(unsigned char)(Saturate(color.y * color.w) * 255.0f + 0.5f),
+			(unsigned char)(Saturate(color.z * color.w) * 255.0f + 0.5f),
+			(unsigned char)(Saturate(color.w) * 255.0f + 0.5f),
+		};
+		const size_t pixels = (size_t)_width * _height;
+		for (size_t i = 0; i < pixels; i++)
+			memcpy(_pixels + i * 4, pixel, 4);
+	}
+
+	void Raster::PushClipRect(const ImFloat4& rect)
+	{
+		Reserve((void**)&_clipStack, &_clipCapacity, _clipDepth + 1, sizeof(ImFloat4));
+		_clipStack[_clipDepth++] = _clip;
+		_clip.x = Max(_clip.x, rect.x * _scale);
+		_clip.y = Max(_clip.y, rect.y * _scale);
+		_clip.z = Max(_clip.x, Min(_clip.z, (rect.x + rect.z) * _scale));
+		_clip.w = Max(_clip.y, Min(_clip.w, (rect.y + rect.w) * _scale));
+	}
+
+	void Raster::PopClipRect()
+	{
+		if (_clipDepth > 0)
+			_clip = _clipStack[--_clipDepth];
+	}
+
+	// coverage[x - x0] of the pixels x0..x1-1 of row y, scaled by how much of them the clip rect keeps
+	void Raster::BlendSpan(int y, int x0, int x1, const float* coverage, const ImFloat4& color)
+	{
+		const float clip_y = Overlap((float)y, (float)y + 1.0f, _clip.y, _clip.w);
+		const float alpha = Saturate(color.w) * clip_y;
+		if (alpha <= 0.0f)
+			return;
+
+		const float r = Saturate(color.x) * 255.0f, g = Saturate(color.y) * 255.0f, b = Saturate(color.z) * 255.0f;
+		unsigned char* pixel = _pixels + ((size_t)y * _width + x0) * 4;
+		for (int x = x0; x < x1; x++, pixel += 4)
+		{
+			float a = coverage[x - x0];
+			if (a <= 0.0f)
+				continue;
+			if (x < _clip.x + 1.0f || x + 1.0f > _clip.z)
+				a *= Overlap((float)x, (float)x + 1.0f, _clip.x, _clip.z);
+			a = Min(a, 1.0f) * alpha;
+
+			const float inv = 1.0f - a;
+			pixel[0] = (unsigned char)(r * a + pixel[0] * inv + 0.5f);
+			pixel[1] = (unsigned char)(g * a + pixel[1] * inv + 0.5f);
+			pixel[2] = (unsigned char)(b * a + pixel[2] * inv + 0.5f);
+			pixel[3] = (unsigned char)(255.0f * a + pixel[3] * inv + 0.5f);
+		}
+	}
+
+	void Raster::FillRect(const ImFloat4& rect, const ImFloat4& color, bool aliased)
+	{
+		float x0 = rect.x * _scale, y0 = rect.y * _scale, x1 = (rect.x + rect.z) * _scale, y1 = (rect.y + rect.w) * _scale;
+		if (aliased)
+		{
+			x0 = floorf(x0 + 0.5f);
+			y0 = floorf(y0 + 0.5f);
+			x1 = floorf(x1 + 0.5f);
+			y1 = floorf(y1 + 0.5f);
+		}
+		if (x1 <= x0 || y1 <= y0)
+			return;
+
+		// the pixels of the rect inside the clip rect, BlendSpan() applies the clip to their coverage
+		const int ix0 = Max((int)floorf(Max(x0, _clip.x)), 0), ix1 = Min((int)ceilf(Min(x1, _clip.z)), _width);
+		const int iy0 = Max((int)floorf(Max(y0, _clip.y)), 0), iy1 = Min((int)ceilf(Min(y1, _clip.w)), _height);
+		if (ix1 <= ix0 || iy1 <= iy0)
+			return;
+		for (int x = ix0; x < ix1; x++)
+			_coverage[x - ix0] = Overlap((float)x, (float)x + 1.0f, x0, x1);
+		for (int y = iy0; y < iy1; y++)
+		{
+			const float cover_y = Overlap((float)y, (float)y + 1.0f, y0, y1);
+			const ImFloat4 row_color(color.x, color.y, color.z, color.w * cover_y);
+			BlendSpan(y, ix0, ix1, _coverage, row_color);
+		}
+	}
+
+	void Raster::DrawRect(const ImFloat4& rect, const ImFloat4& color, float stroke)
+	{
+		const float h = stroke * 0.5f;
+		ImFloat2 points[8];
+		int sizes[2] = { 4, 4 };
+		points[0] = ImFloat2(rect.x - h, rect.y - h);
+		points[1] = ImFloat2(rect.x + rect.z + h, rect.y - h);
+		points[2] = ImFloat2(rect.x + rect.z + h, rect.y + rect.w + h);
+		points[3] = ImFloat2(rect.x - h, rect.y + rect.w + h);
+		points[4] = ImFloat2(rect.x + h, rect.y + h);
+		points[5] = ImFloat2(rect.x + rect.z - h, rect.y + h);
+		points[6] = ImFloat2(rect.x + rect.z - h, rect.y + rect.w - h);
+		points[7] = ImFloat2(rect.x + h, rect.y + rect.w - h);
+		const bool hollow = rect.z > stroke && rect.w > stroke;
+		FillPath(points, sizes, hollow ? 2 : 1, color);
+	}
+
+	void Raster::FillRoundedRect(const ImFloat4& rect, float rx, float ry, const ImFloat4& color)
+	{
+		ImFloat2 points[36];
+		int size = AppendRoundedRect(points, rect, rx, ry);
+		FillPath(points, &size, 1, color);
+	}
+
+	void Raster::DrawRoundedRect(const ImFloat4& rect, float rx, float ry, const ImFloat4& color, float stroke)
+	{
+		const float h = stroke * 0.5f;
+		ImFloat2 points[72];
+		int sizes[2];
+		sizes[0] = AppendRoundedRect(points, ImFloat4(rect.x - h, rect.y - h, rect.z + stroke, rect.w + stroke), rx + h, ry + h);
+		const bool hollow = rect.z > stroke && rect.w > stroke;
+		sizes[1] = hollow ? AppendRoundedRect(points + sizes[0], ImFloat4(rect.x + h, rect.y + h, rect.z - stroke, rect.w - stroke), rx - h, ry - h) : 0;
+		FillPath(points, sizes, hollow ? 2 : 1, color);
+	}
+
+	void Raster::FillEllipse(const ImFloat2& center, const ImFloat2& radius, const ImFloat4& color)
+	{
+		ImFloat2 points[128];
+		int size = AppendEllipse(points, center, radius.x, radius.y);
+		FillPath(points, &size, 1, color);
+	}
+
+	void Raster::DrawEllipse(const ImFloat2& center, const ImFloat2& radius, const ImFloat4& color, float stroke)
+	{
+		const float h = stroke * 0.5f;
+		ImFloat2 points[256];
+		int sizes[2];
+		sizes[0] = AppendEllipse(points, center, radius.x + h, radius.y + h);
+		const bool hollow = radius.x > h && radius.y > h;
+		sizes[1] = hollow ? AppendEllipse(points + sizes[0], center, radius.x - h, radius.y - h) : 0;
+		FillPath(points, sizes, hollow ? 2 : 1, color);
+	}
+
+	void Raster::FillPolygon(const ImFloat2* points, int count, const ImFloat4& color)
+	{
+		if (count >= 3)
+			FillPath(points, &count, 1, color);
+	}
+
+	// segments are drawn one by one, without joins, like flat capped Direct2D lines
+	void Raster::DrawPolyline(const ImFloat2* points, int count, const ImFloat4& color, float stroke, bool closed)
+	{
+		for (int i = 0; i + 1 < count; i++)
+			DrawLine(points[i], points[i + 1], color, stroke);
+		if (closed && count > 2)
+			DrawLine(points[count - 1], points[0], color, stroke);
+	}
+
+	void Raster::DrawLine(const ImFloat2& p0, const ImFloat2& p1, const ImFloat4& color, float stroke)
+	{
+		const float dx = p1.x - p0.x, dy = p1.y - p0.y;
+		const float length = sqrtf(dx * dx + dy * dy);
+		if (length <= 0.0f)
+			return;
+
+		const ImFloat2 n(-dy / length * stroke * 0.5f, dx / length * stroke * 0.5f);
+		ImFloat2 points[4] = { p0 + n, p1 + n, p1 - n, p0 - n };
+		int size = 4;
+		FillPath(points, &size, 1, color);
+	}
+
+	void Raster::DrawText(const char* text, const ImFloat4& rect, int align, const ImFloat4& color, float font_size)
+	{
+		// the advances of the null renderer, glyph pixels scaled to fill 5 of the 6 columns of a cell
+		const float advance = ceilf(font_size * 0.5f);
+		const float line_height = ceilf(font_size * 1.25f);
+		const float scale = advance / 6.0f;
+
+		int lines = 1;
+		for (const char* p = text; *p; p++)
+			lines += (*p == '\n') ? 1 : 0;
+
+		float top = rect.y + (rect.w - lines * line_height) * 0.5f;
+		for (const unsigned char* line = (const unsigned char*)text; ; top += line_height)
+		{
+			int chars = 0;
+			const unsigned char* end = line;
+			for (; *end && *end != '\n'; end++)
+				chars += ((*end & 0xC0) != 0x80) ? 1 : 0;
+
+			const float width = chars * advance;
+			float x = (align == 0) ? rect.x : (align == 2) ? rect.x + rect.z - width : rect.x + (rect.z - width) * 0.5f;
+			const float y = top + floorf((line_height - 7.0f * scale) * 0.5f);
+			for (const unsigned char* p = line; p < end; p++)
+			{
+				if ((*p & 0xC0) == 0x80)
+					continue;
+				const unsigned char* glyph = (*p >= 0x20 && *p < 0x7F) ? sc_font[*p - 0x20] : (*p >= 0x80) ? sc_missingGlyph : sc_font[0];
+				for (int column = 0; column < 5; column++)
+				{
+					for (int row = 0; row < 7; row++)
+					{
+						if (glyph[column] & (1 << row))
+							FillRect(ImFloat4(x + column * scale, y + row * scale, scale, scale), color);
+					}
+				}
+				x += advance;
+			}
+
+			if (*end == '\0')
+				break;
+			line = end + 1;
+		}
+	}
+
+	void Raster::Compose(const Raster& src, const ImFloat2& pos, float alpha)
+	{
+		const int ox = (int)floorf(pos.x + 0.5f), oy = (int)floorf(pos.y + 0.5f);
+		const int x0 = Max(Max(ox, 0), (int)ceilf(_clip.x)), x1 = Min(Min(ox + src._width, _width), (int)floorf(_clip.z));
+		const int y0 = Max(Max(oy, 0), (int)ceilf(_clip.y)), y1 = Min(Min(oy + src._height, _height), (int)floorf(_clip.w));
+		const float a = Saturate(alpha);
+		for (int y = y0; y < y1; y++)
+		{
+			const unsigned char* s = src._pixels + ((size_t)(y - oy) * src._width + (x0 - ox)) * 4;
+			unsigned char* d = _pixels + ((size_t)y * _width + x0) * 4;
+			for (int x = x0; x < x1; x++, s += 4, d += 4)
+			{
+				const float inv = 1.0f - s[3] * a / 255.0f;
+				for (int c = 0; c < 4; c++)
+					d[c] = (unsigned char)Min(255.0f, s[c] * a + d[c] * inv + 0.5f);
+			}
+		}
+	}
+
+	// even-odd scanline fill, SUBSAMPLES scanlines per pixel row and exact horizontal coverage.
+	// The points are in units, scaled to pixels here.
+	void Raster::FillPath(const ImFloat2* points, const int* contour_sizes, int contours, const ImFloat4& color)
+	{
+		int edge_count = 0;
+		for (int c = 0; c < contours; c++)
+			edge_count += contour_sizes[c];
+		Reserve((void**)&_edges, &_edgeCapacity, edge_count, sizeof(Edge));
+		Reserve((void**)&_crossings, &_crossingCapacity, edge_count, sizeof(float));
+
+		float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+		edge_count = 0;
+		for (int c = 0, first = 0; c < contours; first += contour_sizes[c++])
+		{
+			for (int i = 0; i < contour_sizes[c]; i++)
+			{
+				const ImFloat2& pa = points[first + i];
+				const ImFloat2& pb = points[first + (i + 1) % contour_sizes[c]];
+				const ImFloat2 a(pa.x * _scale, pa.y * _scale), b(pb.x * _scale, pb.y * _scale);
+				min_x = Min(min_x, a.x);
+				max_x = Max(max_x, a.x);
+				min_y = Min(min_y, a.y);
+				max_y = Max(max_y, a.y);
+				if (a.y != b.y)
+				{
+					const Edge edge = { a.x, a.y, b.x, b.y };
+					_edges[edge_count++] = edge;
+				}
+			}
+		}
+
+		const int x0 = Max((int)floorf(Max(min_x, _clip.x)), 0);
+		const int x1 = Min((int)ceilf(Min(max_x, _clip.z)), _width);
+		const int y0 = Max((int)floorf(Max(min_y, _clip.y)), 0);
+		const int y1 = Min((int)ceilf(Min(max_y, _clip.w)), _height);
+		if (x1 <= x0 || y1 <= y0)
+			return;
+
+		for (int y = y0; y < y1; y++)
+		{
+			memset(_coverage, 0, (x1 - x0) * sizeof(float));
+			for (int s = 0; s < SUBSAMPLES; s++)
+			{
+				const float sy = y + (s + 0.5f) / SUBSAMPLES;
+				int count = 0;
+				for (int i = 0; i < edge_count; i++)
+				{
+					const Edge& e = _edges[i];
+					if ((sy >= e.Y0 && sy < e.Y1) || (sy >= e.Y1 && sy < e.Y0))
+					{
+						// insertion sort, the crossings of a scanline are few
+						const float x = e.X0 + (sy - e.Y0) * (e.X1 - e.X0) / (e.Y1 - e.Y0);
+						int j = count++;
+						for (; j > 0 && _crossings[j - 1] > x; j--)
+							_crossings[j] = _crossings[j - 1];
+						_crossings[j] = x;
+					}
+				}
+
+				for (int i = 0; i + 1 < count; i += 2)
+				{
+					const float a = Max(_crossings[i], (float)x0), b = Min(_crossings[i + 1], (float)x1);
+					if (b <= a)
+						continue;
+					const int ia = (int)a, ib = (int)b;
+					const float w = 1.0f / SUBSAMPLES;
+					if (ia == ib)
+					{
+						_coverage[ia - x0] += (b - a) * w;
+						continue;
+					}
+					_coverage[ia - x0] += (ia + 1 - a) * w;
+					for (int x = ia + 1; x < ib; x++)
+						_coverage[x - x0] += w;
+					if (ib < x1)
+						_coverage[ib - x0] += (b - ib) * w;
+				}
+			}
+			BlendSpan(y, x0, x1, _coverage, color);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// zlib streams and PNG
+
+	struct Crc32Table
+	{
+		ImUint	Values[256];
+
+		Crc32Table()
+		{
+			for (ImUint n = 0; n < 256; n++)
+			{
+				ImUint c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				Values[n] = c;
+			}
+		}
+	};
+
+	static ImUint Crc32(const unsigned char* data, size_t size, ImUint crc)
+	{
+		static const Crc32Table table;		// built once, by the first thread to get here
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+			crc = table.Values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	static ImUint GetBE32(const unsigned char* in)
+	{
+		return ((ImUint)in[0] << 24) | ((ImUint)in[1] << 16) | ((ImUint)in[2] << 8) | in[3];
+	}
+
+	static void PutBE32(unsigned char* out, ImUint v)
+	{
+		out[0] = (unsigned char)(v >> 24);
+		out[1] = (unsigned char)(v >> 16);
+		out[2] = (unsigned char)(v >> 8);
+		out[3] = (unsigned char)v;
+	}
+
+	static int Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+		return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+	}
+
+	// deflate length and distance codes
+	static const unsigned short	sc_lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const unsigned char	sc_lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const unsigned short	sc_distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const unsigned char	sc_distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	static int FloorLog2(ImUint v)
+	{
+		int log = 0;
+		while (v >>= 1)
+			log++;
+		return log;
+	}
+
+	Deflater::Deflater(WriteFunc func, void* user_data)
+		: _func(func)
+		, _userData(user_data)
+		, _ok(true)
+		, _windowBase(0)
+		, _windowEnd(0)
+		, _pending(0)
+		, _adler1(1)
+		, _adler2(0)
+		, _bits(0)
+		, _bitCount(0)
+		, _outSize(0)
+	{
+		_window = (unsigned char*)MemAlloc(BUFFER, AllocCategory_Images);
+		_head = (size_t*)MemAlloc(sizeof(size_t) << HASH_BITS, AllocCategory_Images);
+		_out = (unsigned char*)MemAlloc(OUT_CHUNK, AllocCategory_Images);
+		memset(_head, 0, sizeof(size_t) << HASH_BITS);
+
+		// zlib header, then the one block of the stream: final, fixed Huffman codes
+		PutByte(0x78);
+		PutByte(0x01);
+		PutBits(1, 1);
+		PutBits(1, 2);
+	}
+
+	Deflater::~Deflater()
+	{
+		MemFree(_window);
+		MemFree(_head);
+		MemFree(_out);
+	}
+
+	void Deflater::PutByte(unsigned char byte)
+	{
+		_out[_outSize++] = byte;
+		if (_outSize == OUT_CHUNK)
+		{
+			_ok = _ok && _func(_out, _outSize, _userData);
+			_outSize = 0;
+		}
+	}
+
+	void Deflater::PutBits(ImUint bits, int count)
+	{
+		_bits |= bits << _bitCount;
+		_bitCount += count;
+		while (_bitCount >= 8)
+		{
+			PutByte((unsigned char)_bits);
+			_bits >>= 8;
+			_bitCount -= 8;
+		}
+	}
+
+	void Deflater::PutCode(ImUint code, int length)
+	{
+		ImUint reversed = 0;
+		for (int i = 0; i < length; i++)
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+		PutBits(reversed, length);
+	}
+
+	// the fixed literal / length code of RFC 1951 3.2.6
+	void Deflater::PutLiteral(int symbol)
+	{
+		if (symbol < 144)
+			PutCode(0x30 + symbol, 8);
+		else if (symbol < 256)
+			PutCode(0x190 + symbol - 144, 9);
+		else if (symbol < 280)
+			PutCode(symbol - 256, 7);
+		else
+			PutCode(0xC0 + symbol - 280, 8);
+	}
+
+	void Deflater::PutMatch(int length, int distance)
+	{
+		const ImUint l = (ImUint)(length - 3);
+		const int length_code = (length == 258) ? 28 : (l < 8) ? (int)l : 4 * (FloorLog2(l) - 1) + (int)((l >> (FloorLog2(l) - 2)) & 3);
+		PutLiteral(257 + length_code);
+		PutBits(length - sc_lengthBase[length_code], sc_lengthExtra[length_code]);
+
+		const ImUint d = (ImUint)(distance - 1);
+		const int dist_code = (d < 4) ? (int)d : 2 * FloorLog2(d) + (int)((d >> (FloorLog2(d) - 1)) & 1);
+		PutCode(dist_code, 5);
+		PutBits(distance - sc_distBase[dist_code], sc_distExtra[dist_code]);
+	}
+
+	void Deflater::Write(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		while (size > 0)
+		{
+			const size_t count = (BUFFER - _windowEnd < size) ? BUFFER - _windowEnd : size;
+			memcpy(_window + _windowEnd, bytes, count);
+
+			// adler32, reduced every 5552 bytes at most
+			for (size_t i = 0; i < count;)
+			{
+				const size_t end = (count - i < 5552) ? count : i + 5552;
+				for (; i < end; i++)
+				{
+					_adler1 += bytes[i];
+					_adler2 += _adler1;
+				}
+				_adler1 %= 65521;
+				_adler2 %= 65521;
+			}
+
+			_windowEnd += count;
+			bytes += count;
+			size -= count;
+			if (_windowEnd == BUFFER)
+				Compress(false);
+		}
+	}
+
+	// Compresses the pending bytes, all of them when final, else up to MAX_MATCH from the end so
+	// that matches may be as long as they can. Then slides the window.
+	void Deflater::Compress(bool final)
+	{
+		const size_t limit = final ? _windowEnd : _windowEnd - MAX_MATCH;
+		size_t pos = _pending;
+		while (pos < limit)
+		{
+			int length = 0;
+			size_t distance = 0;
+			if (_windowEnd - pos >= MIN_MATCH)
+			{
+				const unsigned char* p = _window + pos;
+				const ImUint hash = (((ImUint)p[0] << 16 | (ImUint)p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+				const size_t candidate = _head[hash];
+				_head[hash] = _windowBase + pos + 1;
+				if (candidate > _windowBase && _windowBase + pos + 1 - candidate <= WINDOW)
+				{
+					const unsigned char* q = _window + (candidate - 1 - _windowBase);
+					const int max_length = (int)((_windowEnd - pos < (size_t)MAX_MATCH) ? _windowEnd - pos : (size_t)MAX_MATCH);
+					while (length < max_length && q[length] == p[length])
+						length++;
+					distance = (size_t)(p - q);
+				}
+			}
+
+			if (length >= MIN_MATCH)
+			{
+				PutMatch(length, (int)distance);
+				for (int i = 1; i < length; i++)
+				{
+					if (_windowEnd - (pos + i) < MIN_MATCH)
+						break;
+					const unsigned char* p = _window + pos + i;
+					_head[(((ImUint)p[0] << 16 | (ImUint)p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS)] = _windowBase + pos + i + 1;
+				}
+				pos += length;
+			}
+			else
+			{
+				PutLiteral(_window[pos]);
+				pos++;
+			}
+		}
+		_pending = pos;
+
+		if (_pending > WINDOW)
+		{
+			const size_t shift = _pending - WINDOW;
+			memmove(_window, _window + shift, _windowEnd - shift);
+			_windowBase += shift;
+			_windowEnd -= shift;
+			_pending -= shift;
+		}
+	}
+
+	bool Deflater::End()
+	{
+		Compress(true);
+		PutLiteral(256);
+		if (_bitCount > 0)
+			PutBits(0, 8 - _bitCount);
+
+		unsigned char adler[4];
+		PutBE32(adler, (_adler2 << 16) | _adler1);
+		for (int i = 0; i < 4; i++)
+			PutByte(adler[i]);
+		if (_outSize > 0)
+			_ok = _ok && _func(_out, _outSize, _userData);
+		_outSize = 0;
+		return _ok;
+	}
+
+	// PNG encoder fed a row at a time. Rows are filtered with the filter that leaves the smallest
+	// sum of residuals, deflated, and written out in IDAT chunks as the deflater hands them over.
+	class PngEncoder
+	{
+	public:
+		PngEncoder(int width, int height, WriteFunc func, void* user_data);
+		~PngEncoder();
+
+		unsigned char*	GetRow() { return _row; }		// to fill with the next straight alpha RGBA row
+		void			AddRow();
+		bool			End();
+
+	private:
+		static bool		WriteIDAT(const void* data, size_t size, void* user_data);
+		void			WriteChunk(const char* type, const unsigned char* data, size_t size);
+
+		WriteFunc		_func;
+		void*			_userData;
+		bool			_ok;
+		size_t			_stride;
+		unsigned char*	_row;
+		unsigned char*	_prevRow;
+		unsigned char*	_filtered;		// the filter byte then the filtered row
+		Deflater		_deflater;
+	};
+
+	PngEncoder::PngEncoder(int width, int height, WriteFunc func, void* user_data)
+		: _func(func)
+		, _userData(user_data)
+		, _ok(true)
+		, _stride((size_t)width * 4)
+		, _deflater(WriteIDAT, this)
+	{
+		_row = (unsigned char*)MemAlloc(_stride + 1, AllocCategory_Images);
+		_prevRow = (unsigned char*)MemAlloc(_stride + 1, AllocCategory_Images);
+		_filtered = (unsigned char*)MemAlloc(_stride + 1, AllocCategory_Images);
+		memset(_prevRow, 0, _stride + 1);
+
+		static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		unsigned char ihdr[13];
+		PutBE32(ihdr, (ImUint)width);
+		PutBE32(ihdr + 4, (ImUint)height);
+		ihdr[8] = 8;		// bits per channel
+		ihdr[9] = 6;		// RGBA
+		ihdr[10] = ihdr[11] = ihdr[12] = 0;
+		_ok = _func(signature, sizeof(signature), _userData);
+		WriteChunk("IHDR", ihdr, sizeof(ihdr));
+	}
+
+	PngEncoder::~PngEncoder()
+	{
+		MemFree(_row);
+		MemFree(_prevRow);
+		MemFree(_filtered);
+	}
+
+	void PngEncoder::WriteChunk(const char* type, const unsigned char* data, size_t size)
+	{
+		unsigned char head[8];
+		PutBE32(head, (ImUint)size);
+		memcpy(head + 4, type, 4);
+		unsigned char crc[4];
+		PutBE32(crc, Crc32(data, size, Crc32(head + 4, 4, 0)));
+		_ok = _ok && _func(head, 8, _userData) && (size == 0 || _func(data, size, _userData)) && _func(crc, 4, _userData);
+	}
+
+	bool PngEncoder::WriteIDAT(const void* data, size_t size, void* user_data)
+	{
+		PngEncoder* self = (PngEncoder*)user_data;
+		self->WriteChunk("IDAT", (const unsigned char*)data, size);
+		return self->_ok;
+	}
+
+	void PngEncoder::AddRow()
+	{
+		// None, Sub, Up, Average, Paeth on the bytes of the pixel to the left and above: the sums
+		// of the residuals of all five in one pass, then the row through the best one
+		size_t sums[5] = { 0, 0, 0, 0, 0 };
+		for (size_t i = 0; i < _stride; i++)
+		{
+			const int x = _row[i];
+			const int a = (i >= 4) ? _row[i - 4] : 0;
+			const int b = _prevRow[i];
+			const int c = (i >= 4) ? _prevRow[i - 4] : 0;
+			const int predicted[5] = { 0, a, b, (a + b) >> 1, Paeth(a, b, c) };
+			for (int filter = 0; filter < 5; filter++)
+			{
+				const unsigned char v = (unsigned char)(x - predicted[filter]);
+				sums[filter] += (v < 128) ? v : 256 - v;
+			}
+		}
+		int best = 0;
+		for (int filter = 1; filter < 5; filter++)
+			best = (sums[filter] < sums[best]) ? filter : best;
+
+		_filtered[0] = (unsigned char)best;
+		for (size_t i = 0; i < _stride; i++)
+		{
+			const int a = (i >= 4) ? _row[i - 4] : 0;
+			const int b = _prevRow[i];
+			const int c = (i >= 4) ? _prevRow[i - 4] : 0;
+			const int predicted = (best == 0) ? 0 : (best == 1) ? a : (best == 2) ? b : (best == 3) ? (a + b) >> 1 : Paeth(a, b, c);
+			_filtered[i + 1] = (unsigned char)(_row[i] - predicted);
+		}
+		_deflater.Write(_filtered, _stride + 1);
+
+		unsigned char* swap = _prevRow;
+		_prevRow = _row;
+		_row = swap;
+	}
+
+	bool PngEncoder::End()
+	{
+		_ok = _deflater.End() && _ok;
+		WriteChunk("IEND", NULL, 0);
+		return _ok;
+	}
+
+	bool Raster::WritePNG(WriteFunc func, void* user_data) const
+	{
+		PngEncoder encoder(_width, _height, func, user_data);
+		for (int y = 0; y < _height; y++)
+		{
+			unsigned char* out = encoder.GetRow();
+			const unsigned char* in = _pixels + (size_t)y * _width * 4;
+			for (int x = 0; x < _width; x++, in += 4, out += 4)
+			{
+				const unsigned a = in[3];
+				for (int c = 0; c < 3; c++)
+					out[c] = a ? (unsigned char)Min((int)((in[c] * 255u + a / 2) / a), 255) : 0;
+				out[3] = (unsigned char)a;
+			}
+			encoder.AddRow();
+		}
+		return encoder.End();
+	}
+
+	static bool WriteFile(const void* data, size_t size, void* user_data)
+	{
+		return fwrite(data, 1, size, (FILE*)user_data) == size;
+	}
+
+	bool Raster::WritePNG(const char* path) const
+	{
+		FILE* f = fopen(path, "wb");
+		if (f == NULL)
+			return false;
+		const bool ok = WritePNG(WriteFile, f);
+		return (fclose(f) == 0) && ok;
+	}
+
+	// zlib inflate of stored, fixed and dynamic Huffman blocks, into a buffer of known size
+	struct Inflater
+	{
+		const unsigned char*	In;
+		size_t					InSize;
+		size_t					InPos;
+		ImUint					Bits;
+		int						BitCount;
+		unsigned char*			Out;
+		size_t					OutSize;
+		size_t					OutPos;
+		bool					Error;
+	};
+
+	// canonical Huffman code: how many codes of every length, and the symbols ordered by code
+	struct Huffman
+	{
+		unsigned short	Counts[16];
+		unsigned short	Symbols[288];
+	};
+
+	static ImUint GetBits(Inflater* s, int count)
+	{
+		while (s->BitCount < count)
+		{
+			if (s->InPos == s->InSize)
+			{
+				s->Error = true;
+				return 0;
+			}
+			s->Bits |= (ImUint)s->In[s->InPos++] << s->BitCount;
+			s->BitCount += 8;
+		}
+		const ImUint bits = s->Bits & ((1u << count) - 1);
+		s->Bits >>= count;
+		s->BitCount -= count;
+		return bits;
+	}
+
+	static void BuildHuffman(Huffman* h, const unsigned char* lengths, int count)
+	{
+		unsigned short offsets[16];
+		memset(h->Counts, 0, sizeof(h->Counts));
+		for (int i = 0; i < count; i++)
+			h->Counts[lengths[i]]++;
+		h->Counts[0] = 0;
+		offsets[1] = 0;
+		for (int len = 1; len < 15; len++)
+			offsets[len + 1] = offsets[len] + h->Counts[len];
+		for (int i = 0; i < count; i++)
+		{
+			if (lengths[i] != 0)
+				h->Symbols[offsets[lengths[i]]++] = (unsigned short)i;
+		}
+	}
+
+	static int DecodeSymbol(Inflater* s, const Huffman* h)
+	{
+		int code = 0, first = 0, index = 0;
+		for (int len = 1; len < 16; len++)
+		{
+			code |= (int)GetBits(s, 1);
+			const int count = h->Counts[len];
+			if (code - first < count)
+				return h->Symbols[index + code - first];
+			index += count;
+			first = (first + count) << 1;
+			code <<= 1;
+		}
+		s->Error = true;
+		return -1;
+	}
+
+	static bool InflateCodes(Inflater* s, const Huffman* lengths, const Huffman* distances)
+	{
+		for (;;)
+		{
+			int symbol = DecodeSymbol(s, lengths);
+			if (s->Error)
+				return false;
+			if (symbol < 256)
+			{
+				if (s->OutPos == s->OutSize)
+					return false;
+				s->Out[s->OutPos++] = (unsigned char)symbol;
+				continue;
+			}
+			if (symbol == 256)
+				return true;
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+			const size_t length = sc_lengthBase[symbol] + GetBits(s, sc_lengthExtra[symbol]);
+			const int dist_symbol = DecodeSymbol(s, distances);
+			if (s->Error || dist_symbol >= 30)
+				return false;
+			const size_t dist = sc_distBase[dist_symbol] + GetBits(s, sc_distExtra[dist_symbol]);
+			if (s->Error || dist > s->OutPos || length > s->OutSize - s->OutPos)
+				return false;
+			for (size_t i = 0; i < length; i++, s->OutPos++)
+				s->Out[s->OutPos] = s->Out[s->OutPos - dist];
+		}
+	}
+
+	static bool InflateDynamic(Inflater* s, Huffman* lengths, Huffman* distances)
+	{
+		static const unsigned char sc_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		const int nlen = (int)GetBits(s, 5) + 257;
+		const int ndist = (int)GetBits(s, 5) + 1;
+		const int ncode = (int)GetBits(s, 4) + 4;
+		if (s->Error || nlen > 286 || ndist > 30)
+			return false;
+
+		unsigned char code_lengths[320];
+		memset(code_lengths, 0, sizeof(code_lengths));
+		for (int i = 0; i < ncode; i++)
+			code_lengths[sc_order[i]] = (unsigned char)GetBits(s, 3);
+		BuildHuffman(lengths, code_lengths, 19);
+
+		for (int i = 0; i < nlen + ndist;)
+		{
+			const int symbol = DecodeSymbol(s, lengths);
+			if (s->Error)
+				return false;
+			if (symbol < 16)
+			{
+				code_lengths[i++] = (unsigned char)symbol;
+				continue;
+			}
+
+			unsigned char repeat_length = 0;
+			int repeat;
+			if (symbol == 16)
+			{
+				if (i == 0)
+					return false;
+				repeat_length = code_lengths[i - 1];
+				repeat = 3 + (int)GetBits(s, 2);
+			}
+			else
+			{
+				repeat = (symbol == 17) ? 3 + (int)GetBits(s, 3) : 11 + (int)GetBits(s, 7);
+			}
+			if (i + repeat > nlen + ndist)
+				return false;
+			while (repeat--)
+				code_lengths[i++] = repeat_length;
+		}
+
+		BuildHuffman(lengths, code_lengths, nlen);
+		BuildHuffman(distances, code_lengths + nlen, ndist);
+		return !s->Error && InflateCodes(s, lengths, distances);
+	}
+
+	bool Inflate(const void* in_data, size_t in_size, void* out, size_t out_size)
+	{
+		const unsigned char* in = (const unsigned char*)in_data;
+		// 2 bytes of zlib header, the adler32 at the end is not checked
+		if (in_size < 2 || (in[0] & 0x0F) != 8 || (in[1] & 0x20) != 0)
+			return false;
+
+		Inflater s;
+		memset(&s, 0, sizeof(s));
+		s.In = in + 2;
+		s.InSize = in_size - 2;
+		s.Out = (unsigned char*)out;
+		s.OutSize = out_size;
+
+		Huffman lengths, distances;
+		bool last = false;
+		while (!last)
+		{
+			last = GetBits(&s, 1) != 0;
+			const ImUint type = GetBits(&s, 2);
+			if (s.Error)
+				return false;
+
+			if (type == 0)
+			{
+				s.Bits = 0;
+				s.BitCount = 0;
+				if (s.InSize - s.InPos < 4)
+					return false;
+				const size_t size = s.In[s.InPos] | (s.In[s.InPos + 1] << 8);
+				s.InPos += 4;
+				if (s.InSize - s.InPos < size || s.OutSize - s.OutPos < size)
+					return false;
+				memcpy(s.Out + s.OutPos, s.In + s.InPos, size);
+				s.InPos += size;
+				s.OutPos += size;
+			}
+			else if (type == 1)
+			{
+				unsigned char code_lengths[288 + 30];
+				memset(code_lengths, 8, 144);
+				memset(code_lengths + 144, 9, 112);
+				memset(code_lengths + 256, 7, 24);
+				memset(code_lengths + 280, 8, 8);
+				memset(code_lengths + 288, 5, 30);
+				BuildHuffman(&lengths, code_lengths, 288);
+				BuildHuffman(&distances, code_lengths + 288, 30);
+				if (!InflateCodes(&s, &lengths, &distances))
+					return false;
+			}
+			else if (type != 2 || !InflateDynamic(&s, &lengths, &distances))
+			{
+				return false;
+			}
+		}
+		return s.OutPos == s.OutSize;
+	}
+
+	bool Raster::ReadPNG(const char* path)
+	{
+		FILE* f = fopen(path, "rb");
+		if (f == NULL)
+			return false;
+		fseek(f, 0, SEEK_END);
+		const long file_size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		unsigned char* file = (unsigned char*)MemAlloc(file_size > 0 ? (size_t)file_size : 1, AllocCategory_Images);
+		const size_t size = (file_size > 0) ? fread(file, 1, (size_t)file_size, f) : 0;
+		fclose(f);
+
+		static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		bool ok = size >= 8 + 25 && memcmp(file, signature, 8) == 0 && memcmp(file + 12, "IHDR", 4) == 0;
+		const int width = ok ? (int)GetBE32(file + 16) : 0;
+		const int height = ok ? (int)GetBE32(file + 20) : 0;
+		const int color_type = ok ? file[25] : 0;
+		const int channels = (color_type == 0) ? 1 : (color_type == 4) ? 2 : (color_type == 2) ? 3 : (color_type == 6) ? 4 : 0;
+		ok = ok && width > 0 && height > 0 && width <= 1 << 15 && height <= 1 << 15
+			&& file[24] == 8 && channels != 0 && file[28] == 0;
+
+		// the IDAT chunks make up one zlib stream, gathered in place at the start of the file
+		size_t idat_size = 0;
+		for (size_t pos = 8; ok && size - pos >= 12;)
+		{
+			const size_t chunk_size = GetBE32(file + pos);
+			if (chunk_size > size - pos - 12)
+			{
+				ok = false;
+				break;
+			}
+			if (memcmp(file + pos + 4, "IEND", 4) == 0)
+				break;
+			if (memcmp(file + pos + 4, "IDAT", 4) == 0)
+			{
+				memmove(file + idat_size, file + pos + 8, chunk_size);
+				idat_size += chunk_size;
+			}
+			pos += 12 + chunk_size;
+		}
+
+		const size_t stride = (size_t)width * channels;
+		const size_t raw_size = (stride + 1) * height;
+		unsigned char* raw = ok ? (unsigned char*)MemAlloc(raw_size, AllocCategory_Images) : NULL;
+		ok = ok && Inflate(file, idat_size, raw, raw_size);
+
+		if (ok)
+		{
+			Resize(width, height);
+			for (int y = 0; y < height && ok; y++)
+			{
+				unsigned char* row = raw + y * (stride + 1) + 1;
+				const unsigned char* prev = (y > 0) ? row - (stride + 1) : NULL;
+				const int filter = row[-1];
+				for (size_t i = 0; i < stride; i++)
+				{
+					const int a = (i >= (size_t)channels) ? row[i - channels] : 0;
+					const int b = prev ? prev[i] : 0;
+					const int c = (prev && i >= (size_t)channels) ? prev[i - channels] : 0;
+					switch (filter)
+					{
+					case 0: break;
+					case 1: row[i] = (unsigned char)(row[i] + a); break;
+					case 2: row[i] = (unsigned char)(row[i] + b); break;
+					case 3: row[i] = (unsigned char)(row[i] + ((a + b) >> 1)); break;
+					case 4: row[i] = (unsigned char)(row[i] + Paeth(a, b, c)); break;
+					default: ok = false; break;
+					}
+				}
+
+				unsigned char* out = _pixels + (size_t)y * width * 4;
+				for (int x = 0; x < width; x++, out += 4)
+				{
+					const unsigned char* in = row + x * channels;
+					const unsigned alpha = (channels == 2 || channels == 4) ? in[channels - 1] : 255;
+					for (int k = 0; k < 3; k++)
+					{
+						const unsigned v = (channels < 3) ? in[0] : in[k];
+						out[k] = (unsigned char)((v * alpha + 127) / 255);
+					}
+					out[3] = (unsigned char)alpha;
+				}
+			}
+		}
+
+		MemFree(raw);
+		MemFree(file);
+		return ok;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// frame captures
+
+	FrameCaptureReader::FrameCaptureReader()
+		: _header()
+		, _windows(NULL)
+		, _windowCount(0)
+		, _bgImage("")
+		, _toolTip("")
+	{
+	}
+
+	FrameCaptureReader::~FrameCaptureReader()
+	{
+		MemFree(_windows);
+	}
+
+	// finite and within the frame size the rasterizer is asked for
+	static bool IsCaptureSize(float width, float height)
+	{
+		return width >= 0.0f && width <= FRAME_CAPTURE_MAX_SIZE && height >= 0.0f && height <= FRAME_CAPTURE_MAX_SIZE;
+	}
+
+	static bool IsCaptureRect(const ImFloat4& rect)
+	{
+		return IsCaptureSize(rect.z, rect.w) && rect.x >= -FRAME_CAPTURE_MAX_SIZE && rect.y >= -FRAME_CAPTURE_MAX_SIZE
+			&& rect.x + rect.z <= FRAME_CAPTURE_MAX_SIZE && rect.y + rect.w <= FRAME_CAPTURE_MAX_SIZE;
+	}
+
+	static bool IsString(const char* text, ImUint text_bytes, ImUint offset)
+	{
+		return offset < text_bytes && memchr(text + offset, '\0', text_bytes - offset) != NULL;
+	}
+
+	const char* FrameCaptureReader::Read(const void* data, size_t size)
+	{
+		const char* bytes = (const char*)data;
+		const char* end = bytes + size;
+		MemFree(_windows);
+		_windows = NULL;
+		_windowCount = 0;
+
+		if (size < sizeof(FrameCaptureHeader))
+			return "not a frame capture";
+		if ((size_t)bytes % 4 != 0)
+			return "frame capture not aligned to 4 bytes in memory";
+		memcpy(&_header, bytes, sizeof(_header));
+		const ImUint swapped_magic = (FRAME_CAPTURE_MAGIC >> 24) | ((FRAME_CAPTURE_MAGIC >> 8) & 0xFF00) | ((FRAME_CAPTURE_MAGIC & 0xFF00) << 8) | ((ImUint)FRAME_CAPTURE_MAGIC << 24);
+		if (_header.Magic == swapped_magic)
+			return "frame capture of a host of the other byte order";
+		if (_header.Magic != FRAME_CAPTURE_MAGIC)
+			return "not a frame capture";
+		if (_header.Version != FRAME_CAPTURE_VERSION)
+			return "frame capture of another version";
+		if (!IsCaptureSize(_header.Width, _header.Height) || !IsCaptureRect(_header.ToolTipRect))
+			return "frame capture of a corrupt size";
+		if (_header.WindowCount > (size - sizeof(FrameCaptureHeader)) / sizeof(FrameCaptureWindow))
+			return "truncated frame capture";
+
+		_windows = (WindowData*)MemAlloc((_header.WindowCount ? _header.WindowCount : 1) * sizeof(WindowData), AllocCategory_Images);
+		const char* pos = bytes + sizeof(FrameCaptureHeader);
+		for (ImUint i = 0; i < _header.WindowCount; i++)
+		{
+			WindowData& window = _windows[i];
+			if ((size_t)(end - pos) < sizeof(FrameCaptureWindow))
+				return "truncated frame capture";
+			memcpy(&window.Info, pos, sizeof(FrameCaptureWindow));
+			window.Info.Name[sizeof(window.Info.Name) - 1] = '\0';
+			pos += sizeof(FrameCaptureWindow);
+			if (window.Info.TextBytes % 4 != 0 || !IsCaptureRect(window.Info.Rect))
+				return "corrupt window in frame capture";
+
+			const size_t cmd_bytes = (size_t)window.Info.CmdCount * sizeof(FrameCaptureCmd);
+			const size_t point_bytes = (size_t)window.Info.PointCount * sizeof(ImFloat2);
+			if ((size_t)(end - pos) < cmd_bytes + point_bytes + window.Info.TextBytes)
+				return "truncated frame capture";
+			window.Cmds = (const FrameCaptureCmd*)pos;
+			window.Points = (const ImFloat2*)(pos + cmd_bytes);
+			window.Text = pos + cmd_bytes + point_bytes;
+			pos += cmd_bytes + point_bytes + window.Info.TextBytes;
+
+			for (ImUint j = 0; j < window.Info.CmdCount; j++)
+			{
+				const FrameCaptureCmd& cmd = window.Cmds[j];
+				bool valid = cmd.Type < FrameCaptureCmd_COUNT;
+				switch (cmd.Type)
+				{
+				case FrameCaptureCmd_Line:
+					valid = cmd.Offset < window.Info.PointCount && window.Info.PointCount - cmd.Offset >= 2;
+					break;
+				case FrameCaptureCmd_Polygon:
+				case FrameCaptureCmd_PolygonalLine:
+					valid = cmd.Offset <= window.Info.PointCount && cmd.Count <= window.Info.PointCount - cmd.Offset;
+					break;
+				case FrameCaptureCmd_Text:
+				case FrameCaptureCmd_Image:
+					valid = IsString(window.Text, window.Info.TextBytes, cmd.Offset);
+					break;
+				case FrameCaptureCmd_ImageView:
+					valid = IsString(window.Text, window.Info.TextBytes, cmd.Offset)
+						&& cmd.Count < window.Info.PointCount && window.Info.PointCount - cmd.Count >= 2;
+					break;
+				}
+				if (!valid)
+					return "corrupt draw command in frame capture";
+			}
+			_windowCount++;
+		}
+
+		const char* bg_end = (const char*)memchr(pos, '\0', end - pos);
+		if (bg_end == NULL || memchr(bg_end + 1, '\0', end - bg_end - 1) == NULL)
+			return "truncated frame capture";
+		_bgImage = pos;
+		_toolTip = bg_end + 1;
+		return NULL;
+	}
+
+	int FrameCaptureReader::FindWindow(const char* name) const
+	{
+		for (int i = 0; i < _windowCount; i++)
+		{
+			if (strcmp(_windows[i].Info.Name, name) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	ImFloat2 FrameCaptureReader::GetFrameSize() const
+	{
+		if (_header.Width > 0.0f && _header.Height > 0.0f)
+			return ImFloat2(_header.Width, _header.Height);
+
+		ImFloat2 size(1.0f, 1.0f);
+		for (int i = 0; i <= _windowCount; i++)
+		{
+			if (i == _windowCount && _toolTip[0] == '\0')
+				break;
+			const ImFloat4& rect = (i < _windowCount) ? _windows[i].Info.Rect : _header.ToolTipRect;
+			size.x = Max(size.x, rect.x + rect.z);
+			size.y = Max(size.y, rect.y + rect.w);
+		}
+		return size;
+	}
+
+	void RasterCaptureCommand(Raster* surface, const FrameCaptureReader& capture, int window_index, ImUint cmd_index)
+	{
+		const FrameCaptureReader::WindowData& window = capture.GetWindow(window_index);
+		const FrameCaptureCmd& cmd = window.Cmds[cmd_index];
+		const float stroke = capture.GetHeader().StrokeWidth;
+		const bool filled = (cmd.Flags & FrameCaptureCmd_Filled) != 0;
+		switch (cmd.Type)
+		{
+		case FrameCaptureCmd_Line:
+			surface->DrawLine(window.Points[cmd.Offset], window.Points[cmd.Offset + 1], cmd.Color, stroke);
+			break;
+		case FrameCaptureCmd_Rect:
+			if (filled)
+				surface->FillRect(cmd.Rect, cmd.Color, (cmd.Flags & FrameCaptureCmd_Aliased) != 0);
+			else
+				surface->DrawRect(cmd.Rect, cmd.Color, stroke);
+			break;
+		case FrameCaptureCmd_RoundedRect:
+			if (filled)
+				surface->FillRoundedRect(cmd.Rect, cmd.Radius.x, cmd.Radius.y, cmd.Color);
+			else
+				surface->DrawRoundedRect(cmd.Rect, cmd.Radius.x, cmd.Radius.y, cmd.Color, stroke);
+			break;
+		case FrameCaptureCmd_Ellipse:
+			if (filled)
+				surface->FillEllipse(ImFloat2(cmd.Rect.x, cmd.Rect.y), cmd.Radius, cmd.Color);
+			else
+				surface->DrawEllipse(ImFloat2(cmd.Rect.x, cmd.Rect.y), cmd.Radius, cmd.Color, stroke);
+			break;
+		case FrameCaptureCmd_Polygon:
+			if (filled)
+				surface->FillPolygon(window.Points + cmd.Offset, (int)cmd.Count, cmd.Color);
+			else
+				surface->DrawPolyline(window.Points + cmd.Offset, (int)cmd.Count, cmd.Color, stroke, true);
+			break;
+		case FrameCaptureCmd_PolygonalLine:
+			surface->DrawPolyline(window.Points + cmd.Offset, (int)cmd.Count, cmd.Color, stroke, false);
+			break;
+		case FrameCaptureCmd_Text:
+			surface->DrawText(window.Text + cmd.Offset, cmd.Rect, (int)((cmd.Flags >> FrameCaptureCmd_AlignShift) & 3), cmd.Color, capture.GetHeader().FontSize);
+			break;
+		case FrameCaptureCmd_Image:
+		case FrameCaptureCmd_ImageView:
+		case FrameCaptureCmd_Heatmap:
+		{
+			// a zero size image is drawn at its natural size, unknown here
+			if (cmd.Rect.z <= 0.0f || cmd.Rect.w <= 0.0f)
+				break;
+			const ImFloat4 cross(0.35f, 0.35f, 0.35f, 1.0f);
+			const ImFloat2 p0(cmd.Rect.x, cmd.Rect.y);
+			const ImFloat2 p1(cmd.Rect.x + cmd.Rect.z, cmd.Rect.y + cmd.Rect.w);
+			surface->FillRect(cmd.Rect, ImFloat4(0.5f, 0.5f, 0.5f, 1.0f));
+			surface->DrawLine(p0, p1, cross, stroke);
+			surface->DrawLine(ImFloat2(p1.x, p0.y), ImFloat2(p0.x, p1.y), cross, stroke);
+			break;
+		}
+		case FrameCaptureCmd_PushClip:
+			surface->PushClipRect(cmd.Rect);
+			break;
+		case FrameCaptureCmd_PopClip:
+			surface->PopClipRect();
+			break;
+		}
+	}
+
+	void RasterCaptureWindow(Raster* surface, const FrameCaptureReader& capture, int window, ImUint cmd_count, float scale)
+	{
+		const FrameCaptureWindow& info = capture.GetWindow(window).Info;
+		surface->Resize((int)(info.Rect.z * scale + 0.5f), (int)(info.Rect.w * scale + 0.5f));
+		surface->SetScale(scale);
+		for (ImUint i = 0; i < cmd_count && i < info.CmdCount; i++)
+			RasterCaptureCommand(surface, capture, window, i);
+	}
+
+	// the windows and the tooltip of the capture over what frame holds already
+	static void ComposeCapture(Raster* frame, Raster* surface, const FrameCaptureReader& capture, int until_window, ImUint until_cmd, float scale)
+	{
+		frame->SetScale(scale);
+		for (int i = 0; i < capture.GetWindowCount(); i++)
+		{
+			const FrameCaptureWindow& info = capture.GetWindow(i).Info;
+			if (info.Flags & FrameCaptureWindow_Hidden)
+				continue;
+
+			RasterCaptureWindow(surface, capture, i, (i == until_window) ? until_cmd + 1 : info.CmdCount, scale);
+			frame->Compose(*surface, ImFloat2(info.Rect.x * scale, info.Rect.y * scale), info.Alpha);
+			if (i == until_window)
+				return;
+		}
+
+		if (capture.GetToolTip()[0])
+		{
+			const FrameCaptureHeader& header = capture.GetHeader();
+			frame->FillRoundedRect(header.ToolTipRect, 5, 5, header.ToolTipBgColor);
+			frame->DrawText(capture.GetToolTip(), header.ToolTipRect, 1, header.ToolTipTextColor, header.FontSize);
+		}
+	}
+
+	void RasterCaptureFrame(Raster* frame, Raster* surface, const FrameCaptureReader& capture, const ImFloat4& bg, int until_window, ImUint until_cmd, float scale)
+	{
+		const ImFloat2 size = capture.GetFrameSize();
+		frame->Resize((int)(size.x * scale + 0.5f), (int)(size.y * scale + 0.5f));
+		frame->Clear(bg);
+		ComposeCapture(frame, surface, capture, until_window, until_cmd, scale);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// OffscreenRenderer
+
+	OffscreenRenderer::OffscreenRenderer()
+		: _data(NULL)
+		, _size(0)
+		, _capacity(0)
+	{
+	}
+
+	OffscreenRenderer::~OffscreenRenderer()
+	{
+		MemFree(_data);
+	}
+
+	// called from ImDui::Render(), the capture is kept until the next frame
+	void OffscreenRenderer::OnCapture(const void* data, size_t size, void* user_data)
+	{
+		OffscreenRenderer* self = (OffscreenRenderer*)user_data;
+		if (size > self->_capacity)
+		{
+			MemFree(self->_data);
+			self->_capacity = size + size / 2;
+			self->_data = (char*)MemAlloc(self->_capacity, AllocCategory_Images);
+		}
+		memcpy(self->_data, data, size);
+		self->_size = size;
+	}
+
+	bool OffscreenRenderer::Capture()
+	{
+		_size = 0;
+		CaptureFrame(OnCapture, this);
+		ImDui::Render();
+		return _size != 0 && _capture.Read(_data, _size) == NULL;
+	}
+
+	bool OffscreenRenderer::Render(int width, int height, float scale, const ImFloat4& clear_color)
+	{
+		if (!Capture())
+			return false;
+		_frame.Resize(width, height);
+		_frame.Clear(clear_color);
+		ComposeCapture(&_frame, &_surface, _capture, -1, 0, scale);
+		return true;
+	}
+
+	void OffscreenRenderer::Draw(unsigned char* pixels, int width, int height, float scale, const ImFloat4& clear_color)
+	{
+		_frame.Attach(pixels, width, height);
+		_frame.Clear(clear_color);
+		ComposeCapture(&_frame, &_surface, _capture, -1, 0, scale);
+	}
+}
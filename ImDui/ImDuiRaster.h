@@ -0,0 +1,239 @@
+// Name		: ImDui
+// File		: ImDuiRaster.h
+//
+// CPU rasterizer for the primitives ImDui draws: antialiased rects, rounded rects, ellipses,
+// polygons and lines with the stroke semantics of Direct2D, axis aligned clip rects, and text
+// in a built-in 5x7 pixel font laid out with the advances of the null renderer. Pixels are
+// 32bpp premultiplied RGBA. It draws frame captures and offscreen frames without Direct2D, and
+// reads and writes PNG files.
+
+#ifndef __IMDUI_RASTER_H__
+#define __IMDUI_RASTER_H__
+
+#include "ImDui.h"
+
+namespace ImDui
+{
+	// receives the bytes of an encoded file in order, returns false to stop
+	typedef bool	(*WriteFunc)(const void* data, size_t size, void* user_data);
+
+	// zlib stream writer: one block of fixed Huffman codes from a greedy LZ77 over a 32 KB
+	// window, handed to func in pieces of at most 64 KB as it goes, in about 300 KB of memory
+	class Deflater
+	{
+	public:
+		Deflater(WriteFunc func, void* user_data);
+		~Deflater();
+
+		void	Write(const void* data, size_t size);
+		bool	End();		// false when func stopped
+
+	private:
+		enum
+		{
+			WINDOW		= 32768,
+			BUFFER		= WINDOW * 3,		// the window and the bytes not compressed yet
+			HASH_BITS	= 14,
+			MIN_MATCH	= 3,
+			MAX_MATCH	= 258,
+			OUT_CHUNK	= 65536,
+		};
+
+		Deflater(const Deflater&);
+		Deflater& operator=(const Deflater&);
+
+		void	PutByte(unsigned char byte);
+		void	PutBits(ImUint bits, int count);
+		void	PutCode(ImUint code, int length);		// Huffman codes are stored from their top bit
+		void	PutLiteral(int symbol);
+		void	PutMatch(int length, int distance);
+		void	Compress(bool final);
+
+		WriteFunc		_func;
+		void*			_userData;
+		bool			_ok;
+		unsigned char*	_window;
+		size_t			_windowBase;	// stream position of _window[0]
+		size_t			_windowEnd;
+		size_t			_pending;		// first byte of _window not compressed yet
+		size_t*			_head;			// stream position + 1 of the last 3 bytes of every hash
+		ImUint			_adler1;
+		ImUint			_adler2;
+		ImUint			_bits;
+		int				_bitCount;
+		unsigned char*	_out;
+		size_t			_outSize;
+	};
+
+	// a zlib stream of stored, fixed or dynamic Huffman blocks into out, which it must fill
+	bool	Inflate(const void* in, size_t in_size, void* out, size_t out_size);
+
+	class Raster
+	{
+	public:
+		Raster();
+		~Raster();
+
+		void	Resize(int width, int height);		// cleared to transparent, the clip stack is reset
+		void	Attach(unsigned char* pixels, int width, int height);	// draws into pixels of the caller, as they are, until the next Resize()
+		void	Clear(const ImFloat4& color);
+		int		GetWidth() const { return _width; }
+		int		GetHeight() const { return _height; }
+		unsigned char*			GetPixels() { return _pixels; }
+		const unsigned char*	GetPixels() const { return _pixels; }
+
+		// pixels per unit of the coordinates, sizes, strokes and font sizes given to the drawing
+		// functions below (default 1). Kept by Resize().
+		void	SetScale(float scale) { _scale = scale; }
+		float	GetScale() const { return _scale; }
+
+		// intersected with the current clip rect
+		void	PushClipRect(const ImFloat4& rect);
+		void	PopClipRect();
+
+		// colors are straight alpha, strokes are centered on the outline like Direct2D ones
+		void	FillRect(const ImFloat4& rect, const ImFloat4& color, bool aliased = false);
+		void	DrawRect(const ImFloat4& rect, const ImFloat4& color, float stroke);
+		void	FillRoundedRect(const ImFloat4& rect, float rx, float ry, const ImFloat4& color);
+		void	DrawRoundedRect(const ImFloat4& rect, float rx, float ry, const ImFloat4& color, float stroke);
+		void	FillEllipse(const ImFloat2& center, const ImFloat2& radius, const ImFloat4& color);
+		void	DrawEllipse(const ImFloat2& center, const ImFloat2& radius, const ImFloat4& color, float stroke);
+		void	FillPolygon(const ImFloat2* points, int count, const ImFloat4& color);
+		void	DrawPolyline(const ImFloat2* points, int count, const ImFloat4& color, float stroke, bool closed);
+		void	DrawLine(const ImFloat2& p0, const ImFloat2& p1, const ImFloat4& color, float stroke);
+
+		// align: 0 left, 1 center, 2 right. Lines are centered vertically in rect, not wrapped.
+		void	DrawText(const char* text, const ImFloat4& rect, int align, const ImFloat4& color, float font_size);
+
+		// src-over of another raster at pos, in pixels, its pixels multiplied by alpha
+		void	Compose(const Raster& src, const ImFloat2& pos, float alpha);
+
+		// Straight alpha RGBA. Encoded as it goes: every row is filtered and deflated into IDAT
+		// chunks of at most 64 KB handed to func, in about 300 KB of memory whatever the size of
+		// the image.
+		bool	WritePNG(WriteFunc func, void* user_data) const;
+		bool	WritePNG(const char* path) const;
+
+		// 8 bit gray, gray + alpha, RGB or RGBA, not interlaced. Resizes the raster.
+		bool	ReadPNG(const char* path);
+
+	private:
+		struct Edge
+		{
+			float	X0, Y0, X1, Y1;
+		};
+
+		Raster(const Raster&);
+		Raster& operator=(const Raster&);
+
+		void	FillPath(const ImFloat2* points, const int* contour_sizes, int contours, const ImFloat4& color);
+		void	BlendSpan(int y, int x0, int x1, const float* coverage, const ImFloat4& color);
+		void	Reserve(void** buffer, int* capacity, int count, size_t item_size);
+
+		int				_width;
+		int				_height;
+		float			_scale;
+		unsigned char*	_pixels;
+		bool			_attached;			// _pixels belong to the caller
+		ImFloat4		_clip;				// x0, y0, x1, y1
+		ImFloat4*		_clipStack;
+		int				_clipDepth;
+		int				_clipCapacity;
+
+		// scratch of FillPath()
+		Edge*			_edges;
+		int				_edgeCapacity;
+		float*			_crossings;
+		int				_crossingCapacity;
+		float*			_coverage;
+	};
+
+	// A frame capture (see FrameCaptureHeader) read in place: the bytes must outlive the reader.
+	class FrameCaptureReader
+	{
+	public:
+		struct WindowData
+		{
+			FrameCaptureWindow		Info;
+			const FrameCaptureCmd*	Cmds;
+			const ImFloat2*			Points;
+			const char*				Text;
+		};
+
+		FrameCaptureReader();
+		~FrameCaptureReader();
+
+		// checks everything the commands point to, returns NULL or what is wrong with data
+		const char*		Read(const void* data, size_t size);
+
+		const FrameCaptureHeader&	GetHeader() const { return _header; }
+		int							GetWindowCount() const { return _windowCount; }
+		const WindowData&			GetWindow(int index) const { return _windows[index]; }
+		int							FindWindow(const char* name) const;		// -1 when there is none
+		const char*					GetBgImage() const { return _bgImage; }
+		const char*					GetToolTip() const { return _toolTip; }
+
+		// of the render target, or with the null renderer of the windows and the tooltip
+		ImFloat2		GetFrameSize() const;
+
+	private:
+		FrameCaptureReader(const FrameCaptureReader&);
+		FrameCaptureReader& operator=(const FrameCaptureReader&);
+
+		FrameCaptureHeader	_header;
+		WindowData*			_windows;
+		int					_windowCount;
+		const char*			_bgImage;
+		const char*			_toolTip;
+	};
+
+	// Draws one command of a window the way D2DRender::Execute() does. Images, image views and
+	// heatmaps are gray placeholders, their pixels are not captured.
+	void	RasterCaptureCommand(Raster* surface, const FrameCaptureReader& capture, int window, ImUint cmd);
+
+	// Resizes surface to the window, scale pixels per unit, and draws its first cmd_count commands.
+	void	RasterCaptureWindow(Raster* surface, const FrameCaptureReader& capture, int window, ImUint cmd_count, float scale = 1.0f);
+
+	// Draws the frame as ComposeFrame() does, into frame sized to GetFrameSize() * scale: bg, the
+	// windows back to front through surface, then the tooltip. With until_window >= 0 it stops
+	// after command until_cmd of that window.
+	void	RasterCaptureFrame(Raster* frame, Raster* surface, const FrameCaptureReader& capture, const ImFloat4& bg,
+				int until_window = -1, ImUint until_cmd = 0, float scale = 1.0f);
+
+	// Offscreen rendering: draws the frames of the current context into memory with the
+	// rasterizer, without a window or a GPU (build with IMDUI_NULL_RENDER). Build a frame from
+	// NewFrame() on as usual, then call Render() instead of ImDui::Render(). Contexts render
+	// concurrently on their own threads; keep a renderer per thread, its buffers are reused.
+	class OffscreenRenderer
+	{
+	public:
+		OffscreenRenderer();
+		~OffscreenRenderer();
+
+		// ImDui::Render() of the current context, drawn into a width x height image with scale
+		// pixels per unit. Returns false when the frame could not be captured.
+		bool			Render(int width, int height, float scale, const ImFloat4& clear_color);
+		const Raster&	GetImage() const { return _frame; }
+
+		// the two halves of Render(): ImDui::Render() captured, then the capture drawn into
+		// pixels of the caller, width * 4 bytes a row
+		bool			Capture();
+		void			Draw(unsigned char* pixels, int width, int height, float scale, const ImFloat4& clear_color);
+		const FrameCaptureReader&	GetCapture() const { return _capture; }
+
+	private:
+		OffscreenRenderer(const OffscreenRenderer&);
+		OffscreenRenderer& operator=(const OffscreenRenderer&);
+
+		static void		OnCapture(const void* data, size_t size, void* user_data);
+
+		Raster				_frame;
+		Raster				_surface;
+		FrameCaptureReader	_capture;
+		char*				_data;
+		size_t				_size;
+		size_t				_capacity;
+	};
+}
+
+#endif //__IMDUI_RASTER_H__
@@ -0,0 +1,534 @@
+#include "ImDuiRemote.h"
+#include <algorithm>
+#include <new>
+#include <string.h>
+
+namespace ImDui
+{
+	//-----------------------------------------------------------------------------
+	// RemoteBuffer, RemoteWindowList
+	//-----------------------------------------------------------------------------
+
+	RemoteBuffer::~RemoteBuffer()
+	{
+		MemFree(Data);
+	}
+
+	void RemoteBuffer::Resize(size_t size)
+	{
+		if (size > Capacity)
+		{
+			const size_t capacity = size + size / 2 + 64;
+			unsigned char* data = (unsigned char*)MemAlloc(capacity, AllocCategory_DrawLists);
+			if (Size)
+				memcpy(data, Data, Size);
+			MemFree(Data);
+			Data = data;
+			Capacity = capacity;
+		}
+		Size = size;
+	}
+
+	void RemoteBuffer::Append(const void* data, size_t size)
+	{
+		const size_t pos = Size;
+		Resize(Size + size);
+		memcpy(Data + pos, data, size);
+	}
+
+	void RemoteBuffer::Swap(RemoteBuffer& other)
+	{
+		std::swap(Data, other.Data);
+		std::swap(Size, other.Size);
+		std::swap(Capacity, other.Capacity);
+	}
+
+	RemoteWindowList::~RemoteWindowList()
+	{
+		for (int i = 0; i < _capacity; i++)
+			_windows[i].~Window();
+		MemFree(_windows);
+	}
+
+	void RemoteWindowList::Reset(int count)
+	{
+		if (count > _capacity)
+		{
+			// the buffers are swapped into the new windows, the others start empty
+			const int capacity = count + count / 2;
+			Window* windows = (Window*)MemAlloc(capacity * sizeof(Window), AllocCategory_DrawLists);
+			for (int i = 0; i < capacity; i++)
+				new (&windows[i]) Window();
+			for (int i = 0; i < _capacity; i++)
+			{
+				memcpy(windows[i].Name, _windows[i].Name, sizeof(windows[i].Name));
+				windows[i].Content.Swap(_windows[i].Content);
+				_windows[i].~Window();
+			}
+			MemFree(_windows);
+			_windows = windows;
+			_capacity = capacity;
+		}
+		_count = count;
+	}
+
+	RemoteBuffer* RemoteWindowList::Set(int index, const char* name)
+	{
+		Window& window = _windows[index];
+		strncpy(window.Name, name, sizeof(window.Name) - 1);
+		window.Name[sizeof(window.Name) - 1] = '\0';
+		window.Content.Clear();
+		return &window.Content;
+	}
+
+	int RemoteWindowList::Find(const char* name) const
+	{
+		for (int i = 0; i < _count; i++)
+			if (strcmp(_windows[i].Name, name) == 0)
+				return i;
+		return -1;
+	}
+
+	void RemoteWindowList::Swap(RemoteWindowList* other)
+	{
+		Window* windows = _windows;
+		const int count = _count, capacity = _capacity;
+		_windows = other->_windows;
+		_count = other->_count;
+		_capacity = other->_capacity;
+		other->_windows = windows;
+		other->_count = count;
+		other->_capacity = capacity;
+	}
+
+	// the commands of a window without their times, its points and text: what the viewer holds
+	static void GetWindowContent(const FrameCaptureReader::WindowData& window, RemoteBuffer* content)
+	{
+		const size_t cmd_bytes = (size_t)window.Info.CmdCount * sizeof(FrameCaptureCmd);
+		content->Append(window.Cmds, cmd_bytes);
+		for (ImUint i = 0; i < window.Info.CmdCount; i++)
+			((FrameCaptureCmd*)content->Data)[i].Time = 0.0f;
+		content->Append(window.Points, (size_t)window.Info.PointCount * sizeof(ImFloat2));
+		content->Append(window.Text, window.Info.TextBytes);
+	}
+
+	static void XorBytes(unsigned char* dst, const unsigned char* src, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+			dst[i] ^= src[i];
+	}
+
+	static bool SendRemoteMessage(Socket* socket, ImUint type, const void* data, size_t size)
+	{
+		RemoteMessageHeader header;
+		header.Type = type;
+		header.Size = (ImUint)size;
+		return socket->Send(&header, sizeof(header)) && socket->Send(data, size);
+	}
+
+	static bool SendHello(Socket* socket)
+	{
+		RemoteHello hello;
+		hello.Magic = REMOTE_MAGIC;
+		hello.Version = REMOTE_VERSION;
+		return SendRemoteMessage(socket, RemoteMessage_Hello, &hello, sizeof(hello));
+	}
+
+	static bool IsHello(const RemoteBuffer& message)
+	{
+		RemoteHello hello;
+		if (message.Size != sizeof(hello))
+			return false;
+		memcpy(&hello, message.Data, sizeof(hello));
+		return hello.Magic == REMOTE_MAGIC && hello.Version == REMOTE_VERSION;
+	}
+
+	// the next message into message, false when the peer is gone or sent one too large
+	static bool ReceiveRemoteMessage(Socket* socket, ImUint* type, RemoteBuffer* message)
+	{
+		RemoteMessageHeader header = {};
+		if (!socket->Receive(&header, sizeof(header)) || header.Size > REMOTE_MAX_MESSAGE)
+			return false;
+		message->Resize(header.Size);
+		if (header.Size != 0 && !socket->Receive(message->Data, header.Size))
+		{
+			// cut short, the peer is gone: nothing of it is used
+			message->Clear();
+			return false;
+		}
+		*type = header.Type;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	// RemoteServer
+	//-----------------------------------------------------------------------------
+
+	RemoteServer::RemoteServer()
+		: _helloReceived(false)
+		, _frame(0)
+	{
+		memset(&_stats, 0, sizeof(_stats));
+	}
+
+	RemoteServer::~RemoteServer()
+	{
+		Close();
+	}
+
+	bool RemoteServer::Listen(const char* address)
+	{
+		Close();
+		return _listener.Listen(address);
+	}
+
+	void RemoteServer::Close()
+	{
+		Disconnect();
+		_listener.Close();
+	}
+
+	void RemoteServer::Disconnect()
+	{
+		_viewer.Close();
+		_helloReceived = false;
+		_sent.Clear();
+		_stats.Connected = false;
+	}
+
+	bool RemoteServer::ReceiveMessage()
+	{
+		ImUint type;
+		if (!ReceiveRemoteMessage(&_viewer, &type, &_message))
+			return false;
+		if (type == RemoteMessage_Hello)
+			return _helloReceived = IsHello(_message);
+		if (type != RemoteMessage_Input || !_helloReceived || _message.Size % sizeof(RemoteInputEvent) != 0)
+			return false;
+
+		// a viewer sending an unknown event or key is dropped before any of its events is queued
+		const int key_count = (int)(sizeof(Event::KeysDown) / sizeof(Event::KeysDown[0]));
+		for (size_t pos = 0; pos < _message.Size; pos += sizeof(RemoteInputEvent))
+		{
+			RemoteInputEvent e;
+			memcpy(&e, _message.Data + pos, sizeof(e));
+			if (e.Type > RemoteInput_Key || (e.Type == RemoteInput_Key && (e.Value < 0 || e.Value >= key_count)))
+				return false;
+		}
+
+		for (size_t pos = 0; pos < _message.Size; pos += sizeof(RemoteInputEvent))
+		{
+			RemoteInputEvent e;
+			memcpy(&e, _message.Data + pos, sizeof(e));
+			switch (e.Type)
+			{
+			case RemoteInput_MouseMove:		AddMouseMoveEvent(e.X, e.Y); break;
+			case RemoteInput_MouseButton:	AddMouseButtonEvent(e.X, e.Y, e.Value != 0); break;
+			case RemoteInput_MouseWheel:	AddMouseWheelEvent(e.Value); break;
+			case RemoteInput_Key:			AddKeyEvent(e.Value, e.Down != 0); break;
+			default:						return false;
+			}
+			_stats.InputEvents++;
+		}
+		return true;
+	}
+
+	void RemoteServer::PollInput()
+	{
+		// the last viewer to connect wins, it starts from a whole frame
+		if (_listener.IsOpen() && _listener.WaitReadable(0))
+		{
+			Disconnect();
+			if (_listener.Accept(&_viewer, 0) && SendHello(&_viewer))
+				_stats.Connected = true;
+			else
+				Disconnect();
+		}
+
+		while (_viewer.IsOpen() && _viewer.WaitReadable(0))
+		{
+			if (!ReceiveMessage())
+				Disconnect();
+		}
+	}
+
+	void RemoteServer::OnCapture(const void* data, size_t size, void* user_data)
+	{
+		RemoteServer* self = (RemoteServer*)user_data;
+		self->_capture.Clear();
+		self->_capture.Append(data, size);
+	}
+
+	bool RemoteServer::OnDeflate(const void* data, size_t size, void* user_data)
+	{
+		((RemoteServer*)user_data)->_message.Append(data, size);
+		return true;
+	}
+
+	void RemoteServer::Render()
+	{
+		if (!_viewer.IsOpen() || !_helloReceived)
+		{
+			ImDui::Render();
+			return;
+		}
+
+		_capture.Clear();
+		CaptureFrame(OnCapture, this);
+		ImDui::Render();
+
+		FrameCaptureReader capture;
+		if (_capture.Size == 0 || capture.Read(_capture.Data, _capture.Size) != NULL)
+			return;
+		// the viewer is behind: this frame is dropped, the next is a delta of the last one sent
+		if (!_viewer.IsWritable())
+		{
+			_stats.FramesSkipped++;
+			return;
+		}
+		if (!SendFrame(capture))
+		{
+			Disconnect();
+			return;
+		}
+		_stats.Frames++;
+		_stats.CaptureBytes += _capture.Size;
+	}
+
+	bool RemoteServer::SendFrame(const FrameCaptureReader& capture)
+	{
+		_raw.Clear();
+		FrameCaptureHeader header = capture.GetHeader();
+		header.BuildTime = 0.0f;
+		header.DrawTime = 0.0f;
+		_raw.Append(&header, sizeof(header));
+
+		_next.Reset(capture.GetWindowCount());
+		for (int i = 0; i < capture.GetWindowCount(); i++)
+		{
+			const FrameCaptureReader::WindowData& window = capture.GetWindow(i);
+			RemoteBuffer* content = _next.Set(i, window.Info.Name);
+			GetWindowContent(window, content);
+
+			FrameCaptureWindow info = window.Info;
+			info.DrawTime = 0.0f;
+			_raw.Append(&info, sizeof(info));
+
+			const int sent = _sent.Find(info.Name);
+			const RemoteBuffer* previous = (sent >= 0) ? &_sent.GetContent(sent) : NULL;
+			ImUint mode = RemoteWindow_Whole;
+			if (previous != NULL && previous->Size == content->Size)
+				mode = (memcmp(previous->Data, content->Data, content->Size) == 0) ? RemoteWindow_Same : RemoteWindow_Xor;
+			_raw.Append(&mode, sizeof(mode));
+			if (mode == RemoteWindow_Same)
+				continue;
+			const size_t pos = _raw.Size;
+			_raw.Append(content->Data, content->Size);
+			if (mode == RemoteWindow_Xor)
+				XorBytes(_raw.Data + pos, previous->Data, content->Size);
+		}
+		const char* bg_image = capture.GetBgImage();
+		const char* tooltip = capture.GetToolTip();
+		_raw.Append(bg_image, strlen(bg_image) + 1);
+		_raw.Append(tooltip, strlen(tooltip) + 1);
+
+		// the size is known once the frame is deflated, written over the header then
+		RemoteMessageHeader message_header = {};
+		message_header.Type = RemoteMessage_Frame;
+		RemoteFrameHeader frame_header = {};
+		frame_header.Frame = ++_frame;
+		frame_header.RawSize = (ImUint)_raw.Size;
+		_message.Clear();
+		_message.Append(&message_header, sizeof(message_header));
+		_message.Append(&frame_header, sizeof(frame_header));
+		Deflater deflater(OnDeflate, this);
+		deflater.Write(_raw.Data, _raw.Size);
+		deflater.End();
+
+		message_header.Size = (ImUint)(_message.Size - sizeof(message_header));
+		memcpy(_message.Data, &message_header, sizeof(message_header));
+		if (!_viewer.Send(_message.Data, _message.Size))
+			return false;
+		_stats.BytesSent += _message.Size;
+		_sent.Swap(&_next);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	// RemoteViewer
+	//-----------------------------------------------------------------------------
+
+	RemoteViewer::RemoteViewer()
+		: _helloReceived(false)
+		, _frame(0)
+		, _frameBytes(0)
+	{
+	}
+
+	RemoteViewer::~RemoteViewer()
+	{
+		Close();
+	}
+
+	bool RemoteViewer::Connect(const char* address)
+	{
+		Close();
+		if (_socket.Connect(address) && SendHello(&_socket))
+			return true;
+		Close();
+		return false;
+	}
+
+	void RemoteViewer::Close()
+	{
+		_socket.Close();
+		_helloReceived = false;
+		_received.Clear();
+	}
+
+	bool RemoteViewer::ReadFrame(const unsigned char* raw, size_t size)
+	{
+		const unsigned char* pos = raw;
+		const unsigned char* end = raw + size;
+		FrameCaptureHeader header;
+		if (size < sizeof(header))
+			return false;
+		memcpy(&header, pos, sizeof(header));
+		pos += sizeof(header);
+		if (header.WindowCount > (size_t)(end - pos) / (sizeof(FrameCaptureWindow) + sizeof(ImUint)))
+			return false;
+
+		_capture.Clear();
+		_capture.Append(&header, sizeof(header));
+		_next.Reset((int)header.WindowCount);
+		for (ImUint i = 0; i < header.WindowCount; i++)
+		{
+			FrameCaptureWindow info;
+			ImUint mode;
+			if ((size_t)(end - pos) < sizeof(info) + sizeof(mode))
+				return false;
+			memcpy(&info, pos, sizeof(info));
+			memcpy(&mode, pos + sizeof(info), sizeof(mode));
+			pos += sizeof(info) + sizeof(mode);
+			info.Name[sizeof(info.Name) - 1] = '\0';
+			if (info.CmdCount > REMOTE_MAX_MESSAGE || info.PointCount > REMOTE_MAX_MESSAGE || info.TextBytes > REMOTE_MAX_MESSAGE)
+				return false;
+			const size_t content_size = (size_t)info.CmdCount * sizeof(FrameCaptureCmd) + (size_t)info.PointCount * sizeof(ImFloat2) + info.TextBytes;
+
+			RemoteBuffer* content = _next.Set((int)i, info.Name);
+			const int received = _received.Find(info.Name);
+			const RemoteBuffer* previous = (received >= 0) ? &_received.GetContent(received) : NULL;
+			if (mode != RemoteWindow_Whole && (previous == NULL || previous->Size != content_size))
+				return false;
+			if (mode == RemoteWindow_Same)
+				content->Append(previous->Data, content_size);
+			else if (mode == RemoteWindow_Xor || mode == RemoteWindow_Whole)
+			{
+				if ((size_t)(end - pos) < content_size)
+					return false;
+				content->Append(pos, content_size);
+				pos += content_size;
+				if (mode == RemoteWindow_Xor)
+					XorBytes(content->Data, previous->Data, content_size);
+			}
+			else
+				return false;
+
+			_capture.Append(&info, sizeof(info));
+			_capture.Append(content->Data, content->Size);
+		}
+		// the background image and the tooltip
+		_capture.Append(pos, end - pos);
+
+		if (_reader.Read(_capture.Data, _capture.Size) != NULL)
+			return false;
+		_received.Swap(&_next);
+		return true;
+	}
+
+	bool RemoteViewer::ReadMessage(bool* frame)
+	{
+		ImUint type;
+		*frame = false;
+		if (!ReceiveRemoteMessage(&_socket, &type, &_message))
+			return false;
+		if (type == RemoteMessage_Hello)
+			return _helloReceived = IsHello(_message);
+		if (type != RemoteMessage_Frame || !_helloReceived || _message.Size < sizeof(RemoteFrameHeader))
+			return false;
+
+		RemoteFrameHeader header;
+		memcpy(&header, _message.Data, sizeof(header));
+		if (header.RawSize == 0 || header.RawSize > REMOTE_MAX_MESSAGE)
+			return false;
+		_raw.Resize(header.RawSize);
+		if (!Inflate(_message.Data + sizeof(header), _message.Size - sizeof(header), _raw.Data, _raw.Size) || !ReadFrame(_raw.Data, _raw.Size))
+			return false;
+		_frame = header.Frame;
+		_frameBytes = sizeof(RemoteMessageHeader) + _message.Size;
+		*frame = true;
+		return true;
+	}
+
+	bool RemoteViewer::ReceiveFrame(int timeout_ms)
+	{
+		const long long end = GetTicks() + (long long)timeout_ms * GetTickFrequency() / 1000;
+		while (_socket.IsOpen())
+		{
+			int wait = -1;
+			if (timeout_ms >= 0)
+			{
+				const long long left = end - GetTicks();
+				wait = (left > 0) ? (int)(left * 1000 / GetTickFrequency()) : 0;
+			}
+			if (!_socket.WaitReadable(wait))
+				return false;
+
+			bool frame;
+			if (!ReadMessage(&frame))
+			{
+				// gone or malformed, the capture was half rebuilt
+				Close();
+				_reader.Read(NULL, 0);
+				return false;
+			}
+			if (frame)
+				return true;
+		}
+		return false;
+	}
+
+	bool RemoteViewer::SendInput(ImUint type, float x, float y, int value, int down)
+	{
+		RemoteInputEvent e;
+		e.Type = type;
+		e.X = x;
+		e.Y = y;
+		e.Value = value;
+		e.Down = down;
+		if (_socket.IsOpen() && SendRemoteMessage(&_socket, RemoteMessage_Input, &e, sizeof(e)))
+			return true;
+		Close();
+		return false;
+	}
+
+	bool RemoteViewer::SendMouseMove(float x, float y)
+	{
+		return SendInput(RemoteInput_MouseMove, x, y, 0, 0);
+	}
+
+	bool RemoteViewer::SendMouseButton(float x, float y, bool down)
+	{
+		return SendInput(RemoteInput_MouseButton, x, y, down ? 1 : 0, down ? 1 : 0);
+	}
+
+	bool RemoteViewer::SendMouseWheel(int delta)
+	{
+		return SendInput(RemoteInput_MouseWheel, 0.0f, 0.0f, delta, 0);
+	}
+
+	bool RemoteViewer::SendKey(int key, bool down)
+	{
+		return SendInput(RemoteInput_Key, 0.0f, 0.0f, key, down ? 1 : 0);
+	}
+}
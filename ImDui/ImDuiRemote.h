@@ -0,0 +1,225 @@
+// Name		: ImDui
+// File		: ImDuiRemote.h
+//
+// Remote UI: a RemoteServer streams the frames of a context to one viewer over a TCP or Unix
+// socket, and queues the input the viewer sends back into the context. Frames go out as their
+// draw commands (the frame capture of FrameCaptureHeader), each window either unchanged, XORed
+// with what the viewer holds of it or whole, and deflated: an unchanged window costs its
+// FrameCaptureWindow, a moving slider little more. The RemoteViewer rebuilds the captures, to
+// be drawn with RasterCaptureFrame() of ImDuiRaster.h.
+
+#ifndef __IMDUI_REMOTE_H__
+#define __IMDUI_REMOTE_H__
+
+#include "ImDuiRaster.h"
+#include "ImDuiPlatform.h"
+
+namespace ImDui
+{
+	// Every message is a RemoteMessageHeader then Size bytes. Both sides start with a Hello.
+	// A Frame is a RemoteFrameHeader then a zlib stream of RawSize bytes: the FrameCaptureHeader,
+	// for every window its FrameCaptureWindow, an ImUint RemoteWindowMode and unless unchanged
+	// its commands, points and text, then the background image path and the tooltip. Times are
+	// not sent. Input is RemoteInputEvent records. In the byte order of the hosts, as the frame
+	// captures: both ends must share it, the Hello of the other byte order is refused.
+	enum
+	{
+		REMOTE_MAGIC		= 0x52444D49,	// "IMDR"
+		REMOTE_VERSION		= 2,
+		REMOTE_MAX_MESSAGE	= 64 << 20,
+	};
+
+	enum RemoteMessageType
+	{
+		RemoteMessage_Hello,
+		RemoteMessage_Frame,
+		RemoteMessage_Input,
+	};
+
+	enum RemoteWindowMode
+	{
+		RemoteWindow_Same,			// as in the previous frame, by name
+		RemoteWindow_Xor,			// XORed with the previous frame, of the same size
+		RemoteWindow_Whole,
+	};
+
+	enum RemoteInputType
+	{
+		RemoteInput_MouseMove,
+		RemoteInput_MouseButton,	// Value 1 down, 0 up
+		RemoteInput_MouseWheel,		// Value the delta
+		RemoteInput_Key,			// Value the virtual key, Down
+	};
+
+	struct RemoteMessageHeader
+	{
+		ImUint		Type;			// RemoteMessageType
+		ImUint		Size;
+	};
+
+	struct RemoteHello
+	{
+		ImUint		Magic;
+		ImUint		Version;
+	};
+
+	struct RemoteFrameHeader
+	{
+		ImUint		Frame;
+		ImUint		RawSize;
+	};
+
+	struct RemoteInputEvent
+	{
+		ImUint		Type;			// RemoteInputType
+		float		X;
+		float		Y;
+		int			Value;
+		int			Down;
+	};
+
+	struct RemoteStats
+	{
+		int			Frames;			// sent
+		int			FramesSkipped;	// while the viewer could not take them
+		size_t		BytesSent;		// on the wire, frames and their headers
+		size_t		CaptureBytes;	// the frame captures the frames were made of
+		int			InputEvents;	// received
+		bool		Connected;
+	};
+
+	// growable bytes of the remote streams
+	struct RemoteBuffer
+	{
+		unsigned char*	Data;
+		size_t			Size;
+		size_t			Capacity;
+
+		RemoteBuffer() : Data(NULL), Size(0), Capacity(0) {}
+		~RemoteBuffer();
+		void	Resize(size_t size);		// keeps the bytes up to size
+		void	Append(const void* data, size_t size);
+		void	Swap(RemoteBuffer& other);
+		void	Clear() { Size = 0; }
+
+	private:
+		RemoteBuffer(const RemoteBuffer&);
+		RemoteBuffer& operator=(const RemoteBuffer&);
+	};
+
+	// the windows of the last frame sent or received, by name, that the next one is a delta of
+	class RemoteWindowList
+	{
+	public:
+		RemoteWindowList() : _windows(NULL), _count(0), _capacity(0) {}
+		~RemoteWindowList();
+
+		void					Reset(int count);		// count windows to Set(), their buffers reused
+		RemoteBuffer*			Set(int index, const char* name);		// the emptied content of window index
+		int						Find(const char* name) const;			// -1 when there is none
+		const RemoteBuffer&		GetContent(int index) const { return _windows[index].Content; }
+		void					Swap(RemoteWindowList* other);
+		void					Clear() { _count = 0; }
+
+	private:
+		struct Window
+		{
+			char			Name[64];
+			RemoteBuffer	Content;
+
+			Window() { Name[0] = '\0'; }
+		};
+
+		RemoteWindowList(const RemoteWindowList&);
+		RemoteWindowList& operator=(const RemoteWindowList&);
+
+		Window*		_windows;
+		int			_count;
+		int			_capacity;
+	};
+
+	class RemoteServer
+	{
+	public:
+		RemoteServer();
+		~RemoteServer();
+
+		bool		Listen(const char* address);		// see Socket
+		void		Close();
+
+		// before NewFrame(): takes a viewer that connects, in place of the one before, and
+		// queues the input it sent into the current context
+		void		PollInput();
+
+		// ImDui::Render() of the current context, sent to the viewer as a delta from the last
+		// frame it got. A viewer that cannot take it yet misses it.
+		void		Render();
+		RemoteStats	GetStats() const { return _stats; }
+
+	private:
+		RemoteServer(const RemoteServer&);
+		RemoteServer& operator=(const RemoteServer&);
+
+		static void	OnCapture(const void* data, size_t size, void* user_data);
+		static bool	OnDeflate(const void* data, size_t size, void* user_data);
+		bool		ReceiveMessage();
+		bool		SendFrame(const FrameCaptureReader& capture);
+		void		Disconnect();
+
+		Socket				_listener;
+		Socket				_viewer;
+		bool				_helloReceived;
+		RemoteBuffer		_capture;
+		RemoteBuffer		_raw;
+		RemoteBuffer		_message;
+		RemoteWindowList	_sent;
+		RemoteWindowList	_next;
+		ImUint				_frame;
+		RemoteStats			_stats;
+	};
+
+	class RemoteViewer
+	{
+	public:
+		RemoteViewer();
+		~RemoteViewer();
+
+		bool		Connect(const char* address);		// see Socket
+		void		Close();
+		bool		IsConnected() const { return _socket.IsOpen(); }
+
+		// Waits up to timeout_ms (-1 for ever) for the next frame and rebuilds its capture.
+		// False on timeout, or when the connection closed or sent a malformed frame.
+		bool		ReceiveFrame(int timeout_ms);
+		const FrameCaptureReader&	GetCapture() const { return _reader; }
+		ImUint		GetFrame() const { return _frame; }
+		size_t		GetFrameBytes() const { return _frameBytes; }	// on the wire, of the last frame
+
+		// input for the context of the server, queued there as it arrives
+		bool		SendMouseMove(float x, float y);
+		bool		SendMouseButton(float x, float y, bool down);
+		bool		SendMouseWheel(int delta);
+		bool		SendKey(int key, bool down);
+
+	private:
+		RemoteViewer(const RemoteViewer&);
+		RemoteViewer& operator=(const RemoteViewer&);
+
+		bool		SendInput(ImUint type, float x, float y, int value, int down);
+		bool		ReadMessage(bool* frame);
+		bool		ReadFrame(const unsigned char* raw, size_t size);
+
+		Socket				_socket;
+		RemoteBuffer		_message;
+		RemoteBuffer		_raw;
+		RemoteBuffer		_capture;
+		RemoteWindowList	_received;
+		RemoteWindowList	_next;
+		FrameCaptureReader	_reader;
+		bool				_helloReceived;
+		ImUint				_frame;
+		size_t				_frameBytes;
+	};
+}
+
+#endif //__IMDUI_REMOTE_H__
@@ -0,0 +1,315 @@
+#include "ImDuiShm.h"
+#include <math.h>
+#include <stddef.h>
+
+namespace ImDui
+{
+	static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "the shared frames header needs lock free atomics");
+
+	static const size_t	PAGE_SIZE = 4096;
+
+	static size_t AlignPage(size_t size)
+	{
+		return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	}
+
+	static bool RectsOverlap(const ImFloat4& a, const ImFloat4& b)
+	{
+		return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+	}
+
+	static ImFloat4 RectsUnion(const ImFloat4& a, const ImFloat4& b)
+	{
+		const float x0 = fminf(a.x, b.x), y0 = fminf(a.y, b.y);
+		return ImFloat4(x0, y0, fmaxf(a.x + a.z, b.x + b.z) - x0, fmaxf(a.y + a.w, b.y + b.w) - y0);
+	}
+
+	// Adds rt, in units, as whole pixels plus the antialiased edge clipped to the frame, merged
+	// with the rects it overlaps.
+	static void AddDirtyRect(ImFloat4* rects, int* count, const ImFloat4& rt, float scale, const SharedFramesHeader& header)
+	{
+		const float x0 = fmaxf(0.0f, floorf(rt.x * scale) - 1.0f);
+		const float y0 = fmaxf(0.0f, floorf(rt.y * scale) - 1.0f);
+		const float x1 = fminf((float)header.Width, ceilf((rt.x + rt.z) * scale) + 1.0f);
+		const float y1 = fminf((float)header.Height, ceilf((rt.y + rt.w) * scale) + 1.0f);
+		if (x1 <= x0 || y1 <= y0)
+			return;
+
+		ImFloat4 dirty(x0, y0, x1 - x0, y1 - y0);
+		for (int i = 0; i < *count;)
+		{
+			if (RectsOverlap(rects[i], dirty))
+			{
+				dirty = RectsUnion(rects[i], dirty);
+				rects[i] = rects[--*count];
+				i = 0;
+			}
+			else
+			{
+				i++;
+			}
+		}
+		rects[(*count)++] = dirty;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// SharedFrameWriter
+
+	SharedFrameWriter::SharedFrameWriter()
+		: _header(NULL)
+		, _frameId(0)
+		, _scale(0.0f)
+		, _clearColor(-1.0f, -1.0f, -1.0f, -1.0f)
+		, _windows(NULL)
+		, _windowCount(0)
+		, _toolTipHash(0)
+	{
+	}
+
+	SharedFrameWriter::~SharedFrameWriter()
+	{
+		Close();
+		MemFree(_windows);
+	}
+
+	bool SharedFrameWriter::Create(const char* name, int width, int height, int slot_count)
+	{
+		Close();
+		if (width <= 0 || height <= 0 || slot_count < 2 || slot_count > SHARED_FRAMES_MAX_SLOTS)
+			return false;
+
+		const size_t pitch = (size_t)width * 4;
+		const size_t slot_size = AlignPage(pitch * height);
+		const size_t pixels_offset = AlignPage(sizeof(SharedFramesHeader));
+		if (!_memory.Create(name, pixels_offset + slot_size * slot_count))
+			return false;
+
+		// the memory comes zero filled, the atomics with it
+		_header = (SharedFramesHeader*)_memory.GetData();
+		_header->Magic = SHARED_FRAMES_MAGIC;
+		_header->Version = SHARED_FRAMES_VERSION;
+		_header->Width = (ImUint)width;
+		_header->Height = (ImUint)height;
+		_header->Pitch = (ImUint)pitch;
+		_header->SlotCount = (ImUint)slot_count;
+		_header->SlotSize = (ImUint)slot_size;
+		_header->PixelsOffset = (ImUint)pixels_offset;
+		_frameId = 0;
+		_scale = 0.0f;
+		_windowCount = 0;
+		_toolTipHash = 0;
+		return true;
+	}
+
+	void SharedFrameWriter::Close()
+	{
+		if (_header != NULL)
+			_header->Closed.store(1);
+		_header = NULL;
+		_memory.Close();
+	}
+
+	// A slot other than the latest one and the one the reader holds. The reader sets its fence
+	// then checks the frame of the slot, the writer clears the frame then checks the fence: one
+	// of them sees the other.
+	int SharedFrameWriter::FindFreeSlot()
+	{
+		const ImUint latest = _header->LatestSlot.load();
+		for (ImUint i = 1; i <= _header->SlotCount; i++)
+		{
+			const ImUint index = (latest + i) % _header->SlotCount;
+			SharedFrameSlot& slot = _header->Slots[index];
+			if (index == latest && _frameId != 0)
+				continue;
+
+			const unsigned long long held = slot.FrameId.exchange(0);
+			if (held != 0 && _header->ReaderFence.load() == held)
+			{
+				slot.FrameId.store(held);
+				continue;
+			}
+			return (int)index;
+		}
+		return -1;
+	}
+
+	int SharedFrameWriter::FindDirtyRects(float scale, ImFloat4* rects)
+	{
+		const FrameCaptureReader& capture = _renderer.GetCapture();
+		const ImUint tooltip = capture.GetToolTip()[0] ? HashBytes(capture.GetToolTip(), strlen(capture.GetToolTip()), HashBytes(&capture.GetHeader().ToolTipRect, sizeof(ImFloat4))) : 0;
+
+		// the windows of this frame, back to front, their commands hashed without their times
+		const int count = capture.GetWindowCount();
+		WindowState* windows = (WindowState*)MemAlloc((count ? count : 1) * sizeof(WindowState), AllocCategory_Images);
+		for (int i = 0; i < count; i++)
+		{
+			const FrameCaptureReader::WindowData& data = capture.GetWindow(i);
+			WindowState& window = windows[i];
+			memcpy(window.Name, data.Info.Name, sizeof(window.Name));
+			window.Rect = data.Info.Rect;
+			window.Alpha = data.Info.Alpha;
+			window.Hash = 0;
+			if (data.Info.Flags & FrameCaptureWindow_Hidden)
+				continue;
+			ImUint hash = 2166136261u;
+			for (ImUint j = 0; j < data.Info.CmdCount; j++)
+				hash = HashBytes(&data.Cmds[j], offsetof(FrameCaptureCmd, Time), hash);
+			hash = HashBytes(data.Points, data.Info.PointCount * sizeof(ImFloat2), hash);
+			window.Hash = HashBytes(data.Text, data.Info.TextBytes, hash) | 1;
+		}
+
+		// windows that appeared, disappeared, moved, were restacked, faded or redrawn
+		int dirty = 0;
+		bool full = _frameId == 0 || scale != _scale;
+		int last = 0;
+		for (int i = 0; i < count && !full; i++)
+		{
+			int j = 0;
+			while (j < _windowCount && strcmp(_windows[j].Name, windows[i].Name) != 0)
+				j++;
+			if (j == _windowCount)
+			{
+				if (windows[i].Hash)
+					AddDirtyRect(rects, &dirty, windows[i].Rect, scale, *_header);
+				continue;
+			}
+
+			WindowState& prev = _windows[j];
+			const bool moved = memcmp(&prev.Rect, &windows[i].Rect, sizeof(ImFloat4)) != 0 || j < last || prev.Alpha != windows[i].Alpha;
+			if (prev.Hash && (moved || windows[i].Hash == 0))
+				AddDirtyRect(rects, &dirty, prev.Rect, scale, *_header);
+			if (windows[i].Hash && (moved || prev.Hash != windows[i].Hash))
+				AddDirtyRect(rects, &dirty, windows[i].Rect, scale, *_header);
+			last = (j > last) ? j : last;
+			prev.Name[0] = '\0';
+			full = dirty > SHARED_FRAMES_MAX_DIRTY - 2;
+		}
+		for (int j = 0; j < _windowCount && !full; j++)
+		{
+			if (_windows[j].Name[0] && _windows[j].Hash)
+				AddDirtyRect(rects, &dirty, _windows[j].Rect, scale, *_header);
+			full = dirty > SHARED_FRAMES_MAX_DIRTY - 2;
+		}
+		if (tooltip != _toolTipHash && !full)
+		{
+			if (_toolTipHash)
+				AddDirtyRect(rects, &dirty, _toolTipRect, scale, *_header);
+			if (tooltip)
+				AddDirtyRect(rects, &dirty, capture.GetHeader().ToolTipRect, scale, *_header);
+		}
+
+		MemFree(_windows);
+		_windows = windows;
+		_windowCount = count;
+		_toolTipHash = tooltip;
+		_toolTipRect = capture.GetHeader().ToolTipRect;
+		return full ? -1 : dirty;
+	}
+
+	SharedFrameResult SharedFrameWriter::Render(float scale, const ImFloat4& clear_color)
+	{
+		if (_header == NULL || !_renderer.Capture())
+			return SharedFrame_Failed;
+
+		ImFloat4 rects[SHARED_FRAMES_MAX_DIRTY];
+		int dirty = FindDirtyRects(scale, rects);
+		if (memcmp(&clear_color, &_clearColor, sizeof(ImFloat4)) != 0)
+			dirty = -1;
+		if (dirty == 0)
+			return SharedFrame_Unchanged;
+
+		// drawn straight into the slot. A dropped frame makes the next one whole, its rects are
+		// not those of the last published frame.
+		const int index = FindFreeSlot();
+		_clearColor = clear_color;
+		_scale = (index < 0) ? 0.0f : scale;
+		if (index < 0)
+			return SharedFrame_NoFreeSlot;
+
+		SharedFrameSlot& slot = _header->Slots[index];
+		_renderer.Draw((unsigned char*)_memory.GetData() + _header->PixelsOffset + (size_t)index * _header->SlotSize, (int)_header->Width, (int)_header->Height, scale, clear_color);
+		slot.Time = GetTicks();
+		slot.DirtyCount = (dirty < 0) ? 0 : (ImUint)dirty;
+		memcpy(slot.DirtyRects, rects, sizeof(ImFloat4) * slot.DirtyCount);
+		slot.FrameId.store(++_frameId, std::memory_order_release);
+		_header->LatestSlot.store((ImUint)index, std::memory_order_release);
+		_header->LatestFrame.store(_frameId, std::memory_order_release);
+		return SharedFrame_Published;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// SharedFrameReader
+
+	SharedFrameReader::SharedFrameReader()
+		: _header(NULL)
+	{
+	}
+
+	SharedFrameReader::~SharedFrameReader()
+	{
+		Close();
+	}
+
+	bool SharedFrameReader::Open(const char* name)
+	{
+		Close();
+		if (!_memory.Open(name) || _memory.GetSize() < sizeof(SharedFramesHeader))
+			return false;
+
+		const SharedFramesHeader* header = (const SharedFramesHeader*)_memory.GetData();
+		if (header->Magic != SHARED_FRAMES_MAGIC || header->Version != SHARED_FRAMES_VERSION ||
+			header->SlotCount > SHARED_FRAMES_MAX_SLOTS || header->Pitch < header->Width * 4 ||
+			header->SlotSize < (size_t)header->Pitch * header->Height ||
+			_memory.GetSize() < header->PixelsOffset + (size_t)header->SlotSize * header->SlotCount)
+		{
+			_memory.Close();
+			return false;
+		}
+		_header = (SharedFramesHeader*)_memory.GetData();
+		return true;
+	}
+
+	void SharedFrameReader::Close()
+	{
+		Release();
+		_header = NULL;
+		_memory.Close();
+	}
+
+	bool SharedFrameReader::Acquire(unsigned long long last_frame, SharedFrame* frame)
+	{
+		if (_header == NULL)
+			return false;
+
+		// the writer may publish again meanwhile, then the slot no longer holds the frame
+		for (int attempt = 0; attempt < 4; attempt++)
+		{
+			const unsigned long long id = _header->LatestFrame.load(std::memory_order_acquire);
+			const ImUint index = _header->LatestSlot.load(std::memory_order_acquire);
+			if (id == 0 || id <= last_frame || index >= _header->SlotCount)
+				break;
+
+			_header->ReaderFence.store(id);
+			const SharedFrameSlot& slot = _header->Slots[index];
+			if (slot.FrameId.load() != id)
+			{
+				_header->ReaderFence.store(0);
+				continue;
+			}
+
+			frame->Pixels = (const unsigned char*)_memory.GetData() + _header->PixelsOffset + (size_t)index * _header->SlotSize;
+			frame->FrameId = id;
+			frame->Time = slot.Time;
+			frame->DirtyCount = (id == last_frame + 1 && slot.DirtyCount <= SHARED_FRAMES_MAX_DIRTY) ? (int)slot.DirtyCount : 0;
+			memcpy(frame->DirtyRects, slot.DirtyRects, sizeof(ImFloat4) * frame->DirtyCount);
+			return true;
+		}
+		return false;
+	}
+
+	void SharedFrameReader::Release()
+	{
+		if (_header != NULL)
+			_header->ReaderFence.store(0);
+	}
+}
@@ -0,0 +1,145 @@
+// Name		: ImDui
+// File		: ImDuiShm.h
+//
+// Shared memory frame output: a context renders its frames with the offscreen renderer of
+// ImDuiRaster.h straight into a ring of frame buffers in named shared memory, and another
+// process, a video compositor for instance, maps them and reads the pixels in place. The frames
+// are handed over through the atomics of SharedFramesHeader, without locks or system calls: the
+// writer never writes the slot of the latest frame nor the one the reader holds, so with three
+// slots or more it always has one free.
+
+#ifndef __IMDUI_SHM_H__
+#define __IMDUI_SHM_H__
+
+#include "ImDuiRaster.h"
+#include "ImDuiPlatform.h"
+#include <atomic>
+
+namespace ImDui
+{
+	// The mapping holds a SharedFramesHeader, then at PixelsOffset SlotCount frame buffers of
+	// SlotSize bytes, page aligned: Height rows of Pitch bytes of premultiplied RGBA.
+	enum
+	{
+		SHARED_FRAMES_MAGIC		= 0x46534449,	// "IDSF"
+		SHARED_FRAMES_VERSION	= 1,
+		SHARED_FRAMES_MAX_SLOTS	= 8,
+		SHARED_FRAMES_MAX_DIRTY	= 8,
+	};
+
+	struct SharedFrameSlot
+	{
+		std::atomic<unsigned long long>	FrameId;	// of the frame it holds, 0 while it is written
+		long long		Time;			// GetTicks() when published, the same clock in every process
+		ImUint			DirtyCount;		// 0 when the whole frame changed
+		ImUint			Pad;
+		ImFloat4		DirtyRects[SHARED_FRAMES_MAX_DIRTY];	// pixels that changed since frame FrameId - 1, x y w h
+	};
+
+	struct SharedFramesHeader
+	{
+		ImUint			Magic;
+		ImUint			Version;
+		ImUint			Width;
+		ImUint			Height;
+		ImUint			Pitch;
+		ImUint			SlotCount;
+		ImUint			SlotSize;
+		ImUint			PixelsOffset;
+
+		// published frames are numbered from 1, LatestSlot is written before LatestFrame
+		std::atomic<unsigned long long>	LatestFrame;
+		std::atomic<ImUint>				LatestSlot;
+		std::atomic<ImUint>				Closed;			// the writer is gone
+		std::atomic<unsigned long long>	ReaderFence;	// frame held by the reader, 0 when none
+		SharedFrameSlot					Slots[SHARED_FRAMES_MAX_SLOTS];
+	};
+
+	enum SharedFrameResult
+	{
+		SharedFrame_Published,
+		SharedFrame_Unchanged,		// nothing to draw, the latest frame stays
+		SharedFrame_NoFreeSlot,		// two slots and the reader holds the older frame: dropped
+		SharedFrame_Failed,
+	};
+
+	// the writer side, in the process building the UI
+	class SharedFrameWriter
+	{
+	public:
+		SharedFrameWriter();
+		~SharedFrameWriter();
+
+		bool				Create(const char* name, int width, int height, int slot_count = 3);
+		void				Close();		// tells the reader, and removes the name
+
+		// ImDui::Render() of the current context, drawn into a free slot with scale pixels per
+		// unit and published with the rects that changed since the last published frame.
+		SharedFrameResult	Render(float scale, const ImFloat4& clear_color);
+		unsigned long long	GetFrameId() const { return _frameId; }		// of the last published frame
+
+	private:
+		struct WindowState
+		{
+			char		Name[64];
+			ImFloat4	Rect;
+			float		Alpha;
+			ImUint		Hash;		// of the commands, points and text, 0 when hidden
+		};
+
+		SharedFrameWriter(const SharedFrameWriter&);
+		SharedFrameWriter& operator=(const SharedFrameWriter&);
+
+		int		FindFreeSlot();
+		int		FindDirtyRects(float scale, ImFloat4* rects);		// -1 when everything changed
+
+		SharedMemory		_memory;
+		SharedFramesHeader*	_header;
+		OffscreenRenderer	_renderer;
+		unsigned long long	_frameId;
+		float				_scale;			// of the last published frame
+		ImFloat4			_clearColor;
+		WindowState*		_windows;		// of the last published frame
+		int					_windowCount;
+		ImFloat4			_toolTipRect;
+		ImUint				_toolTipHash;
+	};
+
+	struct SharedFrame
+	{
+		const unsigned char*	Pixels;
+		unsigned long long		FrameId;
+		long long				Time;
+		int						DirtyCount;		// 0 when the whole frame is to be read again
+		ImFloat4				DirtyRects[SHARED_FRAMES_MAX_DIRTY];
+	};
+
+	// the reader side, in the compositor: one reader per shared memory
+	class SharedFrameReader
+	{
+	public:
+		SharedFrameReader();
+		~SharedFrameReader();
+
+		bool	Open(const char* name);
+		void	Close();
+
+		// The latest frame when it is newer than last_frame (0 = any), held until Release() or
+		// the next Acquire() that finds a newer one: its slot is not written meanwhile. Dirty
+		// rects are given when the frame follows last_frame.
+		bool	Acquire(unsigned long long last_frame, SharedFrame* frame);
+		void	Release();
+
+		const SharedFramesHeader*	GetHeader() const { return _header; }
+		bool						IsClosed() const { return _header == NULL || _header->Closed.load() != 0; }
+
+	private:
+		SharedFrameReader(const SharedFrameReader&);
+		SharedFrameReader& operator=(const SharedFrameReader&);
+
+		SharedMemory		_memory;
+		SharedFramesHeader*	_header;
+	};
+}
+
+#endif //__IMDUI_SHM_H__
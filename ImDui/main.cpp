@@ -1,4 +1,4 @@
-#include "ImDui.h"
+#include "ImDuiDemo.h"
 
 // Data
 static ID2D1Factory*			g_pD2DFactory		= NULL;		// D2D
@@ -6,6 +6,39 @@ static IDWriteFactory*			g_pDWriteFactory	= NULL;		// DWrite
 static IWICImagingFactory*		g_pWICFactory		= NULL;		// WIC
 static ID2D1HwndRenderTarget*	g_pMainRT			= NULL;		// 
 
+// Pipelined rendering: the render thread draws and presents frame N while the UI thread builds frame N+1
+static bool						g_pipelined			= false;
+static std::thread				g_renderThread;
+static std::atomic<bool>		g_renderQuit(false);
+static std::atomic<UINT>		g_resizeRequest(0);		// (width << 16) | height, applied by the thread drawing
+
+// Dirty rectangles: only the changed regions of the main render target are composed again
+static bool						g_dirtyRects		= false;
+static std::atomic<bool>		g_dirtyRectsApplied(false);	// read by the thread drawing
+
+// Extra delay per frame, to check that clicks and double clicks survive low frame rates
+static int						g_frameDelay		= 0;
+
+// Heap allocations made by each thread, counted by the operator new below. Once warmed up, a
+// frame that shows no new widget, label or image must not allocate, neither to build nor to render.
+static thread_local size_t		t_allocations		= 0;
+static size_t					g_buildAllocs		= 0;	// last frame
+static std::atomic<size_t>		g_renderAllocs(0);			// last frame, written by the thread drawing
+static int						g_allocFrames		= 0;	// frames that allocated since the last reset
+
+void* operator new(size_t size)
+{
+	t_allocations++;
+	if (void* ptr = malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
 template<class Interface>
 inline void SafeRelease(Interface **ppInterfaceToRelease)
 {
@@ -22,7 +55,8 @@ HRESULT CreateDeviceIndependentResources()
 	HRESULT hr;
 	ID2D1GeometrySink *pSink = NULL;
 
-	hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &g_pD2DFactory);
+	// the render thread draws with resources of this factory while the UI thread creates others
+	hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, &g_pD2DFactory);
 
 	if (SUCCEEDED(hr))
 		hr = DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(g_pDWriteFactory), reinterpret_cast<IUnknown **>(&g_pDWriteFactory));
@@ -44,7 +78,8 @@ HRESULT CreateDeviceResources(HWND hWnd)
 		RECT rc;
 		GetClientRect(hWnd, &rc);
 		D2D1_SIZE_U size = D2D1::SizeU(	rc.right - rc.left,	rc.bottom - rc.top);
-		hr = g_pD2DFactory->CreateHwndRenderTarget(D2D1::RenderTargetProperties(), D2D1::HwndRenderTargetProperties(hWnd, size), &g_pMainRT);
+		hr = g_pD2DFactory->CreateHwndRenderTarget(D2D1::RenderTargetProperties(),
+			D2D1::HwndRenderTargetProperties(hWnd, size, D2D1_PRESENT_OPTIONS_RETAIN_CONTENTS), &g_pMainRT);
 	}
 
 	return hr;
@@ -62,24 +97,32 @@ void DestroyResources()
 
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
-	ImDui::Event& events = ImDui::GetEvents();
 	switch (msg)
 	{
 	case WM_LBUTTONDOWN:
-		events.MouseDown = true;
+		ImDui::AddMouseButtonEvent((signed short)(lParam), (signed short)(lParam >> 16), true);
 		return true;
 	case WM_LBUTTONUP:
-		events.MouseDown = false;
+		ImDui::AddMouseButtonEvent((signed short)(lParam), (signed short)(lParam >> 16), false);
 		return true;
 	case WM_MOUSEWHEEL:
-		events.MouseWheel = GET_WHEEL_DELTA_WPARAM(wParam) > 0 ? +1 : -1;
+		ImDui::AddMouseWheelEvent(GET_WHEEL_DELTA_WPARAM(wParam) > 0 ? +1 : -1);
 		return true;
 	case WM_MOUSEMOVE:
-		events.MousePos.x = (signed short)(lParam);
-		events.MousePos.y = (signed short)(lParam >> 16);
+		ImDui::AddMouseMoveEvent((signed short)(lParam), (signed short)(lParam >> 16));
 		return true;
+	case WM_KEYDOWN:
+	case WM_SYSKEYDOWN:
+		if (wParam < 256)
+			ImDui::AddKeyEvent((int)wParam, true);
+		break;
+	case WM_KEYUP:
+	case WM_SYSKEYUP:
+		if (wParam < 256)
+			ImDui::AddKeyEvent((int)wParam, false);
+		break;
 	case WM_SIZE:
-		g_pMainRT->Resize(D2D1::SizeU(LOWORD(lParam), HIWORD(lParam)));
+		g_resizeRequest = (UINT)((LOWORD(lParam) << 16) | HIWORD(lParam));
 		break;
 	case WM_DESTROY:
 		PostQuitMessage(0);
@@ -88,82 +131,550 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-void ShowWindowOptions(bool* open)
-{
-	static char* options_en[11] = 
-	{
-		"Window Options",
-		"I can eat glass and it doesn't hurt me.",
-		"Help",
-		"1.Double-click on title bar to collapse window.\n2.Click and drag on lower right corner to resize window.\n3.Click and drag on any empty space to move window.",
-		"Window options",
-		"no titlebar",
-		"no border",
-		"no resize",
-		"no move",
-		"English",
-		"fill alpha"
-	};
-
-	static char* options_cn[11] = 
-	{
-		"ѡ",
-		"²塣",
-		"",
-		"1.˫۵ڡ\n2.½϶ɵڴС\n3.϶ƶڡ",
-		"ѡ",
-		"ޱ",
-		"ޱ߿",
-		"ɵС",
-		"ƶ",
-		"",
-		"͸"
-	};
-
-	static bool no_titlebar = false;
-	static bool no_border = true;
-	static bool no_resize = false;
-	static bool no_move = false;
-	static bool cn = true;
-	static float fill_alpha = 1.f;
-
-	const unsigned int layout_flags = 
-		(no_titlebar ? ImDuiWindowFlags_NoTitleBar : 0) | 
-		(no_border ? 0 : ImDuiWindowFlags_ShowBorders) |
-		(no_resize ? ImDuiWindowFlags_NoResize : 0) | 
-		(no_move ? ImDuiWindowFlags_NoMove : 0);
-	ImDui::BeginWindow(cn ? options_cn[0] : options_en[0], open, ImFloat2(20, 20 + 200 + 20), ImFloat2(400, 300), fill_alpha, layout_flags);
-	ImDui::Text(cn ? options_cn[1] : options_en[1]);
-	ImDui::Spacing();
-
-	if (ImDui::Collapse(cn ? options_cn[2] : options_en[2]))
-	{
-		ImDui::Text(cn ? options_cn[3] : options_en[3]);
-	}
-
-	if (ImDui::Collapse(cn ? options_cn[4] : options_en[4]))
-	{
-		ImDui::CheckBox(cn ? options_cn[5] : options_en[5], &no_titlebar); ImDui::SameLine(100);
-		ImDui::CheckBox(cn ? options_cn[6] : options_en[6], &no_border); 
-		ImDui::CheckBox(cn ? options_cn[7] : options_en[7], &no_resize);ImDui::SameLine(100);
-		ImDui::CheckBox(cn ? options_cn[8] : options_en[8], &no_move); ImDui::SameLine(200);
-		ImDui::CheckBox(cn ? options_cn[9] : options_en[9], &cn);
-		ImDui::SliderFloat(cn ? options_cn[10] : options_en[10], &fill_alpha, 0.0f, 1.0f);
+// Builds 60 text heavy windows in a private context with 1/2/4/8/16 worker threads
+// and reports the average frame build time (ms) for each thread count.
+static const int	sc_benchThreads[5]	= { 1, 2, 4, 8, 16 };
+static float		s_benchParallel[5]	= { 0 };
+
+void BuildHeavyWindow(int index)
+{
+	for (int i = 0; i < 40; i++)
+		ImDui::Text("window %d, item %d: %.3f", index, i, index * 0.25f + i * 0.001f);
+
+	static float values[60] = { 0 };
+	ImDui::SliderFloat("value", &values[index], 0.0f, 1.0f);
+}
+
+void RunParallelBuildBenchmark()
+{
+	ImDui::Context* prev_ctx = ImDui::GetCurrentContext();
+	ImDui::Context* bench_ctx = ImDui::CreateContext();
+	ImDui::SetCurrentContext(bench_ctx);
+	ImDui::InitResources(g_pD2DFactory, g_pDWriteFactory, g_pWICFactory, g_pMainRT);
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+
+	const int frames = 10;
+	for (int t = 0; t < 5; t++)
+	{
+		LARGE_INTEGER begin, end;
+		QueryPerformanceCounter(&begin);
+		for (int frame = 0; frame < frames; frame++)
+		{
+			ImDui::NewFrame();
+			ImDui::BeginParallelWindows();
+			for (int i = 0; i < 60; i++)
+			{
+				char name[32];
+				sprintf(name, "bench %d", i);
+				ImDui::ParallelWindow(name, NULL, [i]() { BuildHeavyWindow(i); }, ImFloat2((float)(i % 10) * 20, (float)(i / 10) * 20), ImFloat2(300, 600));
+			}
+			ImDui::EndParallelWindows(sc_benchThreads[t]);
+		}
+		QueryPerformanceCounter(&end);
+		s_benchParallel[t] = (end.QuadPart - begin.QuadPart) * 1000.0f / freq.QuadPart / frames;
+	}
+
+	ImDui::DestroyContext(bench_ctx);
+	ImDui::SetCurrentContext(prev_ctx);
+}
+
+void ShowHeavyPanel(bool* open)
+{
+	ImDui::BeginWindow("Heavy Panel", open, ImFloat2(60, 60), ImFloat2(300, 400));
+	for (int i = 0; i < 300; i++)
+		ImDui::Text("row %d: %.4f", i, i * 0.0123f);
+	ImDui::EndWindow();
+}
+
+static bool		s_showLatency		= false;
+
+// Shows 200 thumbnails of distinct sizes, every one a separate decode, and records the frame
+// times until all of them are ready: p99 and max frame time and the total load time (ms),
+// with synchronous and asynchronous decoding.
+static bool					s_showThumbnails	= false;
+static bool					s_asyncImages		= true;
+static std::vector<float>	s_thumbFrameTimes;
+static double				s_thumbStart		= 0.0;
+static double				s_thumbLastFrame	= 0.0;
+static float				s_benchImages[2][3]	= { 0 };	// [sync, async][p99, max, total]
+
+void StartThumbnailBenchmark()
+{
+	ImDui::ReleaseImages();
+	ImDui::SetImageLoading(s_asyncImages);
+	s_thumbFrameTimes.clear();
+	s_thumbStart = s_thumbLastFrame = ImDui::GetTime();
+	s_showThumbnails = true;
+}
+
+void ShowThumbnails(bool* open)
+{
+	ImDui::BeginWindow("Thumbnails", open, ImFloat2(20, 240), ImFloat2(800, 340));
+	for (int i = 0; i < 200; i++)
+	{
+		if (i % 20 != 0)
+			ImDui::SameLine();
+		ImDui::Image("iceland.jpg", ImFloat2(24.0f + i % 20, 16.0f + i / 20));
+	}
+	ImDui::EndWindow();
+
+	if (s_thumbStart == 0.0)
+		return;
+
+	const double now = ImDui::GetTime();
+	s_thumbFrameTimes.push_back((float)(now - s_thumbLastFrame) * 1000.0f);
+	s_thumbLastFrame = now;
+
+	// 200 thumbnails + the background image
+	const ImDui::ImageLoadStats stats = ImDui::GetImageLoadStats();
+	if (stats.Pending == 0 && stats.Decoded == 0 && stats.Ready + stats.Failed >= 201)
+	{
+		std::vector<float> times = s_thumbFrameTimes;
+		std::sort(times.begin(), times.end());
+		float* result = s_benchImages[s_asyncImages ? 1 : 0];
+		result[0] = times[(times.size() - 1) * 99 / 100];
+		result[1] = times.back();
+		result[2] = (float)(now - s_thumbStart) * 1000.0f;
+		s_thumbStart = 0.0;
 	}
+}
 
+void ShowLatencyWindow(bool* open)
+{
+	ImDui::BeginWindow("Input Latency", open, ImFloat2(630, 20), ImFloat2(340, 140));
+	ImDui::ShowLatencyStats();
 	ImDui::EndWindow();
 }
 
-int main(int, char**)
+// Pans and zooms over iceland.jpg from 256x256 tiles; "ImDuiPack demo.idp -tiles iceland.jpg"
+// stores the pyramid ahead of time
+static bool			s_showImageViewer	= false;
+
+void ShowImageViewer(bool* open)
 {
+	ImDui::BeginWindow("Image Viewer", open, ImFloat2(200, 120), ImFloat2(520, 380));
+	ImDui::ImageViewer("iceland.jpg", ImFloat2(500, 330));
+	ImDui::EndWindow();
+}
+
+// A 4096x4096 density field, a brush circling over it adds to a 64x64 block every frame and
+// only that block is reported to the heatmap
+static bool			s_showHeatmap		= false;
+
+void ShowHeatmap(bool* open)
+{
+	const int size = 4096, brush = 64;
+	static std::vector<float> field;
+	static int colormap = ImDui::Colormap_Viridis;
+	static float t = 0.0f;
+	const bool first = field.empty();
+	if (first)
+		field.resize(size * size, 0.0f);
+
+	t += 0.02f;
+	const int bx = (int)((0.5f + 0.4f * cosf(t)) * (size - brush));
+	const int by = (int)((0.5f + 0.4f * sinf(t * 1.3f)) * (size - brush));
+	for (int y = 0; y < brush; y++)
+	{
+		for (int x = 0; x < brush; x++)
+		{
+			const float dx = (x - brush * 0.5f) / brush, dy = (y - brush * 0.5f) / brush;
+			float& v = field[(by + y) * size + bx + x];
+			v = std::min(1.0f, v + 0.05f * expf(-(dx * dx + dy * dy) * 16.0f));
+		}
+	}
+	const ImDui::HeatmapRegion region = { bx, by, brush, brush };
+
+	ImDui::BeginWindow("Heatmap", open, ImFloat2(240, 80), ImFloat2(540, 620));
+	ImDui::SliderInt("colormap", &colormap, 0, ImDui::Colormap_COUNT - 1);
+	ImDui::Heatmap("density", field.data(), size, size, size, 0.0f, 1.0f, ImFloat2(512, 512),
+		(ImDui::HeatmapColormap)colormap, &region, first ? -1 : 1);
+	ImDui::EndWindow();
+}
+
+// 10000 widgets in a window showing about 30 of them. Widgets outside the window clip rect
+// skip text measurement and drawing; unchecking "cull" pushes an unbounded clip rect so that
+// every widget is built and left to Direct2D to clip, for comparison.
+static bool			s_showCulling		= false;
+
+void ShowCulling(bool* open)
+{
+	const int count = 10000;
+	static bool checks[count / 4];
+	static float values[count / 4];
+	static bool cull = true;
+	static float build_ms = 0.0f;
+	static int visible = 0;
+	char label[32];
+
+	const double start = ImDui::GetTime();
+	ImDui::BeginWindow("Culling", open, ImFloat2(300, 60), ImFloat2(360, 640));
+	ImDui::CheckBox("cull", &cull);
+	ImDui::Text("build: %.2f ms, %d rows visible", build_ms, visible);
+
+	if (!cull)
+		ImDui::PushClipRect(ImFloat4(-1e6f, -1e6f, 2e6f, 2e6f), false);
+	int rows_visible = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (ImDui::IsRectVisible(ImFloat2(1, 1)))
+			rows_visible++;
+		switch (i % 4)
+		{
+		case 0:
+			ImDui::Text("Text %d", i);
+			break;
+		case 1:
+			sprintf(label, "Button %d", i);
+			ImDui::Button(label);
+			break;
+		case 2:
+			sprintf(label, "Check %d", i);
+			ImDui::CheckBox(label, &checks[i / 4]);
+			break;
+		case 3:
+			sprintf(label, "Slider %d", i);
+			ImDui::SliderFloat(label, &values[i / 4], 0.0f, 1.0f);
+			break;
+		}
+	}
+	if (!cull)
+		ImDui::PopClipRect();
+	ImDui::EndWindow();
+
+	build_ms = (float)(ImDui::GetTime() - start) * 1000.0f;
+	visible = rows_visible;
+}
+
+// Time to the first frame showing the demo images (ms), from the creation of a new context in
+// this running process, once decoding the files and once mapping demo.idp. WIC, the Direct2D
+// factories and the files in the system cache are warm already: not a cold start of the
+// application, which a new process measures. demo.idp is made with
+//   ImDuiPack demo.idp iceland.jpg:160x100 ../samples/sample1.png:160x100 ../samples/sample2.png:160x100
+static const char*	sc_firstFrameImages[3]	= { "iceland.jpg", "../samples/sample1.png", "../samples/sample2.png" };
+static float		s_benchFirstFrame[2]	= { 0 };	// [decode, pack], < 0 when there is no pack
+
+void RunWarmFirstFrameBenchmark()
+{
+	ImDui::Context* prev_ctx = ImDui::GetCurrentContext();
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+
+	for (int m = 0; m < 2; m++)
+	{
+		LARGE_INTEGER begin, end;
+		QueryPerformanceCounter(&begin);
+
+		ImDui::Context* bench_ctx = ImDui::CreateContext();
+		ImDui::SetCurrentContext(bench_ctx);
+		ImDui::InitResources(g_pD2DFactory, g_pDWriteFactory, g_pWICFactory, g_pMainRT);
+		ImDui::SetImageLoading(false);
+
+		if (m == 1 && !ImDui::LoadImagePack("demo.idp"))
+		{
+			s_benchFirstFrame[m] = -1.0f;
+			ImDui::DestroyContext(bench_ctx);
+			continue;
+		}
+
+		ImDui::NewFrame();
+		ImDui::BeginWindow("First Frame", NULL, ImFloat2(20, 240), ImFloat2(520, 140));
+		for (int i = 0; i < 3; i++)
+		{
+			if (i != 0)
+				ImDui::SameLine();
+			ImDui::Image(sc_firstFrameImages[i], ImFloat2(160, 100));
+		}
+		ImDui::EndWindow();
+
+		g_pMainRT->BeginDraw();
+		ImDui::Render();
+		g_pMainRT->EndDraw();
+
+		QueryPerformanceCounter(&end);
+		s_benchFirstFrame[m] = (end.QuadPart - begin.QuadPart) * 1000.0f / freq.QuadPart;
+
+		ImDui::DestroyContext(bench_ctx);
+	}
+
+	ImDui::SetCurrentContext(prev_ctx);
+}
+
+// A 3840x2160 BGRA image scaled to 1920x1080 and a 1920x1080 one scaled to 3840x2160 (ms), once
+// with the WIC scaler and format converter, once with ImDui::ResampleImage() per filter
+static float		s_benchResample[2][4]	= { 0 };	// [down, up][WIC, box, bilinear, lanczos3]
+
+static HRESULT ResampleWithWIC(BYTE* src, UINT src_w, UINT src_h, BYTE* dst, UINT dst_w, UINT dst_h)
+{
+	IWICBitmap* pBitmap = NULL;
+	IWICBitmapScaler* pScaler = NULL;
+	IWICFormatConverter* pConverter = NULL;
+
+	HRESULT hr = g_pWICFactory->CreateBitmapFromMemory(src_w, src_h, GUID_WICPixelFormat32bppBGRA, src_w * 4, src_w * src_h * 4, src, &pBitmap);
+	if (SUCCEEDED(hr))
+		hr = g_pWICFactory->CreateBitmapScaler(&pScaler);
+	if (SUCCEEDED(hr))
+		hr = pScaler->Initialize(pBitmap, dst_w, dst_h, WICBitmapInterpolationModeCubic);
+	if (SUCCEEDED(hr))
+		hr = g_pWICFactory->CreateFormatConverter(&pConverter);
+	if (SUCCEEDED(hr))
+		hr = pConverter->Initialize(pScaler, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, NULL, 0.f, WICBitmapPaletteTypeMedianCut);
+	if (SUCCEEDED(hr))
+		hr = pConverter->CopyPixels(NULL, dst_w * 4, dst_w * dst_h * 4, dst);
+
+	SafeRelease(&pConverter);
+	SafeRelease(&pScaler);
+	SafeRelease(&pBitmap);
+	return hr;
+}
+
+void RunResampleBenchmark()
+{
+	const UINT big_w = 3840, big_h = 2160;
+	std::vector<BYTE> source(big_w * big_h * 4);
+	std::vector<BYTE> output(big_w * big_h * 4);
+	for (UINT i = 0; i < big_w * big_h; i++)
+	{
+		const UINT x = i % big_w, y = i / big_w;
+		source[i * 4 + 0] = (BYTE)(x * 255 / big_w);
+		source[i * 4 + 1] = (BYTE)(y * 255 / big_h);
+		source[i * 4 + 2] = (BYTE)(((x / 8) ^ (y / 8)) & 1 ? 255 : 0);
+		source[i * 4 + 3] = (BYTE)(x < 256 ? x : 255);
+	}
+
+	LARGE_INTEGER freq, begin, end;
+	QueryPerformanceFrequency(&freq);
+
+	for (int d = 0; d < 2; d++)
+	{
+		const UINT src_w = d ? big_w / 2 : big_w, src_h = d ? big_h / 2 : big_h;
+		const UINT dst_w = d ? big_w : big_w / 2, dst_h = d ? big_h : big_h / 2;
+		for (int f = 0; f < 4; f++)
+		{
+			QueryPerformanceCounter(&begin);
+			if (f == ImDui::ImageFilter_WIC)
+				ResampleWithWIC(source.data(), src_w, src_h, output.data(), dst_w, dst_h);
+			else
+				ImDui::ResampleImage(source.data(), src_w, src_h, src_w * 4, 4, output.data(), dst_w, dst_h, dst_w * 4, (ImDui::ImageFilter)f);
+			QueryPerformanceCounter(&end);
+			s_benchResample[d][f] = (end.QuadPart - begin.QuadPart) * 1000.0f / freq.QuadPart;
+		}
+	}
+}
+
+void ShowBenchmarks(bool* open)
+{
+	ImDui::BeginWindow("Benchmarks", open, ImFloat2(20 + 400 + 20, 20), ImFloat2(180, 570));
+
+	if (ImDui::Collapse("Pipelined render", NULL, true, true))
+	{
+		static bool show_heavy_panel = false;
+		ImDui::CheckBox("render thread", &g_pipelined);
+		ImDui::CheckBox("heavy panel", &show_heavy_panel);
+		if (show_heavy_panel)
+			ShowHeavyPanel(&show_heavy_panel);
+
+		const ImDui::FrameStats stats = ImDui::GetFrameStats();
+		ImDui::Text("fps: %.1f", ImDui::GetFPS());
+		ImDui::Text("build: %.2f ms", stats.BuildTime);
+		ImDui::Text("render: %.2f ms", stats.RenderTime);
+		ImDui::Text("latency: %.2f ms", stats.Latency);
+		ImDui::Text("dropped: %d", stats.FramesDropped);
+		ImDui::Text("culled: %d", stats.WindowsCulled);
+
+		ImDui::CheckBox("dirty rects", &g_dirtyRects);
+		ImDui::Text("dirty: %d rects", stats.DirtyRects);
+		ImDui::Text("touched: %.1f%%", stats.PixelsTouched * 100.0f / (g_pMainRT->GetSize().width * g_pMainRT->GetSize().height));
+	}
+
+	if (ImDui::Collapse("Input"))
+	{
+		static int clicks = 0;
+		static int double_clicks = 0;
+		const ImDui::Event& events = ImDui::GetEvents();
+		clicks += events.MouseClicked ? 1 : 0;
+		double_clicks += events.MouseDoubleClicked ? 1 : 0;
+
+		ImDui::SliderInt("delay", &g_frameDelay, 0, 100, "%.0f ms");
+		ImDui::Text("clicks: %d", clicks);
+		ImDui::Text("double clicks: %d", double_clicks);
+		ImDui::Text("dt: %.2f ms", events.DeltaTime * 1000.0f);
+
+		ImDui::CheckBox("latency", &s_showLatency);
+	}
+
+	if (ImDui::Collapse("Images"))
+	{
+		ImDui::CheckBox("async decode", &s_asyncImages);
+		ImDui::CheckBox("image viewer", &s_showImageViewer);
+		ImDui::CheckBox("heatmap", &s_showHeatmap);
+		if (ImDui::Button("Load 200 thumbnails"))
+			StartThumbnailBenchmark();
+
+		static int budget_mb = 64;
+		if (ImDui::SliderInt("budget", &budget_mb, 1, 256, "%.0f MB"))
+			ImDui::SetImageCacheBudget((size_t)budget_mb * 1024 * 1024);
+
+		const ImDui::ImageLoadStats stats = ImDui::GetImageLoadStats();
+		const ImDui::ImageCacheStats cache = ImDui::GetImageCacheStats();
+		ImDui::Text("pending: %d", stats.Pending + stats.Decoded);
+		ImDui::Text("ready: %d", stats.Ready);
+		ImDui::Text("cache: %.1f MB", cache.Bytes / (1024.0f * 1024.0f));
+		ImDui::Text("evicted: %d", cache.Evicted);
+
+		// creates Direct2D resources and draws, which must not race with the render thread
+		if (ImDui::Button("First frame (warm)") && !g_renderThread.joinable())
+			RunWarmFirstFrameBenchmark();
+		ImDui::Text("decode: %.1f ms", s_benchFirstFrame[0]);
+		if (s_benchFirstFrame[1] < 0.0f)
+			ImDui::Text("pack: no demo.idp");
+		else
+			ImDui::Text("pack: %.1f ms", s_benchFirstFrame[1]);
+		static const char* filters[4] = { "WIC", "box", "bilinear", "lanczos3" };
+		static int filter = ImDui::ImageFilter_Lanczos3;
+		if (ImDui::SliderInt("filter", &filter, 0, 3))
+			ImDui::SetImageFilter((ImDui::ImageFilter)filter);
+		ImDui::Text("filter: %s", filters[filter]);
+		if (ImDui::Button("Resample 4K"))
+			RunResampleBenchmark();
+		for (int d = 0; d < 2; d++)
+		{
+			for (int f = 0; f < 4; f++)
+				ImDui::Text("%s %s: %.1f ms", d ? "up" : "down", filters[f], s_benchResample[d][f]);
+		}
+		for (int m = 0; m < 2; m++)
+		{
+			ImDui::Text("%s p99: %.1f ms", m ? "async" : "sync", s_benchImages[m][0]);
+			ImDui::Text("%s max: %.1f ms", m ? "async" : "sync", s_benchImages[m][1]);
+			ImDui::Text("%s total: %.0f ms", m ? "async" : "sync", s_benchImages[m][2]);
+		}
+	}
+
+	if (ImDui::Collapse("Culling"))
+		ImDui::CheckBox("10k widgets", &s_showCulling);
+
+	if (ImDui::Collapse("Allocations"))
+	{
+		// opening this section allocates, the frames after it must not
+		ImDui::Text("build: %d, render: %d", (int)g_buildAllocs, (int)g_renderAllocs.load());
+		ImDui::Text("frames allocating: %d", g_allocFrames);
+		if (ImDui::Button("Reset"))
+			g_allocFrames = 0;
+
+		// what ImDui holds, by category
+		static const char* categories[ImDui::AllocCategory_COUNT] = { "context", "windows", "storage", "draw lists", "images", "heatmaps", "scratch" };
+		const ImDui::AllocStats stats = ImDui::GetAllocStats();
+		for (int i = 0; i < ImDui::AllocCategory_COUNT; i++)
+			ImDui::Text("%s: %.1f KB", categories[i], stats.Bytes[i] / 1024.0f);
+		ImDui::Text("collected: %u ids, %u states, %u windows", (unsigned)stats.IdsCollected, (unsigned)stats.StatesCollected, (unsigned)stats.WindowsCollected);
+	}
+
+	if (ImDui::Collapse("Surfaces"))
+	{
+		static int budget_mb = 128;
+		if (ImDui::SliderInt("surface budget", &budget_mb, 0, 256, "%.0f MB"))
+			ImDui::SetSurfaceBudget((size_t)budget_mb * 1024 * 1024);
+
+		const ImDui::SurfaceStats stats = ImDui::GetSurfaceStats();
+		ImDui::Text("surfaces: %d, %.1f MB", stats.Surfaces, stats.Bytes / (1024.0f * 1024.0f));
+		ImDui::Text("created: %d", stats.Created);
+		ImDui::Text("released: %d", stats.Released);
+	}
+
+	if (ImDui::Collapse("Frame capture"))
+	{
+		// the next frame, with the time of every draw command, for ImDuiCapture
+		static int captures = 0;
+		if (ImDui::Button("Capture frame.idc"))
+		{
+			ImDui::CaptureFrame("frame.idc");
+			captures++;
+		}
+		ImDui::Text("captured: %d", captures);
+	}
+
+	if (ImDui::Collapse("Parallel build"))
+	{
+		// the benchmark creates Direct2D resources, which must not race with the render thread
+		if (ImDui::Button("Run") && !g_renderThread.joinable())
+			RunParallelBuildBenchmark();
+		for (int t = 0; t < 5; t++)
+			ImDui::Text("%2d threads: %.2f ms", sc_benchThreads[t], s_benchParallel[t]);
+	}
+
+	ImDui::EndWindow();
+}
+
+void RenderFrame(const ImFloat4& clear_color)
+{
+	const UINT size = g_resizeRequest.exchange(0);
+	if (size != 0)
+		g_pMainRT->Resize(D2D1::SizeU(size >> 16, size & 0xffff));
+
+	const size_t allocations = t_allocations;
+
+	// with dirty rectangles ImDui clears what it composes again
+	g_pMainRT->BeginDraw();
+	if (!g_dirtyRectsApplied)
+		g_pMainRT->Clear(clear_color.ToD2DColorF());
+
+	ImDui::Render();
+
+	g_pMainRT->EndDraw();
+	g_renderAllocs = t_allocations - allocations;
+}
+
+void RenderThreadMain(ImDui::Context* ctx, ImFloat4 clear_color)
+{
+	ImDui::SetCurrentContext(ctx);
+	// sleeps until the UI thread publishes a frame, and looks at g_renderQuit every 50 ms
+	while (!g_renderQuit)
+	{
+		if (ImDui::WaitForFrame(50))
+			RenderFrame(clear_color);
+	}
+}
+
+void SetRenderThread(bool enabled, const ImFloat4& clear_color)
+{
+	if (enabled == g_renderThread.joinable())
+		return;
+
+	if (enabled)
+	{
+		ImDui::SetPipelinedRendering(true);
+		g_renderQuit = false;
+		g_renderThread = std::thread(RenderThreadMain, ImDui::GetCurrentContext(), clear_color);
+	}
+	else
+	{
+		g_renderQuit = true;
+		g_renderThread.join();
+		ImDui::SetPipelinedRendering(false);
+	}
+}
+
+// ImDuiDemo -record <file> writes the input of the session to file, for ImDuiReplay. The
+// benchmarks are hidden, the session shows the demo windows only as the replay does.
+int main(int argc, char** argv)
+{
+	const char* record_path = (argc > 2 && strcmp(argv[1], "-record") == 0) ? argv[2] : NULL;
+
 	CreateDeviceIndependentResources();
 
+	// created before the window, WndProc feeds the input queue of the current context
+	ImDui::CreateContext();
+
 	WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(NULL), NULL, LoadCursor(NULL, IDC_ARROW), NULL, NULL, L"ImDui Example", NULL };
 	RegisterClassEx(&wc);
 	HWND hwnd = CreateWindow(L"ImDui Example", L"ImDui Example", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 1080, 640, NULL, NULL, wc.hInstance, NULL);
 
 	if (!SUCCEEDED(CreateDeviceResources(hwnd)))
 	{
+		ImDui::DestroyContext();
 		DestroyResources();
 		UnregisterClass(L"ImDui Example", wc.hInstance);
 		return 1;
@@ -174,10 +685,14 @@ int main(int, char**)
 
 	ImDui::InitResources(g_pD2DFactory, g_pDWriteFactory, g_pWICFactory, g_pMainRT);
 	ImDui::SetBgImage("iceland.jpg");
+	ImDui::LoadImagePack("demo.idp");		// optional, see RunWarmFirstFrameBenchmark()
+	ImDui::SetGarbageCollection(3600);		// about a minute at 60 fps
 
-	bool show_demo = true;
-	bool show_window_options = true;
-	bool show_style_editor = true;
+	if (record_path != NULL && !ImDui::StartInputRecording(record_path))
+		record_path = NULL;
+
+	ImDui::DemoState demo;
+	bool show_benchmarks = (record_path == NULL);
 	ImFloat4 clear_color = ImFloat4(194 / 255.f, 194 / 255.f, 100 / 255.f, 1.f);
 
 	MSG msg;
@@ -191,55 +706,59 @@ int main(int, char**)
 			continue;
 		}
 
+		const size_t allocations = t_allocations;
 		ImDui::NewFrame();
 
 		// test codes
 
-		if (show_demo)
-		{
-			ImDui::BeginWindow("ImDui Demo", &show_demo, ImFloat2(20, 20), ImFloat2(400, 200));
-			ImDui::Text("Hello ImDui!");
-			ImDui::Button("I am a button.");
-
-			static float val_slider = 0.5;
-			ImDui::SliderFloat("slider", &val_slider, 0.0f, 1.0f);
-
-			static bool val1 = false;
-			static bool val2 = false;
-			ImDui::CheckBox("checkbox1", &val1); ImDui::SameLine(100);
-			ImDui::CheckBox("checkbox2", &val2);
-
-			static int e = 0;
-			ImDui::RadioButton("radio a", &e, 0); ImDui::SameLine(100);
-			ImDui::RadioButton("radio b", &e, 1); ImDui::SameLine(200);
-			ImDui::RadioButton("radio c", &e, 2);
-
-			static float col1[3] = { 1.0f,0.0f,0.2f };
-			ImDui::ColorEdit3("color editor 1", col1);
-			ImDui::EndWindow();
-		}
+		ImDui::ShowDemoWindows(&demo);
 
-		if (show_window_options)
+		if (show_benchmarks)
 		{
-			ShowWindowOptions(&show_window_options);
+			ShowBenchmarks(&show_benchmarks);
 		}
 
-		if (show_style_editor)
+		if (s_showLatency)
+			ShowLatencyWindow(&s_showLatency);
+
+		if (s_showThumbnails)
+			ShowThumbnails(&s_showThumbnails);
+
+		if (s_showImageViewer)
+			ShowImageViewer(&s_showImageViewer);
+
+		if (s_showHeatmap)
+			ShowHeatmap(&s_showHeatmap);
+
+		if (s_showCulling)
+			ShowCulling(&s_showCulling);
+
+		if (g_dirtyRects != g_dirtyRectsApplied)
 		{
-			ImDui::BeginWindow("Style Editor", &show_style_editor, ImFloat2(1080 - 400 - 20 - 18, 20), ImFloat2(400, 570));
-			ImDui::ShowStyleEditor();
-			ImDui::EndWindow();
+			ImDui::SetDirtyRectRendering(g_dirtyRects, clear_color);
+			g_dirtyRectsApplied = g_dirtyRects;
 		}
 
-		g_pMainRT->BeginDraw();
-		g_pMainRT->Clear(clear_color.ToD2DColorF());
+		ImDui::EndFrame();
+		g_buildAllocs = t_allocations - allocations;
 
-		ImDui::Render();
+		if (g_pipelined && g_renderThread.joinable())
+			ImDui::WaitForRenderer();
+		else
+			RenderFrame(clear_color);
 
-		g_pMainRT->EndDraw();
+		if (g_buildAllocs != 0 || g_renderAllocs != 0)
+			g_allocFrames++;
+
+		SetRenderThread(g_pipelined, clear_color);
+
+		if (g_frameDelay > 0)
+			Sleep(g_frameDelay);
 	}
 
+	SetRenderThread(false, clear_color);
 	ImDui::Shutdown();
+	ImDui::DestroyContext();
 	DestroyResources();
 	UnregisterClass(L"ImDui Example", wc.hInstance);
 
@@ -0,0 +1,90 @@
+// ImDuiAllocTest: once warmed up, building and rendering frames allocates nothing. The
+// DemoSession of ImDuiDemo.h is played twice on the demo windows: the first run is the warm-up,
+// the second, which closes what the first opened, must not allocate, neither through the ImDui
+// allocator nor through the global operator new.
+//
+// usage: ImDuiAllocTest
+//
+// Exits with 1 when a frame of the second run allocated, and prints which.
+
+#include "../ImDui/ImDuiDemo.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool s_counting = false;
+static size_t s_allocations = 0;
+
+void* operator new(size_t size)
+{
+	if (s_counting)
+		s_allocations++;
+	void* ptr = malloc(size ? size : 1);
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+static void* CountingAlloc(size_t size, void*)
+{
+	if (s_counting)
+		s_allocations++;
+	return malloc(size);
+}
+
+static void CountingFree(void* ptr, void*)
+{
+	free(ptr);
+}
+
+int main()
+{
+	ImDui::SetAllocatorFunctions(CountingAlloc, CountingFree);
+	ImDui::CreateContext();
+#ifdef IMDUI_D2D
+	printf("ImDuiAllocTest needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	ImDui::InitResources();
+#endif
+
+	ImDui::DemoState demo;
+	ImDui::DemoSession session;
+	const int frames = ImDui::DemoSession::GetFrameCount();
+	size_t total = 0;
+	int allocating_frames = 0;
+	for (int run = 0; run < 2; run++)
+	{
+		session.Restart();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			session.Feed(frame);
+
+			s_allocations = 0;
+			s_counting = run == 1;
+			ImDui::NewFrame();
+			ImDui::ShowDemoWindows(&demo);
+			ImDui::Render();
+			s_counting = false;
+
+			if (s_allocations != 0)
+			{
+				printf("frame %d: %u allocations\n", frame + 1, (unsigned)s_allocations);
+				total += s_allocations;
+				allocating_frames++;
+			}
+		}
+	}
+
+	ImDui::DestroyContext();
+	if (allocating_frames != 0)
+	{
+		printf("%u allocations in %d of %d warmed-up frames\n", (unsigned)total, allocating_frames, frames);
+		return 1;
+	}
+	printf("%d warmed-up frames, no allocation\n", frames);
+	return 0;
+}
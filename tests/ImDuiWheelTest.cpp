@@ -0,0 +1,89 @@
+// ImDuiWheelTest: a notch of the mouse wheel over an ImageViewer() zooms it once, by 1.25x, and
+// the frames after it leave the zoom alone; two notches queued for one frame zoom it twice.
+// The zoom is read back from the frame captures, headless.
+//
+// usage: ImDuiWheelTest <image>      a PNG or JPEG, its size is all the null renderer reads
+//
+// Exits with 1 when a frame has another zoom than expected.
+
+#include "../ImDui/ImDui.h"
+#include "../ImDui/ImDuiRaster.h"
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+static void OnCapture(const void* data, size_t size, void* user_data)
+{
+	std::vector<unsigned char>* capture = (std::vector<unsigned char>*)user_data;
+	capture->assign((const unsigned char*)data, (const unsigned char*)data + size);
+}
+
+// the zoom of the image view of the frame, 0 when there is none
+static float BuildFrame(const char* path, int wheel)
+{
+	for (int i = 0; i < (wheel < 0 ? -wheel : wheel); i++)
+		ImDui::AddMouseWheelEvent(wheel < 0 ? -1 : 1);
+
+	std::vector<unsigned char> capture;
+	ImDui::CaptureFrame(OnCapture, &capture);
+	ImDui::NewFrame();
+	ImDui::BeginWindow("View", NULL, ImFloat2(0, 0), ImFloat2(440, 360));
+	ImDui::ImageViewer(path, ImFloat2(400, 300));
+	ImDui::EndWindow();
+	ImDui::EndFrame();
+	ImDui::Render();
+
+	ImDui::FrameCaptureReader reader;
+	const int window = (capture.empty() || reader.Read(capture.data(), capture.size()) != NULL) ? -1 : reader.FindWindow("View");
+	if (window < 0)
+		return 0.0f;
+	const ImDui::FrameCaptureReader::WindowData& data = reader.GetWindow(window);
+	for (ImUint i = 0; i < data.Info.CmdCount; i++)
+	{
+		if (data.Cmds[i].Type == ImDui::FrameCaptureCmd_ImageView)
+			return data.Points[data.Cmds[i].Count + 1].x;
+	}
+	return 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		printf("usage: ImDuiWheelTest <image>\n");
+		return 1;
+	}
+
+	ImDui::CreateContext();
+#ifdef IMDUI_D2D
+	printf("ImDuiWheelTest needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	ImDui::InitResources();
+#endif
+
+	// notches of every frame and the zoom expected, relative to the zoom fitted by the first
+	static const int sc_wheel[] = { 0, 0, 1, 0, 0, 0, 2, 0, -1, 0 };
+	static const int sc_zoom[] = { 0, 0, 1, 1, 1, 1, 3, 3, 2, 2 };		// powers of 1.25
+
+	ImDui::AddMouseMoveEvent(200, 180);
+	int failures = 0;
+	float fit = 0.0f;
+	for (int f = 0; f < (int)(sizeof(sc_wheel) / sizeof(sc_wheel[0])); f++)
+	{
+		const float zoom = BuildFrame(argv[1], sc_wheel[f]);
+		if (f == 0)
+			fit = zoom;
+		const float expected = fit * powf(1.25f, (float)sc_zoom[f]);
+		if (zoom <= 0.0f || fabsf(zoom - expected) > expected * 1e-4f)
+		{
+			printf("frame %d, %+d notches: zoom %g, expected %g\n", f, sc_wheel[f], zoom, expected);
+			failures++;
+		}
+	}
+
+	ImDui::DestroyContext();
+	if (failures == 0)
+		printf("zoom follows the wheel, fitted at %g\n", fit);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+// ImDuiBatch: renders a dashboard offscreen into PNG images, as a report or thumbnail service
+// would, and measures the throughput. Every thread has its own context and OffscreenRenderer of
+// ImDuiRaster.h and takes the next image; the PNGs are encoded as the rows come and streamed to
+// a sink that only counts the bytes, or to files.
+//
+// usage: ImDuiBatch [-n <images>] [-size <width> <height>] [-scale <s>] [-j <threads>] [-out <dir>]
+//
+//   -n 200            images per run
+//   -size 800 600     of the images, in pixels
+//   -scale 1          pixels per unit, the dashboard is laid out in width / scale x height / scale
+//   -j 4              runs with 1, 2, 4... threads up to that many, one per core by default
+//   -out dir          writes <dir>/dashboard-<n>.png, of the last run
+//
+// Prints the images per second of every run and its scaling over the run on one thread.
+
+#include "../../ImDui/ImDui.h"
+#include "../../ImDui/ImDuiRaster.h"
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+	int				Images;
+	int				Width;
+	int				Height;
+	float			Scale;
+	std::string		OutDir;
+};
+
+// the dashboard of image index, its values vary with it
+static void BuildDashboard(int index, float width, float height)
+{
+	const float half = floorf(width * 0.5f);
+	float load = 0.5f + 0.45f * sinf(index * 0.37f);
+	float memory = 0.5f + 0.45f * cosf(index * 0.23f);
+	bool alert = (index % 7) == 0;
+	bool online = (index % 3) != 0;
+
+	ImDui::NewFrame();
+
+	ImDui::BeginWindow("Server", NULL, ImFloat2(10, 10), ImFloat2(half - 15, height * 0.5f - 15), -1.0f, ImDuiWindowFlags_NoResize);
+	ImDui::Text("Report #%d", index);
+	ImDui::Text("Requests: %d / s", 1200 + (index * 37) % 800);
+	ImDui::SliderFloat("Load", &load, 0.0f, 1.0f, "%.2f");
+	ImDui::SliderFloat("Memory", &memory, 0.0f, 1.0f, "%.2f");
+	ImDui::CheckBox("Online", &online);
+	ImDui::CheckBox("Alert", &alert);
+	ImDui::EndWindow();
+
+	ImDui::BeginWindow("Status", NULL, ImFloat2(half + 5, 10), ImFloat2(width - half - 15, height * 0.5f - 15), -1.0f, ImDuiWindowFlags_NoResize);
+	for (int i = 0; i < 8; i++)
+	{
+		const float v = 0.5f + 0.5f * sinf(index * 0.11f + i);
+		ImDui::ColorButton(ImFloat4(v, 1.0f - v, 0.2f, 1.0f), true);
+		ImDui::SameLine();
+		ImDui::Text("node %d  %3.0f%%", i, v * 100.0f);
+	}
+	ImDui::EndWindow();
+
+	ImDui::BeginWindow("Details", NULL, ImFloat2(10, height * 0.5f + 5), ImFloat2(width - 20, height * 0.5f - 15), -1.0f, ImDuiWindowFlags_NoResize);
+	if (ImDui::Collapse("Jobs", NULL, true, true))
+	{
+		for (int i = 0; i < 6; i++)
+			ImDui::Text("job %d: %d items, %.1f s", index * 6 + i, (index * 13 + i * 7) % 100, ((index + i) % 50) * 0.1f);
+	}
+	ImDui::Button("Export");
+	ImDui::SameLine();
+	ImDui::Button("Refresh");
+	ImDui::EndWindow();
+}
+
+static bool CountBytes(const void*, size_t size, void* user_data)
+{
+	*(size_t*)user_data += size;
+	return true;
+}
+
+static bool WriteFile(const void* data, size_t size, void* user_data)
+{
+	return fwrite(data, 1, size, (FILE*)user_data) == size;
+}
+
+// renders images from next on, until there are none left, in a context of the calling thread
+static void RenderImages(const Options& options, bool write, std::atomic<int>* next, std::atomic<size_t>* png_bytes, std::atomic<int>* failed)
+{
+	ImDui::Context* ctx = ImDui::CreateContext();
+	ImDui::SetCurrentContext(ctx);
+	ImDui::InitResources();
+	ImDui::OffscreenRenderer renderer;
+
+	const float width = options.Width / options.Scale, height = options.Height / options.Scale;
+	const ImFloat4 clear_color(0.85f, 0.85f, 0.85f, 1.0f);
+
+	// a first frame for the windows to be created and laid out
+	BuildDashboard(0, width, height);
+	renderer.Render(options.Width, options.Height, options.Scale, clear_color);
+
+	size_t bytes = 0;
+	for (int i = (*next)++; i < options.Images; i = (*next)++)
+	{
+		BuildDashboard(i, width, height);
+		bool ok = renderer.Render(options.Width, options.Height, options.Scale, clear_color);
+		if (ok && write)
+		{
+			char path[512];
+			snprintf(path, sizeof(path), "%s/dashboard-%d.png", options.OutDir.c_str(), i);
+			FILE* f = fopen(path, "wb");
+			ok = f != NULL && renderer.GetImage().WritePNG(WriteFile, f);
+			ok = (f != NULL && fclose(f) == 0) && ok;
+		}
+		else if (ok)
+		{
+			ok = renderer.GetImage().WritePNG(CountBytes, &bytes);
+		}
+		if (!ok)
+			(*failed)++;
+	}
+	*png_bytes += bytes;
+
+	ImDui::DestroyContext(ctx);
+}
+
+static int Usage()
+{
+	printf("usage: ImDuiBatch [-n <images>] [-size <width> <height>] [-scale <s>] [-j <threads>] [-out <dir>]\n");
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+#ifdef IMDUI_D2D
+	printf("ImDuiBatch needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	Options options;
+	options.Images = 200;
+	options.Width = 800;
+	options.Height = 600;
+	options.Scale = 1.0f;
+	int max_threads = (int)std::thread::hardware_concurrency();
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			options.Images = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-size") == 0 && i + 2 < argc)
+		{
+			options.Width = atoi(argv[++i]);
+			options.Height = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-scale") == 0 && i + 1 < argc)
+			options.Scale = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			max_threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+			options.OutDir = argv[++i];
+		else
+			return Usage();
+	}
+	if (options.Images < 1 || options.Width < 1 || options.Height < 1 || options.Scale <= 0.0f)
+		return Usage();
+	max_threads = max_threads < 1 ? 1 : max_threads;
+
+	printf("%d images of %d x %d, scale %.2f\n", options.Images, options.Width, options.Height, options.Scale);
+	printf("threads   images/s   scaling   KB/image\n");
+	double single_rate = 0.0;
+	for (int threads = 1; ; threads = (threads * 2 > max_threads && threads < max_threads) ? max_threads : threads * 2)
+	{
+		const bool write = !options.OutDir.empty() && threads == max_threads;
+		std::atomic<int> next(0), failed(0);
+		std::atomic<size_t> png_bytes(0);
+
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+			workers.push_back(std::thread(RenderImages, std::cref(options), write, &next, &png_bytes, &failed));
+		for (size_t t = 0; t < workers.size(); t++)
+			workers[t].join();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		const double rate = options.Images / seconds;
+		if (threads == 1)
+			single_rate = rate;
+		printf("%7d   %8.1f   %6.2fx", threads, rate, rate / single_rate);
+		if (write)
+			printf("   written to %s", options.OutDir.c_str());
+		else
+			printf("   %8.1f", png_bytes / 1024.0 / options.Images);
+		printf("\n");
+		if (failed > 0)
+		{
+			printf("%d images failed\n", failed.load());
+			return 1;
+		}
+		if (threads >= max_threads)
+			break;
+	}
+	return 0;
+#endif
+}
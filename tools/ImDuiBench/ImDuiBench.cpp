@@ -0,0 +1,375 @@
+// ImDuiBench: builds frames of ImDui windows as fast as it can, without a window or a GPU, and
+// reports the frame times. Built with the null renderer (the default outside Windows), it
+// measures the layout, id and interaction logic alone.
+//
+// usage: ImDuiBench [frames] [windows] [rows] [threads] [raster|pipelined]
+//        ImDuiBench thumbnails sync|async
+//
+//   ImDuiBench 2000 8 200       eight windows of 200 widget rows, built one after the other
+//   ImDuiBench 2000 8 200 4     the same windows built as parallel windows on 4 threads
+//   ImDuiBench 500 8 200 0 raster      every frame also drawn, 1280 x 720 with the rasterizer of
+//                                      ImDuiRaster.h, after it is built
+//   ImDuiBench 500 8 200 0 pipelined   the same drawing on a render thread, while the next frame
+//                                      is built (SetPipelinedRendering())
+//
+// The mouse follows a fixed path over the windows and presses the button every few frames, so
+// that hovering, dragging and clicking are part of every run and runs are comparable.
+//
+//   ImDuiBench thumbnails sync    200 thumbnails of distinct sizes shown at 60 frames/s, every one
+//                                 decoded inside the frame that first shows it, as DrawImage() did
+//   ImDuiBench thumbnails async   the same decodes on background threads (half the cores, 1 to 4),
+//                                 at most 4 uploaded a frame, as the ImageLoader of the renderer does
+//
+// The null renderer has no image decoder: a decode stands for a copy of a 2200 x 1467 source
+// (the size of iceland.jpg) and a Lanczos3 resample of it to the thumbnail (ResampleImage()),
+// without the JPEG decompression, so the times are lower bounds of those of WIC. The frame times
+// are the work of a frame, without the wait for the next one.
+
+#include "../../ImDui/ImDui.h"
+#include "../../ImDui/ImDuiRaster.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct WindowState
+{
+	char	Name[32];
+	bool	Open;
+	bool	Checks[8];
+	float	Values[8];
+	float	Color[4];
+};
+
+static void BuildRows(WindowState& state, int rows)
+{
+	for (int r = 0; r < rows; r++)
+	{
+		char label[32];
+		switch (r % 6)
+		{
+		case 0:
+			ImDui::Text("row %d of %s", r, state.Name);
+			break;
+		case 1:
+			snprintf(label, sizeof(label), "button %d", r);
+			ImDui::Button(label);
+			break;
+		case 2:
+			snprintf(label, sizeof(label), "check %d", r);
+			ImDui::CheckBox(label, &state.Checks[r % 8]);
+			break;
+		case 3:
+			snprintf(label, sizeof(label), "slider %d", r);
+			ImDui::SliderFloat(label, &state.Values[r % 8], 0.0f, 1.0f);
+			break;
+		case 4:
+			snprintf(label, sizeof(label), "group %d", r);
+			if (ImDui::Collapse(label, NULL, true, true))
+				ImDui::Text("inside %d", r);
+			break;
+		default:
+			snprintf(label, sizeof(label), "color %d", r);
+			ImDui::ColorEdit4(label, state.Color);
+			break;
+		}
+	}
+}
+
+enum
+{
+	THUMB_COUNT		= 200,
+	THUMB_UPLOADS	= 4,		// a frame
+	SOURCE_WIDTH	= 2200,
+	SOURCE_HEIGHT	= 1467,
+};
+
+struct Thumbnail
+{
+	int				Width;
+	int				Height;
+	bool			Queued;
+	bool			Decoded;
+	bool			Ready;
+	std::vector<unsigned char>	Pixels;		// decoded
+	std::vector<unsigned char>	Bitmap;		// uploaded
+};
+
+static void DecodeThumbnail(const std::vector<unsigned char>& source, std::vector<unsigned char>& scratch, Thumbnail& thumb)
+{
+	memcpy(&scratch[0], &source[0], source.size());
+	thumb.Pixels.resize(thumb.Width * thumb.Height * 4);
+	ImDui::ResampleImage(&scratch[0], SOURCE_WIDTH, SOURCE_HEIGHT, SOURCE_WIDTH * 4, 4,
+		&thumb.Pixels[0], thumb.Width, thumb.Height, thumb.Width * 4, ImDui::ImageFilter_Lanczos3, 1);
+}
+
+static int RunThumbnails(bool async)
+{
+	ImDui::CreateContext();
+#ifdef IMDUI_D2D
+	printf("ImDuiBench needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	ImDui::InitResources();
+#endif
+
+	std::vector<unsigned char> source(SOURCE_WIDTH * SOURCE_HEIGHT * 4);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = (unsigned char)(i * 7 + i / 4096);
+	std::vector<unsigned char> scratch(source.size());
+
+	Thumbnail* thumbs = new Thumbnail[THUMB_COUNT];
+	for (int i = 0; i < THUMB_COUNT; i++)
+	{
+		thumbs[i].Width = 24 + i % 20;
+		thumbs[i].Height = 16 + i / 20;
+		thumbs[i].Queued = thumbs[i].Decoded = thumbs[i].Ready = false;
+	}
+
+	// the decode threads take the queue in order; the frames upload what they decoded
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::vector<int> queue;
+	bool quit = false;
+	std::vector<std::thread> decoders;
+	if (async)
+	{
+		const int count = std::max(1, std::min(4, (int)std::thread::hardware_concurrency() / 2));
+		for (int t = 0; t < count; t++)
+		{
+			decoders.push_back(std::thread([&]
+			{
+				std::vector<unsigned char> decoder_scratch(source.size());
+				std::unique_lock<std::mutex> lock(mutex);
+				for (;;)
+				{
+					queued.wait(lock, [&] { return quit || !queue.empty(); });
+					if (quit)
+						return;
+					Thumbnail& thumb = thumbs[queue.front()];
+					queue.erase(queue.begin());
+					lock.unlock();
+					DecodeThumbnail(source, decoder_scratch, thumb);
+					lock.lock();
+					thumb.Decoded = true;
+				}
+			}));
+		}
+	}
+
+	std::vector<double> times;
+	int ready = 0;
+	bool open = true;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double load_ms = 0.0;
+	for (int f = 0; ready < THUMB_COUNT; f++)
+	{
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		ImDui::NewFrame();
+		ImDui::BeginWindow("Thumbnails", &open, ImFloat2(20, 20), ImFloat2(800, 340));
+		for (int i = 0; i < THUMB_COUNT; i++)
+		{
+			if (i % 20 != 0)
+				ImDui::SameLine();
+			ImDui::Image("iceland.jpg", ImFloat2((float)thumbs[i].Width, (float)thumbs[i].Height));
+		}
+		ImDui::EndWindow();
+		ImDui::EndFrame();
+
+		// what the renderer does of the images of the frame
+		int uploads = 0;
+		for (int i = 0; i < THUMB_COUNT; i++)
+		{
+			Thumbnail& thumb = thumbs[i];
+			if (thumb.Ready)
+				continue;
+			if (!async)
+				DecodeThumbnail(source, scratch, thumb);
+			else
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!thumb.Queued)
+				{
+					thumb.Queued = true;
+					queue.push_back(i);
+					queued.notify_one();
+				}
+				if (!thumb.Decoded || uploads == THUMB_UPLOADS)
+					continue;
+				uploads++;
+			}
+			thumb.Bitmap = thumb.Pixels;
+			thumb.Ready = true;
+			ready++;
+		}
+		ImDui::Render();
+
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		times.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+		load_ms = std::chrono::duration<double, std::milli>(end - start).count();
+		std::this_thread::sleep_until(start + std::chrono::microseconds((long long)(f + 1) * 1000000 / 60));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		queued.notify_all();
+	}
+	for (size_t t = 0; t < decoders.size(); t++)
+		decoders[t].join();
+
+	std::sort(times.begin(), times.end());
+	printf("%d thumbnails, decoded %s, %d frames\n", THUMB_COUNT, async ? "on background threads" : "in the frame", (int)times.size());
+	printf("frame: %.3f ms p50, %.3f ms p99, %.3f ms max\n", times[(times.size() - 1) / 2], times[(times.size() - 1) * 99 / 100], times.back());
+	printf("loaded in %.1f ms\n", load_ms);
+
+	ImDui::DestroyContext();
+	delete[] thumbs;
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1 && strcmp(argv[1], "thumbnails") == 0)
+	{
+		if (argc != 3 || (strcmp(argv[2], "sync") != 0 && strcmp(argv[2], "async") != 0))
+		{
+			printf("usage: ImDuiBench thumbnails sync|async\n");
+			return 1;
+		}
+		return RunThumbnails(strcmp(argv[2], "async") == 0);
+	}
+
+	const int frames = argc > 1 ? atoi(argv[1]) : 1000;
+	const int windows = argc > 2 ? atoi(argv[2]) : 8;
+	const int rows = argc > 3 ? atoi(argv[3]) : 100;
+	const int threads = argc > 4 ? atoi(argv[4]) : 0;
+	const bool raster = argc > 5 && (strcmp(argv[5], "raster") == 0 || strcmp(argv[5], "pipelined") == 0);
+	const bool pipelined = argc > 5 && strcmp(argv[5], "pipelined") == 0;
+	if (frames <= 0 || windows <= 0 || rows <= 0 || (argc > 5 && !raster))
+	{
+		printf("usage: ImDuiBench [frames] [windows] [rows] [threads] [raster|pipelined]\n");
+		return 1;
+	}
+
+	ImDui::CreateContext();
+#ifdef IMDUI_D2D
+	printf("ImDuiBench needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	ImDui::InitResources();
+#endif
+
+	WindowState* states = new WindowState[windows];
+	for (int w = 0; w < windows; w++)
+	{
+		WindowState& state = states[w];
+		snprintf(state.Name, sizeof(state.Name), "window %d", w);
+		state.Open = true;
+		for (int i = 0; i < 8; i++)
+		{
+			state.Checks[i] = (i & 1) != 0;
+			state.Values[i] = i / 8.0f;
+		}
+		state.Color[0] = state.Color[1] = state.Color[2] = state.Color[3] = 0.5f;
+	}
+
+	// the frames are drawn into memory; pipelined, on a render thread that sleeps until one is published
+	ImDui::Context* ctx = ImDui::GetCurrentContext();
+	ImDui::OffscreenRenderer renderer;
+	const ImFloat4 clear_color(0.85f, 0.85f, 0.85f, 1.0f);
+	std::atomic<bool> render_quit(false);
+	std::thread render_thread;
+	if (pipelined)
+	{
+		ImDui::SetPipelinedRendering(true);
+		render_thread = std::thread([ctx, &renderer, &render_quit, clear_color]
+		{
+			ImDui::SetCurrentContext(ctx);
+			while (!render_quit)
+			{
+				if (ImDui::WaitForFrame(50))
+					renderer.Render(1280, 720, 1.0f, clear_color);
+			}
+		});
+	}
+
+	double total_ms = 0.0;
+	double max_ms = 0.0;
+	double build_ms = 0.0;
+	double render_ms = 0.0;
+	for (int f = 0; f < frames; f++)
+	{
+		// the mouse sweeps the columns of windows, pressed for 4 frames out of 16
+		const float x = 40.0f + (f * 7 % (windows * 260));
+		const float y = 40.0f + (f * 13 % 600);
+		ImDui::AddMouseMoveEvent(x, y);
+		if (f % 16 == 0 || f % 16 == 4)
+			ImDui::AddMouseButtonEvent(x, y, f % 16 == 0);
+
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		ImDui::NewFrame();
+		if (threads > 0)
+		{
+			ImDui::BeginParallelWindows();
+			for (int w = 0; w < windows; w++)
+			{
+				WindowState* state = &states[w];
+				ImDui::ParallelWindow(state->Name, &state->Open, [state, rows] { BuildRows(*state, rows); }, ImFloat2(20.0f + w * 260.0f, 20.0f), ImFloat2(250, 640));
+			}
+			ImDui::EndParallelWindows(threads);
+		}
+		else
+		{
+			for (int w = 0; w < windows; w++)
+			{
+				WindowState& state = states[w];
+				ImDui::BeginWindow(state.Name, &state.Open, ImFloat2(20.0f + w * 260.0f, 20.0f), ImFloat2(250, 640));
+				BuildRows(state, rows);
+				ImDui::EndWindow();
+			}
+		}
+		ImDui::EndFrame();
+		if (pipelined)
+			ImDui::WaitForRenderer();
+		else if (raster)
+			renderer.Render(1280, 720, 1.0f, clear_color);
+		else
+			ImDui::Render();
+
+		const ImDui::FrameStats stats = ImDui::GetFrameStats();
+		build_ms += stats.BuildTime;
+		render_ms += stats.RenderTime;
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		total_ms += ms;
+		max_ms = ms > max_ms ? ms : max_ms;
+	}
+
+	const ImDui::AllocStats allocs = ImDui::GetAllocStats();
+	size_t bytes = 0;
+	for (int i = 0; i < ImDui::AllocCategory_COUNT; i++)
+		bytes += allocs.Bytes[i];
+
+	if (pipelined)
+	{
+		render_quit = true;
+		render_thread.join();
+		ImDui::SetPipelinedRendering(false);
+	}
+
+	printf("%d frames, %d windows of %d rows, %s%s\n", frames, windows, rows, threads > 0 ? "parallel" : "serial",
+		pipelined ? ", drawn on a render thread" : raster ? ", drawn" : "");
+	printf("frame: %.3f ms average, %.3f ms max, %.0f frames/s\n", total_ms / frames, max_ms, frames * 1000.0 / total_ms);
+	printf("build: %.3f ms, render: %.3f ms average\n", build_ms / frames, render_ms / frames);
+	printf("memory: %.1f KB\n", bytes / 1024.0);
+
+	ImDui::DestroyContext();
+	delete[] states;
+	return 0;
+}
@@ -0,0 +1,285 @@
+// ImDuiCapture: reads a frame capture written by ImDui::CaptureFrame() and prints what every
+// window cost to draw, lists the draw commands one by one, or renders the frame again with the
+// CPU rasterizer of ImDuiRaster.h, without Direct2D.
+//
+// usage: ImDuiCapture <capture>                       the frame and the cost of every window
+//        ImDuiCapture <capture> -list [window]        every command, its clip depth and time
+//        ImDuiCapture <capture> -png <file> [-until <window> <cmd>] [-window <window>] [-bg rrggbb]
+//
+//   -until 2 15      draws the windows up to the third one, and that one up to its command 15,
+//                    to step through a frame
+//   -window 2        draws only the third window, at the size of its surface
+//
+// Windows are given by index or by name. Times are those of the machine that captured the frame:
+// the time of a command is what it took to issue, the window time includes the flush of its
+// surface, where the GPU work of Direct2D is done. The raster times are those of this tool.
+// Images and heatmaps are drawn as placeholders, their pixels are not captured.
+
+#include "../../ImDui/ImDuiRaster.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const char* const sc_cmd_names[ImDui::FrameCaptureCmd_COUNT] =
+{
+	"line", "rect", "rounded rect", "ellipse", "polygon", "polyline", "text",
+	"image", "image view", "heatmap", "push clip", "pop clip",
+};
+
+// a file into memory, the reader points into it
+static bool LoadCapture(const char* path, std::vector<char>* data, ImDui::FrameCaptureReader* capture)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		printf("cannot open %s\n", path);
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	data->resize((size_t)ftell(f));
+	fseek(f, 0, SEEK_SET);
+	const size_t read = fread(data->data(), 1, data->size(), f);
+	fclose(f);
+
+	const char* error = capture->Read(data->data(), read);
+	if (error != NULL)
+	{
+		printf("%s: %s\n", path, error);
+		return false;
+	}
+	return true;
+}
+
+// by index, or by name
+static int FindWindow(const ImDui::FrameCaptureReader& capture, const char* window)
+{
+	char* end = NULL;
+	const long index = strtol(window, &end, 10);
+	if (end != window && *end == '\0')
+		return (index >= 0 && index < capture.GetWindowCount()) ? (int)index : -1;
+	return capture.FindWindow(window);
+}
+
+// RasterCaptureWindow() timing every command, by_type receiving the ms per command type
+static double RasterWindow(ImDui::Raster* surface, const ImDui::FrameCaptureReader& capture, int window, double* by_type)
+{
+	const ImDui::FrameCaptureReader::WindowData& data = capture.GetWindow(window);
+	surface->Resize((int)(data.Info.Rect.z + 0.5f), (int)(data.Info.Rect.w + 0.5f));
+
+	double total = 0.0;
+	for (ImUint i = 0; i < data.Info.CmdCount; i++)
+	{
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		ImDui::RasterCaptureCommand(surface, capture, window, i);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		by_type[data.Cmds[i].Type] += ms;
+		total += ms;
+	}
+	return total;
+}
+
+static void PrintSummary(const ImDui::FrameCaptureReader& capture)
+{
+	const ImDui::FrameCaptureHeader& header = capture.GetHeader();
+	printf("frame %u, %u windows, %.0f x %.0f, font size %.1f\n", header.Frame, header.WindowCount, header.Width, header.Height, header.FontSize);
+	printf("build %.3f ms, draw %.3f ms\n", header.BuildTime, header.DrawTime);
+	if (capture.GetBgImage()[0])
+		printf("background image %s\n", capture.GetBgImage());
+	if (capture.GetToolTip()[0])
+		printf("tooltip \"%s\"\n", capture.GetToolTip());
+
+	double captured_by_type[ImDui::FrameCaptureCmd_COUNT] = {};
+	double raster_by_type[ImDui::FrameCaptureCmd_COUNT] = {};
+	ImUint count_by_type[ImDui::FrameCaptureCmd_COUNT] = {};
+	ImDui::Raster surface;
+
+	printf("\n  #  window                            cmds  points   text   draw ms  issue ms  raster ms  flags\n");
+	for (int i = 0; i < capture.GetWindowCount(); i++)
+	{
+		const ImDui::FrameCaptureReader::WindowData& window = capture.GetWindow(i);
+		double issue = 0.0;
+		for (ImUint j = 0; j < window.Info.CmdCount; j++)
+		{
+			issue += window.Cmds[j].Time;
+			captured_by_type[window.Cmds[j].Type] += window.Cmds[j].Time;
+			count_by_type[window.Cmds[j].Type]++;
+		}
+		const double raster = RasterWindow(&surface, capture, i, raster_by_type);
+
+		printf("%3d  %-32.32s %5u %7u %6u %9.3f %9.3f %10.3f  %s%s\n", i, window.Info.Name,
+			window.Info.CmdCount, window.Info.PointCount, window.Info.TextBytes, window.Info.DrawTime, issue, raster,
+			(window.Info.Flags & ImDui::FrameCaptureWindow_Hidden) ? "hidden " : "",
+			(window.Info.Flags & ImDui::FrameCaptureWindow_Opaque) ? "opaque" : "");
+	}
+
+	printf("\ncommand        count  issue ms  raster ms\n");
+	for (int i = 0; i < ImDui::FrameCaptureCmd_COUNT; i++)
+	{
+		if (count_by_type[i] != 0)
+			printf("%-13s %6u %9.3f %10.3f\n", sc_cmd_names[i], count_by_type[i], captured_by_type[i], raster_by_type[i]);
+	}
+}
+
+static void PrintCommands(const ImDui::FrameCaptureReader& capture, int only_window)
+{
+	for (int i = 0; i < capture.GetWindowCount(); i++)
+	{
+		if (only_window >= 0 && i != only_window)
+			continue;
+
+		const ImDui::FrameCaptureReader::WindowData& window = capture.GetWindow(i);
+		printf("window %d \"%s\" at (%.1f, %.1f) %.1f x %.1f, alpha %.2f, %u commands\n", i, window.Info.Name,
+			window.Info.Rect.x, window.Info.Rect.y, window.Info.Rect.z, window.Info.Rect.w, window.Info.Alpha, window.Info.CmdCount);
+
+		int clip_depth = 0;
+		for (ImUint j = 0; j < window.Info.CmdCount; j++)
+		{
+			const ImDui::FrameCaptureCmd& cmd = window.Cmds[j];
+			clip_depth -= cmd.Type == ImDui::FrameCaptureCmd_PopClip ? 1 : 0;
+			printf("  %5u  clip %d  %8.4f ms  %-12s", j, clip_depth, cmd.Time, sc_cmd_names[cmd.Type]);
+
+			switch (cmd.Type)
+			{
+			case ImDui::FrameCaptureCmd_Line:
+				printf(" (%.1f, %.1f) - (%.1f, %.1f)", window.Points[cmd.Offset].x, window.Points[cmd.Offset].y,
+					window.Points[cmd.Offset + 1].x, window.Points[cmd.Offset + 1].y);
+				break;
+			case ImDui::FrameCaptureCmd_Ellipse:
+				printf(" center (%.1f, %.1f) radius %.1f, %.1f", cmd.Rect.x, cmd.Rect.y, cmd.Radius.x, cmd.Radius.y);
+				break;
+			case ImDui::FrameCaptureCmd_Polygon:
+			case ImDui::FrameCaptureCmd_PolygonalLine:
+				printf(" %u points", cmd.Count);
+				break;
+			case ImDui::FrameCaptureCmd_PopClip:
+				break;
+			default:
+				printf(" (%.1f, %.1f) %.1f x %.1f", cmd.Rect.x, cmd.Rect.y, cmd.Rect.z, cmd.Rect.w);
+				break;
+			}
+
+			if (cmd.Type == ImDui::FrameCaptureCmd_Text || cmd.Type == ImDui::FrameCaptureCmd_Image || cmd.Type == ImDui::FrameCaptureCmd_ImageView)
+				printf(" \"%s\"", window.Text + cmd.Offset);
+			if (cmd.Type == ImDui::FrameCaptureCmd_Heatmap)
+				printf(" id %u", cmd.Count);
+			if (cmd.Type != ImDui::FrameCaptureCmd_PushClip && cmd.Type != ImDui::FrameCaptureCmd_PopClip
+				&& cmd.Type != ImDui::FrameCaptureCmd_Image && cmd.Type != ImDui::FrameCaptureCmd_ImageView)
+			{
+				printf(" color %.2f %.2f %.2f %.2f%s", cmd.Color.x, cmd.Color.y, cmd.Color.z, cmd.Color.w,
+					(cmd.Flags & ImDui::FrameCaptureCmd_Filled) ? " filled" : "");
+			}
+			printf("\n");
+
+			clip_depth += cmd.Type == ImDui::FrameCaptureCmd_PushClip ? 1 : 0;
+		}
+	}
+}
+
+// The whole frame, or with only_window >= 0 that window alone at the size of its surface.
+static bool WritePNG(const ImDui::FrameCaptureReader& capture, const char* path, int until_window, ImUint until_cmd, int only_window, const ImFloat4& bg)
+{
+	ImDui::Raster frame;
+	ImDui::Raster surface;
+
+	if (only_window >= 0)
+	{
+		const ImUint cmd_count = (only_window == until_window) ? until_cmd + 1 : capture.GetWindow(only_window).Info.CmdCount;
+		ImDui::RasterCaptureWindow(&surface, capture, only_window, cmd_count);
+		frame.Resize(surface.GetWidth(), surface.GetHeight());
+		frame.Clear(bg);
+		frame.Compose(surface, ImFloat2(0, 0), 1.0f);
+	}
+	else
+	{
+		ImDui::RasterCaptureFrame(&frame, &surface, capture, bg, until_window, until_cmd);
+	}
+	return frame.WritePNG(path);
+}
+
+static int Usage()
+{
+	printf("usage: ImDuiCapture <capture>\n");
+	printf("       ImDuiCapture <capture> -list [window]\n");
+	printf("       ImDuiCapture <capture> -png <file> [-until <window> <cmd>] [-window <window>] [-bg rrggbb]\n");
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argv[1][0] == '-')
+		return Usage();
+
+	std::vector<char> data;
+	ImDui::FrameCaptureReader capture;
+	if (!LoadCapture(argv[1], &data, &capture))
+		return 1;
+
+	if (argc == 2)
+	{
+		PrintSummary(capture);
+		return 0;
+	}
+
+	if (strcmp(argv[2], "-list") == 0)
+	{
+		const int window = (argc > 3) ? FindWindow(capture, argv[3]) : -1;
+		if (argc > 3 && window < 0)
+		{
+			printf("no window %s\n", argv[3]);
+			return 1;
+		}
+		PrintCommands(capture, window);
+		return 0;
+	}
+
+	if (strcmp(argv[2], "-png") != 0 || argc < 4)
+		return Usage();
+
+	const char* path = argv[3];
+	int until_window = -1;
+	ImUint until_cmd = 0;
+	int only_window = -1;
+	ImFloat4 bg(194 / 255.0f, 194 / 255.0f, 100 / 255.0f, 1.0f);		// the clear color of the demo
+	for (int i = 4; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-until") == 0 && i + 2 < argc)
+		{
+			until_window = FindWindow(capture, argv[i + 1]);
+			until_cmd = (ImUint)strtoul(argv[i + 2], NULL, 10);
+			if (until_window < 0)
+			{
+				printf("no window %s\n", argv[i + 1]);
+				return 1;
+			}
+			i += 2;
+		}
+		else if (strcmp(argv[i], "-window") == 0 && i + 1 < argc)
+		{
+			only_window = FindWindow(capture, argv[++i]);
+			if (only_window < 0)
+			{
+				printf("no window %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-bg") == 0 && i + 1 < argc)
+		{
+			const unsigned long rgb = strtoul(argv[++i], NULL, 16);
+			bg = ImFloat4(((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f, 1.0f);
+		}
+		else
+		{
+			return Usage();
+		}
+	}
+
+	if (!WritePNG(capture, path, until_window, until_cmd, only_window, bg))
+	{
+		printf("cannot write %s\n", path);
+		return 1;
+	}
+	printf("wrote %s\n", path);
+	return 0;
+}
@@ -0,0 +1,368 @@
+// ImDuiGolden: builds the demo windows and the style editor under a set of styles and states,
+// draws every scene with the CPU rasterizer of ImDuiRaster.h from a frame capture, and compares
+// it to a golden PNG. No window, no GPU: the scenes run in parallel, one context per thread.
+//
+// usage: ImDuiGolden <golden dir> [-update] [-scene <name>] [-j <threads>] [-threshold <t>] [-max-diff <pixels>] [-out <dir>]
+//
+//   -update          writes the goldens of the scenes, instead of comparing
+//   -scene dark      runs that scene only
+//   -j 4             threads, one per core by default
+//   -threshold 0.1   a pixel differs when its YIQ color distance to the golden one is above
+//                    threshold, 0 to 1 of the largest distance: small anti-aliasing and rounding
+//                    differences are not seen, a changed color or a moved edge is
+//   -max-diff 0      a scene passes with at most that many differing pixels
+//   -out dir         where the failing scenes write <scene>.png and <scene>.diff.png, the
+//                    golden dir by default
+//
+// Exits with 1 when a scene fails or has no golden. Text is measured by the null renderer and
+// drawn in the 5x7 font of the rasterizer, so goldens are the same on every platform.
+
+#include "../../ImDui/ImDuiDemo.h"
+#include "../../ImDui/ImDuiRaster.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Click
+{
+	float	X, Y;
+};
+
+struct Scene
+{
+	const char*		Name;
+	void			(*Setup)(ImDui::GuiStyle* style, ImDui::DemoState* demo);
+	Click			Clicks[4];		// clicked in turn before the captured frame, x = 0 ends
+};
+
+static void SetupDefault(ImDui::GuiStyle*, ImDui::DemoState*)
+{
+}
+
+static void SetupEnglish(ImDui::GuiStyle*, ImDui::DemoState* demo)
+{
+	demo->Chinese = false;
+}
+
+static void SetupValues(ImDui::GuiStyle*, ImDui::DemoState* demo)
+{
+	demo->Slider = 0.9f;
+	demo->Check1 = true;
+	demo->Check2 = true;
+	demo->Radio = 2;
+	demo->Color[0] = 0.1f;
+	demo->Color[1] = 0.6f;
+	demo->Color[2] = 0.3f;
+}
+
+static void SetupWindowFlags(ImDui::GuiStyle*, ImDui::DemoState* demo)
+{
+	demo->Chinese = false;
+	demo->NoTitleBar = true;
+	demo->NoBorder = false;
+	demo->NoResize = true;
+}
+
+static void SetupAlpha(ImDui::GuiStyle*, ImDui::DemoState* demo)
+{
+	demo->FillAlpha = 0.5f;
+}
+
+static void SetupDark(ImDui::GuiStyle* style, ImDui::DemoState*)
+{
+	style->Colors[Color_Text]			= ImFloat4(0.90f, 0.90f, 0.90f, 1.0f);
+	style->Colors[Color_WindowBg]		= ImFloat4(0.12f, 0.12f, 0.14f, 1.0f);
+	style->Colors[Color_WidgetBg]		= ImFloat4(0.22f, 0.22f, 0.26f, 1.0f);
+	style->Colors[Color_TitleBar]		= ImFloat4(0.20f, 0.30f, 0.45f, 1.0f);
+	style->Colors[Color_Button]			= ImFloat4(0.30f, 0.32f, 0.40f, 1.0f);
+	style->Colors[Color_Collapse]		= ImFloat4(0.30f, 0.32f, 0.40f, 1.0f);
+	style->Colors[Color_Slider]			= ImFloat4(0.40f, 0.55f, 0.80f, 1.0f);
+	style->Colors[Color_ResizeGrip]		= ImFloat4(0.35f, 0.35f, 0.40f, 1.0f);
+}
+
+static void SetupSpacing(ImDui::GuiStyle* style, ImDui::DemoState*)
+{
+	style->WindowPadding = ImFloat2(16, 16);
+	style->FramePadding = ImFloat2(10, 8);
+	style->ItemSpacing = ImFloat2(16, 10);
+	style->ItemInnerSpacing = ImFloat2(8, 8);
+}
+
+static void SetupTitleBar(ImDui::GuiStyle* style, ImDui::DemoState*)
+{
+	style->TitleBarHeight = 32.0f;
+}
+
+static void SetupLargeFont(ImDui::GuiStyle* style, ImDui::DemoState* demo)
+{
+	style->FontSize = 16.0f;
+	demo->Chinese = false;
+}
+
+static const Scene sc_scenes[] =
+{
+	{ "default",		SetupDefault, {} },
+	{ "english",		SetupEnglish, {} },
+	{ "values",			SetupValues, {} },
+	{ "window-flags",	SetupWindowFlags, {} },
+	{ "alpha",			SetupAlpha, {} },
+	{ "dark",			SetupDark, {} },
+	{ "spacing",		SetupSpacing, {} },
+	{ "title-bar",		SetupTitleBar, {} },
+	{ "large-font",		SetupLargeFont, {} },
+	{ "options-open",	SetupDefault, { { 100, 332 }, { 100, 304 } } },		// the collapses of the window options
+	{ "collapsed",		SetupDefault, { { 200, 28 }, { 200, 28 } } },		// double click on the title bar of the demo
+};
+
+static const int SCENE_COUNT = (int)(sizeof(sc_scenes) / sizeof(sc_scenes[0]));
+
+struct Options
+{
+	std::string		GoldenDir;
+	std::string		OutDir;
+	bool			Update;
+	float			Threshold;
+	int				MaxDiff;
+};
+
+struct Result
+{
+	bool			Passed;
+	int				DiffPixels;
+	double			Ms;
+	std::string		Message;
+};
+
+static void CopyCapture(const void* data, size_t size, void* user_data)
+{
+	std::vector<char>* capture = (std::vector<char>*)user_data;
+	capture->assign((const char*)data, (const char*)data + size);
+}
+
+// Builds the scene in a context of the calling thread and returns its frame capture.
+static std::vector<char> BuildScene(const Scene& scene)
+{
+	ImDui::Context* ctx = ImDui::CreateContext();
+	ImDui::SetCurrentContext(ctx);
+	ImDui::DemoState demo;
+	scene.Setup(&ImDui::GetStyle(), &demo);		// before InitResources(), which reads the font size
+	ImDui::InitResources();
+
+	// a frame to hover, one to press and one to release every click, then two for the layout to settle
+	int clicks = 0;
+	while (clicks < 4 && scene.Clicks[clicks].X != 0.0f)
+		clicks++;
+	const int frames = clicks * 3 + 2;
+
+	std::vector<char> capture;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		if (frame < clicks * 3)
+		{
+			const Click& click = scene.Clicks[frame / 3];
+			if (frame % 3 == 0)
+				ImDui::AddMouseMoveEvent(click.X, click.Y);
+			else
+				ImDui::AddMouseButtonEvent(click.X, click.Y, frame % 3 == 1);
+		}
+		if (frame == frames - 1)
+			ImDui::CaptureFrame(CopyCapture, &capture);
+
+		ImDui::NewFrame();
+		ImDui::ShowDemoWindows(&demo);
+		ImDui::Render();
+	}
+
+	ImDui::DestroyContext(ctx);
+	return capture;
+}
+
+// the YIQ distance of two opaque pixels, 0 to 1 of the largest one
+static float ColorDistance(const unsigned char* a, const unsigned char* b)
+{
+	const float dr = (float)a[0] - b[0], dg = (float)a[1] - b[1], db = (float)a[2] - b[2];
+	const float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+	const float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+	const float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+	return (0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q) / 35215.0f;
+}
+
+// Counts the pixels of actual farther than threshold from golden, and marks them red in diff over
+// a faded golden.
+static int ComparePixels(const ImDui::Raster& actual, const ImDui::Raster& golden, float threshold, ImDui::Raster* diff)
+{
+	const int width = golden.GetWidth(), height = golden.GetHeight();
+	const float max_distance = threshold * threshold;
+	diff->Resize(width, height);
+
+	int count = 0;
+	for (int i = 0; i < width * height; i++)
+	{
+		const unsigned char* a = actual.GetPixels() + i * 4;
+		const unsigned char* g = golden.GetPixels() + i * 4;
+		unsigned char* d = diff->GetPixels() + i * 4;
+		if (ColorDistance(a, g) > max_distance)
+		{
+			d[0] = 255, d[1] = 0, d[2] = 0;
+			count++;
+		}
+		else
+		{
+			const unsigned char gray = (unsigned char)(255 - (255 - (g[0] * 3 + g[1] * 6 + g[2]) / 10) / 4);
+			d[0] = d[1] = d[2] = gray;
+		}
+		d[3] = 255;
+	}
+	return count;
+}
+
+static Result RunScene(const Scene& scene, const Options& options)
+{
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	Result result;
+	result.Passed = false;
+	result.DiffPixels = 0;
+
+	const std::vector<char> data = BuildScene(scene);
+	ImDui::FrameCaptureReader capture;
+	const char* error = capture.Read(data.data(), data.size());
+
+	ImDui::Raster frame, surface;
+	const std::string golden_path = options.GoldenDir + "/" + scene.Name + ".png";
+	if (error != NULL)
+	{
+		result.Message = error;
+	}
+	else
+	{
+		ImDui::RasterCaptureFrame(&frame, &surface, capture, ImFloat4(194 / 255.f, 194 / 255.f, 100 / 255.f, 1.f));
+
+		ImDui::Raster golden, diff;
+		if (options.Update)
+		{
+			result.Passed = frame.WritePNG(golden_path.c_str());
+			result.Message = result.Passed ? "updated" : "cannot write " + golden_path;
+		}
+		else if (!golden.ReadPNG(golden_path.c_str()))
+		{
+			result.Message = "no golden " + golden_path;
+		}
+		else if (golden.GetWidth() != frame.GetWidth() || golden.GetHeight() != frame.GetHeight())
+		{
+			char message[128];
+			snprintf(message, sizeof(message), "%d x %d, the golden is %d x %d", frame.GetWidth(), frame.GetHeight(), golden.GetWidth(), golden.GetHeight());
+			result.Message = message;
+		}
+		else
+		{
+			result.DiffPixels = ComparePixels(frame, golden, options.Threshold, &diff);
+			result.Passed = result.DiffPixels <= options.MaxDiff;
+			if (!result.Passed)
+			{
+				const std::string out = options.OutDir + "/" + scene.Name;
+				diff.WritePNG((out + ".diff.png").c_str());
+				result.Message = "see " + out + ".diff.png";
+			}
+		}
+
+		if (!result.Passed && !options.Update)
+			frame.WritePNG((options.OutDir + "/" + scene.Name + ".png").c_str());
+	}
+
+	result.Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	return result;
+}
+
+static int Usage()
+{
+	printf("usage: ImDuiGolden <golden dir> [-update] [-scene <name>] [-j <threads>] [-threshold <t>] [-max-diff <pixels>] [-out <dir>]\n");
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+#ifdef IMDUI_D2D
+	printf("ImDuiGolden needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	if (argc < 2 || argv[1][0] == '-')
+		return Usage();
+
+	Options options;
+	options.GoldenDir = argv[1];
+	options.Update = false;
+	options.Threshold = 0.1f;
+	options.MaxDiff = 0;
+	int threads = (int)std::thread::hardware_concurrency();
+	const char* only_scene = NULL;
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-update") == 0)
+			options.Update = true;
+		else if (strcmp(argv[i], "-scene") == 0 && i + 1 < argc)
+			only_scene = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc)
+			options.Threshold = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-max-diff") == 0 && i + 1 < argc)
+			options.MaxDiff = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc)
+			options.OutDir = argv[++i];
+		else
+			return Usage();
+	}
+	if (options.OutDir.empty())
+		options.OutDir = options.GoldenDir;
+
+	std::vector<int> scenes;
+	for (int i = 0; i < SCENE_COUNT; i++)
+	{
+		if (only_scene == NULL || strcmp(sc_scenes[i].Name, only_scene) == 0)
+			scenes.push_back(i);
+	}
+	if (scenes.empty())
+	{
+		printf("no scene %s\n", only_scene);
+		return 1;
+	}
+	threads = threads < 1 ? 1 : threads > (int)scenes.size() ? (int)scenes.size() : threads;
+
+	// every thread takes the next scene, in its own context
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<Result> results(scenes.size());
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			for (int i = next++; i < (int)scenes.size(); i = next++)
+				results[i] = RunScene(sc_scenes[scenes[i]], options);
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	int failed = 0;
+	for (size_t i = 0; i < scenes.size(); i++)
+	{
+		const Result& result = results[i];
+		failed += result.Passed ? 0 : 1;
+		printf("%-4s  %-14s %8.2f ms", result.Passed ? "ok" : "FAIL", sc_scenes[scenes[i]].Name, result.Ms);
+		if (result.DiffPixels != 0)
+			printf("  %d pixels differ", result.DiffPixels);
+		if (!result.Message.empty())
+			printf("  %s", result.Message.c_str());
+		printf("\n");
+	}
+	printf("%d scenes, %d failed, %.2f s on %d threads\n", (int)scenes.size(), failed, seconds, threads);
+	return failed ? 1 : 0;
+#endif
+}
@@ -0,0 +1,300 @@
+// ImDuiPack: writes an ImDui image pack (see ImagePackHeader in ImDui.h), so that an application
+// maps pre-decoded pixels at startup instead of decoding its images through WIC.
+//
+// usage: ImDuiPack <pack> [-tiles] <image>[:<width>x<height>] ...
+//
+//   ImDuiPack demo.idp iceland.jpg:160x100 ../samples/sample1.png
+//   ImDuiPack scan.idp -tiles scan.tif
+//
+// An image without a size is stored at its natural size. The name of an image in the pack is
+// the path as given, which is the path the application passes to ImDui::Image(), followed by
+// its size as given when that is not the natural size: only an Image() of that size finds it,
+// where the natural size is found by any request without a size. -tiles stores
+// the whole mip pyramid of the next image as the tiles read by ImDui::ImageViewer().
+// Images are decoded one at a time while the pack is written, so packs may be larger than memory.
+
+#include "../../ImDui/ImDui.h"
+
+#pragma comment(lib, "windowscodecs.lib")
+
+template<class Interface>
+inline void SafeRelease(Interface **ppInterfaceToRelease)
+{
+	if (*ppInterfaceToRelease != NULL)
+	{
+		(*ppInterfaceToRelease)->Release();
+		(*ppInterfaceToRelease) = NULL;
+	}
+}
+
+struct PackImage
+{
+	std::string				Name;
+	std::string				Path;
+	WICRect					Clip;		// part of the source, Width 0 = all of it
+	UINT					Width;		// stored size
+	UINT					Height;
+};
+
+static bool ReadImageSize(IWICImagingFactory* pFactory, const std::string& file, UINT* width, UINT* height)
+{
+	IWICBitmapDecoder *pDecoder = NULL;
+	IWICBitmapFrameDecode *pFrame = NULL;
+
+	WCHAR path[MAX_PATH];
+	MultiByteToWideChar(CP_ACP, 0, file.c_str(), -1, path, MAX_PATH);
+
+	HRESULT hr = pFactory->CreateDecoderFromFilename(path, NULL, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &pDecoder);
+	if (SUCCEEDED(hr))
+		hr = pDecoder->GetFrame(0, &pFrame);
+	if (SUCCEEDED(hr))
+		hr = pFrame->GetSize(width, height);
+
+	SafeRelease(&pDecoder);
+	SafeRelease(&pFrame);
+	return SUCCEEDED(hr);
+}
+
+// decodes the clip of the image to 32bpp premultiplied BGRA at its stored size
+static bool DecodeImage(IWICImagingFactory* pFactory, const PackImage& image, std::vector<BYTE>& pixels)
+{
+	IWICBitmapDecoder *pDecoder = NULL;
+	IWICBitmapFrameDecode *pFrame = NULL;
+	IWICBitmapClipper *pClipper = NULL;
+	IWICBitmapScaler *pScaler = NULL;
+	IWICFormatConverter *pConverter = NULL;
+
+	WCHAR path[MAX_PATH];
+	MultiByteToWideChar(CP_ACP, 0, image.Path.c_str(), -1, path, MAX_PATH);
+
+	HRESULT hr = pFactory->CreateDecoderFromFilename(path, NULL, GENERIC_READ, WICDecodeMetadataCacheOnLoad, &pDecoder);
+
+	if (SUCCEEDED(hr))
+		hr = pDecoder->GetFrame(0, &pFrame);
+
+	IWICBitmapSource* pInput = pFrame;
+	if (SUCCEEDED(hr) && image.Clip.Width > 0)
+	{
+		hr = pFactory->CreateBitmapClipper(&pClipper);
+		if (SUCCEEDED(hr))
+			hr = pClipper->Initialize(pFrame, &image.Clip);
+		pInput = pClipper;
+	}
+
+	UINT width = 0, height = 0;
+	if (SUCCEEDED(hr))
+		hr = pInput->GetSize(&width, &height);
+
+	if (SUCCEEDED(hr) && (width != image.Width || height != image.Height))
+	{
+		hr = pFactory->CreateBitmapScaler(&pScaler);
+		if (SUCCEEDED(hr))
+			hr = pScaler->Initialize(pInput, image.Width, image.Height, image.Clip.Width > 0 ? WICBitmapInterpolationModeFant : WICBitmapInterpolationModeCubic);
+		pInput = pScaler;
+	}
+
+	if (SUCCEEDED(hr))
+		hr = pFactory->CreateFormatConverter(&pConverter);
+
+	if (SUCCEEDED(hr))
+		hr = pConverter->Initialize(pInput, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, NULL, 0.f, WICBitmapPaletteTypeMedianCut);
+
+	if (SUCCEEDED(hr))
+	{
+		pixels.resize(image.Width * image.Height * 4);
+		hr = pConverter->CopyPixels(NULL, image.Width * 4, (UINT)pixels.size(), pixels.data());
+	}
+
+	SafeRelease(&pDecoder);
+	SafeRelease(&pFrame);
+	SafeRelease(&pClipper);
+	SafeRelease(&pScaler);
+	SafeRelease(&pConverter);
+
+	return SUCCEEDED(hr);
+}
+
+// the tiles of every level of the mip pyramid, see IMAGE_TILE_SIZE
+static void AddTiles(const std::string& path, UINT width, UINT height, std::vector<PackImage>& images)
+{
+	for (int level = 0; level == 0 || ((width > height ? width : height) >> (level - 1)) > ImDui::IMAGE_TILE_SIZE; level++)
+	{
+		const UINT tile_src = ImDui::IMAGE_TILE_SIZE << level;
+		const UINT round = (1 << level) - 1;
+		for (UINT y = 0; y * tile_src < height; y++)
+		{
+			for (UINT x = 0; x * tile_src < width; x++)
+			{
+				char name[sizeof(((ImDui::ImagePackEntry*)0)->Name) + 32];
+				sprintf(name, "%s#%d/%u_%u", path.c_str(), level, x, y);
+
+				PackImage tile;
+				tile.Name = name;
+				tile.Path = path;
+				tile.Clip.X = x * tile_src;
+				tile.Clip.Y = y * tile_src;
+				tile.Clip.Width = std::min(tile_src, width - tile.Clip.X);
+				tile.Clip.Height = std::min(tile_src, height - tile.Clip.Y);
+				tile.Width = (tile.Clip.Width + round) >> level;
+				tile.Height = (tile.Clip.Height + round) >> level;
+				images.push_back(tile);
+			}
+		}
+	}
+}
+
+static bool WritePack(IWICImagingFactory* pFactory, const char* path, const std::vector<PackImage>& images)
+{
+	ImDui::ImagePackHeader header;
+	header.Magic = ImDui::IMAGE_PACK_MAGIC;
+	header.Version = ImDui::IMAGE_PACK_VERSION;
+	header.Count = (ImUint)images.size();
+	header.Reserved = 0;
+
+	// pixel blobs follow the index, each aligned
+	std::vector<ImDui::ImagePackEntry> entries(images.size());
+	// offsets are 32 bit, a pack has to fit in the address space of a 32 bit process anyway
+	ULONGLONG offset = sizeof(header) + entries.size() * sizeof(ImDui::ImagePackEntry);
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		offset = (offset + ImDui::IMAGE_PACK_ALIGN - 1) & ~(ULONGLONG)(ImDui::IMAGE_PACK_ALIGN - 1);
+
+		ImDui::ImagePackEntry& entry = entries[i];
+		memset(&entry, 0, sizeof(entry));
+		strcpy(entry.Name, images[i].Name.c_str());
+		entry.Width = images[i].Width;
+		entry.Height = images[i].Height;
+		entry.Offset = (ImUint)offset;
+		const ULONGLONG size = (ULONGLONG)images[i].Width * images[i].Height * 4;
+		entry.Size = (ImUint)size;
+		offset += size;
+		if (offset > 0xFFFFFFFF)
+			break;
+	}
+
+	if (offset > 0xFFFFFFFF)
+	{
+		printf("%s: larger than 4 GB\n", path);
+		return false;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (ok && !entries.empty())
+		ok = fwrite(entries.data(), sizeof(ImDui::ImagePackEntry), entries.size(), file) == entries.size();
+
+	std::vector<BYTE> pixels;
+	ULONGLONG written = sizeof(header) + entries.size() * sizeof(ImDui::ImagePackEntry);
+	for (size_t i = 0; ok && i < images.size(); i++)
+	{
+		if (!DecodeImage(pFactory, images[i], pixels))
+		{
+			printf("%s: failed to decode\n", images[i].Name.c_str());
+			ok = false;
+			break;
+		}
+
+		static const BYTE sc_padding[ImDui::IMAGE_PACK_ALIGN] = { 0 };
+		const size_t padding = (size_t)(entries[i].Offset - written);
+		ok = fwrite(sc_padding, 1, padding, file) == padding;
+		if (ok)
+			ok = fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+		written += padding + pixels.size();
+	}
+
+	fclose(file);
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("usage: ImDuiPack <pack> [-tiles] <image>[:<width>x<height>] ...\n");
+		return 1;
+	}
+
+	CoInitialize(NULL);
+
+	IWICImagingFactory* pFactory = NULL;
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&pFactory));
+	if (FAILED(hr))
+	{
+		printf("failed to create the WIC factory (0x%08x)\n", (unsigned)hr);
+		return 1;
+	}
+
+	std::vector<PackImage> images;
+	int result = 0;
+	bool tiles = false;
+	for (int i = 2; i < argc && result == 0; i++)
+	{
+		if (strcmp(argv[i], "-tiles") == 0)
+		{
+			tiles = true;
+			continue;
+		}
+
+		PackImage image;
+		image.Name = argv[i];
+		memset(&image.Clip, 0, sizeof(image.Clip));
+		image.Width = image.Height = 0;
+
+		// an optional ":<width>x<height>" suffix, the last colon so that drive letters survive
+		const size_t colon = image.Name.rfind(':');
+		if (colon != std::string::npos && sscanf(image.Name.c_str() + colon + 1, "%ux%u", &image.Width, &image.Height) == 2)
+			image.Name.resize(colon);
+		else
+			image.Width = image.Height = 0;
+
+		image.Path = image.Name;
+
+		UINT width, height;
+		if (image.Name.size() + 32 >= sizeof(((ImDui::ImagePackEntry*)0)->Name))
+		{
+			printf("%s: name too long\n", image.Name.c_str());
+			result = 1;
+		}
+		else if (!ReadImageSize(pFactory, image.Path, &width, &height))
+		{
+			printf("%s: failed to read\n", image.Name.c_str());
+			result = 1;
+		}
+		else if (tiles)
+		{
+			const size_t count = images.size();
+			AddTiles(image.Path, width, height, images);
+			printf("%s: %ux%u, %u tiles\n", image.Name.c_str(), width, height, (unsigned)(images.size() - count));
+			tiles = false;
+		}
+		else
+		{
+			if (image.Width == 0)
+			{
+				image.Width = width;
+				image.Height = height;
+			}
+			else if (image.Width != width || image.Height != height)
+			{
+				char size[32];
+				sprintf(size, ":%ux%u", image.Width, image.Height);
+				image.Name += size;
+			}
+			printf("%s: %ux%u\n", image.Path.c_str(), image.Width, image.Height);
+			images.push_back(image);
+		}
+	}
+
+	if (result == 0 && !WritePack(pFactory, argv[1], images))
+	{
+		printf("%s: failed to write\n", argv[1]);
+		result = 1;
+	}
+
+	SafeRelease(&pFactory);
+	CoUninitialize();
+	return result;
+}
@@ -0,0 +1,229 @@
+// ImDuiRemote: the remote UI of ImDuiRemote.h, both sides. The server builds the demo windows,
+// with the slider moving for a while then still, and streams their frames; the viewer, another
+// process, draws every frame it gets with the CPU rasterizer and clicks where it is told to,
+// through the input it sends back.
+//
+// usage: ImDuiRemote -serve <address> [-frames <n>] [-fps <n>]
+//        ImDuiRemote -view <address> [-frames <n>] [-scale <s>] [-click <x> <y>]... [-png <file>]
+//
+//   address           host:port, :port for the loopback, or unix:<path>
+//   -frames 600       frames to build, 0 until the viewer leaves; or frames to receive
+//   -fps 60           frames built per second
+//   -scale 1          pixels per unit of the frames drawn
+//   -click 100 332    a click at x y, the clicks go one every 20 frames from frame 30
+//   -png file         writes the last frame drawn
+//
+// Start the server first. Every second the server prints the bytes it sent a frame next to
+// the frame captures they carry; the viewer prints the same of what it got, and the time to
+// draw a frame.
+
+#include "../../ImDui/ImDuiDemo.h"
+#include "../../ImDui/ImDuiRemote.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+	const char*		Address;
+	int				Frames;
+	int				Fps;
+	float			Scale;
+	std::vector<ImFloat2>	Clicks;
+	const char*		Png;
+};
+
+static double Ms(long long ticks)
+{
+	return ticks * 1000.0 / ImDui::GetTickFrequency();
+}
+
+static int Serve(const Options& options)
+{
+	ImDui::Context* ctx = ImDui::CreateContext();
+	ImDui::SetCurrentContext(ctx);
+	ImDui::InitResources();
+
+	ImDui::RemoteServer server;
+	if (!server.Listen(options.Address))
+	{
+		printf("cannot listen on %s\n", options.Address);
+		ImDui::DestroyContext(ctx);
+		return 1;
+	}
+	printf("serving on %s\n", options.Address);
+
+	ImDui::DemoState demo;
+	ImDui::RemoteStats last;
+	memset(&last, 0, sizeof(last));
+	bool served = false;
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int frame = 0; options.Frames == 0 || frame < options.Frames; frame++)
+	{
+		// the slider moves every other frame for 3 s, then stays for 3 s
+		if (frame % 2 == 0 && (frame / 180) % 2 == 0)
+			demo.Slider = 0.5f + 0.5f * (float)((frame / 2) % 20) / 20.0f;
+
+		server.PollInput();
+		ImDui::NewFrame();
+		ImDui::ShowDemoWindows(&demo);
+		server.Render();
+
+		const ImDui::RemoteStats stats = server.GetStats();
+		served = served || stats.Connected;
+		if (served && !stats.Connected && options.Frames == 0)
+			break;
+		if (frame % options.Fps == options.Fps - 1 && stats.Frames > last.Frames)
+		{
+			const int frames = stats.Frames - last.Frames;
+			printf("%s: %4d frames, %7.1f bytes sent a frame for %8.1f of capture, %d skipped, %d input events\n",
+				(frame / 180) % 2 == 0 ? "moving" : "still ", frames,
+				(double)(stats.BytesSent - last.BytesSent) / frames, (double)(stats.CaptureBytes - last.CaptureBytes) / frames,
+				stats.FramesSkipped - last.FramesSkipped, stats.InputEvents - last.InputEvents);
+			last = stats;
+		}
+		std::this_thread::sleep_until(begin + std::chrono::microseconds((long long)(frame + 1) * 1000000 / options.Fps));
+	}
+
+	const ImDui::RemoteStats stats = server.GetStats();
+	printf("sent %d frames, %.1f KB, %.1f bytes a frame for %.1f of capture, %d skipped\n", stats.Frames,
+		stats.BytesSent / 1024.0, stats.Frames ? (double)stats.BytesSent / stats.Frames : 0.0,
+		stats.Frames ? (double)stats.CaptureBytes / stats.Frames : 0.0, stats.FramesSkipped);
+	server.Close();
+	ImDui::DestroyContext(ctx);
+	return 0;
+}
+
+static int View(const Options& options)
+{
+	ImDui::RemoteViewer viewer;
+	for (int attempt = 0; !viewer.Connect(options.Address); attempt++)
+	{
+		if (attempt == 100)
+		{
+			printf("no server on %s\n", options.Address);
+			return 1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+	printf("viewing %s\n", options.Address);
+
+	const ImFloat4 bg(194 / 255.f, 194 / 255.f, 100 / 255.f, 1.f);		// the clear color of the demo
+	ImDui::Raster frame, surface;
+	int received = 0, second = 0;
+	size_t bytes = 0, second_bytes = 0, max_bytes = 0, capture_bytes = 0;
+	long long draw_ticks = 0;
+	bool ok = true;
+	while (received < options.Frames)
+	{
+		if (!viewer.ReceiveFrame(5000))
+		{
+			ok = !viewer.IsConnected() && received > 0;
+			if (!viewer.IsConnected())
+				printf("the server is gone\n");
+			else
+				printf("no frame for 5 s\n");
+			break;
+		}
+		const ImDui::FrameCaptureReader& capture = viewer.GetCapture();
+		const long long draw_begin = ImDui::GetTicks();
+		ImDui::RasterCaptureFrame(&frame, &surface, capture, bg, -1, 0, options.Scale);
+		draw_ticks += ImDui::GetTicks() - draw_begin;
+
+		size_t size = sizeof(ImDui::FrameCaptureHeader) + strlen(capture.GetBgImage()) + strlen(capture.GetToolTip()) + 2;
+		for (int i = 0; i < capture.GetWindowCount(); i++)
+		{
+			const ImDui::FrameCaptureWindow& info = capture.GetWindow(i).Info;
+			size += sizeof(info) + info.CmdCount * sizeof(ImDui::FrameCaptureCmd) + info.PointCount * sizeof(ImFloat2) + info.TextBytes;
+		}
+		capture_bytes += size;
+		bytes += viewer.GetFrameBytes();
+		second_bytes += viewer.GetFrameBytes();
+		max_bytes = viewer.GetFrameBytes() > max_bytes ? viewer.GetFrameBytes() : max_bytes;
+		received++;
+		second++;
+		if (second == 60)
+		{
+			printf("%4d frames, %7.1f bytes a frame\n", second, (double)second_bytes / second);
+			second = 0;
+			second_bytes = 0;
+		}
+
+		// a click is a move, a press and a release, a frame apart
+		const int click = (received - 30) / 20, step = (received - 30) % 20;
+		if (received >= 30 && click < (int)options.Clicks.size() && step < 3)
+		{
+			const ImFloat2 pos = options.Clicks[click];
+			if (step == 0)
+				viewer.SendMouseMove(pos.x, pos.y);
+			else
+				viewer.SendMouseButton(pos.x, pos.y, step == 1);
+		}
+	}
+
+	if (received > 0)
+	{
+		printf("received %d frames, %.1f KB, %.1f bytes a frame, %zu at most, for %.1f of capture\n", received,
+			bytes / 1024.0, (double)bytes / received, max_bytes, (double)capture_bytes / received);
+		printf("drawn in %.3f ms a frame, %d x %d\n", Ms(draw_ticks) / received, frame.GetWidth(), frame.GetHeight());
+	}
+	if (received > 0 && options.Png != NULL && !frame.WritePNG(options.Png))
+	{
+		printf("cannot write %s\n", options.Png);
+		return 1;
+	}
+	return ok ? 0 : 1;
+}
+
+static int Usage()
+{
+	printf("usage: ImDuiRemote -serve <address> [-frames <n>] [-fps <n>]\n");
+	printf("       ImDuiRemote -view <address> [-frames <n>] [-scale <s>] [-click <x> <y>]... [-png <file>]\n");
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+#ifdef IMDUI_D2D
+	printf("ImDuiRemote needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	if (argc < 3 || (strcmp(argv[1], "-serve") != 0 && strcmp(argv[1], "-view") != 0))
+		return Usage();
+
+	Options options;
+	options.Address = argv[2];
+	options.Frames = 600;
+	options.Fps = 60;
+	options.Scale = 1.0f;
+	options.Png = NULL;
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			options.Frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)
+			options.Fps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-scale") == 0 && i + 1 < argc)
+			options.Scale = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-click") == 0 && i + 2 < argc)
+		{
+			const float x = (float)atof(argv[++i]);
+			options.Clicks.push_back(ImFloat2(x, (float)atof(argv[++i])));
+		}
+		else if (strcmp(argv[i], "-png") == 0 && i + 1 < argc)
+			options.Png = argv[++i];
+		else
+			return Usage();
+	}
+	if (options.Frames < 0 || options.Fps < 1 || options.Scale <= 0.0f)
+		return Usage();
+	if (strcmp(argv[1], "-serve") == 0)
+		return Serve(options);
+	if (options.Frames < 1)
+		return Usage();
+	return View(options);
+#endif
+}
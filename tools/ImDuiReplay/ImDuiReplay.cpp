@@ -0,0 +1,172 @@
+// ImDuiReplay: replays an input recording through the demo windows without a window or a GPU,
+// and prints for every frame its time, the allocations ImDui made and two hashes: of the values
+// held by the widgets, and of the window rects with everything they draw (GetFrameHash()). The
+// run hash combines all of them, a replay that differs anywhere ends with another run hash.
+// Then the p50 and p99 input latencies, measured on the clock of the recording.
+//
+// usage: ImDuiReplay <file> [-expect <run hash>] [-capture <frame> <capture>]
+//        ImDuiReplay -record <file> [frames]
+//
+//   ImDuiReplay -record session.idr         plays the DemoSession of ImDuiDemo.h and records it
+//   ImDuiReplay session.idr                 replays it
+//   ImDuiReplay session.idr -expect 1a2b3c4d   exits with 1 when the run hash differs
+//   ImDuiReplay session.idr -capture 120 frame.idc   captures frame 120 for ImDuiCapture
+//
+// Recordings made by "ImDuiDemo -record <file>" replay the same way, as long as the renderer
+// measures text the same: the null renderer does not measure like DirectWrite.
+
+#include "../../ImDui/ImDuiDemo.h"
+#include "../../ImDui/ImDuiPlatform.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+template<typename T>
+static ImUint HashValue(const T& value, ImUint hash)
+{
+	return ImDui::HashBytes(&value, sizeof(T), hash);
+}
+
+static ImUint HashDemoState(const ImDui::DemoState& demo)
+{
+	ImUint hash = HashValue(demo.ShowDemo, 2166136261u);
+	hash = HashValue(demo.ShowWindowOptions, hash);
+	hash = HashValue(demo.ShowStyleEditor, hash);
+	hash = HashValue(demo.Slider, hash);
+	hash = HashValue(demo.Check1, hash);
+	hash = HashValue(demo.Check2, hash);
+	hash = HashValue(demo.Radio, hash);
+	hash = ImDui::HashBytes(demo.Color, sizeof(demo.Color), hash);
+	hash = HashValue(demo.NoTitleBar, hash);
+	hash = HashValue(demo.NoBorder, hash);
+	hash = HashValue(demo.NoResize, hash);
+	hash = HashValue(demo.NoMove, hash);
+	hash = HashValue(demo.Chinese, hash);
+	return HashValue(demo.FillAlpha, hash);
+}
+
+static size_t CountAllocations()
+{
+	const ImDui::AllocStats stats = ImDui::GetAllocStats();
+	size_t count = 0;
+	for (int i = 0; i < ImDui::AllocCategory_COUNT; i++)
+		count += stats.Allocations[i];
+	return count;
+}
+
+int main(int argc, char** argv)
+{
+	const bool record = (argc > 2 && strcmp(argv[1], "-record") == 0);
+	const char* path = record ? argv[2] : (argc > 1 ? argv[1] : NULL);
+	const int frames = (record && argc > 3) ? atoi(argv[3]) : ImDui::DemoSession::GetFrameCount();
+	bool expect = false;
+	ImUint expected = 0;
+	int capture_frame = 0;
+	const char* capture_path = NULL;
+	bool usage = (path == NULL || path[0] == '-' || frames <= 0);
+	for (int i = 2; !record && !usage && i < argc; i++)
+	{
+		if (strcmp(argv[i], "-expect") == 0 && i + 1 < argc)
+		{
+			expect = true;
+			expected = (ImUint)strtoul(argv[++i], NULL, 16);
+		}
+		else if (strcmp(argv[i], "-capture") == 0 && i + 2 < argc)
+		{
+			capture_frame = atoi(argv[i + 1]);
+			capture_path = argv[i + 2];
+			i += 2;
+		}
+		else
+		{
+			usage = true;
+		}
+	}
+	if (usage)
+	{
+		printf("usage: ImDuiReplay <file> [-expect <run hash>] [-capture <frame> <capture>]\n");
+		printf("       ImDuiReplay -record <file> [frames]\n");
+		return 1;
+	}
+
+	ImDui::CreateContext();
+#ifdef IMDUI_D2D
+	printf("ImDuiReplay needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	ImDui::InitResources();
+#endif
+	ImDui::SetGarbageCollection(3600);		// as the demo
+
+	const bool opened = record ? ImDui::StartInputRecording(path) : ImDui::StartInputReplay(path);
+	if (!opened)
+	{
+		printf("cannot open %s\n", path);
+		ImDui::DestroyContext();
+		return 1;
+	}
+
+	ImDui::DemoState demo;
+	ImDui::DemoSession session;
+	ImUint run_hash = 2166136261u;
+	double total_ms = 0.0;
+	double max_ms = 0.0;
+	size_t total_allocs = 0;
+	int allocating_frames = 0;
+	int frame = 0;
+
+	printf("frame       ms  allocs    values     frame\n");
+	for (;; frame++)
+	{
+		if (record)
+		{
+			if (frame == frames)
+				break;
+			session.Feed(frame);
+		}
+		else if (!ImDui::ReplayInputFrame())
+		{
+			break;
+		}
+
+		if (capture_path != NULL && frame + 1 == capture_frame)
+			ImDui::CaptureFrame(capture_path);
+
+		const size_t allocations = CountAllocations();
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		ImDui::NewFrame();
+		ImDui::ShowDemoWindows(&demo);
+		ImDui::Render();
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		const size_t allocs = CountAllocations() - allocations;
+
+		const ImUint values_hash = HashDemoState(demo);
+		const ImUint frame_hash = ImDui::GetFrameHash();
+		run_hash = HashValue(frame_hash, HashValue(values_hash, run_hash));
+		printf("%5d %8.3f %7u  %08x  %08x\n", frame + 1, ms, (unsigned)allocs, values_hash, frame_hash);
+
+		total_ms += ms;
+		max_ms = ms > max_ms ? ms : max_ms;
+		total_allocs += allocs;
+		allocating_frames += allocs != 0 ? 1 : 0;
+	}
+
+	const ImDui::LatencyStats latency = ImDui::GetLatencyStats();
+	ImDui::DestroyContext();
+
+	printf("%d frames %s %s\n", frame, record ? "recorded to" : "replayed from", path);
+	if (frame > 0)
+		printf("frame: %.3f ms average, %.3f ms max\n", total_ms / frame, max_ms);
+	printf("allocations: %u, in %d frames\n", (unsigned)total_allocs, allocating_frames);
+	printf("latency of %d input events, p50/p99 ms: consume %.3f/%.3f, react %.3f/%.3f (%d events), present %.3f/%.3f\n",
+		latency.Count, latency.ConsumeP50, latency.ConsumeP99, latency.ReactP50, latency.ReactP99, latency.ReactCount, latency.PresentP50, latency.PresentP99);
+	printf("run hash: %08x\n", run_hash);
+
+	if (expect && run_hash != expected)
+	{
+		printf("expected run hash %08x\n", expected);
+		return 1;
+	}
+	return 0;
+}
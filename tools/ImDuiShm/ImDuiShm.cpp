@@ -0,0 +1,210 @@
+// ImDuiShm: the shared memory frame output of ImDuiShm.h, both sides. The writer builds the demo
+// windows with the slider moving every other frame and renders them into a ring of frame
+// buffers; the reader, another process, maps them and reports what it gets in place.
+//
+// usage: ImDuiShm -write <name> [-frames <n>] [-size <width> <height>] [-scale <s>] [-slots <n>] [-fps <n>]
+//        ImDuiShm -read <name> [-frames <n>] [-png <file>]
+//
+//   -frames 600       frames to build, or to acquire
+//   -size 1280 720    of the frames, in pixels
+//   -slots 3          frame buffers in the ring
+//   -fps 60           frames built per second, 0 as fast as possible
+//   -png file         writes the last frame acquired
+//
+// Start the writer first. The writer prints the time to render and publish a frame next to
+// that of copying one; the reader prints the frames it got and skipped, the pixels they
+// changed and the latency from publication to acquisition.
+
+#include "../../ImDui/ImDuiDemo.h"
+#include "../../ImDui/ImDuiShm.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+	const char*		Name;
+	int				Frames;
+	int				Width;
+	int				Height;
+	float			Scale;
+	int				Slots;
+	int				Fps;
+	const char*		Png;
+};
+
+static double Ms(long long ticks)
+{
+	return ticks * 1000.0 / ImDui::GetTickFrequency();
+}
+
+static int Write(const Options& options)
+{
+	ImDui::Context* ctx = ImDui::CreateContext();
+	ImDui::SetCurrentContext(ctx);
+	ImDui::InitResources();
+
+	ImDui::SharedFrameWriter writer;
+	if (!writer.Create(options.Name, options.Width, options.Height, options.Slots))
+	{
+		printf("cannot create the shared memory %s\n", options.Name);
+		ImDui::DestroyContext(ctx);
+		return 1;
+	}
+	printf("writing %d frames of %d x %d to %s, %d slots\n", options.Frames, options.Width, options.Height, options.Name, options.Slots);
+
+	ImDui::DemoState demo;
+	const ImFloat4 clear_color(194 / 255.f, 194 / 255.f, 100 / 255.f, 1.f);
+	int results[4] = { 0, 0, 0, 0 };
+	long long render_ticks = 0;
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < options.Frames; frame++)
+	{
+		if (frame % 2 == 0)
+			demo.Slider = 0.5f + 0.5f * (float)((frame / 2) % 20) / 20.0f;
+
+		ImDui::NewFrame();
+		ImDui::ShowDemoWindows(&demo);
+		const long long render_begin = ImDui::GetTicks();
+		results[writer.Render(options.Scale, clear_color)]++;
+		render_ticks += ImDui::GetTicks() - render_begin;
+
+		if (options.Fps > 0)
+			std::this_thread::sleep_until(begin + std::chrono::microseconds((long long)(frame + 1) * 1000000 / options.Fps));
+	}
+
+	// what the reader saves: a copy of every frame
+	std::vector<unsigned char> src((size_t)options.Width * options.Height * 4, 1), dst(src.size());
+	const long long copy_begin = ImDui::GetTicks();
+	for (int i = 0; i < 10; i++)
+		memcpy(dst.data(), src.data(), src.size());
+	const double copy_ms = Ms(ImDui::GetTicks() - copy_begin) / 10;
+
+	printf("published %d, unchanged %d, no free slot %d, failed %d\n",
+		results[ImDui::SharedFrame_Published], results[ImDui::SharedFrame_Unchanged], results[ImDui::SharedFrame_NoFreeSlot], results[ImDui::SharedFrame_Failed]);
+	printf("render and publish %.3f ms a frame, a copy of a frame would add %.3f ms\n", Ms(render_ticks) / options.Frames, copy_ms);
+
+	writer.Close();
+	ImDui::DestroyContext(ctx);
+	return results[ImDui::SharedFrame_Failed] ? 1 : 0;
+}
+
+static int Read(const Options& options)
+{
+	ImDui::SharedFrameReader reader;
+	for (int attempt = 0; !reader.Open(options.Name); attempt++)
+	{
+		if (attempt == 100)
+		{
+			printf("no shared frames %s\n", options.Name);
+			return 1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+	const ImDui::SharedFramesHeader* header = reader.GetHeader();
+	printf("reading %s: %u x %u, %u slots\n", options.Name, header->Width, header->Height, header->SlotCount);
+
+	ImDui::SharedFrame frame;
+	unsigned long long last = 0;
+	int acquired = 0, skipped = 0, partial = 0;
+	double pixels = 0.0, latency = 0.0, max_latency = 0.0;
+	while (acquired < options.Frames)
+	{
+		if (!reader.Acquire(last, &frame))
+		{
+			if (reader.IsClosed() && header->LatestFrame.load() <= last)
+				break;
+			std::this_thread::yield();
+			continue;
+		}
+
+		const double ms = Ms(ImDui::GetTicks() - frame.Time);
+		latency += ms;
+		max_latency = ms > max_latency ? ms : max_latency;
+		skipped += (last != 0) ? (int)(frame.FrameId - last - 1) : 0;
+		partial += frame.DirtyCount ? 1 : 0;
+		double frame_pixels = frame.DirtyCount ? 0.0 : (double)header->Width * header->Height;
+		for (int i = 0; i < frame.DirtyCount; i++)
+			frame_pixels += frame.DirtyRects[i].z * frame.DirtyRects[i].w;
+		pixels += frame_pixels;
+		last = frame.FrameId;
+		acquired++;
+	}
+
+	// the last frame is still held
+	ImDui::Raster image;
+	if (acquired > 0 && options.Png != NULL)
+	{
+		image.Resize((int)header->Width, (int)header->Height);
+		memcpy(image.GetPixels(), frame.Pixels, (size_t)header->Pitch * header->Height);
+	}
+	reader.Release();
+	if (acquired == 0)
+	{
+		printf("no frame\n");
+		return 1;
+	}
+	printf("acquired %d frames, skipped %d, %d with dirty rects, %.1f%% of the pixels changed a frame\n",
+		acquired, skipped, partial, 100.0 * pixels / acquired / ((double)header->Width * header->Height));
+	printf("latency %.3f ms on average, %.3f ms at most\n", latency / acquired, max_latency);
+	if (options.Png != NULL && !image.WritePNG(options.Png))
+	{
+		printf("cannot write %s\n", options.Png);
+		return 1;
+	}
+	return 0;
+}
+
+static int Usage()
+{
+	printf("usage: ImDuiShm -write <name> [-frames <n>] [-size <width> <height>] [-scale <s>] [-slots <n>] [-fps <n>]\n");
+	printf("       ImDuiShm -read <name> [-frames <n>] [-png <file>]\n");
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+#ifdef IMDUI_D2D
+	printf("ImDuiShm needs the null renderer, build with IMDUI_NULL_RENDER\n");
+	return 1;
+#else
+	if (argc < 3 || (strcmp(argv[1], "-write") != 0 && strcmp(argv[1], "-read") != 0))
+		return Usage();
+
+	Options options;
+	options.Name = argv[2];
+	options.Frames = 600;
+	options.Width = 1280;
+	options.Height = 720;
+	options.Scale = 1.0f;
+	options.Slots = 3;
+	options.Fps = 60;
+	options.Png = NULL;
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+			options.Frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-size") == 0 && i + 2 < argc)
+		{
+			options.Width = atoi(argv[++i]);
+			options.Height = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-scale") == 0 && i + 1 < argc)
+			options.Scale = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "-slots") == 0 && i + 1 < argc)
+			options.Slots = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc)
+			options.Fps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-png") == 0 && i + 1 < argc)
+			options.Png = argv[++i];
+		else
+			return Usage();
+	}
+	if (options.Frames < 1)
+		return Usage();
+	return (strcmp(argv[1], "-write") == 0) ? Write(options) : Read(options);
+#endif
+}